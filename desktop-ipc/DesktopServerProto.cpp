@@ -176,12 +176,14 @@ void DesktopServerProto::readRegion(Region *region, BlockingGate *gate)
 {
   region->clear();
   unsigned int rectCount = gate->readUInt32();
+  std::vector<Rect> rects;
   for (unsigned int i = 0; i < rectCount; i++) {
     Rect r = readRect(gate);
     if (r.isValid()) {
-      region->addRect(&r);
+      rects.push_back(r);
     }
   }
+  region->addRects(&rects);
 }
 
 void DesktopServerProto::sendFrameBuffer(const FrameBuffer *srcFb,
@@ -31,6 +31,7 @@
 #include "rfb/PixelFormat.h"
 #include "rfb/FrameBuffer.h"
 #include "fb-update-sender/UpdateRequestListener.h"
+#include "FrameSnapshot.h"
 
 // This class is a public interface to a desktop.
 class Desktop : public UpdateRequestListener
@@ -60,11 +61,10 @@ public:
   virtual void setMouseEvent(UINT16 x, UINT16 y, UINT8 buttonMask) = 0;
   virtual void setNewClipText(const StringStorage *newClipboard) = 0;
 
-  // Updates external frame buffer pixels only for the region from view port
-  // located at the place in a central frame buffer.
-  // If view port is out of central frame buffer bounds the function will return false.
-  virtual bool updateExternalFrameBuffer(FrameBuffer *fb, const Region *region,
-                                         const Rect *viewPort) = 0;
+  // Returns a snapshot of the central frame buffer that is at least as new
+  // as the updates given to the clients so far. The snapshot is shared with
+  // other clients and must be released by the caller.
+  virtual FrameSnapshot *getFrameSnapshot() = 0;
 };
 
 #endif // __DESKTOP_H__
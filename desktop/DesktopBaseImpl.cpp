@@ -229,6 +229,7 @@ void DesktopBaseImpl::sendUpdate()
 
     m_log->info(_T("extracting updates from UpdateHandler"));
     m_updateHandler->extract(&updCont);
+    m_updateHandler->publishFrame(&updCont);
   } catch (Exception &e) {
     m_log->info(_T("WinDesktop::sendUpdate() failed with error:%s"),
                e.getMessage());
@@ -280,8 +281,7 @@ void DesktopBaseImpl::onConfigReload(ServerConfig *serverConfig)
   applyNewConfiguration();
 }
 
-bool DesktopBaseImpl::updateExternalFrameBuffer(FrameBuffer *fb, const Region *region,
-                                           const Rect *viewPort)
+FrameSnapshot *DesktopBaseImpl::getFrameSnapshot()
 {
-  return m_updateHandler->updateExternalFrameBuffer(fb, region, viewPort);
+  return m_updateHandler->getFrameSnapshot();
 }
@@ -82,8 +82,7 @@ protected:
   // This is an auxiliary function which determines that
   virtual bool isRemoteInputTempBlocked() = 0;
 
-  virtual bool updateExternalFrameBuffer(FrameBuffer *fb, const Region *region,
-                                         const Rect *viewPort);
+  virtual FrameSnapshot *getFrameSnapshot();
 
   void sendUpdate();
 
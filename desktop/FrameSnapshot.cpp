@@ -0,0 +1,103 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FrameSnapshot.h"
+
+FrameSnapshot::FrameSnapshot(const std::vector<FrameTile *> *tiles,
+                             const Dimension *dim, const PixelFormat *pf,
+                             int tileSize)
+: m_refCount(1),
+  m_tiles(*tiles),
+  m_dimension(*dim),
+  m_pixelFormat(*pf),
+  m_tileSize(tileSize),
+  m_columns((dim->width + tileSize - 1) / tileSize)
+{
+  std::vector<FrameTile *>::iterator iTile;
+  for (iTile = m_tiles.begin(); iTile != m_tiles.end(); iTile++) {
+    (*iTile)->addRef();
+  }
+}
+
+FrameSnapshot::~FrameSnapshot()
+{
+  std::vector<FrameTile *>::iterator iTile;
+  for (iTile = m_tiles.begin(); iTile != m_tiles.end(); iTile++) {
+    (*iTile)->release();
+  }
+}
+
+void FrameSnapshot::addRef()
+{
+  InterlockedIncrement(&m_refCount);
+}
+
+void FrameSnapshot::release()
+{
+  if (InterlockedDecrement(&m_refCount) == 0) {
+    delete this;
+  }
+}
+
+Dimension FrameSnapshot::getDimension() const
+{
+  return m_dimension;
+}
+
+PixelFormat FrameSnapshot::getPixelFormat() const
+{
+  return m_pixelFormat;
+}
+
+void FrameSnapshot::copyTo(FrameBuffer *dst, const Rect *dstRect,
+                           int srcX, int srcY) const
+{
+  Rect srcRect(srcX, srcY,
+               srcX + dstRect->getWidth(), srcY + dstRect->getHeight());
+  Rect fbRect = m_dimension.getRect();
+  srcRect = srcRect.intersection(&fbRect);
+  if (srcRect.isEmpty()) {
+    return;
+  }
+
+  int offsetX = dstRect->left - srcX;
+  int offsetY = dstRect->top - srcY;
+
+  int firstRow = srcRect.top / m_tileSize;
+  int lastRow = (srcRect.bottom - 1) / m_tileSize;
+  int firstColumn = srcRect.left / m_tileSize;
+  int lastColumn = (srcRect.right - 1) / m_tileSize;
+  for (int row = firstRow; row <= lastRow; row++) {
+    for (int column = firstColumn; column <= lastColumn; column++) {
+      const FrameTile *tile = m_tiles[row * m_columns + column];
+      Rect tileRect(tile->getPixels()->getDimension().getRect());
+      tileRect.move(column * m_tileSize, row * m_tileSize);
+
+      Rect part = tileRect.intersection(&srcRect);
+      Rect dstPart(&part);
+      dstPart.move(offsetX, offsetY);
+      dst->copyFrom(&dstPart, tile->getPixels(),
+                    part.left - tileRect.left, part.top - tileRect.top);
+    }
+  }
+}
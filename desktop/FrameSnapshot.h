@@ -0,0 +1,75 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __FRAMESNAPSHOT_H__
+#define __FRAMESNAPSHOT_H__
+
+#include "util/CommonHeader.h"
+#include "rfb/FrameBuffer.h"
+#include "FrameTile.h"
+#include <vector>
+
+// FrameSnapshot is an immutable, reference-counted picture of the desktop
+// frame buffer made of shared tiles. Taking a snapshot only references the
+// tiles of a TiledFrameBuffer, the pixels are never copied. The object is
+// created with the reference count of one and deletes itself when the last
+// reference is released.
+class FrameSnapshot
+{
+public:
+  // Takes a reference to every tile of the `tiles' grid. The grid covers
+  // `dim' row by row with square tiles of `tileSize' pixels, the tiles of
+  // the right and the bottom edges may be smaller.
+  FrameSnapshot(const std::vector<FrameTile *> *tiles,
+                const Dimension *dim, const PixelFormat *pf,
+                int tileSize);
+
+  void addRef();
+  void release();
+
+  Dimension getDimension() const;
+  PixelFormat getPixelFormat() const;
+
+  // Copies the pixels located at (srcX, srcY) of the snapshot to `dstRect'
+  // of `dst'. The pixel format of `dst' must be equal to the snapshot's one.
+  // The parts of `dstRect' falling outside of the snapshot are left intact.
+  void copyTo(FrameBuffer *dst, const Rect *dstRect, int srcX, int srcY) const;
+
+private:
+  // Only release() may delete the object.
+  ~FrameSnapshot();
+
+  // Do not allow copying objects.
+  FrameSnapshot(const FrameSnapshot &other);
+  FrameSnapshot &operator=(const FrameSnapshot &other);
+
+  volatile LONG m_refCount;
+
+  std::vector<FrameTile *> m_tiles;
+  Dimension m_dimension;
+  PixelFormat m_pixelFormat;
+  int m_tileSize;
+  int m_columns;
+};
+
+#endif // __FRAMESNAPSHOT_H__
@@ -0,0 +1,61 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FrameTile.h"
+
+FrameTile::FrameTile(const Dimension *dim, const PixelFormat *pf)
+: m_refCount(1)
+{
+  m_pixels.setProperties(dim, pf);
+}
+
+FrameTile::~FrameTile()
+{
+}
+
+void FrameTile::addRef()
+{
+  InterlockedIncrement(&m_refCount);
+}
+
+void FrameTile::release()
+{
+  if (InterlockedDecrement(&m_refCount) == 0) {
+    delete this;
+  }
+}
+
+bool FrameTile::isShared() const
+{
+  return m_refCount > 1;
+}
+
+FrameBuffer *FrameTile::getPixels()
+{
+  return &m_pixels;
+}
+
+const FrameBuffer *FrameTile::getPixels() const
+{
+  return &m_pixels;
+}
@@ -0,0 +1,62 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __FRAMETILE_H__
+#define __FRAMETILE_H__
+
+#include "util/CommonHeader.h"
+#include "rfb/FrameBuffer.h"
+
+// FrameTile is a reference-counted piece of a TiledFrameBuffer. A tile is
+// shared between the store and every FrameSnapshot referencing it, so the
+// owner may write its pixels only while isShared() returns false. The object
+// is created with the reference count of one and deletes itself when the
+// last reference is released.
+class FrameTile
+{
+public:
+  FrameTile(const Dimension *dim, const PixelFormat *pf);
+
+  void addRef();
+  void release();
+
+  // Returns true if somebody other than the caller references the tile.
+  bool isShared() const;
+
+  FrameBuffer *getPixels();
+  const FrameBuffer *getPixels() const;
+
+private:
+  // Only release() may delete the object.
+  ~FrameTile();
+
+  // Do not allow copying objects.
+  FrameTile(const FrameTile &other);
+  FrameTile &operator=(const FrameTile &other);
+
+  volatile LONG m_refCount;
+
+  FrameBuffer m_pixels;
+};
+
+#endif // __FRAMETILE_H__
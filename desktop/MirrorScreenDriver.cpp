@@ -157,6 +157,7 @@ void MirrorScreenDriver::execute()
 {
   Region changedRegion;
   Rect changedRect;
+  std::vector<Rect> changedRects;
   unsigned long currentCounter = 0;
 
   while (!isTerminating()) {
@@ -168,13 +169,15 @@ void MirrorScreenDriver::execute()
         CHANGES_BUF *changesBuf = m_mirrorClient->getChangesBuf();
         if (changesBuf != 0) {
           currentCounter = changesBuf->counter;
+          changedRects.clear();
           for (unsigned long i = m_lastCounter; i != currentCounter;
                i++, i%= MAXCHANGES_BUF) {
             changedRect.fromWindowsRect(&changesBuf->pointrect[i].rect);
             if (changedRect.isValid()) {
-              changedRegion.addRect(&changedRect);
+              changedRects.push_back(changedRect);
             }
           }
+          changedRegion.addRects(&changedRects);
 
           m_updateKeeper->addChangedRegion(&changedRegion);
           m_lastCounter = currentCounter;
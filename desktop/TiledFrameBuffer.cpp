@@ -0,0 +1,167 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TiledFrameBuffer.h"
+#include "thread/AutoLock.h"
+#include <string.h>
+
+TiledFrameBuffer::TiledFrameBuffer()
+: m_columns(0),
+  m_rows(0),
+  m_isValid(false),
+  m_snapshot(0)
+{
+  memset(&m_pixelFormat, 0, sizeof(m_pixelFormat));
+}
+
+TiledFrameBuffer::~TiledFrameBuffer()
+{
+  releaseSnapshot();
+  releaseTiles();
+}
+
+void TiledFrameBuffer::update(const FrameBuffer *src,
+                              const Region *changedRegion)
+{
+  AutoLock al(&m_lock);
+
+  PixelFormat srcPf = src->getPixelFormat();
+  Dimension srcDim = src->getDimension();
+  if (!m_isValid || !srcPf.isEqualTo(&m_pixelFormat) ||
+      !srcDim.isEqualTo(&m_dimension)) {
+    rebuild(src);
+    return;
+  }
+
+  std::vector<Rect> rects;
+  changedRegion->getRectVector(&rects);
+  Rect fbRect = m_dimension.getRect();
+  bool changed = false;
+  for (size_t i = 0; i < rects.size(); i++) {
+    Rect rect = rects[i].intersection(&fbRect);
+    if (rect.isEmpty()) {
+      continue;
+    }
+    int lastRow = (rect.bottom - 1) / TILE_SIZE;
+    int lastColumn = (rect.right - 1) / TILE_SIZE;
+    for (int row = rect.top / TILE_SIZE; row <= lastRow; row++) {
+      for (int column = rect.left / TILE_SIZE; column <= lastColumn; column++) {
+        m_dirtyTiles[row * m_columns + column] = true;
+      }
+    }
+    changed = true;
+  }
+  if (!changed) {
+    return;
+  }
+
+  // The cached snapshot must not keep the tiles shared, otherwise they
+  // would be copied even if no client is sending from them.
+  releaseSnapshot();
+  for (size_t i = 0; i < m_tiles.size(); i++) {
+    if (m_dirtyTiles[i]) {
+      refreshTile(i, src);
+      m_dirtyTiles[i] = false;
+    }
+  }
+}
+
+void TiledFrameBuffer::invalidate()
+{
+  AutoLock al(&m_lock);
+  m_isValid = false;
+}
+
+FrameSnapshot *TiledFrameBuffer::getSnapshot()
+{
+  AutoLock al(&m_lock);
+  if (m_snapshot == 0) {
+    m_snapshot = new FrameSnapshot(&m_tiles, &m_dimension, &m_pixelFormat,
+                                   TILE_SIZE);
+  }
+  m_snapshot->addRef();
+  return m_snapshot;
+}
+
+void TiledFrameBuffer::rebuild(const FrameBuffer *src)
+{
+  releaseSnapshot();
+  releaseTiles();
+
+  m_dimension = src->getDimension();
+  m_pixelFormat = src->getPixelFormat();
+  m_columns = (m_dimension.width + TILE_SIZE - 1) / TILE_SIZE;
+  m_rows = (m_dimension.height + TILE_SIZE - 1) / TILE_SIZE;
+
+  size_t tileCount = (size_t)m_columns * m_rows;
+  m_tiles.resize(tileCount);
+  m_dirtyTiles.assign(tileCount, false);
+  for (size_t i = 0; i < tileCount; i++) {
+    Rect tileRect = getTileRect(i);
+    Dimension tileDim(&tileRect);
+    m_tiles[i] = new FrameTile(&tileDim, &m_pixelFormat);
+    refreshTile(i, src);
+  }
+  m_isValid = true;
+}
+
+void TiledFrameBuffer::refreshTile(size_t index, const FrameBuffer *src)
+{
+  FrameTile *tile = m_tiles[index];
+  if (tile->isShared()) {
+    // A snapshot still holds the old pixels, leave them to it.
+    Dimension tileDim = tile->getPixels()->getDimension();
+    FrameTile *newTile = new FrameTile(&tileDim, &m_pixelFormat);
+    tile->release();
+    tile = newTile;
+    m_tiles[index] = tile;
+  }
+  Rect tileRect = getTileRect(index);
+  tile->getPixels()->copyFrom(src, tileRect.left, tileRect.top);
+}
+
+Rect TiledFrameBuffer::getTileRect(size_t index) const
+{
+  int left = (int)(index % m_columns) * TILE_SIZE;
+  int top = (int)(index / m_columns) * TILE_SIZE;
+  int right = min(left + TILE_SIZE, m_dimension.width);
+  int bottom = min(top + TILE_SIZE, m_dimension.height);
+  return Rect(left, top, right, bottom);
+}
+
+void TiledFrameBuffer::releaseTiles()
+{
+  for (size_t i = 0; i < m_tiles.size(); i++) {
+    m_tiles[i]->release();
+  }
+  m_tiles.clear();
+  m_dirtyTiles.clear();
+}
+
+void TiledFrameBuffer::releaseSnapshot()
+{
+  if (m_snapshot != 0) {
+    m_snapshot->release();
+    m_snapshot = 0;
+  }
+}
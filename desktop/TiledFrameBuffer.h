@@ -0,0 +1,89 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __TILEDFRAMEBUFFER_H__
+#define __TILEDFRAMEBUFFER_H__
+
+#include "rfb/FrameBuffer.h"
+#include "region/Region.h"
+#include "thread/LocalMutex.h"
+#include "FrameTile.h"
+#include "FrameSnapshot.h"
+#include <vector>
+
+// TiledFrameBuffer keeps a copy of the desktop frame buffer split into
+// reference-counted tiles and hands it out as FrameSnapshot objects, so any
+// number of update senders share one copy of the screen. A tile is written
+// in place while nobody else references it. Otherwise, a snapshot still
+// holds its old version and the tile is copied on write, so the memory
+// used on behalf of a client is limited to the tiles changed since the
+// snapshot that client is sending from.
+//
+// All functions are thread-safe.
+class TiledFrameBuffer
+{
+public:
+  TiledFrameBuffer();
+  virtual ~TiledFrameBuffer();
+
+  // Brings the tiles touched by `changedRegion' up to date with `src'. If
+  // the dimension or the pixel format of `src' differs from the current
+  // ones, or invalidate() has been called, all tiles are rebuilt.
+  void update(const FrameBuffer *src, const Region *changedRegion);
+
+  // Makes the next update() call rebuild all tiles. It must be called when
+  // the source frame buffer has been replaced without reporting its whole
+  // area as changed.
+  void invalidate();
+
+  // Returns a snapshot of the current contents. The caller must release
+  // the snapshot when it is not needed anymore.
+  FrameSnapshot *getSnapshot();
+
+  // The side of a square tile, in pixels.
+  static const int TILE_SIZE = 64;
+
+private:
+  void rebuild(const FrameBuffer *src);
+  void refreshTile(size_t index, const FrameBuffer *src);
+  Rect getTileRect(size_t index) const;
+  void releaseTiles();
+  void releaseSnapshot();
+
+  std::vector<FrameTile *> m_tiles;
+  // Marks of tiles to be refreshed, used by update() only.
+  std::vector<bool> m_dirtyTiles;
+  int m_columns;
+  int m_rows;
+  Dimension m_dimension;
+  PixelFormat m_pixelFormat;
+  bool m_isValid;
+
+  // The snapshot of the current contents, made on demand and shared by all
+  // callers of getSnapshot() until the next change.
+  FrameSnapshot *m_snapshot;
+
+  LocalMutex m_lock;
+};
+
+#endif // __TILEDFRAMEBUFFER_H__
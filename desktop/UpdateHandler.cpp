@@ -36,40 +36,27 @@ void UpdateHandler::initFrameBuffer(const FrameBuffer *newFb)
 {
   AutoLock al(&m_fbLocMut);
   m_backupFrameBuffer.clone(newFb);
+  m_tiledFrameBuffer.invalidate();
 }
 
-bool UpdateHandler::updateExternalFrameBuffer(FrameBuffer *fb, const Region *region,
-                                              const Rect *viewPort)
+void UpdateHandler::publishFrame(const UpdateContainer *updateContainer)
 {
+  Region changedRegion = updateContainer->changedRegion;
+  changedRegion.add(&updateContainer->copiedRegion);
+  changedRegion.add(&updateContainer->videoRegion);
+
   AutoLock al(&m_fbLocMut);
-  return updateExternalFrameBuffer(fb, &m_backupFrameBuffer, region, viewPort);
+  if (updateContainer->screenSizeChanged) {
+    m_tiledFrameBuffer.invalidate();
+  }
+  m_tiledFrameBuffer.update(&m_backupFrameBuffer, &changedRegion);
 }
 
-bool UpdateHandler::updateExternalFrameBuffer(FrameBuffer *dstFb, FrameBuffer *srcFb,
-                                              const Region *region,
-                                              const Rect *viewPort)
+FrameSnapshot *UpdateHandler::getFrameSnapshot()
 {
-  PixelFormat dstPf = dstFb->getPixelFormat();
-  PixelFormat srcPf = srcFb->getPixelFormat();
-  Dimension dstFbDim = dstFb->getDimension();
-  Rect srcFbRect = srcFb->getDimension().getRect();
-  Rect resultViewPort = srcFbRect.intersection(viewPort);
-
-  if (!dstPf.isEqualTo(&srcPf) || !dstFbDim.isEqualTo(&Dimension(&resultViewPort)) ||
-      !resultViewPort.isEqualTo(viewPort)) {
-    dstFb->setProperties(&resultViewPort, &srcPf);
-    return false;
-  }
-
-  std::vector<Rect> rects;
-  std::vector<Rect>::iterator iRect;
-  region->getRectVector(&rects);
-
-  for (iRect = rects.begin(); iRect < rects.end(); iRect++) {
-    Rect *rect = &(*iRect);
-    dstFb->copyFrom(rect, srcFb,
-                           rect->left + viewPort->left,
-                           rect->top + viewPort->top);
-  }
-  return true;
+  AutoLock al(&m_fbLocMut);
+  // Nothing is copied here unless the tiles have not been built yet.
+  Region emptyRegion;
+  m_tiledFrameBuffer.update(&m_backupFrameBuffer, &emptyRegion);
+  return m_tiledFrameBuffer.getSnapshot();
 }
@@ -31,6 +31,7 @@
 #include "ScreenGrabber.h"
 #include "WindowsCursorShapeGrabber.h"
 #include "rfb/FrameBuffer.h"
+#include "TiledFrameBuffer.h"
 #include "thread/AutoLock.h"
 #include "UpdateListener.h"
 #include "UpdateDetector.h"
@@ -91,21 +92,26 @@ public:
 
   void initFrameBuffer(const FrameBuffer *newFb);
 
-  virtual bool updateExternalFrameBuffer(FrameBuffer *fb, const Region *region,
-                                         const Rect *viewPort);
+  // Brings the shared tiled copy of the frame buffer up to date with the
+  // changes reported by the last extract() call. Must be called from the
+  // thread calling extract(), right after it.
+  void publishFrame(const UpdateContainer *updateContainer);
+
+  // Returns a snapshot of the frame buffer as of the last publishFrame()
+  // call. The caller must release the snapshot.
+  FrameSnapshot *getFrameSnapshot();
 
   // FIXME: It's no good idea to place this function to here.
   // Because it uses only for the UpdateHandlerClient class.
   virtual void sendInit(BlockingGate *gate) {}
 
 protected:
-  virtual bool updateExternalFrameBuffer(FrameBuffer *dstFb, FrameBuffer *srcFb,
-                                         const Region *region,
-                                         const Rect *viewPort);
-
   FrameBuffer m_backupFrameBuffer;
   LocalMutex m_fbLocMut;
 
+  // The copy of m_backupFrameBuffer shared by all clients.
+  TiledFrameBuffer m_tiledFrameBuffer;
+
   // m_cursorShape not thread safed
   CursorShape m_cursorShape;
 };
@@ -101,6 +101,7 @@ void UpdateHandlerImpl::extract(UpdateContainer *updateContainer)
       // may be invoked from other threads and then it shall cover by the mutex.
       AutoLock al(&m_fbLocMut);
       m_backupFrameBuffer.clone(m_screenDriver->getScreenBuffer());
+      m_tiledFrameBuffer.invalidate();
     }
     updateContainer->changedRegion.clear();
     updateContainer->copiedRegion.clear();
@@ -0,0 +1,81 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "UpdateMailbox.h"
+
+#include <algorithm>
+
+UpdateMailbox::UpdateMailbox()
+: m_head(0)
+{
+}
+
+UpdateMailbox::~UpdateMailbox()
+{
+  std::vector<UpdateSnapshot *> snapshots;
+  takeAll(&snapshots);
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    snapshots[i]->release();
+  }
+}
+
+void UpdateMailbox::post(UpdateSnapshot *snapshot)
+{
+  Node *node = new Node;
+  node->snapshot = snapshot;
+  snapshot->addRef();
+
+  Node *head;
+  do {
+    head = m_head;
+    node->next = head;
+  } while (InterlockedCompareExchangePointer((PVOID volatile *)&m_head,
+                                             node, head) != head);
+}
+
+void UpdateMailbox::takeAll(std::vector<UpdateSnapshot *> *snapshots)
+{
+  // Taking the whole list at once makes the list immune to the ABA problem
+  // a single node pop would have.
+  Node *node = (Node *)InterlockedExchangePointer((PVOID volatile *)&m_head,
+                                                  0);
+  if (node == 0) {
+    return;
+  }
+
+  // The list is in the reverse order.
+  size_t first = snapshots->size();
+  while (node != 0) {
+    Node *next = node->next;
+    snapshots->push_back(node->snapshot);
+    delete node;
+    node = next;
+  }
+  std::reverse(snapshots->begin() + first, snapshots->end());
+}
+
+bool UpdateMailbox::isEmpty() const
+{
+  return m_head == 0;
+}
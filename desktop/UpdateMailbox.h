@@ -0,0 +1,70 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __UPDATEMAILBOX_H__
+#define __UPDATEMAILBOX_H__
+
+#include <vector>
+
+#include "UpdateSnapshot.h"
+
+// UpdateMailbox passes update snapshots from any number of producer threads
+// to one consumer thread without locks. Producers push snapshots to an
+// atomic list, the consumer takes the whole list at once, so posting never
+// waits for the consumer, however slow it is.
+class UpdateMailbox
+{
+public:
+  UpdateMailbox();
+  // Releases the snapshots that were not taken.
+  ~UpdateMailbox();
+
+  // Adds a reference to the snapshot and queues it. May be called from any
+  // thread.
+  void post(UpdateSnapshot *snapshot);
+
+  // Moves all queued snapshots to the end of the vector in the order they
+  // were posted. The caller owns the references and must release them.
+  // Must be called from one thread at a time.
+  void takeAll(std::vector<UpdateSnapshot *> *snapshots);
+
+  // Returns true if nothing has been posted since the last takeAll().
+  bool isEmpty() const;
+
+private:
+  struct Node
+  {
+    Node *next;
+    UpdateSnapshot *snapshot;
+  };
+
+  // Do not allow copying objects.
+  UpdateMailbox(const UpdateMailbox &other);
+  UpdateMailbox &operator=(const UpdateMailbox &other);
+
+  // Top of the list, the most recently posted node first.
+  Node * volatile m_head;
+};
+
+#endif // __UPDATEMAILBOX_H__
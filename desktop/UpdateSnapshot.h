@@ -0,0 +1,63 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __UPDATESNAPSHOT_H__
+#define __UPDATESNAPSHOT_H__
+
+#include "util/CommonHeader.h"
+#include "rfb/CursorShape.h"
+#include "UpdateContainer.h"
+
+// UpdateSnapshot is an immutable, reference-counted copy of the updates
+// collected by the desktop for one sending round. One snapshot is shared by
+// all clients, so passing updates to a client costs no copying. The object
+// is created with the reference count of one and deletes itself when the
+// last reference is released.
+class UpdateSnapshot
+{
+public:
+  UpdateSnapshot(const UpdateContainer *updateContainer,
+                 const CursorShape *cursorShape);
+
+  void addRef();
+  void release();
+
+  const UpdateContainer *getUpdateContainer() const;
+  const CursorShape *getCursorShape() const;
+
+private:
+  // Only release() may delete the object.
+  ~UpdateSnapshot();
+
+  // Do not allow copying objects.
+  UpdateSnapshot(const UpdateSnapshot &other);
+  UpdateSnapshot &operator=(const UpdateSnapshot &other);
+
+  volatile LONG m_refCount;
+
+  UpdateContainer m_updateContainer;
+  CursorShape m_cursorShape;
+};
+
+#endif // __UPDATESNAPSHOT_H__
@@ -27,6 +27,7 @@
 
 CursorUpdates::CursorUpdates(LogWriter *log)
 : m_blockCurPosTime(0),
+  m_cursorIsDrawn(false),
   m_isDrawCursorMethod(false),
   m_log(log)
 {
@@ -42,7 +43,6 @@ void CursorUpdates::update(const EncodeOptions *encodeOptions,
                            const Rect *viewPort,
                            bool shareOnlyApp,
                            const Region *shareAppRegion,
-                           FrameBuffer *fb,
                            CursorShape *cursorShape)
 {
   // Check cursor events. If they are outside of shared region then ignore they.
@@ -70,7 +70,7 @@ void CursorUpdates::update(const EncodeOptions *encodeOptions,
 
   if (!richEnabled && !posEnabled) {
     // Draw the shape on the frame buffer.
-    drawCursor(updCont, fb);
+    drawCursor(updCont);
   }
 
   bool initShapeByZeroIsNeeded = false;
@@ -88,13 +88,13 @@ void CursorUpdates::update(const EncodeOptions *encodeOptions,
       if (methodWasChanged) {
         m_isDrawCursorMethod = false;
         // Restore background under the cursor shape
-        restoreFrameBuffer(fb);
+        removeCursor();
         Rect backgroundRect = getBackgroundRect();
         updCont->changedRegion.addRect(&backgroundRect);
       }
     }
     if (m_isDrawCursorMethod) {
-      drawCursor(updCont, fb);
+      drawCursor(updCont);
       updCont->cursorShapeChanged = methodWasChanged;
     } else {
       updCont->cursorShapeChanged = updCont->cursorShapeChanged ||
@@ -126,39 +126,42 @@ void CursorUpdates::update(const EncodeOptions *encodeOptions,
   }
 }
 
-void CursorUpdates::restoreFrameBuffer(FrameBuffer *fb)
+void CursorUpdates::removeCursor()
 {
   AutoLock al(&m_curPosLocMut);
-  Rect dstRect = m_shapeBackground.getDimension().getRect();
-  dstRect.setLocation(m_backgroundPos.x, m_backgroundPos.y);
-  fb->copyFrom(&dstRect, &m_shapeBackground, 0, 0);
-  // m_shapeBackground.setDimension(&Dimension(0, 0));
+  // The frame buffer itself is shared and never gets the cursor painted,
+  // so forgetting the drawn state is enough to restore the background.
+  m_cursorIsDrawn = false;
 }
 
-void CursorUpdates::drawCursor(UpdateContainer *updCont, FrameBuffer *fb)
+void CursorUpdates::overlayCursor(FrameBuffer *fb, const Rect *fbRect)
+{
+  AutoLock al(&m_curPosLocMut);
+  if (!m_cursorIsDrawn) {
+    return;
+  }
+  Rect rect(&m_backgroundDim.getRect());
+  rect.setLocation(m_backgroundPos.x - fbRect->left,
+                   m_backgroundPos.y - fbRect->top);
+  fb->overlay(&rect,
+              m_cursorShape.getPixels(), 0, 0,
+              m_cursorShape.getMask());
+}
+
+void CursorUpdates::drawCursor(UpdateContainer *updCont)
 {
   AutoLock al(&m_curPosLocMut);
   // Add previous background rectangle to the changed region.
-  Rect rect(&m_shapeBackground.getDimension().getRect());
+  Rect rect(&m_backgroundDim.getRect());
   rect.setLocation(m_backgroundPos.x, m_backgroundPos.y);
   updCont->changedRegion.addRect(&rect);
   // Keep the current background rectangle.
   Point hotSpot = m_cursorShape.getHotSpot();
   m_backgroundPos.setPoint(m_cursorPos.x - hotSpot.x,
                            m_cursorPos.y - hotSpot.y);
-  m_shapeBackground.setProperties(&m_cursorShape.getDimension(),
-                                  &m_cursorShape.getPixelFormat());
-  // Keep background under cursor shape to can reconstruct full image.
-  m_shapeBackground.copyFrom(fb,
-                             m_backgroundPos.x,
-                             m_backgroundPos.y);
-  // Draw the cursor shape on the frame buffer
-  rect.setRect(&m_cursorShape.getDimension().getRect());
-  rect.setLocation(m_backgroundPos.x, m_backgroundPos.y);
-
-  fb->overlay(&rect,
-              m_cursorShape.getPixels(), 0, 0,
-              m_cursorShape.getMask());
+  m_backgroundDim = m_cursorShape.getDimension();
+  // The shape is overlaid on the pixels while they are being sent.
+  m_cursorIsDrawn = true;
 }
 
 bool CursorUpdates::checkCursorPos(UpdateContainer *updCont,
@@ -219,7 +222,7 @@ Point CursorUpdates::getCurPos()
 Rect CursorUpdates::getBackgroundRect()
 {
   AutoLock al(&m_curPosLocMut);
-  Rect rect(&m_shapeBackground.getDimension().getRect());
+  Rect rect(&m_backgroundDim.getRect());
   rect.setLocation(m_backgroundPos.x, m_backgroundPos.y);
   return rect;
 }
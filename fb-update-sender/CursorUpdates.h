@@ -38,10 +38,11 @@ public:
   CursorUpdates(LogWriter *log);
   virtual ~CursorUpdates();
 
-  // Important: After calling the update() function frame buffer
-  // may contain a cursor image to send it as a frame buffer update.
+  // Important: After calling the update() function the cursor image
+  // may have to be sent as a part of the frame buffer update. In that case
+  // the pixels read for sending must be passed through overlayCursor().
   // After sending the frame buffer updates the user code must at sight
-  // call the restoreFrameBuffer() function. Also function clones
+  // call the removeCursor() function. Also function clones
   // actual cursor shape to the cursorShape argument (Only when after call
   // the updCont->cursorShapeChanged flag is raised).
   void update(const EncodeOptions *encodeOptions,
@@ -50,9 +51,13 @@ public:
               const Rect *viewPort,
               bool shareOnlyApp,
               const Region *shareAppRegion,
-              FrameBuffer *fb,
               CursorShape *cursorShape);
-  void restoreFrameBuffer(FrameBuffer *fb);
+  void removeCursor();
+
+  // Draws the cursor shape on fb if the cursor has to be sent as a part of
+  // the frame buffer. The fbRect argument is the place of fb in the
+  // client frame buffer.
+  void overlayCursor(FrameBuffer *fb, const Rect *fbRect);
 
   // Returns current cursor position. Beetween
   Point getCurPos();
@@ -78,8 +83,8 @@ private:
                       const Rect *viewPort,
                       bool curPosBlockingIsIgnored);
 
-  // Shortcut function to draw cursor on the frame buffer directly.
-  void drawCursor(UpdateContainer *updCont, FrameBuffer *fb);
+  // Shortcut function to make the cursor drawn on the frame buffer.
+  void drawCursor(UpdateContainer *updCont);
 
   // Check for cursor blocking state and
   // return true if it is blocked and false
@@ -90,8 +95,11 @@ private:
   Point m_cursorPos;
   DateTime m_blockCurPosTime;
   CursorShape m_cursorShape;
-  FrameBuffer m_shapeBackground;
+  // The place of the last cursor drawn on the frame buffer.
+  Dimension m_backgroundDim;
   Point m_backgroundPos;
+  // True while the cursor has to be overlaid on the pixels being sent.
+  bool m_cursorIsDrawn;
   LocalMutex m_curPosLocMut;
   // Uses when the rich enabled but pointer pos disabled to determine
   // the last send method: by a cursor shape update or drawing on the
@@ -0,0 +1,150 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TileCache.h"
+
+TileCache::TileCache(UINT16 slotCount)
+: m_slots(slotCount)
+{
+  _ASSERT(slotCount > 0 && slotCount < NO_SLOT);
+  reset();
+}
+
+TileCache::~TileCache()
+{
+}
+
+void TileCache::reset()
+{
+  m_slotByHash.clear();
+  UINT16 slotCount = getSlotCount();
+  for (UINT16 i = 0; i < slotCount; i++) {
+    m_slots[i].hash = 0;
+    m_slots[i].isUsed = false;
+    m_slots[i].older = i > 0 ? i - 1 : NO_SLOT;
+    m_slots[i].newer = i + 1 < slotCount ? i + 1 : NO_SLOT;
+  }
+  m_oldest = 0;
+  m_newest = slotCount - 1;
+}
+
+bool TileCache::find(UINT64 hash, UINT16 *slot)
+{
+  std::map<UINT64, UINT16>::iterator it = m_slotByHash.find(hash);
+  if (it == m_slotByHash.end()) {
+    return false;
+  }
+  *slot = it->second;
+  unlink(*slot);
+  linkAsNewest(*slot);
+  return true;
+}
+
+UINT16 TileCache::insert(UINT64 hash)
+{
+  _ASSERT(m_slotByHash.find(hash) == m_slotByHash.end());
+
+  UINT16 slot = m_oldest;
+  if (m_slots[slot].isUsed) {
+    m_slotByHash.erase(m_slots[slot].hash);
+  }
+  m_slots[slot].hash = hash;
+  m_slots[slot].isUsed = true;
+  m_slotByHash[hash] = slot;
+
+  unlink(slot);
+  linkAsNewest(slot);
+  return slot;
+}
+
+UINT16 TileCache::getSlotCount() const
+{
+  return (UINT16)m_slots.size();
+}
+
+UINT64 TileCache::getHash(const FrameBuffer *fb)
+{
+  // The multiply-rotate mixing of MurmurHash3 over 64-bit words.
+  const UINT64 k1 = ((UINT64)0x87C37B91 << 32) | 0x114253D5;
+  const UINT64 k2 = ((UINT64)0x4CF5AD43 << 32) | 0x2745937F;
+
+  Dimension dim = fb->getDimension();
+  UINT64 hash = ((UINT64)dim.width << 32) | (UINT32)dim.height;
+  hash *= k1;
+
+  const UINT8 *data = (const UINT8 *)fb->getBuffer();
+  size_t size = fb->getBufferSize();
+  size_t numWords = size / sizeof(UINT64);
+  for (size_t i = 0; i < numWords; i++) {
+    UINT64 word;
+    memcpy(&word, data + i * sizeof(UINT64), sizeof(UINT64));
+    word *= k1;
+    word = (word << 31) | (word >> 33);
+    word *= k2;
+    hash ^= word;
+    hash = (hash << 27) | (hash >> 37);
+    hash = hash * 5 + 0x52DCE729;
+  }
+  UINT64 tail = 0;
+  memcpy(&tail, data + numWords * sizeof(UINT64), size % sizeof(UINT64));
+  hash ^= tail * k2;
+
+  // Final avalanche.
+  hash ^= size;
+  hash ^= hash >> 33;
+  hash *= ((UINT64)0xFF51AFD7 << 32) | 0xED558CCD;
+  hash ^= hash >> 33;
+  hash *= ((UINT64)0xC4CEB9FE << 32) | 0x1A85EC53;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+void TileCache::unlink(UINT16 slot)
+{
+  Slot *s = &m_slots[slot];
+  if (s->older != NO_SLOT) {
+    m_slots[s->older].newer = s->newer;
+  } else {
+    m_oldest = s->newer;
+  }
+  if (s->newer != NO_SLOT) {
+    m_slots[s->newer].older = s->older;
+  } else {
+    m_newest = s->older;
+  }
+  s->older = NO_SLOT;
+  s->newer = NO_SLOT;
+}
+
+void TileCache::linkAsNewest(UINT16 slot)
+{
+  Slot *s = &m_slots[slot];
+  s->older = m_newest;
+  s->newer = NO_SLOT;
+  if (m_newest != NO_SLOT) {
+    m_slots[m_newest].newer = slot;
+  } else {
+    m_oldest = slot;
+  }
+  m_newest = slot;
+}
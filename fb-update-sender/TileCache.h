@@ -0,0 +1,92 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __TILECACHE_H__
+#define __TILECACHE_H__
+
+#include "util/CommonHeader.h"
+#include "rfb/FrameBuffer.h"
+#include "rfb/TileCacheDefs.h"
+#include "region/Rect.h"
+#include <vector>
+#include <map>
+
+// An operation of the tile cache planned for sending to the client.
+struct TileCacheOp
+{
+  Rect rect;
+  UINT8 operation;
+  UINT16 slot;
+  UINT64 hash;
+};
+
+// Server side copy of the tile cache of a viewer (see rfb/TileCacheDefs.h).
+// The viewer keeps the pixels, this class keeps the content hashes of the
+// tiles and decides which slot is overwritten next: the least recently used
+// one. The viewer applies the operations in the same order, so both sides
+// always agree on the contents of the slots.
+class TileCache
+{
+public:
+  TileCache(UINT16 slotCount = TileCacheDefs::SLOT_COUNT);
+  virtual ~TileCache();
+
+  // Forgets all the tiles.
+  void reset();
+
+  // Looks up a tile by its content hash. If the tile is found, stores its
+  // slot to the slot argument, marks the tile as the most recently used one
+  // and returns true.
+  bool find(UINT64 hash, UINT16 *slot);
+
+  // Puts a tile that is not in the cache yet to the slot of the least
+  // recently used tile and returns the slot.
+  UINT16 insert(UINT64 hash);
+
+  UINT16 getSlotCount() const;
+
+  // Returns the content hash of the pixels of fb, including its dimension.
+  static UINT64 getHash(const FrameBuffer *fb);
+
+private:
+  // Slots are linked into a list from the least to the most recently used.
+  struct Slot
+  {
+    UINT64 hash;
+    bool isUsed;
+    UINT16 older;
+    UINT16 newer;
+  };
+
+  void unlink(UINT16 slot);
+  void linkAsNewest(UINT16 slot);
+
+  std::vector<Slot> m_slots;
+  std::map<UINT64, UINT16> m_slotByHash;
+  UINT16 m_oldest;
+  UINT16 m_newest;
+
+  static const UINT16 NO_SLOT = 0xFFFF;
+};
+
+#endif // __TILECACHE_H__
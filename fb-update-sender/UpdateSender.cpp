@@ -26,10 +26,12 @@
 #include "rfb/VendorDefs.h"
 #include "rfb/EncodingDefs.h"
 #include "rfb/MsgDefs.h"
+#include "rfb/TileCacheDefs.h"
 #include <vector>
 #include "util/inttypes.h"
 #include "util/Exception.h"
 #include "UpdSenderMsgDefs.h"
+#include "network/SessionRecorder.h"
 
 UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
                            UpdateRequestListener *updReqListener,
@@ -38,6 +40,8 @@ UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
                            Desktop *desktop,
                            LogWriter *log)
 : m_updReqListener(updReqListener),
+  m_frameSnapshot(0),
+  m_rectBufferArea(0),
   m_desktop(desktop),
   m_senderControlInformation(senderControlInformation),
   m_busy(false),
@@ -50,7 +54,8 @@ UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
   m_videoFrozen(false),
   m_shareOnlyApp(false),
   m_log(log),
-  m_cursorUpdates(log)
+  m_cursorUpdates(log),
+  m_tileCacheIsValid(false)
 {
   // FIXME: argument must be defined
   m_updateKeeper = new UpdateKeeper(&Rect());
@@ -72,6 +77,8 @@ UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
                         PseudoEncDefs::SIG_POINTER_POS);
   codeRegtor->addEncCap(PseudoEncDefs::DESKTOP_SIZE,     VendorDefs::TIGHTVNC,
                         PseudoEncDefs::SIG_DESKTOP_SIZE);
+  codeRegtor->addEncCap(PseudoEncDefs::TILE_CACHE,       VendorDefs::TIGHTVNC,
+                        PseudoEncDefs::SIG_TILE_CACHE);
 
   codeRegtor->addClToSrvCap(UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE,
                             VendorDefs::TIGHTVNC,
@@ -90,6 +97,10 @@ UpdateSender::~UpdateSender()
 {
   terminate();
   wait();
+
+  if (m_frameSnapshot != 0) {
+    m_frameSnapshot->release();
+  }
 }
 
 void UpdateSender::onTerminate()
@@ -133,20 +144,35 @@ void UpdateSender::init(const Dimension *viewPortDimension,
   m_updateKeeper->setBorderRect(&viewPortDimension->getRect());
 }
 
-void UpdateSender::newUpdates(const UpdateContainer *updateContainer,
-                              const CursorShape *cursorShape)
+void UpdateSender::newUpdates(UpdateSnapshot *snapshot)
 {
   m_log->debug(_T("New updates passed to client #%d"), m_id);
-  addUpdateContainer(updateContainer);
+  m_updateMailbox.post(snapshot);
 
-  m_cursorUpdates.updateCursorShape(cursorShape);
-
-  AutoLock al(&m_reqRectLocMut);
   m_busy = true;
   m_newUpdatesEvent.notify();
   m_log->debug(_T("Client #%d is waking up"), m_id);
 }
 
+void UpdateSender::takeNewUpdates()
+{
+  m_takenSnapshots.clear();
+  m_updateMailbox.takeAll(&m_takenSnapshots);
+  size_t count = m_takenSnapshots.size();
+  for (size_t i = 0; i < count; i++) {
+    addUpdateContainer(m_takenSnapshots[i]->getUpdateContainer());
+  }
+  // Only the most recent cursor shape matters.
+  if (count != 0) {
+    m_cursorUpdates.updateCursorShape(
+      m_takenSnapshots[count - 1]->getCursorShape());
+  }
+  for (size_t i = 0; i < count; i++) {
+    m_takenSnapshots[i]->release();
+  }
+  m_takenSnapshots.clear();
+}
+
 void UpdateSender::addUpdateContainer(const UpdateContainer *updateContainer)
 {
   UpdateContainer updCont = *updateContainer;
@@ -210,21 +236,14 @@ void UpdateSender::sendNewFBSize(Dimension *dim)
 }
 
 void UpdateSender::sendFbInClientDim(const EncodeOptions *encodeOptions,
-                                     const FrameBuffer *fb,
-                                     const Dimension *dim,
-                                     const PixelFormat *pf)
-{
-  // On the black frame buffer will be overlayed the current framebuffer.
-  // This is needed to combine the server frame buffer with a client frame
-  // buffer when the dimensions are not equal.
-  FrameBuffer blankFrameBuffer;
-  blankFrameBuffer.setProperties(dim, pf);
-  blankFrameBuffer.setColor(0, 0, 0);
-  blankFrameBuffer.copyFrom(fb, 0, 0);
-
+                                     const Dimension *dim)
+{
+  // The pixels outside of the server frame buffer are read as black. This
+  // is needed to combine the server frame buffer with a client frame buffer
+  // when the dimensions are not equal.
   Region region(&dim->getRect());
   std::vector<Rect> rects;
-  splitRegion(m_enbox.getEncoder(), &region, &rects, &blankFrameBuffer, encodeOptions);
+  splitRegion(m_enbox.getEncoder(), &region, &rects, encodeOptions);
 
   // Header
   m_output->writeUInt8(0); // message type
@@ -232,7 +251,7 @@ void UpdateSender::sendFbInClientDim(const EncodeOptions *encodeOptions,
   UINT16 numRects = (UINT16)rects.size();
   _ASSERT(numRects == rects.size());
   m_output->writeUInt16(numRects);
-  sendRectangles(m_enbox.getEncoder(), &rects, &blankFrameBuffer, encodeOptions);
+  sendRectangles(m_enbox.getEncoder(), &rects, encodeOptions);
 }
 
 void UpdateSender::sendCursorShapeUpdate(const PixelFormat *fmt,
@@ -296,6 +315,11 @@ void UpdateSender::sendUpdate()
 {
   m_log->debug(_T("Entered to the sendUpdate() function"));
 
+  // Merge the posted snapshots to the update keeper even if nothing is
+  // requested, so that the mailbox does not grow without bound while the
+  // client has no outstanding request. The keeper coalesces the regions.
+  takeNewUpdates();
+
   // Check requested regions and immediately return if the client did not
   // request anything.
   Region requestedFullReg, requestedIncrReg;
@@ -328,9 +352,9 @@ void UpdateSender::sendUpdate()
                                         &shareAppRegion);
 
   updateFrameBuffer(&updCont, shareOnlyApp, &prevShareAppRegion, &shareAppRegion);
-  FrameBuffer *frameBuffer = &m_frameBuffer;
+  m_blackRegion.clear();
 
-  AutoLock l(m_output);
+  AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FRAMEBUFFER));
 
   Dimension clientDim, lastViewPortDim;
   {
@@ -375,7 +399,7 @@ void UpdateSender::sendUpdate()
 
   // Update pixel converter for effective pixel formats. We must do this
   // before using encoders.
-  const PixelFormat serverPixelFormat = frameBuffer->getPixelFormat();
+  const PixelFormat serverPixelFormat = m_framePixelFormat;
   bool setColorMapEntr;
   PixelFormat clientPixelFormat;
   {
@@ -389,6 +413,12 @@ void UpdateSender::sendUpdate()
   }
   m_pixelConverter.setPixelFormats(&clientPixelFormat, &serverPixelFormat);
 
+  // The session recorder is present only if the session is being recorded.
+  SessionRecorder *recorder = m_output->getRecorder();
+  if (recorder != 0) {
+    recorder->setFormat(&clientDim, &clientPixelFormat);
+  }
+
   // Send updates
   if (updCont.screenSizeChanged || (!requestedFullReg.isEmpty() &&
                                     !encodeOptions.desktopSizeEnabled())) {
@@ -402,8 +432,11 @@ void UpdateSender::sendUpdate()
       m_updateKeeper->dazzleChangedReg();
     } else {
       m_log->debug(_T("Desktop resize is disabled, sending blank screen"));
-      sendFbInClientDim(&encodeOptions, frameBuffer, &clientDim,
-                        &frameBuffer->getPixelFormat());
+      if (shareOnlyApp) {
+        m_blackRegion.addRect(&clientDim.getRect());
+        m_blackRegion.subtract(&shareAppRegion);
+      }
+      sendFbInClientDim(&encodeOptions, &clientDim);
       m_log->debug(_T("Dazzle changed region"));
       m_updateKeeper->dazzleChangedReg();
     }
@@ -416,7 +449,6 @@ void UpdateSender::sendUpdate()
                            &viewPort,
                            shareOnlyApp,
                            &shareAppRegion,
-                           frameBuffer,
                            &cursorShape);
 
     if (!encodeOptions.copyRectEnabled() || getVideoFrozen()) {
@@ -436,7 +468,21 @@ void UpdateSender::sendUpdate()
     updCont.changedRegion.add(&requestedFullReg);
 
     // FIXME: Are these two lines really needed? Check that carefully.
-    Rect frameBufferRect = frameBuffer->getDimension().getRect();
+    Rect frameBufferRect(m_frameRect.getWidth(), m_frameRect.getHeight());
+
+    // If the recorder needs a keyframe, send the whole frame buffer with
+    // lossless encodings so that the client's frame buffer will be equal to
+    // ours after this update.
+    bool keyFrame = recorder != 0 && recorder->isKeyFrameNeeded();
+    if (keyFrame) {
+      m_log->debug(_T("Sending the whole frame buffer for a recorder keyframe"));
+      updCont.changedRegion.addRect(&frameBufferRect);
+      updCont.changedRegion.add(&updCont.copiedRegion);
+      updCont.copiedRegion.clear();
+      updCont.changedRegion.add(&updCont.videoRegion);
+      updCont.videoRegion.clear();
+      encodeOptions.disableJpeg();
+    }
     updCont.videoRegion.crop(&frameBufferRect);
     updCont.changedRegion.crop(&frameBufferRect);
     shareAppRegion.crop(&frameBufferRect);
@@ -455,6 +501,14 @@ void UpdateSender::sendUpdate()
     Region videoRegion = updCont.videoRegion;
     Region changedRegion = updCont.changedRegion;
 
+    // The client may not request the whole frame buffer, the keyframe will
+    // be made on one of the next updates then.
+    if (keyFrame) {
+      Region notCovered(&frameBufferRect);
+      notCovered.subtract(&changedRegion);
+      keyFrame = notCovered.isEmpty();
+    }
+
     if (shareOnlyApp) {
       Region newOpeningAppRegion = shareAppRegion;
       newOpeningAppRegion.subtract(&prevShareAppRegion);
@@ -465,8 +519,18 @@ void UpdateSender::sendUpdate()
       blackRegion.subtract(&shareAppRegion);
       changedRegion.add(&blackRegion);
       changedRegion.add(&newOpeningAppRegion);
-      // Paint black in the framebuffer for the black region.
-      paintBlack(frameBuffer, &blackRegion);
+      // The black region is painted when the pixels are read for sending.
+      m_blackRegion = blackRegion;
+    }
+
+    // Tiles that the client has in its tile cache are sent as references
+    // to the cache instead of pixels.
+    std::vector<TileCacheOp> tileCacheOps;
+    if (encodeOptions.tileCacheEnabled()) {
+      planTileCache(&clientPixelFormat, keyFrame, &changedRegion,
+                    &tileCacheOps);
+      m_log->debug(_T("Number of tile cache operations: %d"),
+                   tileCacheOps.size());
     }
 
     //
@@ -478,7 +542,7 @@ void UpdateSender::sendUpdate()
                changedRegion.getCount());
     std::vector<Rect> normalRects;
     splitRegion(m_enbox.getEncoder(), &changedRegion, &normalRects,
-                frameBuffer, &encodeOptions);
+                &encodeOptions);
 
     // Do the same for the videoRegion.
     std::vector<Rect> videoRects;
@@ -486,7 +550,7 @@ void UpdateSender::sendUpdate()
       m_log->debug(_T("Video region is not empty"));
       m_enbox.validateJpegEncoder(); // make sure JpegEncoder is allocated
       splitRegion(m_enbox.getJpegEncoder(), &videoRegion, &videoRects,
-                  frameBuffer, &encodeOptions);
+                  &encodeOptions);
     }
 
     // Get the final list of CopyRect rectangles.
@@ -498,7 +562,8 @@ void UpdateSender::sendUpdate()
     m_log->debug(_T("Number of video rectangles: %d"), videoRects.size());
     m_log->debug(_T("Number of CopyRect rectangles: %d"), copyRects.size());
     size_t numTotalRects =
-      normalRects.size() + videoRects.size() + copyRects.size();
+      normalRects.size() + videoRects.size() + copyRects.size() +
+      tileCacheOps.size();
 
     if (updCont.cursorPosChanged) {
       numTotalRects++;
@@ -538,9 +603,13 @@ void UpdateSender::sendUpdate()
       m_log->debug(_T("Time between request and a point before send and coding (in milliseconds): %u"),
                  (unsigned int)(DateTime::now() - reqTimePoint).getTime());
       m_log->debug(_T("Sending video rectangles"));
-      sendRectangles(m_enbox.getJpegEncoder(), &videoRects, frameBuffer, &encodeOptions);
+      sendRectangles(m_enbox.getJpegEncoder(), &videoRects, &encodeOptions);
       m_log->debug(_T("Sending normal rectangles"));
-      sendRectangles(m_enbox.getEncoder(), &normalRects, frameBuffer, &encodeOptions);
+      sendRectangles(m_enbox.getEncoder(), &normalRects, &encodeOptions);
+      if (!tileCacheOps.empty()) {
+        m_log->debug(_T("Sending tile cache operations"));
+        sendTileCacheOps(&tileCacheOps);
+      }
       m_log->debug(_T("Time between request and answer is (in milliseconds): %u"),
                  (unsigned int)(DateTime::now() - reqTimePoint).getTime());
     } else {
@@ -551,46 +620,208 @@ void UpdateSender::sendUpdate()
       m_incrUpdIsReq = incrUpdIsReq;
       m_fullUpdIsReq = fullUpdIsReq;
     }
-    m_cursorUpdates.restoreFrameBuffer(frameBuffer);
+    if (keyFrame) {
+      // Take the snapshot before the cursor is removed from the frame
+      // buffer, the client has got it painted too. Streams of the encoders
+      // are reset after the keyframe so that the replay can start from it.
+      Dimension keyFrameDim(&frameBufferRect);
+      FrameBuffer serverKeyFrame;
+      serverKeyFrame.setProperties(&keyFrameDim, &serverPixelFormat);
+      readFramePixels(&frameBufferRect, &serverKeyFrame);
+      FrameBuffer clientKeyFrame;
+      clientKeyFrame.setProperties(&keyFrameDim, &clientPixelFormat);
+      m_pixelConverter.convert(&frameBufferRect, &clientKeyFrame,
+                               &serverKeyFrame);
+      recorder->addKeyFrame(&clientKeyFrame, m_enbox.resetCompression());
+    }
+    m_cursorUpdates.removeCursor();
 
   }
 
   m_log->debug(_T("Flushing output"));
   m_output->flush();
+  m_zlibTuner.addOutputStats(m_output->getBytesSent(),
+                             m_output->getSendSeconds());
+}
+
+void UpdateSender::readFramePixels(const Rect *rect, FrameBuffer *dst)
+{
+  Rect frameRect(m_frameRect.getWidth(), m_frameRect.getHeight());
+  Rect dstRect(rect->getWidth(), rect->getHeight());
+  if (!frameRect.isFullyContainRect(rect)) {
+    dst->fillRect(&dstRect, 0);
+  }
+
+  Rect visibleRect = frameRect.intersection(rect);
+  if (!visibleRect.isEmpty()) {
+    Rect dstVisibleRect(&visibleRect);
+    dstVisibleRect.move(-rect->left, -rect->top);
+    m_frameSnapshot->copyTo(dst, &dstVisibleRect,
+                            m_frameRect.left + visibleRect.left,
+                            m_frameRect.top + visibleRect.top);
+  }
+
+  m_cursorUpdates.overlayCursor(dst, rect);
+
+  if (!m_blackRegion.isEmpty()) {
+    Region blackRegion = m_blackRegion;
+    blackRegion.crop(rect);
+    std::vector<Rect> blackRects;
+    blackRegion.getRectVector(&blackRects);
+    for (size_t i = 0; i < blackRects.size(); i++) {
+      blackRects[i].move(-rect->left, -rect->top);
+      dst->fillRect(&blackRects[i], 0);
+    }
+  }
 }
 
-void UpdateSender::paintBlack(FrameBuffer *frameBuffer, const Region *blackRegion)
+void UpdateSender::prepareRectBuffer(const Rect *rect)
 {
-  std::vector<Rect> blackRects;
-  blackRegion->getRectVector(&blackRects);
-  for (size_t i = 0; i < blackRects.size(); i++) {
-    frameBuffer->fillRect(&blackRects[i], 0);
+  Dimension dim(rect);
+  // Keep the biggest buffer allocated so far to not reallocate it for
+  // each rectangle.
+  if (dim.area() > m_rectBufferArea ||
+      !m_rectBuffer.getPixelFormat().isEqualTo(&m_framePixelFormat)) {
+    m_rectBuffer.setProperties(&dim, &m_framePixelFormat);
+    m_rectBufferArea = dim.area();
+  } else {
+    m_rectBuffer.setPropertiesWithoutResize(&dim, &m_framePixelFormat);
   }
 }
 
 void UpdateSender::splitRegion(Encoder *encoder,
                                const Region *region,
                                std::vector<Rect> *rects,
-                               const FrameBuffer *frameBuffer,
                                const EncodeOptions *encodeOptions)
 {
   std::vector<Rect> baseRects;
   region->getRectVector(&baseRects);
   std::vector<Rect>::iterator i;
   for (i = baseRects.begin(); i != baseRects.end(); i++) {
-    encoder->splitRectangle(&*i, rects, frameBuffer, encodeOptions);
+    if (i->area() <= MAX_RECT_AREA) {
+      encoder->splitRectangle(&*i, rects, &m_rectBuffer, encodeOptions);
+      continue;
+    }
+    // Keep the bands aligned to 64 pixels where possible, encoders divide
+    // rectangles to tiles of up to that size.
+    int bandHeight = MAX_RECT_AREA / i->getWidth();
+    if (bandHeight > 64) {
+      bandHeight -= bandHeight % 64;
+    } else if (bandHeight < 1) {
+      bandHeight = 1;
+    }
+    for (int y0 = i->top; y0 < i->bottom; y0 += bandHeight) {
+      Rect band(i->left, y0, i->right, min(y0 + bandHeight, i->bottom));
+      encoder->splitRectangle(&band, rects, &m_rectBuffer, encodeOptions);
+    }
+  }
+}
+
+void UpdateSender::planTileCache(const PixelFormat *clientPixelFormat,
+                                 bool keyFrame,
+                                 Region *changedRegion,
+                                 std::vector<TileCacheOp> *ops)
+{
+  bool formatChanged =
+    !m_tileCacheClientFormat.isEqualTo(clientPixelFormat) ||
+    !m_tileCacheFrameFormat.isEqualTo(&m_framePixelFormat);
+  if (!m_tileCacheIsValid || formatChanged || keyFrame) {
+    m_tileCache.reset();
+    m_tileCacheIsValid = true;
+    m_tileCacheClientFormat = *clientPixelFormat;
+    m_tileCacheFrameFormat = m_framePixelFormat;
+
+    TileCacheOp reset;
+    reset.operation = TileCacheDefs::RESET;
+    reset.slot = 0;
+    reset.hash = 0;
+    ops->push_back(reset);
+    if (keyFrame) {
+      return;
+    }
+  }
+
+  // Operations of one update touch at most a half of the slots, so a tile
+  // loaded in this update is never evicted by a store of the same update.
+  const size_t maxOps = m_tileCache.getSlotCount() / 2;
+  const int tileSize = TileCacheDefs::TILE_SIZE;
+  Rect frameRect(m_frameRect.getWidth(), m_frameRect.getHeight());
+
+  Region loadedRegion;
+  std::vector<Rect> rects;
+  changedRegion->getRectVector(&rects);
+  std::vector<Rect>::iterator iRect;
+  for (iRect = rects.begin(); iRect != rects.end(); iRect++) {
+    // Only the grid tiles which are completely inside of the rectangle
+    // are cached, the edge tiles of the frame buffer are cut by it.
+    for (int y = iRect->top - iRect->top % tileSize; y < iRect->bottom;
+         y += tileSize) {
+      for (int x = iRect->left - iRect->left % tileSize; x < iRect->right;
+           x += tileSize) {
+        Rect tile(x, y, min(x + tileSize, frameRect.right),
+                  min(y + tileSize, frameRect.bottom));
+        if (!iRect->isFullyContainRect(&tile)) {
+          continue;
+        }
+        if (ops->size() >= maxOps) {
+          changedRegion->subtract(&loadedRegion);
+          return;
+        }
+
+        prepareRectBuffer(&tile);
+        readFramePixels(&tile, &m_rectBuffer);
+
+        TileCacheOp op;
+        op.rect = tile;
+        op.hash = TileCache::getHash(&m_rectBuffer);
+        if (m_tileCache.find(op.hash, &op.slot)) {
+          op.operation = TileCacheDefs::LOAD;
+          loadedRegion.addRect(&tile);
+        } else {
+          op.operation = TileCacheDefs::STORE;
+          op.slot = m_tileCache.insert(op.hash);
+        }
+        ops->push_back(op);
+      }
+    }
+  }
+  changedRegion->subtract(&loadedRegion);
+}
+
+void UpdateSender::sendTileCacheOps(const std::vector<TileCacheOp> *ops)
+{
+  // The operations are sent after the pixels of the update. A tile may be
+  // stored and loaded to another place in the same update, so the stores
+  // are sent before the loads.
+  for (UINT8 operation = TileCacheDefs::RESET;
+       operation <= TileCacheDefs::LOAD; operation++) {
+    std::vector<TileCacheOp>::const_iterator i;
+    for (i = ops->begin(); i != ops->end(); i++) {
+      if (i->operation != operation) {
+        continue;
+      }
+      sendRectHeader(&i->rect, PseudoEncDefs::TILE_CACHE);
+      m_output->writeUInt8(operation);
+      if (operation != TileCacheDefs::RESET) {
+        m_output->writeUInt16(i->slot);
+        m_output->writeUInt64(i->hash);
+      }
+    }
   }
 }
 
 void UpdateSender::sendRectangles(Encoder *encoder,
                                   const std::vector<Rect> *rects,
-                                  const FrameBuffer *frameBuffer,
                                   const EncodeOptions *encodeOptions)
 {
   std::vector<Rect>::const_iterator i;
   for (i = rects->begin(); i != rects->end(); i++) {
+    prepareRectBuffer(&*i);
+    readFramePixels(&*i, &m_rectBuffer);
     sendRectHeader(&*i, encoder->getCode());
-    encoder->sendRectangle(&*i, frameBuffer, encodeOptions);
+    // The encoder sees the rectangle at the origin of m_rectBuffer.
+    Rect bufferRect(i->getWidth(), i->getHeight());
+    encoder->sendRectangle(&bufferRect, &m_rectBuffer, encodeOptions);
   }
 }
 
@@ -650,7 +881,10 @@ void UpdateSender::readUpdateRequest(RfbInputGate *io)
 
   _ASSERT(m_updReqListener != 0);
 
-  bool alreadyHasUpdates = m_updateKeeper->checkForUpdates(&combinedReqRegions);
+  // Snapshots waiting in the mailbox are merged by the sender thread only,
+  // so they are considered as updates here.
+  bool alreadyHasUpdates = !m_updateMailbox.isEmpty() ||
+                           m_updateKeeper->checkForUpdates(&combinedReqRegions);
   if (alreadyHasUpdates) {
     // We should initiaite send update to avoid it skipping on no updates from a desktop
     // FIXME: Code duplication, see the newUpdates() function.
@@ -771,6 +1005,7 @@ bool UpdateSender::extractReqRegions(Region *incrReqReg,
 
 void UpdateSender::extractUpdates(UpdateContainer *updCont)
 {
+  takeNewUpdates();
   m_updateKeeper->extract(updCont);
 }
 
@@ -834,6 +1069,9 @@ void UpdateSender::selectEncoder(EncodeOptions *encodeOptions)
   // Make sure the encoder object corresponds to the preferred encoding
   // requested in the most recent SetEncodings client message.
   m_enbox.selectEncoder(encodeOptions->getPreferredEncoding());
+  // Zlib parameters of the encoders are tuned to the CPU budget and the
+  // link of this client.
+  encodeOptions->setZlibTuner(&m_zlibTuner);
 }
 
 void UpdateSender::updateFrameBuffer(UpdateContainer *updCont,
@@ -857,18 +1095,26 @@ void UpdateSender::updateFrameBuffer(UpdateContainer *updCont,
   // for example, appears when alien application creep on the shared application.
   updCont->changedRegion.add(&newOpeningPixels);
 
-  // Frame buffers synchronizing
-  Region changedAndCopyRgns = updCont->changedRegion;
-  changedAndCopyRgns.add(&updCont->copiedRegion);
-  changedAndCopyRgns.add(&updCont->videoRegion);
-  changedAndCopyRgns.addRect(&m_cursorUpdates.getBackgroundRect());
-  {
-    AutoLock al(&m_reqRectLocMut);
-    changedAndCopyRgns.add(&m_requestedFullReg);
+  // The snapshot is at least as new as the updates extracted before, so
+  // all the pixels to be sent are up to date in it.
+  FrameSnapshot *frameSnapshot = m_desktop->getFrameSnapshot();
+  if (m_frameSnapshot != 0) {
+    m_frameSnapshot->release();
   }
-
-  updCont->screenSizeChanged = !m_desktop->updateExternalFrameBuffer(&m_frameBuffer, &changedAndCopyRgns, &viewPort) ||
-                               updCont->screenSizeChanged;
+  m_frameSnapshot = frameSnapshot;
+
+  // If view port is out of the frame buffer bounds, it is treated as
+  // the screen size change.
+  PixelFormat pf = m_frameSnapshot->getPixelFormat();
+  Rect fbRect = m_frameSnapshot->getDimension().getRect();
+  Rect resultViewPort = fbRect.intersection(&viewPort);
+  bool frameChanged = !pf.isEqualTo(&m_framePixelFormat) ||
+                      !Dimension(&resultViewPort).isEqualTo(&Dimension(&m_frameRect)) ||
+                      !resultViewPort.isEqualTo(&viewPort);
+  m_frameRect = resultViewPort;
+  m_framePixelFormat = pf;
+
+  updCont->screenSizeChanged = frameChanged || updCont->screenSizeChanged;
 }
 
 bool UpdateSender::updateViewPort(Rect *outNewViewPort, bool *shareApp, Region *prevShareAppRegion,
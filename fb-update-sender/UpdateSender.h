@@ -28,6 +28,8 @@
 #include "thread/AutoLock.h"
 #include "thread/Thread.h"
 #include "desktop/UpdateKeeper.h"
+#include "desktop/UpdateMailbox.h"
+#include "desktop/FrameSnapshot.h"
 #include "UpdateRequestListener.h"
 #include "rfb/FrameBuffer.h"
 #include "ViewPort.h"
@@ -38,8 +40,10 @@
 #include "rfb-sconn/JpegEncoder.h"
 #include "rfb-sconn/EncoderStore.h"
 #include "rfb-sconn/RfbCodeRegistrator.h"
+#include "rfb-sconn/ZlibTuner.h"
 #include "util/DateTime.h"
 #include "CursorUpdates.h"
+#include "TileCache.h"
 #include "SenderControlInformationInterface.h"
 
 class UpdateSender : public Thread, public RfbDispatcherListener
@@ -59,13 +63,11 @@ public:
   // FIXME: The comment does not seem to be relevant.
   void init(const Dimension *viewPortDimension, const PixelFormat *pf);
 
-  // The triggerUpdate() function adds updateContainer to the UpdateKeeper,
-  // gives new frame buffer properties if needed.
-  // Also, if client is ready by now (m_reqRect is not empty), triggerUpdate()
-  // notifies to thread.
-  // FIXME: The comment does not seem to be relevant.
-  void newUpdates(const UpdateContainer *updateContainer,
-                  const CursorShape *cursorShape);
+  // Posts the update snapshot to the mailbox of this client and wakes up
+  // the sender thread. The snapshot is merged into the UpdateKeeper by the
+  // sender thread later, so the caller (the desktop thread) never waits for
+  // the sender.
+  void newUpdates(UpdateSnapshot *snapshot);
 
   // Block cursor pos sending by this connection to a client. Unblocking will
   // be automaticly for a time.
@@ -92,9 +94,12 @@ protected:
 
   // The addUpdateContainer() function adds all updates from the first
   // updateContainer parameter to the own UpdateContainer object.
-  // This function may asynchronously be called from any threads.
   void addUpdateContainer(const UpdateContainer *updateContainer);
 
+  // Merges all snapshots posted by newUpdates() into the UpdateKeeper.
+  // Called by the sender thread only.
+  void takeNewUpdates();
+
   // The sender thread.
   virtual void execute();
   virtual void onTerminate();
@@ -109,8 +114,8 @@ protected:
   bool getVideoFrozen();
 
   // The sendUpdate() function sends all stored updates to the client.
-  // Access to a FrameBuffer data passes through the frameBuffer pointer
-  // of the function parameter.
+  // Pixels are read from the frame snapshot shared with other clients, one
+  // rectangle at a time.
   void sendUpdate();
 
   // sendUpdate() auxiliary functions.
@@ -129,7 +134,9 @@ protected:
 
   void selectEncoder(EncodeOptions *encodeOptions);
 
-  // Updates pixels in the internal frame buffer.
+  // Takes the latest frame snapshot from the desktop. Raises
+  // updCont->screenSizeChanged if the sent part of the frame buffer has
+  // changed its dimension or pixel format.
   void updateFrameBuffer(UpdateContainer *updCont,
                          bool shareOnlyApp, const Region *prevSharedRegion,
                          const Region *shareAppRegion);
@@ -152,22 +159,36 @@ protected:
                       INT32 encodingType);
   void sendNewFBSize(Dimension *dim);
   void sendFbInClientDim(const EncodeOptions *encodeOptions,
-                         const FrameBuffer *fb,
-                         const Dimension *dim,
-                         const PixelFormat *pf);
+                         const Dimension *dim);
   void sendCursorShapeUpdate(const PixelFormat *fmt,
                              const CursorShape *cursorShape);
   void sendCursorPosUpdate();
   void sendCopyRect(const std::vector<Rect> *rects, const Point *source);
 
+  // Replaces the tiles of changedRegion which are in the tile cache of the
+  // client with LOAD operations and plans STORE operations for the other
+  // tiles. Resets the cache (with a RESET operation) when it is used first,
+  // when a pixel format has changed and on keyframes. A keyframe must not
+  // depend on the earlier updates, so nothing is cached in its update.
+  void planTileCache(const PixelFormat *clientPixelFormat, bool keyFrame,
+                     Region *changedRegion, std::vector<TileCacheOp> *ops);
+
+  // Sends the tile cache operations as pseudo-rectangles.
+  void sendTileCacheOps(const std::vector<TileCacheOp> *ops);
+
   // Encode and send a list of rectangles via the specified encoder.
   void sendRectangles(Encoder *encoder,
                       const std::vector<Rect> *rects,
-                      const FrameBuffer *frameBuffer,
                       const EncodeOptions *encodeOptions);
 
-  // This function paints black region in framebuffer.
-  void paintBlack(FrameBuffer *frameBuffer, const Region *blackRegion);
+  // Copies the pixels of rect (in the client frame buffer coordinates) from
+  // the frame snapshot to dst so that the top-left corner of rect gets to
+  // (0, 0). The cursor and the black region are painted over the pixels,
+  // the pixels outside of the frame buffer are black.
+  void readFramePixels(const Rect *rect, FrameBuffer *dst);
+
+  // Makes m_rectBuffer fit the pixels of rect.
+  void prepareRectBuffer(const Rect *rect);
 
   // This function is used to split a region into a list of rectangles,
   // where actual splitting is performed by the specified encoder object.
@@ -176,9 +197,12 @@ protected:
   void splitRegion(Encoder *encoder,
                    const Region *region,
                    std::vector<Rect> *rects,
-                   const FrameBuffer *frameBuffer,
                    const EncodeOptions *encodeOptions);
 
+  // Rectangles of a bigger area are split into horizontal bands before
+  // giving them to an encoder, this limits the size of m_rectBuffer.
+  static const int MAX_RECT_AREA = 256 * 1024;
+
   LogWriter *m_log;
 
   WindowsEvent m_newUpdatesEvent;
@@ -204,12 +228,33 @@ protected:
   LocalMutex m_viewPortMut;
 
   UpdateKeeper *m_updateKeeper;
-
-  FrameBuffer m_frameBuffer;
+  // Snapshots posted by newUpdates() and not merged yet.
+  UpdateMailbox m_updateMailbox;
+  std::vector<UpdateSnapshot *> m_takenSnapshots;
+
+  // The frame buffer snapshot the updates are sent from, it is shared with
+  // other clients.
+  FrameSnapshot *m_frameSnapshot;
+  // The part of the snapshot seen by the client.
+  Rect m_frameRect;
+  PixelFormat m_framePixelFormat;
+  // The pixels of the rectangle being encoded.
+  FrameBuffer m_rectBuffer;
+  int m_rectBufferArea;
+  // The part of the client frame buffer that must be sent black in the
+  // current update.
+  Region m_blackRegion;
   Desktop *m_desktop;
 
   CursorUpdates m_cursorUpdates;
 
+  // Copy of the tile cache of the client and the pixel formats of the
+  // cached tiles. The cache is not valid until the first reset is sent.
+  TileCache m_tileCache;
+  bool m_tileCacheIsValid;
+  PixelFormat m_tileCacheClientFormat;
+  PixelFormat m_tileCacheFrameFormat;
+
   // EncodeOptions class maintain the configuration of encoders and
   // pseudo-encoders read from the SetEncodings client message.
   // m_newEncodeOptions may be changed at any time but all change and read
@@ -253,6 +298,10 @@ protected:
   // should be used only by the sender thread.
   EncoderStore m_enbox;
 
+  // Chooses zlib parameters of the encoders for this client. It is used only
+  // by the sender thread too.
+  ZlibTuner m_zlibTuner;
+
   // Information
   // FIXME: Document this properly.
   int m_id;
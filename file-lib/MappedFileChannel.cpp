@@ -0,0 +1,348 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "MappedFileChannel.h"
+#include "EOFException.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include "win-system/Environment.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFileChannel::MappedFileChannel(const TCHAR *pathName, size_t windowSize)
+: m_window(0),
+  m_windowOffset(0),
+  m_windowLength(0),
+  m_size(0),
+  m_position(0)
+{
+#ifdef _WIN32
+  m_mapping = 0;
+  m_buffered = !isMappable(pathName);
+
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  m_granularity = systemInfo.dwAllocationGranularity;
+  m_pageSize = systemInfo.dwPageSize;
+
+  m_file = CreateFile(pathName, GENERIC_READ, FILE_SHARE_READ, 0,
+                      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    throwSystemError();
+  }
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(m_file, &size) == 0) {
+    DWORD errCode = GetLastError();
+    CloseHandle(m_file);
+    SetLastError(errCode);
+    throwSystemError();
+  }
+  m_size = size.QuadPart;
+
+  // Empty file cannot be mapped
+  if (m_size != 0 && !m_buffered) {
+    m_mapping = CreateFileMapping(m_file, 0, PAGE_READONLY, 0, 0, 0);
+    if (m_mapping == 0) {
+      DWORD errCode = GetLastError();
+      CloseHandle(m_file);
+      SetLastError(errCode);
+      throwSystemError();
+    }
+  }
+#else
+  m_granularity = (size_t)sysconf(_SC_PAGESIZE);
+
+  m_file = open(pathName, O_RDONLY);
+  if (m_file == -1) {
+    throwSystemError();
+  }
+
+  struct stat fileStat;
+  if (fstat(m_file, &fileStat) != 0) {
+    int errCode = errno;
+    ::close(m_file);
+    errno = errCode;
+    throwSystemError();
+  }
+  m_size = (UINT64)fileStat.st_size;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(m_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+
+  // Window size must be multiple of granularity
+  m_windowSize = (windowSize + m_granularity - 1) / m_granularity * m_granularity;
+  if (m_windowSize == 0) {
+    m_windowSize = m_granularity;
+  }
+}
+
+MappedFileChannel::~MappedFileChannel()
+{
+  try { close(); } catch (...) {}
+}
+
+UINT64 MappedFileChannel::getSize() const
+{
+  return m_size;
+}
+
+UINT64 MappedFileChannel::getPosition() const
+{
+  return m_position;
+}
+
+size_t MappedFileChannel::map(const char **data, size_t len) throw(IOException)
+{
+  if (m_position >= m_size || len == 0) {
+    return 0;
+  }
+
+  if (m_window == 0 ||
+      m_position < m_windowOffset ||
+      m_position >= m_windowOffset + m_windowLength) {
+    mapWindow();
+  }
+
+  size_t offsetInWindow = (size_t)(m_position - m_windowOffset);
+  size_t available = m_windowLength - offsetInWindow;
+  if (available > len) {
+    available = len;
+  }
+
+  *data = m_window + offsetInWindow;
+
+#ifdef _WIN32
+  if (!m_buffered && !touchPages(*data, available, m_pageSize)) {
+    throw IOException(_T("Cannot read the file: I/O error in mapped view"));
+  }
+#endif
+
+  m_position += available;
+
+  return available;
+}
+
+void MappedFileChannel::seek(INT64 n)
+{
+  if (n < 0 && (UINT64)(-n) > m_position) {
+    throw IOException(_T("Cannot seek before beginning of file"));
+  }
+  m_position += n;
+}
+
+size_t MappedFileChannel::read(void *buffer, size_t len)
+{
+  const char *data;
+  size_t portion = map(&data, len);
+
+  if (portion == 0) {
+    if (len == 0) {
+      return 0;
+    }
+    throw EOFException();
+  }
+
+  memcpy(buffer, data, portion);
+  return portion;
+}
+
+size_t MappedFileChannel::write(const void *buffer, size_t len)
+{
+  throw IOException(_T("Cannot write to read-only file channel"));
+}
+
+void MappedFileChannel::close() throw(Exception)
+{
+  unmapWindow();
+
+#ifdef _WIN32
+  if (m_mapping != 0) {
+    CloseHandle(m_mapping);
+    m_mapping = 0;
+  }
+  if (m_file != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (m_file != -1) {
+    ::close(m_file);
+    m_file = -1;
+  }
+#endif
+}
+
+void MappedFileChannel::mapWindow() throw(IOException)
+{
+  unmapWindow();
+
+  UINT64 offset = m_position - m_position % m_granularity;
+  UINT64 length = m_size - offset;
+  if (length > m_windowSize) {
+    length = m_windowSize;
+  }
+
+#ifdef _WIN32
+  if (m_buffered) {
+    readWindow(offset, (size_t)length);
+    return;
+  }
+  if (m_mapping == 0) {
+    throw IOException(_T("File is closed"));
+  }
+
+  void *window = MapViewOfFile(m_mapping, FILE_MAP_READ,
+                               (DWORD)(offset >> 32), (DWORD)offset,
+                               (SIZE_T)length);
+  if (window == 0) {
+    throwSystemError();
+  }
+#else
+  if (m_file == -1) {
+    throw IOException(_T("File is closed"));
+  }
+
+  void *window = mmap(0, (size_t)length, PROT_READ, MAP_PRIVATE, m_file,
+                      (off_t)offset);
+  if (window == MAP_FAILED) {
+    throwSystemError();
+  }
+
+  // The window is read from beginning to end, pages can be read ahead
+  // and dropped right after they are used
+  madvise(window, (size_t)length, MADV_SEQUENTIAL);
+  madvise(window, (size_t)length, MADV_WILLNEED);
+#endif
+
+  m_window = (char *)window;
+  m_windowOffset = offset;
+  m_windowLength = (size_t)length;
+}
+
+void MappedFileChannel::unmapWindow()
+{
+  if (m_window == 0) {
+    return;
+  }
+
+#ifdef _WIN32
+  if (!m_buffered) {
+    UnmapViewOfFile(m_window);
+  }
+#else
+  munmap(m_window, m_windowLength);
+#endif
+
+  m_window = 0;
+  m_windowOffset = 0;
+  m_windowLength = 0;
+}
+
+#ifdef _WIN32
+
+void MappedFileChannel::readWindow(UINT64 offset, size_t length)
+  throw(IOException)
+{
+  if (m_file == INVALID_HANDLE_VALUE) {
+    throw IOException(_T("File is closed"));
+  }
+
+  LARGE_INTEGER filePointer;
+  filePointer.QuadPart = offset;
+  if (SetFilePointerEx(m_file, filePointer, 0, FILE_BEGIN) == 0) {
+    throwSystemError();
+  }
+
+  m_buffer.resize(length);
+  size_t total = 0;
+  while (total < length) {
+    DWORD portion = 0;
+    if (ReadFile(m_file, &m_buffer[total], (DWORD)(length - total),
+                 &portion, 0) == 0) {
+      throwSystemError();
+    }
+    if (portion == 0) {
+      throw IOException(_T("Unexpected end of file"));
+    }
+    total += portion;
+  }
+
+  m_window = &m_buffer.front();
+  m_windowOffset = offset;
+  m_windowLength = length;
+}
+
+bool MappedFileChannel::touchPages(const char *data, size_t len,
+                                   size_t pageSize)
+{
+  if (len == 0) {
+    return true;
+  }
+  // No objects with destructors here, they cannot be used with __try.
+  __try {
+    volatile char value;
+    size_t offset = pageSize - (size_t)data % pageSize;
+    value = data[0];
+    for (; offset < len; offset += pageSize) {
+      value = data[offset];
+    }
+  } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+              EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH) {
+    return false;
+  }
+  return true;
+}
+
+bool MappedFileChannel::isMappable(const TCHAR *pathName)
+{
+  TCHAR volumePath[MAX_PATH];
+  if (GetVolumePathName(pathName, volumePath, MAX_PATH) == 0) {
+    return false;
+  }
+  UINT driveType = GetDriveType(volumePath);
+  return driveType == DRIVE_FIXED || driveType == DRIVE_RAMDISK;
+}
+
+#endif // _WIN32
+
+void MappedFileChannel::throwSystemError() throw(IOException)
+{
+#ifdef _WIN32
+  StringStorage errText;
+  Environment::getErrStr(&errText);
+  throw IOException(errText.getString());
+#else
+  throw IOException(strerror(errno));
+#endif
+}
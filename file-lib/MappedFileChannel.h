@@ -0,0 +1,124 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __MAPPEDFILECHANNEL_H__
+#define __MAPPEDFILECHANNEL_H__
+
+#include "FileChannel.h"
+#include "util/CommonHeader.h"
+
+#include <vector>
+
+// Read-only file channel that reads file through its mapping to memory.
+// File is mapped by large windows with sequential access hints, so reading
+// of large files does not cost a system call per small buffer, and data can
+// be taken directly from the mapping by map() without copying.
+//
+// On Windows I/O errors in a mapped view are raised as structured
+// exceptions (EXCEPTION_IN_PAGE_ERROR) at the first access to a page, so
+// map() touches the pages it returns and throws IOException instead. Files
+// on network and removable volumes, where such errors are expected, are not
+// mapped but read to a buffer of window size.
+class MappedFileChannel : public FileChannel
+{
+public:
+  // Opens existing file for reading.
+  // windowSize is size of file part that is mapped at once, it's rounded up
+  // to allocation granularity of the system.
+  // Throws IOException on fail.
+  MappedFileChannel(const TCHAR *pathName,
+                    size_t windowSize = DEFAULT_WINDOW_SIZE);
+  virtual ~MappedFileChannel();
+
+  // Returns size of the file (at the moment when it was opened).
+  UINT64 getSize() const;
+
+  // Returns current position in the file.
+  UINT64 getPosition() const;
+
+  // Puts pointer to file data at current position to data argument and
+  // moves position forward. Returns count of bytes that can be read from
+  // the pointer: not more than len, it's less at end of mapped window,
+  // zero at end of file.
+  // Data is valid until next call of any method of the channel.
+  size_t map(const char **data, size_t len) throw(IOException);
+
+  // Inherited from FileChannel.
+  virtual void seek(INT64 n);
+
+  // Inherited from Channel.
+  // Throws EOFException at end of file.
+  virtual size_t read(void *buffer, size_t len);
+
+  // Inherited from Channel.
+  // Always throws IOException, the channel is read-only.
+  virtual size_t write(const void *buffer, size_t len);
+
+  // Inherited from Channel.
+  virtual void close() throw(Exception);
+
+  static const size_t DEFAULT_WINDOW_SIZE = 16 * 1024 * 1024;
+
+private:
+  // Maps window of the file that contains current position.
+  void mapWindow() throw(IOException);
+  void unmapWindow();
+
+  // Throws IOException with description of the last system error.
+  static void throwSystemError() throw(IOException);
+
+#ifdef _WIN32
+  // Reads window of the file to m_buffer when the file is not mapped.
+  void readWindow(UINT64 offset, size_t length) throw(IOException);
+
+  // Reads one byte of every page of the data, so that the pages are read
+  // from the file. Returns false on EXCEPTION_IN_PAGE_ERROR.
+  static bool touchPages(const char *data, size_t len, size_t pageSize);
+
+  // Returns true if the file is on a local fixed disk and can be mapped.
+  static bool isMappable(const TCHAR *pathName);
+
+  HANDLE m_file;
+  HANDLE m_mapping;
+  // Set when the file is read to m_buffer instead of mapping.
+  bool m_buffered;
+  std::vector<char> m_buffer;
+  size_t m_pageSize;
+#else
+  int m_file;
+#endif
+
+  // Mapped part of the file
+  char *m_window;
+  UINT64 m_windowOffset;
+  size_t m_windowLength;
+
+  UINT64 m_size;
+  UINT64 m_position;
+  size_t m_windowSize;
+  // Offset of window must be multiple of this value
+  size_t m_granularity;
+};
+
+#endif // __MAPPEDFILECHANNEL_H__
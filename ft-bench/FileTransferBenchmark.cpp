@@ -0,0 +1,456 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "FileTransferBenchmark.h"
+
+#include <algorithm>
+
+#include "file-lib/File.h"
+#include "file-lib/WinFileChannel.h"
+#include "io-lib/DataOutputStream.h"
+#include "util/Exception.h"
+
+FileTransferBenchmark::FileTransferBenchmark(unsigned int latency,
+                                             unsigned int bandwidth)
+: FileTransferInterface(&m_ftCore),
+  m_log(0),
+  m_clientToServer(latency, bandwidth),
+  m_serverToClient(latency, bandwidth),
+  m_clientInput(&m_serverToClient),
+  m_clientOutput(&m_clientToServer),
+  m_requestSender(&m_log),
+  m_replyBuffer(&m_log),
+  m_ftCore(&m_log, &m_requestSender, &m_replyBuffer, &m_messageProcessor),
+  m_serverInput(&m_clientToServer),
+  m_serverOutput(&m_serverToClient),
+  m_dispatcher(0),
+  m_registrator(0),
+  m_requestHandler(0),
+  m_finishedState(0),
+  m_finishedResult(0),
+  m_operationFailed(false),
+  m_folders(0),
+  m_files(0),
+  m_fileSize(0),
+  m_passes(0),
+  m_startBytesToServer(0),
+  m_startBytesToViewer(0),
+  m_ticksPerSecond(1),
+  m_latency(latency),
+  m_bandwidth(bandwidth)
+{
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+
+  // Viewer side, the same way as FileTransferCapability connects it.
+  m_messageProcessor.addListener(&m_replyBuffer);
+  m_requestSender.setOutput(&m_clientOutput);
+  m_ftCore.setInterface(this);
+
+  // Server side, the same way as RfbClient connects it.
+  m_dispatcher = new RfbDispatcher(&m_serverInput, &m_dispatcherTerminated);
+  m_registrator = new RfbCodeRegistrator(m_dispatcher, &m_srvToClCaps,
+                                         &m_clToSrvCaps, &m_encCaps);
+  m_requestHandler = new FileTransferRequestHandler(m_registrator,
+                                                    &m_serverOutput,
+                                                    0, &m_log, true);
+
+  m_dispatcher->resume();
+  resume();
+}
+
+FileTransferBenchmark::~FileTransferBenchmark()
+{
+  // Closing of the link breaks both reading threads.
+  m_clientToServer.close();
+  m_serverToClient.close();
+
+  terminate();
+  wait();
+
+  delete m_dispatcher;
+  delete m_requestHandler;
+  delete m_registrator;
+}
+
+void FileTransferBenchmark::disableMessage(UINT32 code)
+{
+  m_disabledMessages.push_back(code);
+}
+
+void FileTransferBenchmark::run(const TCHAR *workFolder, unsigned int folders,
+                                unsigned int files, unsigned int fileSize,
+                                unsigned int passes)
+{
+  m_uploadStats = OperationStats();
+  m_reuploadStats = OperationStats();
+  m_listStats = OperationStats();
+  m_downloadStats = OperationStats();
+  m_removeStats = OperationStats();
+  m_folders = folders;
+  m_files = files;
+  m_fileSize = fileSize;
+  m_passes = passes;
+  m_startBytesToServer = m_clientToServer.getBytesWritten();
+  m_startBytesToViewer = m_serverToClient.getBytesWritten();
+
+  // Both sides are known, so the capabilities are taken without handshake.
+  std::vector<UINT32> clientCodes;
+  std::vector<UINT32> serverCodes;
+  m_clToSrvCaps.getCodes(&clientCodes);
+  m_srvToClCaps.getCodes(&serverCodes);
+  for (size_t i = 0; i < m_disabledMessages.size(); i++) {
+    clientCodes.erase(std::remove(clientCodes.begin(), clientCodes.end(),
+                                  m_disabledMessages[i]),
+                      clientCodes.end());
+  }
+  m_ftCore.updateSupportedOperations(&clientCodes, &serverCodes);
+
+  //
+  // Generate the tree
+  //
+
+  StringStorage localRoot;
+  StringStorage remoteRoot;
+  StringStorage downloadRoot;
+  StringStorage treeRoot;
+  localRoot.format(_T("%s\\local"), workFolder);
+  remoteRoot.format(_T("%s\\remote"), workFolder);
+  downloadRoot.format(_T("%s\\download"), workFolder);
+  treeRoot.format(_T("%s\\tree"), localRoot.getString());
+
+  createFolder(workFolder);
+  createFolder(localRoot.getString());
+  createFolder(remoteRoot.getString());
+  createFolder(downloadRoot.getString());
+  createFolder(treeRoot.getString());
+
+  for (unsigned int i = 0; i < folders; i++) {
+    StringStorage folder;
+    folder.format(_T("%s\\folder%u"), treeRoot.getString(), i);
+    createFolder(folder.getString());
+    for (unsigned int j = 0; j < files; j++) {
+      StringStorage file;
+      file.format(_T("%s\\file%u.dat"), folder.getString(), j);
+      createFile(file.getString(), fileSize, i * files + j);
+    }
+  }
+
+  UINT64 totalFiles = (UINT64)folders * files;
+  UINT64 totalBytes = totalFiles * fileSize;
+
+  //
+  // Run the operations
+  //
+
+  StringStorage remoteTree;
+  remoteTree.format(_T("%s\\tree"), remoteRoot.getString());
+
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    upload(localRoot.getString(), remoteRoot.getString(),
+           totalFiles, totalBytes, &m_uploadStats);
+    upload(localRoot.getString(), remoteRoot.getString(),
+           totalFiles, totalBytes, &m_reuploadStats);
+
+    listFolder(remoteTree.getString());
+    for (unsigned int i = 0; i < folders; i++) {
+      StringStorage folder;
+      folder.format(_T("%s\\folder%u"), remoteTree.getString(), i);
+      listFolder(folder.getString());
+    }
+
+    download(remoteRoot.getString(), downloadRoot.getString(),
+             totalFiles, totalBytes);
+    removeRemote(remoteRoot.getString(), totalFiles);
+    removeLocal(downloadRoot.getString());
+  }
+}
+
+void FileTransferBenchmark::printReport(FILE *out)
+{
+  _ftprintf(out, _T("Tree:     %u folders x %u files x %u bytes, %u passes\n"),
+            m_folders, m_files, m_fileSize, m_passes);
+  if (m_bandwidth != 0) {
+    _ftprintf(out, _T("Link:     %u ms latency, %u KB/s\n"),
+              m_latency, m_bandwidth / 1024);
+  } else {
+    _ftprintf(out, _T("Link:     %u ms latency, unlimited bandwidth\n"),
+              m_latency);
+  }
+  _ftprintf(out, _T("Traffic:  %.2f MB to server, %.2f MB to viewer\n"),
+            (double)(m_clientToServer.getBytesWritten() -
+                     m_startBytesToServer) / (1024 * 1024),
+            (double)(m_serverToClient.getBytesWritten() -
+                     m_startBytesToViewer) / (1024 * 1024));
+  _ftprintf(out, _T("\n"));
+
+  _ftprintf(out, _T("%-10s %6s %6s %10s %10s %10s %9s %10s %9s\n"),
+            _T("operation"), _T("runs"), _T("failed"), _T("files"),
+            _T("MB"), _T("time,ms"), _T("MB/s"), _T("files/s"),
+            _T("ops/s"));
+  printStats(out, _T("upload"), &m_uploadStats);
+  printStats(out, _T("reupload"), &m_reuploadStats);
+  printStats(out, _T("list"), &m_listStats);
+  printStats(out, _T("download"), &m_downloadStats);
+  printStats(out, _T("remove"), &m_removeStats);
+}
+
+void FileTransferBenchmark::execute()
+{
+  try {
+    while (!isTerminating()) {
+      // File transfer messages are TightVNC extension messages, so they
+      // all have four byte codes.
+      UINT32 code = m_clientInput.readUInt32();
+      m_messageProcessor.processRfbMessage(&m_clientInput, code);
+    }
+  } catch (Exception &e) {
+    if (!isTerminating()) {
+      _ftprintf(stderr, _T("Reading of server messages failed: %s\n"),
+                e.getMessage());
+      // Do not leave the benchmark waiting for the operation forever.
+      m_operationFailed = true;
+      m_operationFinished.notify();
+    }
+  }
+}
+
+INT64 FileTransferBenchmark::waitForOperation()
+{
+  m_operationFinished.waitForEvent();
+  INT64 finishTicks = getTicks();
+
+  // The same as FileTransferMainDialog does on the operation end.
+  m_ftCore.onOperationFinished();
+  m_ftCore.onUpdateState(m_finishedState, m_finishedResult);
+
+  return finishTicks;
+}
+
+void FileTransferBenchmark::upload(const TCHAR *localFolder,
+                                   const TCHAR *remoteFolder,
+                                   UINT64 files, UINT64 bytes,
+                                   OperationStats *stats)
+{
+  FileInfo tree(0, 0, FileInfo::DIRECTORY, _T("tree"));
+  StringStorage remotePath;
+  getRemotePath(remoteFolder, &remotePath);
+
+  m_operationFailed = false;
+  INT64 startTicks = getTicks();
+  m_ftCore.uploadOperation(&tree, 1, localFolder, remotePath.getString());
+  addStats(stats, files, bytes, waitForOperation() - startTicks);
+}
+
+void FileTransferBenchmark::listFolder(const TCHAR *remoteFolder)
+{
+  StringStorage remotePath;
+  getRemotePath(remoteFolder, &remotePath);
+
+  m_operationFailed = false;
+  INT64 startTicks = getTicks();
+  m_ftCore.remoteFileListOperation(remotePath.getString());
+  INT64 ticks = waitForOperation() - startTicks;
+
+  UINT64 files = 0;
+  bool isNewList;
+  vector<FileInfo> *page;
+  while ((page = m_ftCore.takeRemoteFileListPage(&isNewList)) != 0) {
+    files += page->size();
+  }
+  addStats(&m_listStats, files, 0, ticks);
+}
+
+void FileTransferBenchmark::download(const TCHAR *remoteFolder,
+                                     const TCHAR *localFolder,
+                                     UINT64 files, UINT64 bytes)
+{
+  FileInfo tree(0, 0, FileInfo::DIRECTORY, _T("tree"));
+  StringStorage remotePath;
+  getRemotePath(remoteFolder, &remotePath);
+
+  m_operationFailed = false;
+  INT64 startTicks = getTicks();
+  m_ftCore.downloadOperation(&tree, 1, localFolder, remotePath.getString());
+  addStats(&m_downloadStats, files, bytes, waitForOperation() - startTicks);
+}
+
+void FileTransferBenchmark::removeRemote(const TCHAR *remoteFolder,
+                                         UINT64 files)
+{
+  FileInfo tree(0, 0, FileInfo::DIRECTORY, _T("tree"));
+  StringStorage remotePath;
+  getRemotePath(remoteFolder, &remotePath);
+
+  m_operationFailed = false;
+  INT64 startTicks = getTicks();
+  m_ftCore.remoteFilesDeleteOperation(&tree, 1, remotePath.getString());
+  addStats(&m_removeStats, files, 0, waitForOperation() - startTicks);
+}
+
+void FileTransferBenchmark::removeLocal(const TCHAR *localFolder)
+{
+  FileInfo tree(0, 0, FileInfo::DIRECTORY, _T("tree"));
+
+  m_ftCore.localFilesDeleteOperation(&tree, 1, localFolder);
+  waitForOperation();
+}
+
+void FileTransferBenchmark::createFolder(const TCHAR *path)
+{
+  File folder(path);
+  if (!folder.isDirectory() && !folder.mkdir()) {
+    StringStorage errMess;
+    errMess.format(_T("Cannot create folder %s"), path);
+    throw Exception(errMess.getString());
+  }
+}
+
+void FileTransferBenchmark::createFile(const TCHAR *path, unsigned int size,
+                                       unsigned int seed)
+{
+  std::vector<char> data(size);
+  // Linear congruential generator, the data does not compress.
+  UINT32 state = seed * 2654435761U + 1;
+  for (size_t i = 0; i < data.size(); i++) {
+    state = state * 1103515245 + 12345;
+    data[i] = (char)(state >> 16);
+  }
+
+  WinFileChannel file(path, F_WRITE, FM_CREATE);
+  DataOutputStream output(&file);
+  if (!data.empty()) {
+    output.writeFully(&data.front(), data.size());
+  }
+}
+
+void FileTransferBenchmark::getRemotePath(const TCHAR *localPath,
+                                          StringStorage *remotePath)
+{
+  StringStorage path(localPath);
+  path.replaceChar(_T('\\'), _T('/'));
+  remotePath->format(_T("/%s"), path.getString());
+}
+
+INT64 FileTransferBenchmark::getTicks()
+{
+  LARGE_INTEGER counter;
+  if (QueryPerformanceCounter(&counter) == 0) {
+    return 0;
+  }
+  return counter.QuadPart;
+}
+
+void FileTransferBenchmark::addStats(OperationStats *stats, UINT64 files,
+                                     UINT64 bytes, INT64 ticks)
+{
+  stats->runs++;
+  stats->files += files;
+  stats->bytes += bytes;
+  stats->ticks += ticks;
+  if (m_operationFailed) {
+    stats->failed++;
+  }
+}
+
+void FileTransferBenchmark::printStats(FILE *out, const TCHAR *name,
+                                       const OperationStats *stats)
+{
+  double seconds = (double)stats->ticks / m_ticksPerSecond;
+  double megabytes = (double)stats->bytes / (1024 * 1024);
+  double mbPerSecond = 0;
+  double filesPerSecond = 0;
+  double opsPerSecond = 0;
+  if (seconds > 0) {
+    mbPerSecond = megabytes / seconds;
+    filesPerSecond = stats->files / seconds;
+    opsPerSecond = stats->runs / seconds;
+  }
+  _ftprintf(out, _T("%-10s %6u %6u %10I64u %10.2f %10.1f %9.2f %10.1f %9.2f\n"),
+            name, stats->runs, stats->failed, stats->files, megabytes,
+            seconds * 1000, mbPerSecond, filesPerSecond, opsPerSecond);
+}
+
+//
+// FileTransferInterface implementation. The benchmark overwrites existing
+// files and only counts errors.
+//
+
+int FileTransferBenchmark::onFtTargetFileExists(FileInfo *sourceFileInfo,
+                                                FileInfo *targetFileInfo,
+                                                const TCHAR *pathToTargetFile)
+{
+  return CopyFileEventListener::TFE_OVERWRITE;
+}
+
+void FileTransferBenchmark::setProgress(double progress)
+{
+}
+
+void FileTransferBenchmark::onFtOpError(const TCHAR *message)
+{
+  _ftprintf(stderr, _T("Error: %s\n"), message);
+  m_operationFailed = true;
+}
+
+void FileTransferBenchmark::onFtOpInfo(const TCHAR *message)
+{
+}
+
+void FileTransferBenchmark::onFtOpStarted()
+{
+}
+
+void FileTransferBenchmark::onFtOpFinished(int state, int result)
+{
+  m_finishedState = state;
+  m_finishedResult = result;
+  m_operationFinished.notify();
+}
+
+void FileTransferBenchmark::setNothingState()
+{
+}
+
+void FileTransferBenchmark::onRefreshLocalFileList()
+{
+}
+
+void FileTransferBenchmark::onRefreshRemoteFileList()
+{
+}
+
+void FileTransferBenchmark::onRemoteFileListPage()
+{
+}
+
+void FileTransferBenchmark::raise(Exception &ex)
+{
+  // The operation has failed to start, so it will not notify its end.
+  _ftprintf(stderr, _T("Error: %s\n"), ex.getMessage());
+  m_operationFailed = true;
+  m_operationFinished.notify();
+}
@@ -0,0 +1,199 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _FILE_TRANSFER_BENCHMARK_H_
+#define _FILE_TRANSFER_BENCHMARK_H_
+
+#include <vector>
+#include <stdio.h>
+
+#include "ft-client-lib/FileTransferCore.h"
+#include "ft-client-lib/FileTransferInterface.h"
+#include "ft-client-lib/FileTransferMessageProcessor.h"
+#include "ft-client-lib/FileTransferReplyBuffer.h"
+#include "ft-client-lib/FileTransferRequestSender.h"
+#include "ft-server-lib/FileTransferRequestHandler.h"
+#include "log-writer/LogWriter.h"
+#include "network/RfbInputGate.h"
+#include "network/RfbOutputGate.h"
+#include "rfb-sconn/CapContainer.h"
+#include "rfb-sconn/RfbCodeRegistrator.h"
+#include "rfb-sconn/RfbDispatcher.h"
+#include "thread/Thread.h"
+#include "win-system/WindowsEvent.h"
+#include "LoopbackChannel.h"
+
+//
+// FileTransferBenchmark connects the viewer side of file transfers
+// (FileTransferCore) to the server side (FileTransferRequestHandler) in
+// one process through a pair of loopback channels with the given latency
+// and bandwidth. It generates a tree of files, then uploads it, uploads
+// it again over the existing files (that is where delta upload works),
+// lists the uploaded folders, downloads the tree back and deletes it on
+// the "remote" side, measuring each operation.
+//
+// Both sides work with folders of the local file system, so the results
+// include the disk time as well.
+//
+
+class FileTransferBenchmark : public FileTransferInterface,
+                              private Thread
+{
+public:
+  // latency is one-way delay of the link in milliseconds, bandwidth is
+  // in bytes per second (zero means unlimited).
+  FileTransferBenchmark(unsigned int latency, unsigned int bandwidth);
+  virtual ~FileTransferBenchmark();
+
+  // Stops using of the client to server message by the viewer side, so
+  // that protocol extensions (e.g. pipelined download) can be compared
+  // with the basic protocol. Must be called before run().
+  void disableMessage(UINT32 code);
+
+  // Generates a tree of folders x files files with fileSize bytes
+  // each in workFolder and runs passes of the operations over it.
+  // Statistics of the previous run are dropped.
+  // Throws Exception on a file system error.
+  void run(const TCHAR *workFolder, unsigned int folders,
+           unsigned int files, unsigned int fileSize, unsigned int passes);
+
+  // Prints the statistics of the last run() call.
+  void printReport(FILE *out);
+
+protected:
+  struct OperationStats
+  {
+    OperationStats() : runs(0), files(0), bytes(0), ticks(0), failed(0) {}
+
+    unsigned int runs;
+    UINT64 files;
+    UINT64 bytes;
+    INT64 ticks;
+    unsigned int failed;
+  };
+
+  // Reads server to client messages and passes them to the viewer side.
+  virtual void execute();
+
+  // Waits for the end of the operation that is started already,
+  // returns the time (in ticks) when it has finished.
+  INT64 waitForOperation();
+
+  void upload(const TCHAR *localFolder, const TCHAR *remoteFolder,
+              UINT64 files, UINT64 bytes, OperationStats *stats);
+  void listFolder(const TCHAR *remoteFolder);
+  void download(const TCHAR *remoteFolder, const TCHAR *localFolder,
+                UINT64 files, UINT64 bytes);
+  void removeRemote(const TCHAR *remoteFolder, UINT64 files);
+  void removeLocal(const TCHAR *localFolder);
+
+  static void createFolder(const TCHAR *path);
+  static void createFile(const TCHAR *path, unsigned int size,
+                         unsigned int seed);
+  // Converts local path to path in the file transfer protocol.
+  static void getRemotePath(const TCHAR *localPath, StringStorage *remotePath);
+
+  static INT64 getTicks();
+  void addStats(OperationStats *stats, UINT64 files, UINT64 bytes,
+                INT64 ticks);
+  void printStats(FILE *out, const TCHAR *name, const OperationStats *stats);
+
+  //
+  // Inherited from FileTransferInterface.
+  //
+
+  virtual int onFtTargetFileExists(FileInfo *sourceFileInfo,
+                                   FileInfo *targetFileInfo,
+                                   const TCHAR *pathToTargetFile);
+  virtual void setProgress(double progress);
+  virtual void onFtOpError(const TCHAR *message);
+  virtual void onFtOpInfo(const TCHAR *message);
+  virtual void onFtOpStarted();
+  virtual void onFtOpFinished(int state, int result);
+  virtual void setNothingState();
+  virtual void onRefreshLocalFileList();
+  virtual void onRefreshRemoteFileList();
+  virtual void onRemoteFileListPage();
+  virtual void raise(Exception &ex);
+
+  LogWriter m_log;
+
+  // Link between the sides
+  LoopbackChannel m_clientToServer;
+  LoopbackChannel m_serverToClient;
+
+  //
+  // Viewer side
+  //
+
+  RfbInputGate m_clientInput;
+  RfbOutputGate m_clientOutput;
+  FileTransferRequestSender m_requestSender;
+  FileTransferReplyBuffer m_replyBuffer;
+  FileTransferMessageProcessor m_messageProcessor;
+  FileTransferCore m_ftCore;
+  std::vector<UINT32> m_disabledMessages;
+
+  //
+  // Server side
+  //
+
+  RfbInputGate m_serverInput;
+  RfbOutputGate m_serverOutput;
+  CapContainer m_srvToClCaps;
+  CapContainer m_clToSrvCaps;
+  CapContainer m_encCaps;
+  WindowsEvent m_dispatcherTerminated;
+  RfbDispatcher *m_dispatcher;
+  RfbCodeRegistrator *m_registrator;
+  FileTransferRequestHandler *m_requestHandler;
+
+  // Notified when the current operation is finished.
+  WindowsEvent m_operationFinished;
+  int m_finishedState;
+  int m_finishedResult;
+  // Set when the current operation has reported an error.
+  bool m_operationFailed;
+
+  OperationStats m_uploadStats;
+  OperationStats m_reuploadStats;
+  OperationStats m_listStats;
+  OperationStats m_downloadStats;
+  OperationStats m_removeStats;
+
+  // Parameters of the last run
+  unsigned int m_folders;
+  unsigned int m_files;
+  unsigned int m_fileSize;
+  unsigned int m_passes;
+  // Traffic before the last run
+  UINT64 m_startBytesToServer;
+  UINT64 m_startBytesToViewer;
+
+  INT64 m_ticksPerSecond;
+  unsigned int m_latency;
+  unsigned int m_bandwidth;
+};
+
+#endif
@@ -0,0 +1,138 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoopbackChannel.h"
+
+#include "thread/AutoLock.h"
+#include "thread/Thread.h"
+
+LoopbackChannel::LoopbackChannel(unsigned int latency, unsigned int bandwidth)
+: m_isClosed(false),
+  m_latency((INT64)latency * 1000),
+  m_bandwidth(bandwidth),
+  m_linkFreeTime(0),
+  m_bytesWritten(0),
+  m_ticksPerSecond(1)
+{
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+}
+
+LoopbackChannel::~LoopbackChannel()
+{
+}
+
+UINT64 LoopbackChannel::getBytesWritten()
+{
+  AutoLock al(&m_lock);
+  return m_bytesWritten;
+}
+
+size_t LoopbackChannel::read(void *buffer, size_t len)
+{
+  while (true) {
+    DWORD timeout = INFINITE;
+    {
+      AutoLock al(&m_lock);
+      if (!m_packets.empty()) {
+        Packet *packet = &m_packets.front();
+        INT64 now = getTime();
+        if (packet->deliveryTime <= now) {
+          size_t count = min(len, packet->data.size() - packet->position);
+          memcpy(buffer, &packet->data[packet->position], count);
+          packet->position += count;
+          if (packet->position == packet->data.size()) {
+            m_packets.pop_front();
+          }
+          return count;
+        }
+        timeout = (DWORD)((packet->deliveryTime - now + 999) / 1000);
+      } else if (m_isClosed) {
+        throw IOException(_T("The loopback connection is closed"));
+      }
+    }
+    m_dataEvent.waitForEvent(timeout);
+  }
+}
+
+size_t LoopbackChannel::write(const void *buffer, size_t len)
+{
+  if (len == 0) {
+    return 0;
+  }
+
+  INT64 waitTime = 0;
+  {
+    AutoLock al(&m_lock);
+    if (m_isClosed) {
+      throw IOException(_T("The loopback connection is closed"));
+    }
+
+    INT64 now = getTime();
+    if (m_linkFreeTime < now) {
+      m_linkFreeTime = now;
+    }
+    if (m_bandwidth != 0) {
+      m_linkFreeTime += (INT64)len * 1000000 / m_bandwidth;
+      waitTime = m_linkFreeTime - now -
+                 (INT64)SEND_BUFFER_SIZE * 1000000 / m_bandwidth;
+    }
+
+    m_packets.push_back(Packet());
+    Packet *packet = &m_packets.back();
+    packet->deliveryTime = m_linkFreeTime + m_latency;
+    packet->data.assign((const char *)buffer, (const char *)buffer + len);
+    packet->position = 0;
+
+    m_bytesWritten += len;
+  }
+  m_dataEvent.notify();
+
+  // The send buffer is full, wait until the link transmits the excess.
+  if (waitTime >= 1000) {
+    Thread::sleep((DWORD)(waitTime / 1000));
+  }
+  return len;
+}
+
+void LoopbackChannel::close()
+{
+  {
+    AutoLock al(&m_lock);
+    m_isClosed = true;
+  }
+  m_dataEvent.notify();
+}
+
+INT64 LoopbackChannel::getTime() const
+{
+  LARGE_INTEGER counter;
+  if (QueryPerformanceCounter(&counter) == 0) {
+    return 0;
+  }
+  return counter.QuadPart / m_ticksPerSecond * 1000000 +
+         counter.QuadPart % m_ticksPerSecond * 1000000 / m_ticksPerSecond;
+}
@@ -0,0 +1,115 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _LOOPBACK_CHANNEL_H_
+#define _LOOPBACK_CHANNEL_H_
+
+#include <deque>
+#include <vector>
+
+#include "io-lib/Channel.h"
+#include "io-lib/IOException.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+/**
+ * One direction of an in-memory connection between two threads of the
+ * process. Data written to the channel can be read from it after the
+ * link latency, and the link passes not more than the given count of
+ * bytes per second. As with a socket, writing blocks while the link has
+ * more than a send buffer of data to transmit.
+ */
+class LoopbackChannel : public Channel
+{
+public:
+  /**
+   * Creates the channel.
+   * @param latency one-way delay of the link in milliseconds.
+   * @param bandwidth link bandwidth in bytes per second, zero means
+   * unlimited bandwidth.
+   */
+  LoopbackChannel(unsigned int latency, unsigned int bandwidth);
+  virtual ~LoopbackChannel();
+
+  /**
+   * Returns the number of bytes written to the channel.
+   */
+  UINT64 getBytesWritten();
+
+  /**
+   * Reads data that has passed the link, blocks until there is such data.
+   * @throws IOException when the channel is closed and all data is read.
+   */
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Puts data to the link.
+   * @throws IOException when the channel is closed.
+   */
+  virtual size_t write(const void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Closes the channel and wakes up a blocked reader.
+   */
+  virtual void close() throw(Exception);
+
+protected:
+  /**
+   * Data of one write() call.
+   */
+  struct Packet
+  {
+    // Time when the packet can be read, in microseconds.
+    INT64 deliveryTime;
+    std::vector<char> data;
+    size_t position;
+  };
+
+  /**
+   * Returns current time in microseconds.
+   */
+  INT64 getTime() const;
+
+  std::deque<Packet> m_packets;
+  LocalMutex m_lock;
+  // Notified when a packet is written or the channel is closed.
+  WindowsEvent m_dataEvent;
+  bool m_isClosed;
+
+  INT64 m_latency;
+  unsigned int m_bandwidth;
+  // Time when the link finishes transmitting of written data.
+  INT64 m_linkFreeTime;
+  UINT64 m_bytesWritten;
+
+  INT64 m_ticksPerSecond;
+
+  /**
+   * Amount of data that can wait for transmitting without blocking
+   * of the writer.
+   */
+  static const size_t SEND_BUFFER_SIZE = 64 * 1024;
+};
+
+#endif
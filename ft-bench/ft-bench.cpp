@@ -0,0 +1,125 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "FileTransferBenchmark.h"
+#include "ft-common/FTMessage.h"
+#include "server-config-lib/Configurator.h"
+#include "util/Exception.h"
+#include <stdio.h>
+
+static void printUsage()
+{
+  _ftprintf(stderr,
+            _T("Usage: ft-bench [options] <work folder>\n")
+            _T("  -latency <ms>       one-way link latency (default 0)\n")
+            _T("  -bandwidth <KB/s>   link bandwidth (default unlimited)\n")
+            _T("  -passes <n>         passes over every tree (default 3)\n")
+            _T("  -tree <F>x<N>x<S>   F folders of N files of S bytes,\n")
+            _T("                      can be repeated (default 16x64x4096\n")
+            _T("                      and 1x4x33554432)\n")
+            _T("  -disable <feature>  do not use window, batch, paged or\n")
+            _T("                      delta protocol extension\n"));
+}
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  unsigned int latency = 0;
+  unsigned int bandwidth = 0;
+  unsigned int passes = 3;
+  std::vector<unsigned int> trees;
+  std::vector<UINT32> disabledMessages;
+  const TCHAR *workFolder = 0;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (_tcscmp(argv[i], _T("-latency")) == 0 && hasValue) {
+      latency = _ttoi(argv[++i]);
+    } else if (_tcscmp(argv[i], _T("-bandwidth")) == 0 && hasValue) {
+      bandwidth = _ttoi(argv[++i]) * 1024;
+    } else if (_tcscmp(argv[i], _T("-passes")) == 0 && hasValue) {
+      passes = _ttoi(argv[++i]);
+    } else if (_tcscmp(argv[i], _T("-tree")) == 0 && hasValue) {
+      unsigned int folders, files, size;
+      if (_stscanf(argv[++i], _T("%ux%ux%u"), &folders, &files, &size) != 3) {
+        printUsage();
+        return 1;
+      }
+      trees.push_back(folders);
+      trees.push_back(files);
+      trees.push_back(size);
+    } else if (_tcscmp(argv[i], _T("-disable")) == 0 && hasValue) {
+      const TCHAR *feature = argv[++i];
+      if (_tcscmp(feature, _T("window")) == 0) {
+        disabledMessages.push_back(FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST);
+      } else if (_tcscmp(feature, _T("batch")) == 0) {
+        disabledMessages.push_back(FTMessage::UPLOAD_BATCH_REQUEST);
+        disabledMessages.push_back(FTMessage::DOWNLOAD_BATCH_REQUEST);
+      } else if (_tcscmp(feature, _T("paged")) == 0) {
+        disabledMessages.push_back(FTMessage::FILE_LIST_PAGED_REQUEST);
+      } else if (_tcscmp(feature, _T("delta")) == 0) {
+        disabledMessages.push_back(FTMessage::FILE_SIGNATURE_REQUEST);
+        disabledMessages.push_back(FTMessage::UPLOAD_COPY_REQUEST);
+      } else {
+        printUsage();
+        return 1;
+      }
+    } else if (argv[i][0] != _T('-') && workFolder == 0) {
+      workFolder = argv[i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (workFolder == 0) {
+    printUsage();
+    return 1;
+  }
+
+  if (trees.empty()) {
+    // Many small files, then a few large ones
+    unsigned int defaultTrees[] = { 16, 64, 4096, 1, 4, 32 * 1024 * 1024 };
+    trees.assign(defaultTrees, defaultTrees + 6);
+  }
+
+  try {
+    // The request handler checks the server configuration
+    Configurator configurator(false);
+
+    FileTransferBenchmark benchmark(latency, bandwidth);
+    for (size_t i = 0; i < disabledMessages.size(); i++) {
+      benchmark.disableMessage(disabledMessages[i]);
+    }
+    for (size_t i = 0; i + 2 < trees.size(); i += 3) {
+      _ftprintf(stderr, _T("Running %ux%ux%u tree\n"),
+                trees[i], trees[i + 1], trees[i + 2]);
+      benchmark.run(workFolder, trees[i], trees[i + 1], trees[i + 2], passes);
+      benchmark.printReport(stdout);
+      _ftprintf(stdout, _T("\n"));
+    }
+  } catch (Exception &e) {
+    _ftprintf(stderr, _T("Error: %s\n"), e.getMessage());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,285 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "DeltaEncoder.h"
+
+#include "util/md5.h"
+
+#include <string.h>
+
+DeltaEncoder::DeltaEncoder(const FileSignature *signature,
+                           UINT32 maxLiteralSize)
+: m_signature(*signature),
+  m_blockSize(signature->getBlockSize()),
+  m_lastBlockLength(0),
+  m_maxLiteralSize(maxLiteralSize),
+  m_position(0),
+  m_literalStart(0),
+  m_isChecksumValid(false),
+  m_copyOffset(0),
+  m_copyLength(0),
+  m_isFinished(false),
+  m_literalBytes(0),
+  m_copiedBytes(0)
+{
+  size_t blockCount = signature->getBlockCount();
+
+  m_blockTags.resize(0x10000);
+
+  for (size_t i = 0; i < blockCount; i++) {
+    UINT32 weakSum = signature->getWeakSum(i);
+    m_blocks.insert(std::make_pair(weakSum, i));
+    m_blockTags[(weakSum ^ (weakSum >> 16)) & 0xffff] = true;
+  }
+
+  if (blockCount != 0) {
+    m_lastBlockLength = signature->getBlockLength(blockCount - 1);
+  }
+}
+
+DeltaEncoder::~DeltaEncoder()
+{
+  while (!m_operations.empty()) {
+    delete m_operations.front();
+    m_operations.pop_front();
+  }
+}
+
+void DeltaEncoder::setMaxLiteralSize(UINT32 maxLiteralSize)
+{
+  m_maxLiteralSize = maxLiteralSize;
+}
+
+void DeltaEncoder::addData(const char *data, size_t size)
+{
+  _ASSERT(!m_isFinished);
+
+  //
+  // Drop data that is already encoded
+  //
+
+  if (m_literalStart != 0) {
+    m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_literalStart);
+    m_position -= m_literalStart;
+    m_literalStart = 0;
+  }
+
+  m_buffer.insert(m_buffer.end(), data, data + size);
+
+  process(false);
+}
+
+void DeltaEncoder::finish()
+{
+  process(true);
+
+  m_isFinished = true;
+}
+
+bool DeltaEncoder::getOperation(DeltaOperation *operation)
+{
+  if (m_operations.empty()) {
+    return false;
+  }
+
+  DeltaOperation *front = m_operations.front();
+  m_operations.pop_front();
+
+  operation->literal.swap(front->literal);
+  operation->copyOffset = front->copyOffset;
+  operation->copyLength = front->copyLength;
+
+  delete front;
+
+  return true;
+}
+
+bool DeltaEncoder::isFinished() const
+{
+  return m_isFinished && m_operations.empty();
+}
+
+UINT64 DeltaEncoder::getLiteralBytes() const
+{
+  return m_literalBytes;
+}
+
+UINT64 DeltaEncoder::getCopiedBytes() const
+{
+  return m_copiedBytes;
+}
+
+void DeltaEncoder::process(bool isFinal)
+{
+  size_t size = m_buffer.size();
+
+  //
+  // Slide window of block size along new data until it matches a block
+  // of old file.
+  //
+
+  while (m_blockSize != 0 && size - m_position >= m_blockSize) {
+    if (!m_isChecksumValid) {
+      m_checksum.reset(&m_buffer[m_position], m_blockSize);
+      m_isChecksumValid = true;
+    }
+
+    INT64 block = findBlock(m_checksum.getValue(), &m_buffer[m_position],
+                            m_blockSize);
+    if (block >= 0) {
+      flushLiteral(m_position);
+      addCopy(m_signature.getBlockOffset((size_t)block), m_blockSize);
+
+      m_position += m_blockSize;
+      m_literalStart = m_position;
+      m_isChecksumValid = false;
+      continue;
+    }
+
+    if (size - m_position == m_blockSize) {
+      // Need more data to move the window
+      break;
+    }
+
+    m_checksum.roll(m_buffer[m_position], m_buffer[m_position + m_blockSize]);
+    m_position++;
+
+    if (m_position - m_literalStart >= m_maxLiteralSize) {
+      flushLiteral(m_position);
+    }
+  }
+
+  if (!isFinal) {
+    return ;
+  }
+
+  //
+  // Tail of new file can match the last (short) block of old file
+  //
+
+  if (m_lastBlockLength != 0 && m_lastBlockLength < m_blockSize &&
+      size - m_position >= m_lastBlockLength) {
+    size_t tail = size - m_lastBlockLength;
+    UINT32 weakSum = RollingChecksum::calculate(&m_buffer[tail],
+                                                m_lastBlockLength);
+    INT64 block = findBlock(weakSum, &m_buffer[tail], m_lastBlockLength);
+    if (block >= 0) {
+      flushLiteral(tail);
+      addCopy(m_signature.getBlockOffset((size_t)block), m_lastBlockLength);
+      m_literalStart = size;
+    }
+  }
+
+  flushLiteral(size);
+  flushCopy();
+
+  m_buffer.clear();
+  m_position = 0;
+  m_literalStart = 0;
+}
+
+INT64 DeltaEncoder::findBlock(UINT32 weakSum, const char *data, UINT32 length)
+{
+  if (!m_blockTags[(weakSum ^ (weakSum >> 16)) & 0xffff]) {
+    return -1;
+  }
+
+  std::multimap<UINT32, size_t>::const_iterator it = m_blocks.find(weakSum);
+
+  if (it == m_blocks.end()) {
+    return -1;
+  }
+
+  bool isHashed = false;
+  MD5 md5;
+
+  for (; it != m_blocks.end() && it->first == weakSum; it++) {
+    size_t index = it->second;
+
+    if (m_signature.getBlockLength(index) != length) {
+      continue;
+    }
+
+    if (!isHashed) {
+      md5.update(data, length);
+      md5.finalize();
+      isHashed = true;
+    }
+
+    if (memcmp(md5.getHash(), m_signature.getStrongSum(index),
+               FileSignature::STRONG_SUM_SIZE) == 0) {
+      return (INT64)index;
+    }
+  }
+
+  return -1;
+}
+
+void DeltaEncoder::flushLiteral(size_t end)
+{
+  if (end <= m_literalStart) {
+    return ;
+  }
+
+  flushCopy();
+
+  DeltaOperation *operation = new DeltaOperation;
+  operation->literal.assign(m_buffer.begin() + m_literalStart,
+                            m_buffer.begin() + end);
+  operation->copyOffset = 0;
+  operation->copyLength = 0;
+  m_operations.push_back(operation);
+
+  m_literalBytes += end - m_literalStart;
+  m_literalStart = end;
+}
+
+void DeltaEncoder::addCopy(UINT64 offset, UINT64 length)
+{
+  m_copiedBytes += length;
+
+  if (m_copyLength != 0 && m_copyOffset + m_copyLength == offset &&
+      m_copyLength + length <= MAX_COPY_LENGTH) {
+    m_copyLength += length;
+    return ;
+  }
+
+  flushCopy();
+
+  m_copyOffset = offset;
+  m_copyLength = length;
+}
+
+void DeltaEncoder::flushCopy()
+{
+  if (m_copyLength == 0) {
+    return ;
+  }
+
+  DeltaOperation *operation = new DeltaOperation;
+  operation->copyOffset = m_copyOffset;
+  operation->copyLength = m_copyLength;
+  m_operations.push_back(operation);
+
+  m_copyLength = 0;
+}
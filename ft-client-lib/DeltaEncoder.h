@@ -0,0 +1,150 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _DELTA_ENCODER_H_
+#define _DELTA_ENCODER_H_
+
+#include "util/inttypes.h"
+#include "ft-common/FileSignature.h"
+#include "ft-common/RollingChecksum.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+//
+// Part of delta encoded file: either literal data or range of the old
+// version of file (described by signature) that must be copied.
+//
+
+struct DeltaOperation
+{
+  // Literal data (empty for copy operation)
+  std::vector<char> literal;
+  // Range of old file to copy (zero length for literal operation)
+  UINT64 copyOffset;
+  UINT64 copyLength;
+};
+
+//
+// Encodes new version of file as difference from old version of the file
+// that is known only by its signature (rsync algorithm).
+//
+// Data of new file is passed sequentially by addData(), resulting
+// operations are taken by getOperation() in the same order.
+//
+
+class DeltaEncoder
+{
+public:
+
+  //
+  // Parameters:
+  //
+  // [IN] signature - signature of old version of file (it's copied)
+  // [IN] maxLiteralSize - maximal size of literal operation
+  //
+
+  DeltaEncoder(const FileSignature *signature, UINT32 maxLiteralSize);
+
+  virtual ~DeltaEncoder();
+
+  // Changes maximal size of literal operations that will be created
+  void setMaxLiteralSize(UINT32 maxLiteralSize);
+
+  // Passes next part of new file data
+  void addData(const char *data, size_t size);
+
+  // Must be called when all data of new file is passed
+  void finish();
+
+  //
+  // Moves next ready operation to the operation argument.
+  // Returns false if there is no ready operation.
+  //
+
+  bool getOperation(DeltaOperation *operation);
+
+  //
+  // Returns true if finish() is called and all operations are taken.
+  //
+
+  bool isFinished() const;
+
+  // Returns count of bytes of new file that are sent as literals
+  UINT64 getLiteralBytes() const;
+  // Returns count of bytes of new file that are copied from old file
+  UINT64 getCopiedBytes() const;
+
+protected:
+  // Encodes buffered data of new file, keeps the last window unencoded
+  // until more data is passed unless isFinal is true
+  void process(bool isFinal);
+
+  // Returns index of block of old file that is equal to specified data
+  // or -1 if there is no such block
+  INT64 findBlock(UINT32 weakSum, const char *data, UINT32 length);
+
+  // Creates literal operation from data up to specified position
+  void flushLiteral(size_t end);
+
+  // Adds copy operation (adjacent copies are merged)
+  void addCopy(UINT64 offset, UINT64 length);
+  void flushCopy();
+
+  FileSignature m_signature;
+  UINT32 m_blockSize;
+  UINT32 m_lastBlockLength;
+  UINT32 m_maxLiteralSize;
+
+  // Blocks of old file by their weak checksums
+  std::multimap<UINT32, size_t> m_blocks;
+  // Bit for every 16 bit hash of weak checksums of blocks, allows to
+  // skip most of lookups in m_blocks
+  std::vector<bool> m_blockTags;
+
+  // Data of new file that is not encoded yet
+  std::vector<char> m_buffer;
+  // Position of window in m_buffer
+  size_t m_position;
+  // Beginning of literal data that precedes window
+  size_t m_literalStart;
+  // Checksum of window
+  RollingChecksum m_checksum;
+  bool m_isChecksumValid;
+
+  // Copy that can be merged with the next one
+  UINT64 m_copyOffset;
+  UINT64 m_copyLength;
+
+  std::deque<DeltaOperation *> m_operations;
+
+  // Adjacent copies are merged up to this length
+  static const UINT64 MAX_COPY_LENGTH = 64 * 1024 * 1024;
+  bool m_isFinished;
+
+  UINT64 m_literalBytes;
+  UINT64 m_copiedBytes;
+};
+
+#endif
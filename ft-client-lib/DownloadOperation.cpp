@@ -24,6 +24,8 @@
 
 #include "DownloadOperation.h"
 
+#include "io-lib/ByteArrayInputStream.h"
+
 DownloadOperation::DownloadOperation(LogWriter *logWriter,
                                      const FileInfo *filesToDownload,
                                      size_t filesCount,
@@ -32,7 +34,14 @@ DownloadOperation::DownloadOperation(LogWriter *logWriter,
 : CopyOperation(logWriter),
   m_file(0),
   m_fos(0),
-  m_fileOffset(0)
+  m_fileOffset(0),
+  m_windowSupported(false),
+  m_window(1, MIN_CHUNK_SIZE, MIN_CHUNK_SIZE),
+  m_isDraining(false),
+  m_batchSupported(false),
+  m_batchSize(0),
+  m_batchRequestPending(false),
+  m_hasDeferredDownload(false)
 {
   m_pathToSourceRoot.setString(pathToSourceRoot);
   m_pathToTargetRoot.setString(pathToTargetRoot);
@@ -56,6 +65,22 @@ DownloadOperation::~DownloadOperation()
   }
 }
 
+void DownloadOperation::setWindowSupported(bool windowSupported)
+{
+  m_windowSupported = windowSupported;
+
+  if (m_windowSupported) {
+    m_window.setLimits(WINDOW_SIZE, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE);
+  } else {
+    m_window.setLimits(1, MIN_CHUNK_SIZE, MIN_CHUNK_SIZE);
+  }
+}
+
+void DownloadOperation::setBatchSupported(bool batchSupported)
+{
+  m_batchSupported = batchSupported;
+}
+
 void DownloadOperation::start()
 {
   m_foldersToCalcSizeLeft = 0;
@@ -128,24 +153,27 @@ void DownloadOperation::onDownloadReply(DataInputStream *input)
   }
 
   //
-  // Send first request for file data
+  // Send first requests for file data
   //
 
-  UINT32 dataSize = 1024 * 8;
-  bool compression = m_replyBuffer->isCompressionSupported();
+  m_window.reset();
 
-  m_sender->sendDownloadDataRequest(dataSize,
-                                    compression);
+  sendDataRequests();
 }
 
 void DownloadOperation::onDownloadDataReply(DataInputStream *input)
 {
-  if (isTerminating()) {
-    gotoNext();
+  m_window.replyReceived(m_replyBuffer->getDownloadBufferSize());
+
+  if (m_isDraining) {
+    continueDrain();
     return ;
   }
 
-  UINT32 bufferSize = 1024 * 8;
+  if (isTerminating()) {
+    startDrain();
+    return ;
+  }
 
   try {
     DataOutputStream dos(m_fos);
@@ -155,7 +183,7 @@ void DownloadOperation::onDownloadDataReply(DataInputStream *input)
     }
   } catch (IOException &ioEx) {
     notifyFailedToDownload(ioEx.getMessage());
-    gotoNext();
+    startDrain();
     return ;
   }
 
@@ -170,16 +198,21 @@ void DownloadOperation::onDownloadDataReply(DataInputStream *input)
   }
 
   //
-  // Send next download data request
+  // Send next download data requests
   //
 
-  bool compression = m_replyBuffer->isCompressionSupported();
-
-  m_sender->sendDownloadDataRequest(bufferSize, compression);
+  sendDataRequests();
 }
 
 void DownloadOperation::onDownloadEndReply(DataInputStream *input)
 {
+  m_window.replyReceived(0);
+
+  if (m_isDraining) {
+    continueDrain();
+    return ;
+  }
+
   //
   // Cleanup
   //
@@ -197,11 +230,114 @@ void DownloadOperation::onDownloadEndReply(DataInputStream *input)
   delete m_file;
   m_file = NULL;
 
-  gotoNext();
+  // Other outstanding requests will be replied with end of download too
+  startDrain();
+}
+
+void DownloadOperation::onDownloadBatchReply(DataInputStream *input)
+{
+  m_batchRequestPending = false;
+
+  //
+  // Write received files, files are matched with the requested ones
+  // by their remote paths
+  //
+
+  const vector<UINT8> *data = m_replyBuffer->getDownloadBatchData();
+  ByteArrayInputStream batchStream(data->empty() ? NULL : (const char *)&data->front(),
+                                   data->size());
+  DataInputStream batchInput(&batchStream);
+
+  std::vector<char> content;
+  size_t nextIndex = 0;
+
+  for (UINT32 i = 0; i < m_replyBuffer->getDownloadBatchFilesCount(); i++) {
+    StringStorage pathToSourceFile;
+    UINT64 modificationTime;
+    UINT32 fileSize;
+
+    batchInput.readUTF8(&pathToSourceFile);
+    modificationTime = batchInput.readUInt64();
+    fileSize = batchInput.readUInt32();
+    content.resize(fileSize);
+    if (fileSize != 0) {
+      batchInput.readFully(&content.front(), fileSize);
+    }
+
+    size_t index = nextIndex;
+    while (index < m_batchSources.size() &&
+           !m_batchSources[index].isEqualTo(&pathToSourceFile)) {
+      index++;
+    }
+    if (index == m_batchSources.size()) {
+      throw IOException(_T("Unexpected file in download batch reply"));
+    }
+    nextIndex = index + 1;
+
+    try {
+      writeBatchFile(m_batchTargets[index].getString(), modificationTime,
+                     content.empty() ? NULL : &content.front(), fileSize);
+    } catch (Exception &ex) {
+      StringStorage message;
+
+      message.format(_T("Error: failed to download '%s' (%s)"),
+                     pathToSourceFile.getString(), ex.getMessage());
+
+      notifyError(message.getString());
+    }
+
+    m_totalBytesCopied += fileSize;
+  }
+
+  const vector<StringStorage> *failedFiles = m_replyBuffer->getBatchFailedFiles();
+  const vector<StringStorage> *errors = m_replyBuffer->getBatchErrors();
+
+  for (size_t i = 0; i < failedFiles->size(); i++) {
+    StringStorage message;
+
+    message.format(_T("Error: failed to download '%s' (%s)"),
+                   (*failedFiles)[i].getString(),
+                   (*errors)[i].getString());
+
+    notifyError(message.getString());
+  }
+
+  m_batchSources.clear();
+  m_batchTargets.clear();
+  m_batchSize = 0;
+
+  // Notify that we receive some data
+  if (m_copyListener != NULL) {
+    m_copyListener->dataChunkCopied(m_totalBytesCopied, m_totalBytesToCopy);
+  }
+
+  continueAfterBatch();
 }
 
 void DownloadOperation::onLastRequestFailedReply(DataInputStream *input)
 {
+  //
+  // Server cannot process download batch at all
+  //
+
+  if (m_batchRequestPending) {
+    m_batchRequestPending = false;
+
+    StringStorage errDesc;
+    StringStorage message;
+
+    m_replyBuffer->getLastErrorMessage(&errDesc);
+    message.format(_T("Error: failed to download files (%s)"), errDesc.getString());
+    notifyError(message.getString());
+
+    m_batchSources.clear();
+    m_batchTargets.clear();
+    m_batchSize = 0;
+
+    continueAfterBatch();
+    return ;
+  }
+
   //
   // This LRF message received from get folder size request
   // we do need to download next file
@@ -209,6 +345,26 @@ void DownloadOperation::onLastRequestFailedReply(DataInputStream *input)
 
   if (m_foldersToCalcSizeLeft > 0) {
     decFoldersToCalcSizeCount();
+  } else if (!m_window.isEmpty()) {
+    //
+    // This LRF message received from download data request,
+    // skip replies to the rest of outstanding requests
+    //
+
+    m_window.replyReceived(0);
+
+    if (m_isDraining) {
+      continueDrain();
+      return ;
+    }
+
+    StringStorage message;
+
+    m_replyBuffer->getLastErrorMessage(&message);
+
+    notifyFailedToDownload(message.getString());
+
+    startDrain();
   } else {
     // Logging
     StringStorage message;
@@ -296,10 +452,114 @@ void DownloadOperation::processFile()
     } // switch
   } // if target file exists
 
+  //
+  // Small files are collected to batch and downloaded by one request
+  //
+
+  if (m_fileOffset == 0 && m_batchSupported &&
+      m_toCopy->getFileInfo()->getSize() <= MAX_BATCH_FILE_SIZE) {
+    addFileToBatch();
+    return ;
+  }
+
+  //
+  // Files collected before must be downloaded first, download of this
+  // file is started when reply to download batch request is received.
+  //
+
+  if (!m_batchSources.empty()) {
+    m_hasDeferredDownload = true;
+    sendBatch();
+    return ;
+  }
+
   // Send request that we want to download file
   m_sender->sendDownloadRequest(m_pathToSourceFile.getString(), m_fileOffset);
 }
 
+void DownloadOperation::addFileToBatch()
+{
+  m_batchSources.push_back(m_pathToSourceFile);
+  m_batchTargets.push_back(m_pathToTargetFile);
+  m_batchSize += m_toCopy->getFileInfo()->getSize();
+
+  if (m_batchSize >= MAX_BATCH_SIZE ||
+      m_batchSources.size() >= MAX_BATCH_FILES_COUNT) {
+    sendBatch();
+    return ;
+  }
+
+  gotoNext();
+}
+
+void DownloadOperation::sendBatch()
+{
+  _ASSERT(!m_batchSources.empty());
+
+  m_batchRequestPending = true;
+  m_sender->sendDownloadBatchRequest(&m_batchSources,
+                                     m_replyBuffer->isCompressionSupported());
+}
+
+bool DownloadOperation::isNextFileBatchable()
+{
+  if (isTerminating() || m_toCopy->getChild() != NULL) {
+    return false;
+  }
+
+  FileInfoList *next = m_toCopy->getNext();
+  if (next == NULL) {
+    return false;
+  }
+
+  FileInfo *fileInfo = next->getFileInfo();
+  return !fileInfo->isDirectory() && fileInfo->getSize() <= MAX_BATCH_FILE_SIZE;
+}
+
+void DownloadOperation::continueAfterBatch()
+{
+  if (!m_hasDeferredDownload) {
+    gotoNext();
+    return ;
+  }
+
+  m_hasDeferredDownload = false;
+
+  if (isTerminating()) {
+    gotoNext();
+    return ;
+  }
+
+  m_sender->sendDownloadRequest(m_pathToSourceFile.getString(), m_fileOffset);
+}
+
+void DownloadOperation::writeBatchFile(const TCHAR *pathToTargetFile,
+                                       UINT64 modificationTime,
+                                       const char *data,
+                                       UINT32 size)
+{
+  File file(pathToTargetFile);
+
+  if (!file.truncate()) {
+    throw IOException(_T("Cannot create file"));
+  }
+
+  {
+    WinFileChannel fileChannel(pathToTargetFile, F_WRITE, FM_OPEN);
+
+    if (size != 0) {
+      DataOutputStream output(&fileChannel);
+      output.writeFully(data, size);
+    }
+
+    fileChannel.close();
+  }
+
+  if (!file.setLastModified(modificationTime)) {
+    throw IOException(_T("Cannot set modification time"));
+  }
+}
+
 void DownloadOperation::processFolder()
 {
   File local(m_pathToTargetFile.getString());
@@ -326,6 +586,17 @@ void DownloadOperation::processFolder()
 
 void DownloadOperation::gotoNext()
 {
+  //
+  // Collected files are requested before any other request, so replies
+  // come in the order the operation expects.
+  //
+
+  if (!m_batchSources.empty() && !m_batchRequestPending &&
+      !isNextFileBatchable()) {
+    sendBatch();
+    return ;
+  }
+
   FileInfoList *current = m_toCopy;
 
   bool hasChild = current->getChild() != NULL;
@@ -386,6 +657,41 @@ void DownloadOperation::tryCalcInputFilesSize()
   }
 }
 
+void DownloadOperation::sendDataRequests()
+{
+  bool compression = m_replyBuffer->isCompressionSupported();
+
+  while (!m_window.isFull()) {
+    m_window.requestSent(0);
+
+    if (m_windowSupported) {
+      m_sender->sendDownloadDataWindowRequest(m_window.getChunkSize(),
+                                              compression);
+    } else {
+      m_sender->sendDownloadDataRequest(m_window.getChunkSize(),
+                                        compression);
+    }
+  }
+}
+
+void DownloadOperation::startDrain()
+{
+  m_isDraining = true;
+
+  continueDrain();
+}
+
+void DownloadOperation::continueDrain()
+{
+  if (!m_window.isEmpty()) {
+    return ;
+  }
+
+  m_isDraining = false;
+
+  gotoNext();
+}
+
 void DownloadOperation::killOp()
 {
   //
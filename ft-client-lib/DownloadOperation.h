@@ -29,6 +29,9 @@
 #include "file-lib/WinFileChannel.h"
 #include "FileInfoList.h"
 #include "CopyOperation.h"
+#include "TransferWindow.h"
+
+#include <vector>
 
 //
 // File transfer operation class for downloading files (and file trees).
@@ -56,6 +59,21 @@ public:
 
   virtual ~DownloadOperation();
 
+  //
+  // Allows to keep several download data requests in flight and to grow
+  // their size (server must support DOWNLOAD_DATA_WINDOW_REQUEST message).
+  // If not set, data is requested by fixed chunks one by one.
+  //
+
+  void setWindowSupported(bool windowSupported);
+
+  //
+  // Allows to download small files by batches (server supports
+  // download batch requests).
+  //
+
+  void setBatchSupported(bool batchSupported);
+
   //
   // Inherited from FileTransferOperation
   //
@@ -72,6 +90,7 @@ protected:
   virtual void onDownloadReply(DataInputStream *input) throw(IOException);
   virtual void onDownloadDataReply(DataInputStream *input) throw(IOException);
   virtual void onDownloadEndReply(DataInputStream *input) throw(IOException);
+  virtual void onDownloadBatchReply(DataInputStream *input) throw(IOException);
   virtual void onLastRequestFailedReply(DataInputStream *input) throw(IOException);
   virtual void onDirSizeReply(DataInputStream *input) throw(IOException);
 
@@ -108,6 +127,38 @@ private:
   // m_pathToSourceFile, m_pathToTargetFile members
   void changeFileToDownload(FileInfoList *toDownload);
 
+  // Sends download data requests until window of outstanding
+  // requests is full
+  void sendDataRequests() throw(IOException);
+
+  // Stops sending download data requests and waits for replies to
+  // the outstanding ones, then goes to next file
+  void startDrain() throw(IOException);
+
+  // Helper method that goes to next file when all replies to
+  // outstanding requests have been received
+  void continueDrain() throw(IOException);
+
+  // Adds current file to download batch and goes to next file,
+  // sends the batch when it's full
+  void addFileToBatch() throw(IOException);
+
+  // Sends download batch request for collected files
+  void sendBatch() throw(IOException);
+
+  // Returns true if next file can be added to the same download batch
+  // as the current one
+  bool isNextFileBatchable();
+
+  // Starts deferred download of current file or goes to next file
+  // after reply to download batch request
+  void continueAfterBatch() throw(IOException);
+
+  // Creates (or overwrites) local file of download batch with specified
+  // content, throws Exception on fail
+  void writeBatchFile(const TCHAR *pathToTargetFile, UINT64 modificationTime,
+                      const char *data, UINT32 size);
+
 protected:
   // Target local file
   File *m_file;
@@ -120,6 +171,43 @@ protected:
   // Helper member to know how many folders to download left
   // to get their file size
   UINT32 m_foldersToCalcSizeLeft;
+
+  // Server allows to pipeline download data requests
+  bool m_windowSupported;
+  // Outstanding download data requests and size of next ones
+  TransferWindow m_window;
+  // Replies to outstanding requests are ignored until all of them
+  // will be received
+  bool m_isDraining;
+
+  //
+  // Download batch members
+  //
+
+  bool m_batchSupported;
+  // Remote and local paths of small files that are not requested yet
+  // (or requested by the pending download batch request)
+  std::vector<StringStorage> m_batchSources;
+  std::vector<StringStorage> m_batchTargets;
+  // Total size of collected files according to their listings
+  UINT64 m_batchSize;
+  // Download batch request is sent, reply to it is not received yet
+  bool m_batchRequestPending;
+  // Download of current file is started after reply to download batch
+  // request
+  bool m_hasDeferredDownload;
+
+  // Size of download data requests when window is not supported,
+  // and initial size when it is
+  static const UINT32 MIN_CHUNK_SIZE = 8 * 1024;
+  static const UINT32 MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+  // Count of download data requests that can be in flight
+  static const size_t WINDOW_SIZE = 4;
+  // Files larger than this are never downloaded by batches
+  static const UINT64 MAX_BATCH_FILE_SIZE = 64 * 1024;
+  // Batch is requested when its size or count of files reaches these limits
+  static const UINT64 MAX_BATCH_SIZE = 1024 * 1024;
+  static const size_t MAX_BATCH_FILES_COUNT = 128;
 };
 
 #endif
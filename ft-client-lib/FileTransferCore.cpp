@@ -34,6 +34,7 @@
 
 #include "file-lib/File.h"
 #include "ft-common/FolderListener.h"
+#include "thread/AutoLock.h"
 
 FileTransferCore::FileTransferCore(LogWriter *logWriter,
                                    FileTransferRequestSender *sender,
@@ -43,7 +44,8 @@ FileTransferCore::FileTransferCore(LogWriter *logWriter,
   m_state(NOTHING_STATE),
   m_sender(sender), m_replyBuffer(replyBuffer),
   m_fileTransferListeners(ftListeners),
-  m_currentOperation(0)
+  m_currentOperation(0),
+  m_isNewRemoteFileList(false)
 {
 }
 
@@ -52,6 +54,10 @@ FileTransferCore::~FileTransferCore()
   if (m_currentOperation != NULL) {
     delete m_currentOperation;
   }
+  while (!m_remoteFilePages.empty()) {
+    delete m_remoteFilePages.front();
+    m_remoteFilePages.pop_front();
+  }
 }
 
 void FileTransferCore::dataChunkCopied(UINT64 totalBytesCopied, UINT64 totalBytesToCopy)
@@ -99,9 +105,49 @@ vector<FileInfo> *FileTransferCore::getListLocalFolder(const TCHAR *pathToFile)
   return &m_localFilesInfo;
 }
 
-vector<FileInfo> *FileTransferCore::getListRemoteFolder()
+vector<FileInfo> *FileTransferCore::takeRemoteFileListPage(bool *isNewList)
+{
+  vector<FileInfo> *page = new vector<FileInfo>;
+
+  {
+    AutoLock al(&m_remoteFilesLock);
+
+    page->swap(m_receivedRemoteFiles);
+    *isNewList = m_isNewRemoteFileList;
+    m_isNewRemoteFileList = false;
+  }
+
+  if (*isNewList) {
+    while (!m_remoteFilePages.empty()) {
+      delete m_remoteFilePages.front();
+      m_remoteFilePages.pop_front();
+    }
+  } else if (page->empty()) {
+    delete page;
+    return NULL;
+  }
+
+  m_remoteFilePages.push_back(page);
+  return page;
+}
+
+void FileTransferCore::remoteFilesListed(const FileInfo *filesInfo,
+                                         UINT32 filesCount,
+                                         bool isFirstPage)
 {
-  return &m_remoteFilesInfo;
+  {
+    AutoLock al(&m_remoteFilesLock);
+
+    if (isFirstPage) {
+      m_receivedRemoteFiles.clear();
+      m_isNewRemoteFileList = true;
+    }
+    m_receivedRemoteFiles.insert(m_receivedRemoteFiles.end(),
+                                 filesInfo, filesInfo + filesCount);
+  }
+
+  // Interface shows received files info without waiting for the rest
+  m_ftInterface->onRemoteFileListPage();
 }
 
 void FileTransferCore::updateSupportedOperations(const vector<UINT32> *clientCaps,
@@ -125,18 +171,7 @@ void FileTransferCore::ftOpFinished(FileTransferOperation *sender)
   if (m_state == FILE_LIST_STATE) {
     RemoteFileListOperation *fileListOp = dynamic_cast<RemoteFileListOperation *>(sender);
 
-    if (fileListOp->isOk()) {
-
-      //
-      // Copy files info to class members
-      //
-
-      UINT32 numberFiles = m_replyBuffer->getFilesInfoCount();
-      m_remoteFilesInfo.resize(numberFiles);
-      for (UINT32 i = 0; i < numberFiles; i++) {
-        m_remoteFilesInfo[i] = m_replyBuffer->getFilesInfo()[i];
-      } // for all files in reply
-    } // if no error during file list operation
+    // Files info is already passed to remoteFilesListed() method
 
     // Notify dialog than operation is finished
     int result = fileListOp->isOk() ? 1 : 0;
@@ -224,6 +259,8 @@ void FileTransferCore::downloadOperation(const FileInfo *filesToDownload,
                                                  pathToTargetRoot,
                                                  pathToSourceRoot);
   dOp->setCopyProcessListener(this);
+  dOp->setWindowSupported(m_supportedOps.isDownloadWindowSupported());
+  dOp->setBatchSupported(m_supportedOps.isDownloadBatchSupported());
   executeOperation(dOp);
 }
 
@@ -240,6 +277,8 @@ void FileTransferCore::uploadOperation(const FileInfo *filesToDownload,
                                              pathToSourceRoot,
                                              pathToTargetRoot);
   uOp->setCopyProcessListener(this);
+  uOp->setDeltaSupported(m_supportedOps.isDeltaUploadSupported());
+  uOp->setBatchSupported(m_supportedOps.isUploadBatchSupported());
   executeOperation(uOp);
 }
 
@@ -286,7 +325,12 @@ void FileTransferCore::remoteFileRenameOperation(FileInfo sourceFileInfo,
 void FileTransferCore::remoteFileListOperation(const TCHAR *pathToFile)
 {
   m_state = FILE_LIST_STATE;
-  executeOperation(new RemoteFileListOperation(m_logWriter, pathToFile));
+  RemoteFileListOperation *fileListOp = new RemoteFileListOperation(m_logWriter,
+                                                                    pathToFile);
+  fileListOp->setFileListListener(this);
+  fileListOp->setPagedListSupported(m_supportedOps.isPagedFileListSupported());
+
+  executeOperation(fileListOp);
 }
 
 void FileTransferCore::terminateCurrentOperation()
@@ -35,13 +35,18 @@
 #include "OperationEventListener.h"
 #include "CopyFileEventListener.h"
 #include "OperationSupport.h"
+#include "RemoteFileListListener.h"
+#include "thread/LocalMutex.h"
+
+#include <list>
 
 #include "FileTransferInterface.h"
 
 class FileTransferInterface;
 
 class FileTransferCore : public OperationEventListener,
-                         public CopyFileEventListener
+                         public CopyFileEventListener,
+                         public RemoteFileListListener
 {
 public:
   //
@@ -64,7 +69,20 @@ public:
   const OperationSupport &getSupportedOps();
 
   vector<FileInfo> *getListLocalFolder(const TCHAR *pathToFile);
-  vector<FileInfo> *getListRemoteFolder();
+
+  //
+  // Takes part of remote folder content that is received since
+  // the previous call, returns NULL if nothing is received.
+  //
+  // Returned files info is valid until content of other folder
+  // is received. isNewList is set to true when returned part is the
+  // first part of new folder content, in this case files info returned
+  // before is deleted by this call.
+  //
+  // Remark: must be called from one thread.
+  //
+
+  vector<FileInfo> *takeRemoteFileListPage(bool *isNewList);
 
   void downloadOperation(const FileInfo *filesToDownload,
                          size_t filesCount,
@@ -108,6 +126,14 @@ protected:
                                FileInfo *targetFileInfo,
                                const TCHAR *pathToTargetFile);
 
+  //
+  // Inherited from RemoteFileListListener
+  //
+
+  virtual void remoteFilesListed(const FileInfo *filesInfo,
+                                 UINT32 filesCount,
+                                 bool isFirstPage);
+
   //
   // Inherited from OperationEventListener
   //
@@ -165,7 +191,12 @@ protected:
   // File list request variables
   //
 
-  vector <FileInfo> m_remoteFilesInfo;
+  // Parts of remote folder content that are taken by interface
+  std::list<vector<FileInfo> *> m_remoteFilePages;
+  // Files info received since the last takeRemoteFileListPage() call
+  vector<FileInfo> m_receivedRemoteFiles;
+  bool m_isNewRemoteFileList;
+  LocalMutex m_remoteFilesLock;
 
   //
   // Local file list variables
@@ -43,6 +43,11 @@ void FileTransferEventAdapter::onFileListReply(DataInputStream *input)
   throw OperationNotPermittedException();
 }
 
+void FileTransferEventAdapter::onFileListPageReply(DataInputStream *input)
+{
+  throw OperationNotPermittedException();
+}
+
 void FileTransferEventAdapter::onMd5DataReply(DataInputStream *input)
 {
   throw OperationNotPermittedException();
@@ -63,6 +68,11 @@ void FileTransferEventAdapter::onUploadEndReply(DataInputStream *input)
   throw OperationNotPermittedException();
 }
 
+void FileTransferEventAdapter::onUploadBatchReply(DataInputStream *input)
+{
+  throw OperationNotPermittedException();
+}
+
 void FileTransferEventAdapter::onDownloadReply(DataInputStream *input)
 {
   throw OperationNotPermittedException();
@@ -78,6 +88,11 @@ void FileTransferEventAdapter::onDownloadEndReply(DataInputStream *input)
   throw OperationNotPermittedException();
 }
 
+void FileTransferEventAdapter::onDownloadBatchReply(DataInputStream *input)
+{
+  throw OperationNotPermittedException();
+}
+
 void FileTransferEventAdapter::onMkdirReply(DataInputStream *input)
 {
   throw OperationNotPermittedException();
@@ -98,6 +113,11 @@ void FileTransferEventAdapter::onDirSizeReply(DataInputStream *input)
   throw OperationNotPermittedException();
 }
 
+void FileTransferEventAdapter::onFileSignatureReply(DataInputStream *input)
+{
+  throw OperationNotPermittedException();
+}
+
 void FileTransferEventAdapter::onLastRequestFailedReply(DataInputStream *input)
 {
   throw OperationNotPermittedException();
@@ -49,21 +49,25 @@ public:
 
   virtual void onCompressionSupportReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onFileListReply(DataInputStream *input) throw(OperationNotPermittedException);
+  virtual void onFileListPageReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onMd5DataReply(DataInputStream *input) throw(OperationNotPermittedException);
 
   virtual void onUploadReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onUploadDataReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onUploadEndReply(DataInputStream *input) throw(OperationNotPermittedException);
+  virtual void onUploadBatchReply(DataInputStream *input) throw(OperationNotPermittedException);
 
   virtual void onDownloadReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onDownloadDataReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onDownloadEndReply(DataInputStream *input) throw(OperationNotPermittedException);
+  virtual void onDownloadBatchReply(DataInputStream *input) throw(OperationNotPermittedException);
 
   virtual void onMkdirReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onRmReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onMvReply(DataInputStream *input) throw(OperationNotPermittedException);
 
   virtual void onDirSizeReply(DataInputStream *input) throw(OperationNotPermittedException);
+  virtual void onFileSignatureReply(DataInputStream *input) throw(OperationNotPermittedException);
   virtual void onLastRequestFailedReply(DataInputStream *input) throw(OperationNotPermittedException);
 };
 
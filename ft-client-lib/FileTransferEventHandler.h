@@ -43,21 +43,25 @@ public:
 
   virtual void onCompressionSupportReply(DataInputStream *input) = 0;
   virtual void onFileListReply(DataInputStream *input) = 0;
+  virtual void onFileListPageReply(DataInputStream *input) = 0;
   virtual void onMd5DataReply(DataInputStream *input) = 0;
 
   virtual void onUploadReply(DataInputStream *input) = 0;
   virtual void onUploadDataReply(DataInputStream *input) = 0;
   virtual void onUploadEndReply(DataInputStream *input) = 0;
+  virtual void onUploadBatchReply(DataInputStream *input) = 0;
 
   virtual void onDownloadReply(DataInputStream *input) = 0;
   virtual void onDownloadDataReply(DataInputStream *input) = 0;
   virtual void onDownloadEndReply(DataInputStream *input) = 0;
+  virtual void onDownloadBatchReply(DataInputStream *input) = 0;
 
   virtual void onMkdirReply(DataInputStream *input) = 0;
   virtual void onRmReply(DataInputStream *input) = 0;
   virtual void onMvReply(DataInputStream *input) = 0;
 
   virtual void onDirSizeReply(DataInputStream *input) = 0;
+  virtual void onFileSignatureReply(DataInputStream *input) = 0;
   virtual void onLastRequestFailedReply(DataInputStream *input) = 0;
 };
 
@@ -68,6 +68,13 @@ public:
   // Called if remote file list is updated
   virtual void onRefreshRemoteFileList() = 0;
 
+  //
+  // Called when part of remote folder content is received (it can be
+  // taken by FileTransferCore::takeRemoteFileListPage()).
+  // This function must be is not blocking, otherwise it may happen deadlock.
+  //
+  virtual void onRemoteFileListPage() = 0;
+
   //
   // Shows error message and throws exception
   //
@@ -51,6 +51,9 @@ void FileTransferMessageProcessor::processRfbMessage(DataInputStream *input,
     case FTMessage::FILE_LIST_REPLY:
       listener->onFileListReply(input);
       break;
+    case FTMessage::FILE_LIST_PAGE_REPLY:
+      listener->onFileListPageReply(input);
+      break;
     case FTMessage::DOWNLOAD_START_REPLY:
       listener->onDownloadReply(input);
       break;
@@ -60,6 +63,9 @@ void FileTransferMessageProcessor::processRfbMessage(DataInputStream *input,
     case FTMessage::DOWNLOAD_END_REPLY:
       listener->onDownloadEndReply(input);
       break;
+    case FTMessage::DOWNLOAD_BATCH_REPLY:
+      listener->onDownloadBatchReply(input);
+      break;
     case FTMessage::UPLOAD_START_REPLY:
       listener->onUploadReply(input);
       break;
@@ -69,12 +75,18 @@ void FileTransferMessageProcessor::processRfbMessage(DataInputStream *input,
     case FTMessage::UPLOAD_END_REPLY:
       listener->onUploadEndReply(input);
       break;
+    case FTMessage::UPLOAD_BATCH_REPLY:
+      listener->onUploadBatchReply(input);
+      break;
     case FTMessage::MD5_REPLY:
       listener->onMd5DataReply(input);
       break;
     case FTMessage::DIRSIZE_REPLY:
       listener->onDirSizeReply(input);
       break;
+    case FTMessage::FILE_SIGNATURE_REPLY:
+      listener->onFileSignatureReply(input);
+      break;
     case FTMessage::RENAME_REPLY:
       listener->onMvReply(input);
       break;
@@ -30,7 +30,7 @@
 
 #include "util/inttypes.h"
 #include "util/ListenerContainer.h"
-#include "util/ZLibException.h"
+#include "util/ZlibException.h"
 
 #include "ft-common/OperationNotSupportedException.h"
 
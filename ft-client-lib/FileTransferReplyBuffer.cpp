@@ -30,9 +30,10 @@
 FileTransferReplyBuffer::FileTransferReplyBuffer(LogWriter *logWriter)
 : m_logWriter(logWriter),
   m_isCompressionSupported(false),
-  m_filesInfoCount(0), m_filesInfo(NULL),
+  m_filesInfoCount(0), m_filesInfo(NULL), m_isLastFileListPage(true),
   m_downloadBufferSize(0), 
   m_downloadFileFlags(0), m_downloadLastModified(0),
+  m_downloadBatchFilesCount(0),
   m_dirSize(0)
 {
   m_lastErrorMessage.setString(_T(""));
@@ -65,6 +66,11 @@ FileInfo *FileTransferReplyBuffer::getFilesInfo()
   return m_filesInfo;
 }
 
+bool FileTransferReplyBuffer::isLastFileListPage()
+{
+  return m_isLastFileListPage;
+}
+
 UINT32 FileTransferReplyBuffer::getDownloadBufferSize()
 {
   return m_downloadBufferSize;
@@ -85,6 +91,31 @@ UINT64 FileTransferReplyBuffer::getDirSize()
   return m_dirSize;
 }
 
+const FileSignature *FileTransferReplyBuffer::getFileSignature()
+{
+  return &m_fileSignature;
+}
+
+const vector<UINT8> *FileTransferReplyBuffer::getDownloadBatchData()
+{
+  return &m_downloadBatchData;
+}
+
+UINT32 FileTransferReplyBuffer::getDownloadBatchFilesCount()
+{
+  return m_downloadBatchFilesCount;
+}
+
+const vector<StringStorage> *FileTransferReplyBuffer::getBatchFailedFiles()
+{
+  return &m_batchFailedFiles;
+}
+
+const vector<StringStorage> *FileTransferReplyBuffer::getBatchErrors()
+{
+  return &m_batchErrors;
+}
+
 vector<UINT8> FileTransferReplyBuffer::getDownloadBuffer()
 {
   return m_downloadBuffer;
@@ -99,6 +130,18 @@ void FileTransferReplyBuffer::onCompressionSupportReply(DataInputStream *input)
 }
 
 void FileTransferReplyBuffer::onFileListReply(DataInputStream *input)
+{
+  readFilesInfo(input);
+}
+
+void FileTransferReplyBuffer::onFileListPageReply(DataInputStream *input)
+{
+  m_isLastFileListPage = (input->readUInt8() & 0x1) != 0;
+
+  readFilesInfo(input);
+}
+
+void FileTransferReplyBuffer::readFilesInfo(DataInputStream *input)
 {
   UINT8 compressionLevel = 0;
   UINT32 compressedSize = 0;
@@ -176,6 +219,23 @@ void FileTransferReplyBuffer::onUploadEndReply(DataInputStream *input)
   m_logWriter->info(_T("Received upload end reply\n"));
 }
 
+void FileTransferReplyBuffer::onUploadBatchReply(DataInputStream *input)
+{
+  UINT32 failedCount = input->readUInt32();
+
+  m_batchFailedFiles.resize(failedCount);
+  m_batchErrors.resize(failedCount);
+
+  for (UINT32 i = 0; i < failedCount; i++) {
+    input->readUTF8(&m_batchFailedFiles[i]);
+    input->readUTF8(&m_batchErrors[i]);
+  }
+
+  m_logWriter->info(_T("Received upload batch reply:\n")
+                    _T("\tfailed files count: %d\n"),
+                    failedCount);
+}
+
 void FileTransferReplyBuffer::onDownloadReply(DataInputStream *input)
 {
   m_logWriter->info(_T("Received download reply\n"));
@@ -208,6 +268,34 @@ void FileTransferReplyBuffer::onDownloadEndReply(DataInputStream *input)
                     m_downloadFileFlags, m_downloadLastModified);
 }
 
+void FileTransferReplyBuffer::onDownloadBatchReply(DataInputStream *input)
+{
+  m_downloadBatchFilesCount = input->readUInt32();
+  UINT8 coLevel = input->readUInt8();
+  UINT32 coBufferSize = input->readUInt32();
+  UINT32 uncoBufferSize = input->readUInt32();
+
+  m_downloadBatchData = readCompressedDataBlock(input, coBufferSize, uncoBufferSize, coLevel);
+
+  UINT32 failedCount = input->readUInt32();
+
+  m_batchFailedFiles.resize(failedCount);
+  m_batchErrors.resize(failedCount);
+
+  for (UINT32 i = 0; i < failedCount; i++) {
+    input->readUTF8(&m_batchFailedFiles[i]);
+    input->readUTF8(&m_batchErrors[i]);
+  }
+
+  m_logWriter->info(_T("Received download batch reply:\n")
+                    _T("\tfiles count: %d\n")
+                    _T("\tcompressed size: %d\n")
+                    _T("\tuncompressed size: %d\n")
+                    _T("\tfailed files count: %d\n"),
+                    m_downloadBatchFilesCount, coBufferSize, uncoBufferSize,
+                    failedCount);
+}
+
 void FileTransferReplyBuffer::onMkdirReply(DataInputStream *input)
 {
   m_logWriter->info(_T("Received mkdir reply\n"));
@@ -230,6 +318,17 @@ void FileTransferReplyBuffer::onDirSizeReply(DataInputStream *input)
   m_logWriter->info(_T("Received dirsize reply\n"));
 }
 
+void FileTransferReplyBuffer::onFileSignatureReply(DataInputStream *input)
+{
+  m_fileSignature.read(input);
+
+  m_logWriter->info(_T("Received file signature reply: \n")
+                    _T("\t block size = %d\n")
+                    _T("\t blocks count = %d\n"),
+                    m_fileSignature.getBlockSize(),
+                    (int)m_fileSignature.getBlockCount());
+}
+
 void FileTransferReplyBuffer::onLastRequestFailedReply(DataInputStream *input)
 {
   input->readUTF8(&m_lastErrorMessage);
@@ -270,16 +369,15 @@ vector<UINT8> FileTransferReplyBuffer::readCompressedDataBlock(DataInputStream *
 
   vector<UINT8> uncoBuffer(uncoSize);
 
-  m_inflater.setUnpackedSize(uncoSize);
-  // FIXME: type conversion in C-style
-  m_inflater.setInput((const char*)&coBuffer.front(), coSize);
-
-  m_inflater.inflate();
-
-  _ASSERT(m_inflater.getOutputSize() == uncoSize);
-
   if (uncoSize != 0) {
-    memcpy(&uncoBuffer.front(), m_inflater.getOutput(), uncoSize);
+    // Decompress directly to the result.
+    // FIXME: type conversion in C-style
+    const char *input = (const char *)&coBuffer.front();
+    size_t inputSize = coSize;
+    size_t outputSize = m_inflater.inflate(&input, &inputSize,
+                                           (char *)&uncoBuffer.front(),
+                                           uncoSize);
+    _ASSERT(outputSize == uncoSize && inputSize == 0);
   }
 
   return uncoBuffer;
@@ -30,8 +30,9 @@
 #include "io-lib/DataInputStream.h"
 
 #include "ft-common/FileInfo.h"
+#include "ft-common/FileSignature.h"
 #include "util/Inflater.h"
-#include "util/ZLibException.h"
+#include "util/ZlibException.h"
 
 #include "ft-common/OperationNotSupportedException.h"
 
@@ -49,6 +50,8 @@ public:
 
   UINT32 getFilesInfoCount();
   FileInfo *getFilesInfo();
+  // Returns true if the last received page of file list is the last one
+  bool isLastFileListPage();
 
   UINT32 getDownloadBufferSize();
   vector<UINT8> getDownloadBuffer();
@@ -58,31 +61,50 @@ public:
 
   UINT64 getDirSize();
 
+  const FileSignature *getFileSignature();
+
+  // Uncompressed data of the last download batch (files in format of
+  // FTMessage::UPLOAD_BATCH_REQUEST data) and count of files in it
+  const vector<UINT8> *getDownloadBatchData();
+  UINT32 getDownloadBatchFilesCount();
+
+  // Paths and error descriptions of files that server failed to write
+  // by the last upload batch or to read by the last download batch
+  const vector<StringStorage> *getBatchFailedFiles();
+  const vector<StringStorage> *getBatchErrors();
+
   //
   // Inherited from FileTransferEventHandler abstract class
   //
 
   virtual void onCompressionSupportReply(DataInputStream *input) throw(IOException);
   virtual void onFileListReply(DataInputStream *input) throw(IOException, ZLibException);
+  virtual void onFileListPageReply(DataInputStream *input) throw(IOException, ZLibException);
   virtual void onMd5DataReply(DataInputStream *input) throw(IOException, OperationNotSupportedException);
 
   virtual void onUploadReply(DataInputStream *input) throw(IOException);
   virtual void onUploadDataReply(DataInputStream *input) throw(IOException);
   virtual void onUploadEndReply(DataInputStream *input) throw(IOException);
+  virtual void onUploadBatchReply(DataInputStream *input) throw(IOException);
 
   virtual void onDownloadReply(DataInputStream *input) throw(IOException);
   virtual void onDownloadDataReply(DataInputStream *input) throw(IOException, ZLibException);
   virtual void onDownloadEndReply(DataInputStream *input) throw(IOException);
+  virtual void onDownloadBatchReply(DataInputStream *input) throw(IOException, ZLibException);
 
   virtual void onMkdirReply(DataInputStream *input) throw(IOException);
   virtual void onRmReply(DataInputStream *input) throw(IOException);
   virtual void onMvReply(DataInputStream *input) throw(IOException);
 
   virtual void onDirSizeReply(DataInputStream *input) throw(IOException);
+  virtual void onFileSignatureReply(DataInputStream *input) throw(IOException);
   virtual void onLastRequestFailedReply(DataInputStream *input) throw(IOException);
 
 private:
 
+  // Reads files info in format of file list reply body
+  void readFilesInfo(DataInputStream *input) throw(IOException, ZLibException);
+
   vector<UINT8> readCompressedDataBlock(DataInputStream *input,
                                         UINT32 compressedSize,
                                         UINT32 uncompressedSize,
@@ -111,6 +133,7 @@ protected:
   // File list reply
   UINT32 m_filesInfoCount;
   FileInfo *m_filesInfo;
+  bool m_isLastFileListPage;
 
   // Last request message failed reply
   StringStorage m_lastErrorMessage;
@@ -125,6 +148,17 @@ protected:
 
   // Dirsize reply data
   UINT64 m_dirSize;
+
+  // File signature reply data
+  FileSignature m_fileSignature;
+
+  // Download batch reply data
+  vector<UINT8> m_downloadBatchData;
+  UINT32 m_downloadBatchFilesCount;
+
+  // Upload and download batch reply data
+  vector<StringStorage> m_batchFailedFiles;
+  vector<StringStorage> m_batchErrors;
 };
 
 #endif
@@ -71,6 +71,25 @@ void FileTransferRequestSender::sendFileListRequest(const TCHAR *fullPath,
   m_output->flush();
 }
 
+void FileTransferRequestSender::sendFileListPagedRequest(const TCHAR *fullPath,
+                                                         bool useCompression)
+{
+  AutoLock al(m_output);
+
+  UINT8 compressionLevel = useCompression ? (UINT8)1 : (UINT8)0;
+
+  m_logWriter->info(_T("Sending paged file list request with parameters:\n")
+                    _T("\tpath = %s\n")
+                    _T("\tuse compression = %d\n"),
+                    fullPath,
+                    useCompression ? 1 : 0);
+
+  m_output->writeUInt32(FTMessage::FILE_LIST_PAGED_REQUEST);
+  m_output->writeUInt8(compressionLevel);
+  m_output->writeUTF8(fullPath);
+  m_output->flush();
+}
+
 void FileTransferRequestSender::sendDownloadRequest(const TCHAR *fullPathName,
                                                     UINT64 offset)
 {
@@ -106,6 +125,25 @@ void FileTransferRequestSender::sendDownloadDataRequest(UINT32 size,
   m_output->flush();
 }
 
+void FileTransferRequestSender::sendDownloadDataWindowRequest(UINT32 size,
+                                                              bool useCompression)
+{
+  AutoLock al(m_output);
+
+  UINT8 compressionLevel = useCompression ? (UINT8)1 : (UINT8)0;
+
+  m_logWriter->info(_T("Sending download data window request with parameters:\n")
+                    _T("\tsize = %d\n")
+                    _T("\tuse compression = %d\n"),
+                    size,
+                    compressionLevel);
+
+  m_output->writeUInt32(FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST);
+  m_output->writeUInt8(compressionLevel);
+  m_output->writeUInt32(size);
+  m_output->flush();
+}
+
 void FileTransferRequestSender::sendRmFileRequest(const TCHAR *fullPathName)
 {
   AutoLock al(m_output);
@@ -173,36 +211,45 @@ void FileTransferRequestSender::sendUploadRequest(const TCHAR *fullPathName,
   m_output->flush();
 }
 
-void FileTransferRequestSender::sendUploadDataRequest(const char *buffer,
-                                                      UINT32 size,
-                                                      bool useCompression)
+UINT32 FileTransferRequestSender::sendUploadDataRequest(const char *buffer,
+                                                        UINT32 size,
+                                                        UINT8 compressionLevel)
 {
   AutoLock al(m_output);
 
-  m_output->writeUInt32(FTMessage::UPLOAD_DATA_REQUEST);
-
-  //
-  // FIXME: Compression is not supported for now
-  // TODO: Compression support on upload
-  //
+  const char *data = buffer;
+  UINT32 dataSize = size;
 
-  if (useCompression) {
-    throw IOException(_T("Compression is not supported yet."));
+  if (size == 0) {
+    compressionLevel = 0;
   }
 
-  UINT8 compressionLevel = useCompression ? (short)1 : (short)0;
+  if (compressionLevel != 0) {
+    m_uploadDeflater.setLevel(compressionLevel);
+    m_uploadDeflater.setInput(buffer, size);
+    m_uploadDeflater.deflate();
+
+    data = m_uploadDeflater.getOutput();
+    dataSize = (UINT32)m_uploadDeflater.getOutputSize();
+    _ASSERT(dataSize == m_uploadDeflater.getOutputSize());
+  }
 
   m_logWriter->info(_T("Sending upload data request with parameters:\n")
                     _T("\tsize = %d\n")
-                    _T("\tuse compression = %d\n"),
+                    _T("\tcompressed size = %d\n")
+                    _T("\tcompression level = %d\n"),
                     size,
+                    dataSize,
                     compressionLevel);
 
+  m_output->writeUInt32(FTMessage::UPLOAD_DATA_REQUEST);
   m_output->writeUInt8(compressionLevel);
+  m_output->writeUInt32(dataSize);
   m_output->writeUInt32(size);
-  m_output->writeUInt32(size);
-  m_output->writeFully(buffer, size);
+  m_output->writeFully(data, dataSize);
   m_output->flush();
+
+  return dataSize;
 }
 
 void FileTransferRequestSender::sendUploadEndRequest(UINT8 fileFlags,
@@ -222,6 +269,74 @@ void FileTransferRequestSender::sendUploadEndRequest(UINT8 fileFlags,
   m_output->flush();
 }
 
+UINT32 FileTransferRequestSender::sendUploadBatchRequest(UINT32 filesCount,
+                                                         const char *data,
+                                                         UINT32 size,
+                                                         UINT8 compressionLevel)
+{
+  AutoLock al(m_output);
+
+  const char *batchData = data;
+  UINT32 batchSize = size;
+
+  if (size == 0) {
+    compressionLevel = 0;
+  }
+
+  if (compressionLevel != 0) {
+    m_uploadDeflater.setLevel(compressionLevel);
+    m_uploadDeflater.setInput(data, size);
+    m_uploadDeflater.deflate();
+
+    batchData = m_uploadDeflater.getOutput();
+    batchSize = (UINT32)m_uploadDeflater.getOutputSize();
+    _ASSERT(batchSize == m_uploadDeflater.getOutputSize());
+  }
+
+  m_logWriter->info(_T("Sending upload batch request with parameters:\n")
+                    _T("\tfiles count = %d\n")
+                    _T("\tsize = %d\n")
+                    _T("\tcompressed size = %d\n")
+                    _T("\tcompression level = %d\n"),
+                    filesCount,
+                    size,
+                    batchSize,
+                    compressionLevel);
+
+  m_output->writeUInt32(FTMessage::UPLOAD_BATCH_REQUEST);
+  m_output->writeUInt32(filesCount);
+  m_output->writeUInt8(compressionLevel);
+  m_output->writeUInt32(batchSize);
+  m_output->writeUInt32(size);
+  m_output->writeFully(batchData, batchSize);
+  m_output->flush();
+
+  return batchSize;
+}
+
+void FileTransferRequestSender::sendDownloadBatchRequest(const std::vector<StringStorage> *fullPathNames,
+                                                         bool useCompression)
+{
+  AutoLock al(m_output);
+
+  UINT8 compressionLevel = useCompression ? (UINT8)1 : (UINT8)0;
+  UINT32 filesCount = (UINT32)fullPathNames->size();
+
+  m_logWriter->info(_T("Sending download batch request with parameters:\n")
+                    _T("\tfiles count = %d\n")
+                    _T("\tuse compression = %d\n"),
+                    filesCount,
+                    useCompression ? 1 : 0);
+
+  m_output->writeUInt32(FTMessage::DOWNLOAD_BATCH_REQUEST);
+  m_output->writeUInt8(compressionLevel);
+  m_output->writeUInt32(filesCount);
+  for (UINT32 i = 0; i < filesCount; i++) {
+    m_output->writeUTF8((*fullPathNames)[i].getString());
+  }
+  m_output->flush();
+}
+
 void FileTransferRequestSender::sendFolderSizeRequest(const TCHAR *fullPath)
 {
   AutoLock al(m_output);
@@ -233,3 +348,55 @@ void FileTransferRequestSender::sendFolderSizeRequest(const TCHAR *fullPath)
   m_output->writeUTF8(fullPath);
   m_output->flush();
 }
+
+void FileTransferRequestSender::sendFileSignatureRequest(const TCHAR *fullPathName,
+                                                         UINT32 blockSize)
+{
+  AutoLock al(m_output);
+
+  m_logWriter->info(_T("Sending file signature request with parameters:\n")
+                    _T("\tpath = %s\n")
+                    _T("\tblock size = %d\n"),
+                    fullPathName,
+                    blockSize);
+
+  m_output->writeUInt32(FTMessage::FILE_SIGNATURE_REQUEST);
+  m_output->writeUTF8(fullPathName);
+  m_output->writeUInt32(blockSize);
+  m_output->flush();
+}
+
+void FileTransferRequestSender::sendDeltaUploadRequest(const TCHAR *fullPathName)
+{
+  AutoLock al(m_output);
+
+  // Overwrite flag and delta flag
+  UINT8 flags = 0x1 | 0x2;
+
+  m_logWriter->info(_T("Sending delta upload request with parameters:\n")
+                    _T("\tpath = %s\n"),
+                    fullPathName);
+
+  m_output->writeUInt32(FTMessage::UPLOAD_START_REQUEST);
+  m_output->writeUTF8(fullPathName);
+  m_output->writeUInt8(flags);
+  m_output->writeUInt64(0);
+  m_output->flush();
+}
+
+void FileTransferRequestSender::sendUploadCopyRequest(UINT64 offset,
+                                                      UINT64 length)
+{
+  AutoLock al(m_output);
+
+  m_logWriter->info(_T("Sending upload copy request with parameters:\n")
+                    _T("\toffset = %ld\n")
+                    _T("\tlength = %ld\n"),
+                    offset,
+                    length);
+
+  m_output->writeUInt32(FTMessage::UPLOAD_COPY_REQUEST);
+  m_output->writeUInt64(offset);
+  m_output->writeUInt64(length);
+  m_output->flush();
+}
@@ -28,9 +28,13 @@
 #include "util/inttypes.h"
 #include "network/RfbOutputGate.h"
 #include "io-lib/IOException.h"
+#include "util/Deflater.h"
+#include "util/StringStorage.h"
 
 #include "log-writer/LogWriter.h"
 
+#include <vector>
+
 class FileTransferRequestSender
 {
 public:
@@ -41,19 +45,59 @@ public:
 
   void sendCompressionSupportRequest() throw(IOException);
   void sendFileListRequest(const TCHAR *fullPath, bool useCompression) throw(IOException);
+  void sendFileListPagedRequest(const TCHAR *fullPath, bool useCompression) throw(IOException);
   void sendDownloadRequest(const TCHAR *fullPathName, UINT64 offset) throw(IOException);
   void sendDownloadDataRequest(UINT32 size, bool useCompression) throw(IOException);
+  void sendDownloadDataWindowRequest(UINT32 size, bool useCompression) throw(IOException);
   void sendRmFileRequest(const TCHAR *fullPathName) throw(IOException);
   void sendMkDirRequest(const TCHAR *fullPathName) throw(IOException);
   void sendMvFileRequest(const TCHAR *oldFileName, const TCHAR *newFileName) throw(IOException);
   void sendUploadRequest(const TCHAR *fullPathName, bool overwrite, UINT64 offset) throw(IOException);
-  void sendUploadDataRequest(const char *buffer, UINT32 size, bool useCompression) throw(IOException);
+
+  //
+  // Sends chunk of uploading file compressed with specified level
+  // (zero means no compression). Compression level can differ from chunk
+  // to chunk. Returns size of data in the message (compressed size if
+  // compression is used).
+  //
+
+  UINT32 sendUploadDataRequest(const char *buffer, UINT32 size,
+                               UINT8 compressionLevel) throw(IOException);
   void sendUploadEndRequest(UINT8 fileFlags, UINT64 modificationTime) throw(IOException);
+
+  //
+  // Sends several small files at once (see FTMessage::UPLOAD_BATCH_REQUEST),
+  // data is compressed in the same way as by sendUploadDataRequest().
+  // Returns size of data in the message.
+  //
+
+  UINT32 sendUploadBatchRequest(UINT32 filesCount, const char *data, UINT32 size,
+                                UINT8 compressionLevel) throw(IOException);
+
+  //
+  // Requests several small files at once (see
+  // FTMessage::DOWNLOAD_BATCH_REQUEST).
+  //
+
+  void sendDownloadBatchRequest(const std::vector<StringStorage> *fullPathNames,
+                                bool useCompression) throw(IOException);
   void sendFolderSizeRequest(const TCHAR *fullPath) throw(IOException);
 
+  //
+  // Delta upload requests (see FTMessage::UPLOAD_COPY_REQUEST)
+  //
+
+  void sendFileSignatureRequest(const TCHAR *fullPathName, UINT32 blockSize) throw(IOException);
+  void sendDeltaUploadRequest(const TCHAR *fullPathName) throw(IOException);
+  void sendUploadCopyRequest(UINT64 offset, UINT64 length) throw(IOException);
+
 protected:
   LogWriter *m_logWriter;
   RfbOutputGate *m_output;
+
+  // Compression stream of upload data. Server decompresses all uploads
+  // of the connection with one stream, so it is never reset.
+  Deflater m_uploadDeflater;
 };
 
 #endif
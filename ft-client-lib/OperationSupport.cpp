@@ -37,6 +37,11 @@ OperationSupport::OperationSupport()
   m_isCompressionSupported = false;
   m_isMD5Supported = false;
   m_isDirSizeSupported = false;
+  m_isDownloadWindowSupported = false;
+  m_isDeltaUploadSupported = false;
+  m_isPagedFileListSupported = false;
+  m_isUploadBatchSupported = false;
+  m_isDownloadBatchSupported = false;
   m_isUploadSupported = false;
   m_isDownloadSupported = false;
 }
@@ -80,6 +85,26 @@ OperationSupport::OperationSupport(const std::vector<UINT32> &clientCodes,
                            isSupport(serverCodes, FTMessage::DOWNLOAD_DATA_REPLY) &&
                            isSupport(serverCodes, FTMessage::DOWNLOAD_END_REPLY) &&
                            m_isFileListSupported && m_isDirSizeSupported);
+
+  m_isDownloadWindowSupported = m_isDownloadSupported &&
+                                isSupport(clientCodes, FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST);
+
+  m_isDeltaUploadSupported = m_isUploadSupported &&
+                             isSupport(clientCodes, FTMessage::FILE_SIGNATURE_REQUEST) &&
+                             isSupport(clientCodes, FTMessage::UPLOAD_COPY_REQUEST) &&
+                             isSupport(serverCodes, FTMessage::FILE_SIGNATURE_REPLY);
+
+  m_isPagedFileListSupported = m_isFileListSupported &&
+                               isSupport(clientCodes, FTMessage::FILE_LIST_PAGED_REQUEST) &&
+                               isSupport(serverCodes, FTMessage::FILE_LIST_PAGE_REPLY);
+
+  m_isUploadBatchSupported = m_isUploadSupported &&
+                             isSupport(clientCodes, FTMessage::UPLOAD_BATCH_REQUEST) &&
+                             isSupport(serverCodes, FTMessage::UPLOAD_BATCH_REPLY);
+
+  m_isDownloadBatchSupported = m_isDownloadSupported &&
+                               isSupport(clientCodes, FTMessage::DOWNLOAD_BATCH_REQUEST) &&
+                               isSupport(serverCodes, FTMessage::DOWNLOAD_BATCH_REPLY);
 }
 
 OperationSupport::~OperationSupport()
@@ -131,6 +156,31 @@ bool OperationSupport::isDirSizeSupported() const
   return m_isDirSizeSupported;
 }
 
+bool OperationSupport::isDownloadWindowSupported() const
+{
+  return m_isDownloadWindowSupported;
+}
+
+bool OperationSupport::isDeltaUploadSupported() const
+{
+  return m_isDeltaUploadSupported;
+}
+
+bool OperationSupport::isPagedFileListSupported() const
+{
+  return m_isPagedFileListSupported;
+}
+
+bool OperationSupport::isUploadBatchSupported() const
+{
+  return m_isUploadBatchSupported;
+}
+
+bool OperationSupport::isDownloadBatchSupported() const
+{
+  return m_isDownloadBatchSupported;
+}
+
 bool OperationSupport::isSupport(const std::vector<UINT32> &codes, UINT32 code)
 {
   return std::find(codes.begin(), codes.end(), code) != codes.end();
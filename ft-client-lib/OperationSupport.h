@@ -46,6 +46,11 @@ public:
   bool isCompressionSupported() const;
   bool isMD5Supported() const;
   bool isDirSizeSupported() const;
+  bool isDownloadWindowSupported() const;
+  bool isDeltaUploadSupported() const;
+  bool isPagedFileListSupported() const;
+  bool isUploadBatchSupported() const;
+  bool isDownloadBatchSupported() const;
 
 protected:
   static bool isSupport(const std::vector<UINT32> &codes, UINT32 code);
@@ -59,6 +64,11 @@ protected:
   bool m_isCompressionSupported;
   bool m_isMD5Supported;
   bool m_isDirSizeSupported;
+  bool m_isDownloadWindowSupported;
+  bool m_isDeltaUploadSupported;
+  bool m_isPagedFileListSupported;
+  bool m_isUploadBatchSupported;
+  bool m_isDownloadBatchSupported;
 };
 
 #endif
@@ -0,0 +1,56 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _REMOTE_FILE_LIST_LISTENER_H_
+#define _REMOTE_FILE_LIST_LISTENER_H_
+
+#include "util/inttypes.h"
+#include "ft-common/FileInfo.h"
+
+//
+// Receiver of remote folder content that is listed by
+// RemoteFileListOperation (can be received in several parts).
+//
+
+class RemoteFileListListener
+{
+public:
+  virtual ~RemoteFileListListener() { }
+
+  //
+  // Method called by file list operation when next part of remote
+  // folder content is received.
+  //
+  // Parameters:
+  //
+  // filesInfo - received files info (valid only during the call)
+  // filesCount - count of elements in filesInfo
+  // isFirstPage - true if this is the first part of folder content
+  //
+
+  virtual void remoteFilesListed(const FileInfo *filesInfo,
+                                 UINT32 filesCount,
+                                 bool isFirstPage) = 0;
+};
+
+#endif
@@ -28,7 +28,10 @@ RemoteFileListOperation::RemoteFileListOperation(LogWriter *logWriter,
                                                  const TCHAR *remotePath)
 : FileTransferOperation(logWriter),
   m_isOk(false),
-  m_isFinished(false)
+  m_isFinished(false),
+  m_fileListListener(0),
+  m_pagedListSupported(false),
+  m_pagesReceived(0)
 {
   m_remotePath.setString(remotePath);
 }
@@ -37,18 +40,58 @@ RemoteFileListOperation::~RemoteFileListOperation()
 {
 }
 
+void RemoteFileListOperation::setFileListListener(RemoteFileListListener *listener)
+{
+  m_fileListListener = listener;
+}
+
+void RemoteFileListOperation::setPagedListSupported(bool pagedListSupported)
+{
+  m_pagedListSupported = pagedListSupported;
+}
+
 void RemoteFileListOperation::start()
 {
   m_isOk = false;
   m_isFinished = false;
+  m_pagesReceived = 0;
 
-  m_sender->sendFileListRequest(m_remotePath.getString(),
-                                m_replyBuffer->isCompressionSupported());
+  if (m_pagedListSupported) {
+    m_sender->sendFileListPagedRequest(m_remotePath.getString(),
+                                       m_replyBuffer->isCompressionSupported());
+  } else {
+    m_sender->sendFileListRequest(m_remotePath.getString(),
+                                  m_replyBuffer->isCompressionSupported());
+  }
   notifyStart();
 }
 
 void RemoteFileListOperation::onFileListReply(DataInputStream *input)
 {
+  if (m_fileListListener != NULL) {
+    m_fileListListener->remoteFilesListed(m_replyBuffer->getFilesInfo(),
+                                          m_replyBuffer->getFilesInfoCount(),
+                                          true);
+  }
+
+  m_isOk = true;
+  m_isFinished = true;
+  notifyFinish();
+}
+
+void RemoteFileListOperation::onFileListPageReply(DataInputStream *input)
+{
+  if (m_fileListListener != NULL) {
+    m_fileListListener->remoteFilesListed(m_replyBuffer->getFilesInfo(),
+                                          m_replyBuffer->getFilesInfoCount(),
+                                          m_pagesReceived == 0);
+  }
+  m_pagesReceived++;
+
+  if (!m_replyBuffer->isLastFileListPage()) {
+    return ;
+  }
+
   m_isOk = true;
   m_isFinished = true;
   notifyFinish();
@@ -26,11 +26,15 @@
 #define _REMOTE_FILE_LIST_OPERATION_H_
 
 #include "FileTransferOperation.h"
+#include "RemoteFileListListener.h"
 
 //
 // File operation that used for receiving file list
 // from remote file system.
 //
+// If server supports paged file lists, content of folder is received
+// in parts, every part is passed to file list listener when it's received.
+//
 
 class RemoteFileListOperation : public FileTransferOperation
 {
@@ -38,6 +42,12 @@ public:
   RemoteFileListOperation(LogWriter *logWriter, const TCHAR *remotePath);
   virtual ~RemoteFileListOperation();
 
+  // Sets listener that receives content of remote folder
+  void setFileListListener(RemoteFileListListener *listener);
+
+  // Allows to receive content of remote folder in parts
+  void setPagedListSupported(bool pagedListSupported);
+
   //
   // Methods inherited from FileTransferOperation class
   //
@@ -49,6 +59,7 @@ public:
   //
 
   virtual void onFileListReply(DataInputStream *input);
+  virtual void onFileListPageReply(DataInputStream *input);
   virtual void onLastRequestFailedReply(DataInputStream *input);
 
   //
@@ -63,6 +74,11 @@ public:
 
   bool m_isFinished;
   bool m_isOk;
+
+  RemoteFileListListener *m_fileListListener;
+  bool m_pagedListSupported;
+  // Count of received parts of folder content
+  UINT32 m_pagesReceived;
 };
 
 #endif
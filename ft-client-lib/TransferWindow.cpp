@@ -0,0 +1,137 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TransferWindow.h"
+
+TransferWindow::TransferWindow(size_t maxRequests,
+                               UINT32 minChunkSize,
+                               UINT32 maxChunkSize)
+{
+  setLimits(maxRequests, minChunkSize, maxChunkSize);
+}
+
+TransferWindow::~TransferWindow()
+{
+}
+
+void TransferWindow::setLimits(size_t maxRequests,
+                               UINT32 minChunkSize,
+                               UINT32 maxChunkSize)
+{
+  _ASSERT(maxRequests > 0 && minChunkSize <= maxChunkSize);
+
+  m_maxRequests = maxRequests;
+  m_minChunkSize = minChunkSize;
+  m_maxChunkSize = maxChunkSize;
+
+  reset();
+}
+
+void TransferWindow::reset()
+{
+  m_requests.clear();
+  m_chunkSize = m_minChunkSize;
+
+  m_minRoundTripTime = 0;
+  m_rateBytes = 0;
+  m_rateStartTime = GetTickCount();
+  m_rate = 0;
+}
+
+void TransferWindow::requestSent(UINT32 dataSize)
+{
+  Request request;
+  request.sendTime = GetTickCount();
+  request.dataSize = dataSize;
+
+  m_requests.push_back(request);
+}
+
+void TransferWindow::replyReceived(UINT32 dataSize)
+{
+  _ASSERT(!m_requests.empty());
+
+  if (m_requests.empty()) {
+    return ;
+  }
+
+  DWORD now = GetTickCount();
+  DWORD roundTripTime = now - m_requests.front().sendTime;
+  m_rateBytes += m_requests.front().dataSize;
+  m_requests.pop_front();
+
+  if (m_minRoundTripTime == 0 || roundTripTime < m_minRoundTripTime) {
+    m_minRoundTripTime = roundTripTime;
+  }
+
+  m_rateBytes += dataSize;
+
+  DWORD elapsed = now - m_rateStartTime;
+
+  if (elapsed < RATE_PERIOD) {
+    return ;
+  }
+
+  m_rate = m_rateBytes * 1000 / elapsed;
+
+  m_rateBytes = 0;
+  m_rateStartTime = now;
+
+  updateChunkSize(m_rate);
+}
+
+bool TransferWindow::isFull() const
+{
+  return m_requests.size() >= m_maxRequests;
+}
+
+bool TransferWindow::isEmpty() const
+{
+  return m_requests.empty();
+}
+
+UINT32 TransferWindow::getChunkSize() const
+{
+  return m_chunkSize;
+}
+
+UINT64 TransferWindow::getRate() const
+{
+  return m_rate;
+}
+
+void TransferWindow::updateChunkSize(UINT64 rate)
+{
+  UINT64 windowTarget = rate * m_minRoundTripTime * 2 / 1000 / m_maxRequests;
+  UINT64 replyTarget = rate * MIN_REPLY_TIME / 1000;
+  UINT64 target = max(windowTarget, replyTarget);
+
+  // Change chunk size smoothly
+  target = min(target, (UINT64)m_chunkSize * 2);
+  target = max(target, (UINT64)m_chunkSize / 2);
+
+  target = min(target, (UINT64)m_maxChunkSize);
+  target = max(target, (UINT64)m_minChunkSize);
+
+  m_chunkSize = (UINT32)target;
+}
@@ -0,0 +1,119 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _TRANSFER_WINDOW_H_
+#define _TRANSFER_WINDOW_H_
+
+#include "util/CommonHeader.h"
+
+#include <deque>
+
+//
+// Keeps track of file data requests that are sent but not replied yet
+// and chooses size of next requests by measured transfer rate.
+//
+// Chunk size is chosen so that all requests in flight cover twice the
+// round trip time (the minimal one, so queueing caused by our own data
+// does not inflate it), and every reply takes some time of transfer to
+// make overhead per request negligible. While the window is too small,
+// the measured rate is limited by it, so the chunk size doubles every
+// measurement period until the link is saturated.
+//
+
+class TransferWindow
+{
+public:
+  //
+  // Parameters:
+  //
+  // [IN] maxRequests - count of requests that can be in flight
+  // [IN] minChunkSize - initial (and minimal) chunk size in bytes
+  // [IN] maxChunkSize - maximal chunk size in bytes, if equal to minChunkSize
+  // chunk size is fixed
+  //
+
+  TransferWindow(size_t maxRequests, UINT32 minChunkSize, UINT32 maxChunkSize);
+
+  virtual ~TransferWindow();
+
+  // Changes limits set in constructor and resets window
+  void setLimits(size_t maxRequests, UINT32 minChunkSize, UINT32 maxChunkSize);
+
+  // Forgets requests in flight and measurements, must be called before
+  // transfer of next file
+  void reset();
+
+  // Must be called for every sent request, dataSize is size of file
+  // data sent with the request (zero if request asks for data)
+  void requestSent(UINT32 dataSize);
+
+  // Must be called for every reply to sent request, dataSize is size
+  // of file data received with the reply (zero if none)
+  void replyReceived(UINT32 dataSize);
+
+  // Returns true if no more requests can be sent until reply
+  bool isFull() const;
+
+  // Returns true if all requests are replied
+  bool isEmpty() const;
+
+  // Returns size of file data to transfer by next request
+  UINT32 getChunkSize() const;
+
+  // Returns last measured transfer rate in bytes per second
+  // (zero if not measured yet)
+  UINT64 getRate() const;
+
+protected:
+  // Recalculates chunk size from current measurements
+  void updateChunkSize(UINT64 rate);
+
+  size_t m_maxRequests;
+  UINT32 m_minChunkSize;
+  UINT32 m_maxChunkSize;
+
+  struct Request
+  {
+    // Send time in milliseconds
+    DWORD sendTime;
+    UINT32 dataSize;
+  };
+
+  // Requests that are not replied yet, the oldest first
+  std::deque<Request> m_requests;
+  UINT32 m_chunkSize;
+
+  // Minimal measured round trip time in milliseconds
+  DWORD m_minRoundTripTime;
+  // Data transferred since m_rateStartTime
+  UINT64 m_rateBytes;
+  DWORD m_rateStartTime;
+  UINT64 m_rate;
+
+  // Transfer rate is measured over periods of at least this length
+  static const DWORD RATE_PERIOD = 250;
+  // Every reply should take at least this time of transfer
+  static const DWORD MIN_REPLY_TIME = 50;
+};
+
+#endif
@@ -0,0 +1,72 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "UploadBatch.h"
+
+UploadBatch::UploadBatch()
+: m_output(&m_data),
+  m_filesCount(0)
+{
+}
+
+UploadBatch::~UploadBatch()
+{
+}
+
+void UploadBatch::addFile(const TCHAR *pathToFile, UINT64 modificationTime,
+                          const char *data, UINT32 size)
+{
+  m_output.writeUTF8(pathToFile);
+  m_output.writeUInt64(modificationTime);
+  m_output.writeUInt32(size);
+  if (size != 0) {
+    m_output.writeFully(data, size);
+  }
+  m_filesCount++;
+}
+
+void UploadBatch::clear()
+{
+  m_data.reset();
+  m_filesCount = 0;
+}
+
+bool UploadBatch::isEmpty() const
+{
+  return m_filesCount == 0;
+}
+
+UINT32 UploadBatch::getFilesCount() const
+{
+  return m_filesCount;
+}
+
+const char *UploadBatch::getData() const
+{
+  return m_data.toByteArray();
+}
+
+size_t UploadBatch::getSize() const
+{
+  return m_data.size();
+}
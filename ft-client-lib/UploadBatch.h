@@ -0,0 +1,75 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _UPLOAD_BATCH_H_
+#define _UPLOAD_BATCH_H_
+
+#include "util/inttypes.h"
+#include "io-lib/ByteArrayOutputStream.h"
+#include "io-lib/DataOutputStream.h"
+
+//
+// Small files that are collected to be uploaded by one upload batch
+// request (see FTMessage::UPLOAD_BATCH_REQUEST).
+//
+
+class UploadBatch
+{
+public:
+  UploadBatch();
+  virtual ~UploadBatch();
+
+  //
+  // Adds file to batch.
+  //
+  // Parameters:
+  //
+  // [IN] pathToFile - absolute path to file on remote machine
+  // [IN] modificationTime - modification time of file
+  // [IN] data, size - content of file
+  //
+
+  void addFile(const TCHAR *pathToFile, UINT64 modificationTime,
+               const char *data, UINT32 size);
+
+  // Removes all files from batch
+  void clear();
+
+  bool isEmpty() const;
+  UINT32 getFilesCount() const;
+
+  //
+  // Returns data of batch in format of FTMessage::UPLOAD_BATCH_REQUEST
+  // message.
+  //
+
+  const char *getData() const;
+  size_t getSize() const;
+
+protected:
+  ByteArrayOutputStream m_data;
+  DataOutputStream m_output;
+  UINT32 m_filesCount;
+};
+
+#endif
@@ -0,0 +1,138 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "UploadChunkReader.h"
+
+#include "file-lib/EOFException.h"
+#include "thread/AutoLock.h"
+
+UploadChunkReader::UploadChunkReader(WinFileChannel *file,
+                                     UINT32 chunkSize,
+                                     size_t maxChunks)
+: m_file(file),
+  m_maxChunks(maxChunks),
+  m_chunkSize(chunkSize),
+  m_endOfFile(false),
+  m_failed(false)
+{
+  resume();
+}
+
+UploadChunkReader::~UploadChunkReader()
+{
+  terminate();
+  wait();
+
+  while (!m_chunks.empty()) {
+    delete m_chunks.front();
+    m_chunks.pop_front();
+  }
+}
+
+void UploadChunkReader::setChunkSize(UINT32 chunkSize)
+{
+  AutoLock al(&m_lock);
+
+  m_chunkSize = chunkSize;
+}
+
+bool UploadChunkReader::getChunk(std::vector<char> *chunk)
+{
+  while (true) {
+    {
+      AutoLock al(&m_lock);
+
+      if (!m_chunks.empty()) {
+        std::vector<char> *front = m_chunks.front();
+        m_chunks.pop_front();
+
+        chunk->swap(*front);
+        delete front;
+
+        m_chunkTakenEvent.notify();
+        return true;
+      }
+      if (m_failed) {
+        throw IOException(m_errorMessage.getString());
+      }
+      if (m_endOfFile) {
+        return false;
+      }
+    }
+    m_chunkReadEvent.waitForEvent();
+  }
+}
+
+void UploadChunkReader::execute()
+{
+  while (!isTerminating()) {
+    UINT32 chunkSize;
+    bool isFull;
+
+    {
+      AutoLock al(&m_lock);
+
+      chunkSize = m_chunkSize;
+      isFull = m_chunks.size() >= m_maxChunks;
+    }
+
+    if (isFull) {
+      m_chunkTakenEvent.waitForEvent();
+      continue;
+    }
+
+    std::vector<char> *chunk = new std::vector<char>(chunkSize);
+
+    try {
+      size_t read = m_file->read(&chunk->front(), chunkSize);
+      chunk->resize(read);
+    } catch (EOFException) {
+      delete chunk;
+
+      AutoLock al(&m_lock);
+      m_endOfFile = true;
+      m_chunkReadEvent.notify();
+      return ;
+    } catch (IOException &ioEx) {
+      delete chunk;
+
+      AutoLock al(&m_lock);
+      m_failed = true;
+      m_errorMessage.setString(ioEx.getMessage());
+      m_chunkReadEvent.notify();
+      return ;
+    }
+
+    {
+      AutoLock al(&m_lock);
+
+      m_chunks.push_back(chunk);
+    }
+    m_chunkReadEvent.notify();
+  }
+}
+
+void UploadChunkReader::onTerminate()
+{
+  m_chunkTakenEvent.notify();
+}
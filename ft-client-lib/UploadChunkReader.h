@@ -0,0 +1,98 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _UPLOAD_CHUNK_READER_H_
+#define _UPLOAD_CHUNK_READER_H_
+
+#include "file-lib/WinFileChannel.h"
+#include "io-lib/IOException.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "util/StringStorage.h"
+#include "win-system/WindowsEvent.h"
+
+#include <deque>
+#include <vector>
+
+//
+// Thread that reads uploading file ahead by chunks, so disk reads
+// overlap with compression and sending of previous chunks.
+//
+// Remark: file must not be used by anyone else while reader exists.
+//
+
+class UploadChunkReader : public Thread
+{
+public:
+
+  //
+  // Parameters:
+  //
+  // [IN] file - file opened for reading at position of the first chunk
+  // [IN] chunkSize - initial chunk size in bytes
+  // [IN] maxChunks - count of chunks that can be read ahead
+  //
+  // Remark: thread is started by the constructor.
+  //
+
+  UploadChunkReader(WinFileChannel *file, UINT32 chunkSize, size_t maxChunks);
+
+  //
+  // Stops reading and waits until thread is finished.
+  //
+
+  virtual ~UploadChunkReader();
+
+  // Sets size of chunks that will be read after this call
+  void setChunkSize(UINT32 chunkSize);
+
+  //
+  // Waits for the next chunk and puts it to the chunk argument.
+  // Returns false if end of file is reached.
+  // Throws IOException if reading of file failed.
+  //
+
+  bool getChunk(std::vector<char> *chunk) throw(IOException);
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  WinFileChannel *m_file;
+  size_t m_maxChunks;
+
+  // Members below are protected by m_lock
+  LocalMutex m_lock;
+  std::deque<std::vector<char> *> m_chunks;
+  UINT32 m_chunkSize;
+  bool m_endOfFile;
+  bool m_failed;
+  StringStorage m_errorMessage;
+
+  // Notified when chunk is read, end of file reached or reading failed
+  WindowsEvent m_chunkReadEvent;
+  // Notified when chunk is taken by getChunk()
+  WindowsEvent m_chunkTakenEvent;
+};
+
+#endif
@@ -25,7 +25,7 @@
 #include "UploadOperation.h"
 
 #include "ft-common/WinFilePath.h"
-#include "ft-common/FolderListener.h"
+#include "ft-common/FolderWalker.h"
 #include "file-lib/EOFException.h"
 
 UploadOperation::UploadOperation(LogWriter *logWriter,
@@ -34,7 +34,13 @@ UploadOperation::UploadOperation(LogWriter *logWriter,
                                  const TCHAR *pathToTargetRoot)
 : CopyOperation(logWriter),
   m_file(0), m_fis(0), m_gotoChild(false), m_gotoParent(false), m_firstUpload(true),
-  m_remoteFilesInfo(0), m_remoteFilesCount(0)
+  m_remoteFilesInfo(0), m_remoteFilesCount(0),
+  m_reader(0), m_window(WINDOW_SIZE, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE),
+  m_endSent(false), m_isDraining(false),
+  m_deltaSupported(false), m_deltaRequestPending(false), m_deltaEncoder(0),
+  m_batchSupported(false), m_batchRequestPending(false),
+  m_hasDeferredUpload(false), m_deferredOffset(0), m_deferredRemoteSize(0),
+  m_folderCache(INFINITE)
 {
   m_pathToSourceRoot.setString(pathToSourceRoot);
   m_pathToTargetRoot.setString(pathToTargetRoot);
@@ -50,7 +56,13 @@ UploadOperation::UploadOperation(LogWriter *logWriter,
                                  const TCHAR *pathToTargetRoot)
 : CopyOperation(logWriter),
   m_file(0), m_fis(0), m_gotoChild(false), m_gotoParent(false), m_firstUpload(true),
-  m_remoteFilesInfo(0), m_remoteFilesCount(0)
+  m_remoteFilesInfo(0), m_remoteFilesCount(0),
+  m_reader(0), m_window(WINDOW_SIZE, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE),
+  m_endSent(false), m_isDraining(false),
+  m_deltaSupported(false), m_deltaRequestPending(false), m_deltaEncoder(0),
+  m_batchSupported(false), m_batchRequestPending(false),
+  m_hasDeferredUpload(false), m_deferredOffset(0), m_deferredRemoteSize(0),
+  m_folderCache(INFINITE)
 {
   m_pathToSourceRoot.setString(pathToSourceRoot);
   m_pathToTargetRoot.setString(pathToTargetRoot);
@@ -65,16 +77,20 @@ UploadOperation::~UploadOperation()
   if (m_toCopy != NULL) {
     delete m_toCopy->getRoot();
   }
-  if (m_fis != NULL) {
-    try { m_fis->close(); } catch (IOException) { }
-    delete m_fis;
-  }
-  if (m_file != NULL) {
-    delete m_file;
-  }
+  releaseFile();
   releaseRemoteFilesInfo();
 }
 
+void UploadOperation::setDeltaSupported(bool deltaSupported)
+{
+  m_deltaSupported = deltaSupported;
+}
+
+void UploadOperation::setBatchSupported(bool batchSupported)
+{
+  m_batchSupported = batchSupported;
+}
+
 void UploadOperation::start()
 {
   //
@@ -104,33 +120,83 @@ void UploadOperation::start()
 
 void UploadOperation::onUploadReply(DataInputStream *input)
 {
-  sendFileDataChunk();
+  m_deltaRequestPending = false;
+
+  m_window.reset();
+  m_endSent = false;
+  m_compressionAdvisor.reset();
+
+  m_reader = new UploadChunkReader(m_fis, m_window.getChunkSize(),
+                                   READ_AHEAD_CHUNKS);
+
+  sendFileDataChunks();
 }
 
 void UploadOperation::onUploadDataReply(DataInputStream *input)
 {
+  m_window.replyReceived(0);
+
+  if (m_isDraining) {
+    continueDrain();
+    return ;
+  }
+
   if (isTerminating()) {
-    gotoNext();
+    startDrain();
     return ;
   }
 
-  sendFileDataChunk();
+  m_reader->setChunkSize(m_window.getChunkSize());
+  if (m_deltaEncoder != NULL) {
+    m_deltaEncoder->setMaxLiteralSize(m_window.getChunkSize());
+  }
+
+  sendFileDataChunks();
 }
 
 void UploadOperation::onUploadEndReply(DataInputStream *input)
 {
-  // Cleanup
-  try { m_fis->close(); } catch (...) { }
-  delete m_fis;
-  m_fis = NULL;
+  m_window.replyReceived(0);
 
-  delete m_file;
-  m_file = NULL;
+  if (m_isDraining) {
+    continueDrain();
+    return ;
+  }
+
+  if (m_deltaEncoder != NULL) {
+    m_logWriter->info(_T("Delta upload of '%s': %I64u bytes sent, %I64u bytes reused\n"),
+                      m_pathToSourceFile.getString(),
+                      m_deltaEncoder->getLiteralBytes(),
+                      m_deltaEncoder->getCopiedBytes());
+  }
+
+  // Cleanup
+  releaseFile();
 
   // Upload next file in the list
   gotoNext();
 }
 
+void UploadOperation::onUploadBatchReply(DataInputStream *input)
+{
+  m_batchRequestPending = false;
+
+  const vector<StringStorage> *failedFiles = m_replyBuffer->getBatchFailedFiles();
+  const vector<StringStorage> *errors = m_replyBuffer->getBatchErrors();
+
+  for (size_t i = 0; i < failedFiles->size(); i++) {
+    StringStorage message;
+
+    message.format(_T("Error: failed to upload '%s' file (%s)"),
+                   (*failedFiles)[i].getString(),
+                   (*errors)[i].getString());
+
+    notifyError(message.getString());
+  }
+
+  continueAfterBatch();
+}
+
 void UploadOperation::onMkdirReply(DataInputStream *input)
 {
   // Upload next file in the list
@@ -139,12 +205,62 @@ void UploadOperation::onMkdirReply(DataInputStream *input)
 
 void UploadOperation::onLastRequestFailedReply(DataInputStream *input)
 {
+  //
+  // Server cannot make signature of remote file or cannot start
+  // delta upload, so upload the whole file instead.
+  //
+
+  if (m_deltaRequestPending) {
+    m_deltaRequestPending = false;
+
+    if (m_deltaEncoder != NULL) {
+      delete m_deltaEncoder;
+      m_deltaEncoder = NULL;
+    }
+
+    m_sender->sendUploadRequest(m_pathToTargetFile.getString(), true, 0);
+    return ;
+  }
+
+  // Server cannot process upload batch at all
+  if (m_batchRequestPending) {
+    m_batchRequestPending = false;
+
+    StringStorage errDesc;
+    StringStorage message;
+
+    m_replyBuffer->getLastErrorMessage(&errDesc);
+    message.format(_T("Error: failed to upload files (%s)"), errDesc.getString());
+    notifyError(message.getString());
+
+    continueAfterBatch();
+    return ;
+  }
+
+  // This LRF message can be received from upload data or end request
+  bool isDataReply = !m_window.isEmpty();
+
+  if (isDataReply) {
+    m_window.replyReceived(0);
+
+    if (m_isDraining) {
+      continueDrain();
+      return ;
+    }
+  }
+
   StringStorage errDesc;
 
   m_replyBuffer->getLastErrorMessage(&errDesc);
 
   notifyFailedToUpload(errDesc.getString());
 
+  // Skip replies to the rest of outstanding requests
+  if (isDataReply) {
+    startDrain();
+    return ;
+  }
+
   //
   // If this LRF message comes to file list request, then
   // don't need to upload next file, we must execute "special message handler".
@@ -164,6 +280,21 @@ void UploadOperation::onFileListReply(DataInputStream *input)
   specialHandler();
 }
 
+void UploadOperation::onFileSignatureReply(DataInputStream *input)
+{
+  if (isTerminating()) {
+    m_deltaRequestPending = false;
+    releaseFile();
+    gotoNext();
+    return ;
+  }
+
+  m_deltaEncoder = new DeltaEncoder(m_replyBuffer->getFileSignature(),
+                                    m_window.getChunkSize());
+
+  m_sender->sendDeltaUploadRequest(m_pathToTargetFile.getString());
+}
+
 void UploadOperation::killOp()
 {
   //
@@ -230,22 +361,12 @@ UINT64 UploadOperation::getFileSize(const TCHAR *pathToFile)
   File file(pathToFile);
 
   if (file.isDirectory()) {
-    UINT32 filesCount = 0;
-    file.list(NULL, &filesCount);
+    // Listings of walked folders are cached and used by processFolder()
+    FolderWalker folderWalker(&m_folderCache);
 
-    StringStorage *fileNames = new StringStorage[filesCount];
-    file.list(fileNames, NULL);
-
-    for (UINT32 i = 0; i < filesCount; i++) {
-      File subfile(pathToFile, fileNames[i].getString());
-
-      StringStorage pathToSubFile;
-      subfile.getPath(&pathToSubFile);
-
-      fileSize += getFileSize(pathToSubFile.getString());
+    if (!folderWalker.getFolderSize(pathToFile, &fileSize)) {
+      fileSize = 0;
     }
-
-    delete[] fileNames;
   } else {
     INT64 len = file.length();
     if (len == -1) {
@@ -294,10 +415,16 @@ void UploadOperation::processFolder()
 {
   StringStorage message;
 
-  // Try list files from folder
-  FolderListener listener(m_pathToSourceFile.getString());
-  if (listener.list()) {
-    m_toCopy->setChild(listener.getFilesInfo(), listener.getFilesCount());
+  // Try list files from folder, the folder is usually listed already
+  // when size of uploading files is calculated
+  std::vector<FileInfo> files;
+  bool isListed = m_folderCache.get(m_pathToSourceFile.getString(), &files, true);
+  if (!isListed) {
+    isListed = FolderWalker::listFolderContent(m_pathToSourceFile.getString(), &files);
+  }
+
+  if (isListed) {
+    m_toCopy->setChild(files.empty() ? NULL : &files.front(), files.size());
   } else {
     // Logging
     StringStorage message;
@@ -318,15 +445,11 @@ void UploadOperation::processFile()
   // Cleanup
   //
 
-  if (m_fis != NULL) {
-    try { m_fis->close(); } catch (...) { }
-    delete m_fis;
-  }
-  if (m_file != NULL) {
-    delete m_file;
-  }
+  releaseFile();
 
   UINT64 initialFileOffset = 0;
+  // Size of file that will be overwritten on remote machine
+  UINT64 remoteFileSize = 0;
 
   // Search if file already exists on remote machine
   for (UINT32 i = 0; i < m_remoteFilesCount; i++) {
@@ -349,6 +472,9 @@ void UploadOperation::processFile()
 
       switch (action) {
       case CopyFileEventListener::TFE_OVERWRITE:
+        if (!remoteFileInfo->isDirectory()) {
+          remoteFileSize = remoteFileInfo->getSize();
+        }
         break;
       case CopyFileEventListener::TFE_APPEND:
         initialFileOffset = remoteFileInfo->getSize();
@@ -385,56 +511,311 @@ void UploadOperation::processFile()
 
   bool overwrite = (initialFileOffset == 0);
 
-  m_sender->sendUploadRequest(m_pathToTargetFile.getString(), overwrite,
-                              initialFileOffset);
+  //
+  // Small files are collected to batch and uploaded by one request
+  //
+
+  if (overwrite && m_batchSupported &&
+      m_toCopy->getFileInfo()->getSize() <= MAX_BATCH_FILE_SIZE) {
+    addFileToBatch();
+    return ;
+  }
+
+  //
+  // Files collected before must be uploaded first, upload of this file
+  // is started when reply to upload batch request is received.
+  //
+
+  if (!m_batch.isEmpty()) {
+    m_hasDeferredUpload = true;
+    m_deferredOffset = initialFileOffset;
+    m_deferredRemoteSize = remoteFileSize;
+    sendBatch();
+    return ;
+  }
+
+  startFileUpload(initialFileOffset, remoteFileSize);
 } // void
 
-void UploadOperation::sendFileDataChunk()
+void UploadOperation::startFileUpload(UINT64 initialFileOffset,
+                                      UINT64 remoteFileSize)
 {
-  _ASSERT(m_fis != NULL);
+  bool overwrite = (initialFileOffset == 0);
 
-  const size_t bufferSize = 1024 * 8;
-  vector<char> buffer(bufferSize);
-  UINT32 read = 0;
-  try {
-    size_t portion = m_fis->read(&buffer.front(), bufferSize);
-    _ASSERT((UINT32)portion == portion);
-    read = (UINT32)portion;
-  } catch (EOFException) {
+  //
+  // Only changed parts of large file are uploaded, upload is started
+  // when signature of remote file is received.
+  //
 
-    //
-    // End of file.
-    //
+  if (overwrite && m_deltaSupported && remoteFileSize >= MIN_DELTA_FILE_SIZE) {
+    m_deltaRequestPending = true;
+    m_sender->sendFileSignatureRequest(m_pathToTargetFile.getString(),
+                                       chooseSignatureBlockSize(remoteFileSize));
+    return ;
+  }
 
-    m_fis->close();
+  m_sender->sendUploadRequest(m_pathToTargetFile.getString(), overwrite,
+                              initialFileOffset);
+}
 
-    UINT64 lastModified = 0;
+void UploadOperation::addFileToBatch()
+{
+  UINT64 lastModified = 0;
+  std::vector<char> content;
 
-    try {
-      lastModified = m_file->lastModified();
-    } catch (IOException) { } // try / catch
+  try {
+    lastModified = m_file->lastModified();
 
-    m_sender->sendUploadEndRequest(0, lastModified);
-    return ;
+    INT64 length = m_file->length();
+    if (length < 0 || (UINT64)length > MAX_BATCH_FILE_SIZE) {
+      throw IOException(_T("Size of file is changed"));
+    }
 
+    content.resize((size_t)length);
+    if (!content.empty()) {
+      DataInputStream input(m_fis);
+      input.readFully(&content.front(), content.size());
+    }
   } catch (IOException &ioEx) {
     notifyFailedToUpload(ioEx.getMessage());
+    releaseFile();
     gotoNext();
     return ;
   } // try / catch
 
-  try {
-    m_sender->sendUploadDataRequest(&buffer.front(), read, false);
-    m_totalBytesCopied += read;
+  releaseFile();
+
+  UINT32 size = (UINT32)content.size();
+  m_batch.addFile(m_pathToTargetFile.getString(), lastModified,
+                  content.empty() ? NULL : &content.front(), size);
+
+  m_totalBytesCopied += size;
+
+  // Notify listener, that data chunk is copied
+  if (m_copyListener != NULL) {
+    m_copyListener->dataChunkCopied(m_totalBytesCopied,
+                                    m_totalBytesToCopy);
+  }
+
+  if (m_batch.getSize() >= MAX_BATCH_SIZE ||
+      m_batch.getFilesCount() >= MAX_BATCH_FILES_COUNT) {
+    sendBatch();
+    return ;
+  }
+
+  gotoNext();
+}
+
+void UploadOperation::sendBatch()
+{
+  _ASSERT(!m_batch.isEmpty());
+
+  UINT32 size = (UINT32)m_batch.getSize();
+  _ASSERT(size == m_batch.getSize());
+
+  // Batch consists of several files, so no decisions made for previous
+  // file are used
+  m_compressionAdvisor.reset();
+  UINT8 compressionLevel = chooseCompressionLevel(m_batch.getData(), size);
+
+  m_batchRequestPending = true;
+  m_sender->sendUploadBatchRequest(m_batch.getFilesCount(),
+                                   m_batch.getData(), size,
+                                   compressionLevel);
+  m_batch.clear();
+}
+
+bool UploadOperation::isNextFileBatchable()
+{
+  if (isTerminating() || m_toCopy->getChild() != NULL) {
+    return false;
+  }
+
+  FileInfoList *next = m_toCopy->getNext();
+  if (next == NULL) {
+    return false;
+  }
+
+  FileInfo *fileInfo = next->getFileInfo();
+  return !fileInfo->isDirectory() && fileInfo->getSize() <= MAX_BATCH_FILE_SIZE;
+}
+
+void UploadOperation::continueAfterBatch()
+{
+  if (!m_hasDeferredUpload) {
+    gotoNext();
+    return ;
+  }
+
+  m_hasDeferredUpload = false;
+
+  if (isTerminating()) {
+    releaseFile();
+    gotoNext();
+    return ;
+  }
+
+  startFileUpload(m_deferredOffset, m_deferredRemoteSize);
+}
+
+void UploadOperation::sendFileDataChunks()
+{
+  _ASSERT(m_reader != NULL);
+
+  while (!m_endSent && !m_window.isFull()) {
+    bool hasChunk;
+
+    try {
+      if (m_deltaEncoder != NULL) {
+        hasChunk = getDeltaChunk();
+      } else {
+        hasChunk = m_reader->getChunk(&m_chunk);
+      }
+    } catch (IOException &ioEx) {
+      notifyFailedToUpload(ioEx.getMessage());
+      startDrain();
+      return ;
+    } // try / catch
+
+    if (!hasChunk) {
+
+      //
+      // End of file.
+      //
+
+      UINT64 lastModified = 0;
+
+      try {
+        lastModified = m_file->lastModified();
+      } catch (IOException) { } // try / catch
+
+      m_sender->sendUploadEndRequest(0, lastModified);
+      m_window.requestSent(0);
+      m_endSent = true;
+      return ;
+    }
+
+    // Upload copy request is sent instead of data
+    if (m_chunk.empty()) {
+      continue;
+    }
+
+    UINT32 size = (UINT32)m_chunk.size();
+    UINT8 compressionLevel = chooseCompressionLevel(&m_chunk.front(), size);
+
+    UINT32 sentSize = m_sender->sendUploadDataRequest(&m_chunk.front(), size,
+                                                      compressionLevel);
+    m_window.requestSent(size);
+
+    m_compressionAdvisor.chunkCompressed(compressionLevel, size, sentSize);
+
+    m_totalBytesCopied += size;
 
     // Notify listener, that data chunk is copied
     if (m_copyListener != NULL) {
       m_copyListener->dataChunkCopied(m_totalBytesCopied,
                                       m_totalBytesToCopy);
     }
-  } catch (IOException &ioEx) {
-    throw ioEx;
-  } // try / catch
+  }
+}
+
+bool UploadOperation::getDeltaChunk()
+{
+  while (!m_deltaEncoder->getOperation(&m_deltaOperation)) {
+    if (m_deltaEncoder->isFinished()) {
+      return false;
+    }
+    if (m_reader->getChunk(&m_chunk)) {
+      m_deltaEncoder->addData(&m_chunk.front(), m_chunk.size());
+    } else {
+      m_deltaEncoder->finish();
+    }
+  }
+
+  if (m_deltaOperation.copyLength == 0) {
+    m_chunk.swap(m_deltaOperation.literal);
+    return true;
+  }
+
+  m_sender->sendUploadCopyRequest(m_deltaOperation.copyOffset,
+                                  m_deltaOperation.copyLength);
+  m_window.requestSent(0);
+  m_chunk.clear();
+
+  m_totalBytesCopied += m_deltaOperation.copyLength;
+
+  if (m_copyListener != NULL) {
+    m_copyListener->dataChunkCopied(m_totalBytesCopied,
+                                    m_totalBytesToCopy);
+  }
+  return true;
+}
+
+UINT32 UploadOperation::chooseSignatureBlockSize(UINT64 fileSize)
+{
+  // Square root of file size gives minimum of signature size plus
+  // size of literal data around changes
+  UINT32 blockSize = MIN_SIGNATURE_BLOCK_SIZE;
+  while (blockSize < MAX_SIGNATURE_BLOCK_SIZE &&
+         (UINT64)blockSize * blockSize < fileSize) {
+    blockSize *= 2;
+  }
+  return blockSize;
+}
+
+UINT8 UploadOperation::chooseCompressionLevel(const char *data, UINT32 size)
+{
+  if (!m_replyBuffer->isCompressionSupported()) {
+    return 0;
+  }
+
+  int level = 6; // Default zlib level
+  if (m_window.getRate() > FAST_LINK_RATE) {
+    level = Z_BEST_SPEED;
+  }
+  return (UINT8)m_compressionAdvisor.chooseLevel(data, size, level);
+}
+
+void UploadOperation::startDrain()
+{
+  m_isDraining = true;
+
+  releaseFile();
+
+  continueDrain();
+}
+
+void UploadOperation::continueDrain()
+{
+  if (!m_window.isEmpty()) {
+    return ;
+  }
+
+  m_isDraining = false;
+
+  gotoNext();
+}
+
+void UploadOperation::releaseFile()
+{
+  // Reader must be stopped before the file is closed
+  if (m_reader != NULL) {
+    delete m_reader;
+    m_reader = NULL;
+  }
+  if (m_deltaEncoder != NULL) {
+    delete m_deltaEncoder;
+    m_deltaEncoder = NULL;
+  }
+  if (m_fis != NULL) {
+    try { m_fis->close(); } catch (...) { }
+    delete m_fis;
+    m_fis = NULL;
+  }
+  if (m_file != NULL) {
+    delete m_file;
+    m_file = NULL;
+  }
 }
 
 void UploadOperation::gotoNext()
@@ -444,6 +825,16 @@ void UploadOperation::gotoNext()
 
 void UploadOperation::gotoNext(bool fake)
 {
+  //
+  // Collected files are sent before any other request, so replies
+  // come in the order the operation expects.
+  //
+
+  if (!m_batch.isEmpty() && !isNextFileBatchable()) {
+    sendBatch();
+    return ;
+  }
+
   FileInfoList *current = m_toCopy;
 
   bool hasChild = current->getChild() != NULL;
@@ -30,6 +30,12 @@
 #include "FileTransferOperation.h"
 #include "FileInfoList.h"
 #include "CopyOperation.h"
+#include "TransferWindow.h"
+#include "UploadChunkReader.h"
+#include "DeltaEncoder.h"
+#include "UploadBatch.h"
+#include "ft-common/FolderMetadataCache.h"
+#include "ft-common/CompressionAdvisor.h"
 
 //
 // File transfer operation class for uploading files (and file trees).
@@ -80,6 +86,20 @@ public:
 
   virtual ~UploadOperation();
 
+  //
+  // Allows to upload only changed parts of files that already exist
+  // on remote machine (server supports delta upload).
+  //
+
+  void setDeltaSupported(bool deltaSupported);
+
+  //
+  // Allows to upload small files by batches (server supports
+  // upload batch requests).
+  //
+
+  void setBatchSupported(bool batchSupported);
+
   //
   // Starts upload operation
   //
@@ -95,9 +115,11 @@ public:
   virtual void onUploadReply(DataInputStream *input) throw(IOException);
   virtual void onUploadDataReply(DataInputStream *input) throw(IOException);
   virtual void onUploadEndReply(DataInputStream *input) throw(IOException);
+  virtual void onUploadBatchReply(DataInputStream *input) throw(IOException);
   virtual void onMkdirReply(DataInputStream *input) throw(IOException);
   virtual void onLastRequestFailedReply(DataInputStream *input) throw(IOException);
   virtual void onFileListReply(DataInputStream *input) throw(IOException);
+  virtual void onFileSignatureReply(DataInputStream *input) throw(IOException);
 
 private:
 
@@ -135,6 +157,41 @@ protected:
 
   void processFile() throw(IOException);
 
+  //
+  // Sends request to upload current file (or its signature request for
+  // delta upload), file must be opened already.
+  //
+
+  void startFileUpload(UINT64 initialFileOffset,
+                       UINT64 remoteFileSize) throw(IOException);
+
+  //
+  // Reads current file to upload batch and goes to next file, sends
+  // the batch when it's full.
+  //
+
+  void addFileToBatch() throw(IOException);
+
+  //
+  // Sends upload batch request with collected files.
+  //
+
+  void sendBatch() throw(IOException);
+
+  //
+  // Returns true if next file can be added to the same upload batch
+  // as the current one.
+  //
+
+  bool isNextFileBatchable();
+
+  //
+  // Starts deferred upload of current file or goes to next file
+  // after reply to upload batch request.
+  //
+
+  void continueAfterBatch() throw(IOException);
+
   //
   // Calls gotoNext method with true 'fake' argument
   //
@@ -152,11 +209,53 @@ protected:
   void gotoNext(bool fake) throw(IOException);
 
   //
-  // Reads data chunk from current uploading file and
-  // sends it to server.
+  // Sends chunks of current uploading file (read ahead by m_reader)
+  // to server until window of outstanding requests is full. Sends
+  // upload end request when end of file is reached.
+  //
+
+  void sendFileDataChunks() throw(IOException);
+
+  //
+  // Takes next delta operation of current file. Sends upload copy
+  // request for copy operation and leaves m_chunk empty, moves literal
+  // data to m_chunk otherwise. Returns false when all data is encoded.
   //
 
-  void sendFileDataChunk() throw(IOException);
+  bool getDeltaChunk() throw(IOException);
+
+  //
+  // Returns size of blocks of remote file signature for delta upload
+  // of file with specified size.
+  //
+
+  static UINT32 chooseSignatureBlockSize(UINT64 fileSize);
+
+  //
+  // Decides if next chunk should be compressed and with which level.
+  //
+
+  UINT8 chooseCompressionLevel(const char *data, UINT32 size);
+
+  //
+  // Stops reading of current file, sending new requests and waits for
+  // replies to the outstanding ones, then goes to next file.
+  //
+
+  void startDrain() throw(IOException);
+
+  //
+  // Goes to next file when all replies to outstanding requests
+  // have been received.
+  //
+
+  void continueDrain() throw(IOException);
+
+  //
+  // Stops read ahead thread and closes current uploading file.
+  //
+
+  void releaseFile();
 
   //
   // Helper methods to control m_remoteFilesInfo, m_remoteFilesCount
@@ -191,6 +290,74 @@ protected:
   bool m_gotoChild;
   bool m_gotoParent;
   bool m_firstUpload;
+
+  //
+  // Upload pipeline members
+  //
+
+  // Reads current file ahead
+  UploadChunkReader *m_reader;
+  // Outstanding upload data requests and size of next chunks
+  TransferWindow m_window;
+  // Buffer for chunk that is sent now
+  std::vector<char> m_chunk;
+  // Upload end request is sent for current file
+  bool m_endSent;
+  // Replies to outstanding requests are ignored until all of them
+  // will be received
+  bool m_isDraining;
+
+  // Decides which chunks of current file are compressed
+  CompressionAdvisor m_compressionAdvisor;
+
+  //
+  // Delta upload members
+  //
+
+  bool m_deltaSupported;
+  // File signature request or delta upload start request is sent,
+  // usual upload is started if it fails
+  bool m_deltaRequestPending;
+  // Encoder of current file, NULL if the file is uploaded as is
+  DeltaEncoder *m_deltaEncoder;
+  DeltaOperation m_deltaOperation;
+
+  //
+  // Upload batch members
+  //
+
+  bool m_batchSupported;
+  // Small files that are not sent yet
+  UploadBatch m_batch;
+  // Upload batch request is sent, reply to it is not received yet
+  bool m_batchRequestPending;
+  // Upload of current file is started after reply to upload batch request
+  bool m_hasDeferredUpload;
+  UINT64 m_deferredOffset;
+  UINT64 m_deferredRemoteSize;
+
+  // Listings of local folders that are made when size of uploading
+  // files is calculated, every listing is taken when folder is uploaded
+  FolderMetadataCache m_folderCache;
+
+  static const UINT32 MIN_CHUNK_SIZE = 8 * 1024;
+  static const UINT32 MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+  // Count of upload data requests that can be in flight
+  static const size_t WINDOW_SIZE = 4;
+  // Count of chunks that can be read ahead
+  static const size_t READ_AHEAD_CHUNKS = 4;
+  // Transfer rate (bytes per second) above which the fastest compression
+  // level is used to make compression not to limit the transfer
+  static const UINT64 FAST_LINK_RATE = 4 * 1024 * 1024;
+  // Remote files smaller than this are always uploaded as is
+  static const UINT64 MIN_DELTA_FILE_SIZE = 64 * 1024;
+  static const UINT32 MIN_SIGNATURE_BLOCK_SIZE = 2 * 1024;
+  static const UINT32 MAX_SIGNATURE_BLOCK_SIZE = 128 * 1024;
+  // Files larger than this are never uploaded by batches
+  static const UINT64 MAX_BATCH_FILE_SIZE = 64 * 1024;
+  // Batch is sent when its size or count of files reaches these limits
+  static const size_t MAX_BATCH_SIZE = 1024 * 1024;
+  static const UINT32 MAX_BATCH_FILES_COUNT = 128;
 };
 
 #endif
@@ -0,0 +1,151 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "CompressionAdvisor.h"
+
+#include "util/ZLibBase.h"
+
+#include <math.h>
+
+//
+// Data with entropy above this value (bits per byte) is not compressed,
+// the estimate of random data by 4 KB sample is about 7.95.
+//
+
+static const double MAX_COMPRESSIBLE_ENTROPY = 7.5;
+
+//
+// Data with entropy below this value is compressed with fastest level,
+// higher levels do not make it much smaller.
+//
+
+static const double REDUNDANT_DATA_ENTROPY = 3.0;
+
+CompressionAdvisor::CompressionAdvisor()
+: m_skips(0),
+  m_backoff(0)
+{
+}
+
+CompressionAdvisor::~CompressionAdvisor()
+{
+}
+
+void CompressionAdvisor::reset()
+{
+  m_skips = 0;
+  m_backoff = 0;
+}
+
+int CompressionAdvisor::chooseLevel(const char *data, size_t size, int level)
+{
+  if (level == 0 || size == 0) {
+    return 0;
+  }
+
+  if (m_skips > 0) {
+    m_skips--;
+    return 0;
+  }
+
+  if (size < MIN_ESTIMATED_SIZE) {
+    return level;
+  }
+
+  double entropy = estimateEntropy(data, size);
+
+  if (entropy > MAX_COMPRESSIBLE_ENTROPY) {
+    skipCompression();
+    return 0;
+  }
+  if (entropy < REDUNDANT_DATA_ENTROPY) {
+    return Z_BEST_SPEED;
+  }
+  return level;
+}
+
+void CompressionAdvisor::chunkCompressed(int level, size_t size,
+                                         size_t compressedSize)
+{
+  if (level == 0) {
+    return ;
+  }
+
+  // Estimation can be wrong, so real result of compression is checked too
+  if ((UINT64)compressedSize * 10 > (UINT64)size * 9) {
+    skipCompression();
+  } else {
+    m_backoff = 0;
+  }
+}
+
+void CompressionAdvisor::skipCompression()
+{
+  m_backoff = m_backoff * 2;
+  if (m_backoff == 0) {
+    m_backoff = 1;
+  }
+  if (m_backoff > MAX_BACKOFF) {
+    m_backoff = MAX_BACKOFF;
+  }
+  m_skips = m_backoff;
+}
+
+double CompressionAdvisor::estimateEntropy(const char *data, size_t size)
+{
+  if (size == 0) {
+    return 0;
+  }
+
+  UINT32 counts[256] = { 0 };
+  size_t sampleSize = 0;
+
+  if (size <= SAMPLE_BLOCKS_COUNT * SAMPLE_BLOCK_SIZE) {
+    for (size_t i = 0; i < size; i++) {
+      counts[(UINT8)data[i]]++;
+    }
+    sampleSize = size;
+  } else {
+    size_t step = (size - SAMPLE_BLOCK_SIZE) / (SAMPLE_BLOCKS_COUNT - 1);
+    for (size_t block = 0; block < SAMPLE_BLOCKS_COUNT; block++) {
+      const char *blockData = data + block * step;
+      for (size_t i = 0; i < SAMPLE_BLOCK_SIZE; i++) {
+        counts[(UINT8)blockData[i]]++;
+      }
+    }
+    sampleSize = SAMPLE_BLOCKS_COUNT * SAMPLE_BLOCK_SIZE;
+  }
+
+  //
+  // Shannon entropy: H = -sum(p * log2(p)), where p = count / sampleSize
+  //
+
+  double entropy = 0;
+  for (int i = 0; i < 256; i++) {
+    if (counts[i] != 0) {
+      double p = (double)counts[i] / sampleSize;
+      entropy -= p * log(p);
+    }
+  }
+  return entropy / log(2.0);
+}
@@ -0,0 +1,97 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _COMPRESSION_ADVISOR_H_
+#define _COMPRESSION_ADVISOR_H_
+
+#include "util/inttypes.h"
+
+//
+// Decides if chunks of transferred file should be compressed and
+// with which compression level.
+//
+// Sample of every chunk is taken to estimate entropy of its data,
+// data that is already compressed (archives, media) is sent as is.
+// When file turns out to be not compressible, following chunks of it
+// are sent as is without estimation, and the next try is made after
+// twice as many chunks as the previous one.
+//
+
+class CompressionAdvisor
+{
+public:
+  CompressionAdvisor();
+  virtual ~CompressionAdvisor();
+
+  //
+  // Forgets decisions that are made for previous file, must be called
+  // when transfer of next file is started.
+  //
+
+  void reset();
+
+  //
+  // Returns compression level for chunk of file (zero means that chunk
+  // should be sent as is).
+  //
+  // Parameters:
+  //
+  // [IN] data, size - chunk of file
+  // [IN] level - compression level that is used for compressible data
+  //
+
+  int chooseLevel(const char *data, size_t size, int level);
+
+  //
+  // Informs advisor about size of chunk after compression with specified
+  // level.
+  //
+
+  void chunkCompressed(int level, size_t size, size_t compressedSize);
+
+  //
+  // Returns estimated entropy of data in bits per byte (from 0 to 8)
+  // that is calculated by sample of the data.
+  //
+
+  static double estimateEntropy(const char *data, size_t size);
+
+protected:
+  // Marks file as not compressible for next few chunks
+  void skipCompression();
+
+  // Count of next chunks that are sent as is without estimation
+  UINT32 m_skips;
+  // Value of m_skips after next chunk that is not compressible
+  UINT32 m_backoff;
+
+  // Maximal count of chunks sent as is before next try
+  static const UINT32 MAX_BACKOFF = 64;
+  // Chunks smaller than this are compressed without estimation
+  static const size_t MIN_ESTIMATED_SIZE = 1024;
+  // Sample consists of this count of blocks spread over the chunk
+  static const size_t SAMPLE_BLOCKS_COUNT = 16;
+  static const size_t SAMPLE_BLOCK_SIZE = 256;
+};
+
+#endif
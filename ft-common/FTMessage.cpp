@@ -50,3 +50,13 @@ const char FTMessage::RENAME_REPLY_SIG[]                = "FTSFMRLY";
 const char FTMessage::DIRSIZE_REQUEST_SIG[]             = "FTCDSRST";
 const char FTMessage::DIRSIZE_REPLY_SIG[]               = "FTSDSRLY";
 const char FTMessage::LAST_REQUEST_FAILED_REPLY_SIG[]   = "FTLRFRLY";
+const char FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST_SIG[] = "FTCDWRST";
+const char FTMessage::FILE_SIGNATURE_REQUEST_SIG[]      = "FTCFSRST";
+const char FTMessage::FILE_SIGNATURE_REPLY_SIG[]        = "FTSFSRLY";
+const char FTMessage::UPLOAD_COPY_REQUEST_SIG[]         = "FTCUCRST";
+const char FTMessage::FILE_LIST_PAGED_REQUEST_SIG[]     = "FTCFPRST";
+const char FTMessage::FILE_LIST_PAGE_REPLY_SIG[]        = "FTSFPRLY";
+const char FTMessage::UPLOAD_BATCH_REQUEST_SIG[]        = "FTCUBRST";
+const char FTMessage::UPLOAD_BATCH_REPLY_SIG[]          = "FTSUBRLY";
+const char FTMessage::DOWNLOAD_BATCH_REQUEST_SIG[]      = "FTCDBRST";
+const char FTMessage::DOWNLOAD_BATCH_REPLY_SIG[]        = "FTSDBRLY";
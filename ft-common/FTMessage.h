@@ -233,6 +233,169 @@ public:
 
   const static UINT32 LAST_REQUEST_FAILED_REPLY = 0xFC000119;
   const static char LAST_REQUEST_FAILED_REPLY_SIG[];
+
+  const static char DOWNLOAD_DATA_WINDOW_REQUEST_SIG[];
+  /**
+   * Request for next chunk of downloading file that can be pipelined, i.e.
+   * client may send several of such requests without waiting for replies.
+   *
+   * @body:
+   *  UINT8 compressionLevel preffered compression level.
+   *  UINT32 dataSize maximum size of requested file data in bytes (server
+   *    can send less than requested).
+   *
+   * @reply DOWNLOAD_DATA_REPLY while file data remains, DOWNLOAD_END_REPLY
+   * when end of file is reached, LAST_REQUEST_FAILED_REPLY on fail.
+   *
+   * @remark unlike DOWNLOAD_DATA_REQUEST, requests that arrive after end of
+   * file has been reached are answered with DOWNLOAD_END_REPLY again
+   * (until next DOWNLOAD_START_REQUEST), so client can drain its window of
+   * outstanding requests without errors.
+   */
+  const static UINT32 DOWNLOAD_DATA_WINDOW_REQUEST = 0xFC00011A;
+
+  const static char FILE_SIGNATURE_REQUEST_SIG[];
+  const static char FILE_SIGNATURE_REPLY_SIG[];
+  /**
+   * Request for signature of remote file (checksums of its blocks) that is
+   * used by client to upload only changed parts of the file.
+   *
+   * @body:
+   *   StringUTF8 pathToFile absolute path to file.
+   *   UINT32 blockSize size of blocks in bytes.
+   *
+   * @reply FILE_SIGNATURE_REPLY on success, LAST_REQUEST_FAILED_REPLY on fail.
+   */
+  const static UINT32 FILE_SIGNATURE_REQUEST = 0xFC00011B;
+  /**
+   * Reply to FILE_SIGNATURE_REQUEST message.
+   *
+   * @body:
+   *   UINT32 blockSize size of blocks in bytes.
+   *   UINT64 fileSize size of file in bytes.
+   *   UINT32 blockCount count of blocks (the last one can be shorter).
+   *   struct {
+   *     UINT32 weakSum rolling checksum of block.
+   *     UINT8 strongSum[16] md5 hash of block.
+   *   } blocks[blockCount].
+   *
+   * @see FileSignature and RollingChecksum classes.
+   */
+  const static UINT32 FILE_SIGNATURE_REPLY = 0xFC00011C;
+
+  const static char UPLOAD_COPY_REQUEST_SIG[];
+  /**
+   * Appends data from the current version of uploading file to the
+   * new one (delta upload).
+   *
+   * Delta upload is started by UPLOAD_START_REQUEST with 0x2 flag: server
+   * writes the uploaded file to temporary file and replaces the existing one
+   * with it on UPLOAD_END_REQUEST. New file is built from literal data
+   * (UPLOAD_DATA_REQUEST) and ranges of the existing file (this message).
+   *
+   * @body:
+   *   UINT64 offset offset of range in existing file.
+   *   UINT64 length length of range in bytes.
+   *
+   * @reply UPLOAD_DATA_REPLY on success, LAST_REQUEST_FAILED_REPLY on fail.
+   */
+  const static UINT32 UPLOAD_COPY_REQUEST = 0xFC00011D;
+
+  const static char FILE_LIST_PAGED_REQUEST_SIG[];
+  const static char FILE_LIST_PAGE_REPLY_SIG[];
+  /**
+   * Request for content of remote folder that is sent in several
+   * parts while the folder is enumerated.
+   *
+   * @body: the same as body of FILE_LIST_REQUEST.
+   *
+   * @reply one or more FILE_LIST_PAGE_REPLY messages, the last one has
+   * 0x1 flag set. LAST_REQUEST_FAILED_REPLY on fail (it can follow pages
+   * that are already sent).
+   */
+  const static UINT32 FILE_LIST_PAGED_REQUEST = 0xFC00011E;
+  /**
+   * Reply to FILE_LIST_PAGED_REQUEST message, contains part of
+   * folder content.
+   *
+   * @body:
+   *   UINT8 flags 0x1 if this is the last part of folder content.
+   *   UINT8 compressionLevel, UINT32 compressedSize, UINT32 uncompressedSize
+   *   and data in the same format as body of FILE_LIST_REPLY.
+   */
+  const static UINT32 FILE_LIST_PAGE_REPLY = 0xFC00011F;
+
+  const static char UPLOAD_BATCH_REQUEST_SIG[];
+  const static char UPLOAD_BATCH_REPLY_SIG[];
+  /**
+   * Uploads several small files at once (with overwriting of existing
+   * files), so files do not cost round trips of upload start, data and
+   * end requests each.
+   *
+   * @body:
+   *   UINT32 filesCount count of files in batch.
+   *   UINT8 compressionLevel, UINT32 compressedSize, UINT32 uncompressedSize
+   *   and data of batch, that is sequence of files:
+   *   struct {
+   *     StringUTF8 pathToFile absolute path to file.
+   *     UINT64 modificationTime modification time of file.
+   *     UINT32 fileSize size of file in bytes.
+   *     UINT8 data[fileSize] content of file.
+   *   } files[filesCount].
+   *
+   * @reply UPLOAD_BATCH_REPLY, LAST_REQUEST_FAILED_REPLY if the batch
+   * cannot be processed at all.
+   *
+   * @remark compressed data is a part of the same zlib stream as data of
+   * UPLOAD_DATA_REQUEST messages.
+   */
+  const static UINT32 UPLOAD_BATCH_REQUEST = 0xFC000120;
+  /**
+   * Reply to UPLOAD_BATCH_REQUEST message.
+   *
+   * @body:
+   *   UINT32 failedCount count of files that cannot be written.
+   *   struct {
+   *     StringUTF8 pathToFile absolute path to file.
+   *     StringUTF8 message error description.
+   *   } failures[failedCount].
+   */
+  const static UINT32 UPLOAD_BATCH_REPLY = 0xFC000121;
+
+  const static char DOWNLOAD_BATCH_REQUEST_SIG[];
+  const static char DOWNLOAD_BATCH_REPLY_SIG[];
+  /**
+   * Downloads several small files at once, so files do not cost round
+   * trips of download start, data and end requests each.
+   *
+   * @body:
+   *   UINT8 compressionLevel zero if client does not allow compression.
+   *   UINT32 filesCount count of files in batch (not more than 1024).
+   *   StringUTF8 pathToFile[filesCount] absolute paths to files.
+   *
+   * @reply DOWNLOAD_BATCH_REPLY, LAST_REQUEST_FAILED_REPLY if the batch
+   * cannot be processed at all.
+   */
+  const static UINT32 DOWNLOAD_BATCH_REQUEST = 0xFC000122;
+  /**
+   * Reply to DOWNLOAD_BATCH_REQUEST message.
+   *
+   * @body:
+   *   UINT32 filesCount count of files that are read.
+   *   UINT8 compressionLevel, UINT32 compressedSize, UINT32 uncompressedSize
+   *   and data of read files in the same format as data of
+   *   UPLOAD_BATCH_REQUEST, in order of the request.
+   *   UINT32 failedCount count of files that cannot be read.
+   *   struct {
+   *     StringUTF8 pathToFile absolute path to file.
+   *     StringUTF8 message error description.
+   *   } failures[failedCount].
+   *
+   * @remark paths to files are the same as in the request. Compressed data
+   * is a part of the same zlib stream as data of DOWNLOAD_DATA_REPLY
+   * messages.
+   */
+  const static UINT32 DOWNLOAD_BATCH_REPLY = 0xFC000123;
 };
 
 #endif
@@ -0,0 +1,158 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FileSignature.h"
+#include "RollingChecksum.h"
+
+#include "util/md5.h"
+
+FileSignature::FileSignature()
+: m_blockSize(0),
+  m_fileSize(0)
+{
+}
+
+FileSignature::~FileSignature()
+{
+}
+
+void FileSignature::calculate(MappedFileChannel *file, UINT32 blockSize)
+{
+  _ASSERT(blockSize >= MIN_BLOCK_SIZE && blockSize <= MAX_BLOCK_SIZE);
+
+  m_blockSize = blockSize;
+  m_fileSize = 0;
+  m_weakSums.clear();
+  m_strongSums.clear();
+
+  m_weakSums.reserve((size_t)(file->getSize() / blockSize + 1));
+  m_strongSums.reserve((size_t)(file->getSize() / blockSize + 1) * STRONG_SUM_SIZE);
+
+  // Used only for blocks that cross boundary of mapped window
+  std::vector<char> block;
+
+  while (true) {
+    //
+    // Blocks are hashed directly in the file mapping
+    //
+
+    const char *data;
+    size_t length = file->map(&data, blockSize);
+
+    if (length == 0) {
+      break;
+    }
+
+    if (length < blockSize) {
+      block.assign(data, data + length);
+
+      const char *portion;
+      size_t portionLength;
+      while (block.size() < blockSize &&
+             (portionLength = file->map(&portion, blockSize - block.size())) != 0) {
+        block.insert(block.end(), portion, portion + portionLength);
+      }
+
+      data = &block.front();
+      length = block.size();
+    }
+
+    m_weakSums.push_back(RollingChecksum::calculate(data, length));
+
+    MD5 md5;
+    md5.update(data, (UINT32)length);
+    md5.finalize();
+    m_strongSums.insert(m_strongSums.end(), md5.getHash(),
+                        md5.getHash() + STRONG_SUM_SIZE);
+
+    m_fileSize += length;
+  }
+}
+
+void FileSignature::write(DataOutputStream *output) const
+{
+  output->writeUInt32(m_blockSize);
+  output->writeUInt64(m_fileSize);
+  output->writeUInt32((UINT32)m_weakSums.size());
+
+  for (size_t i = 0; i < m_weakSums.size(); i++) {
+    output->writeUInt32(m_weakSums[i]);
+    output->writeFully(getStrongSum(i), STRONG_SUM_SIZE);
+  }
+}
+
+void FileSignature::read(DataInputStream *input)
+{
+  m_blockSize = input->readUInt32();
+  m_fileSize = input->readUInt64();
+  UINT32 blockCount = input->readUInt32();
+
+  if (m_blockSize < MIN_BLOCK_SIZE || m_blockSize > MAX_BLOCK_SIZE ||
+      blockCount != (m_fileSize + m_blockSize - 1) / m_blockSize) {
+    throw IOException(_T("Invalid file signature"));
+  }
+
+  m_weakSums.resize(blockCount);
+  m_strongSums.resize(blockCount * STRONG_SUM_SIZE);
+
+  for (UINT32 i = 0; i < blockCount; i++) {
+    m_weakSums[i] = input->readUInt32();
+    input->readFully(&m_strongSums[i * STRONG_SUM_SIZE], STRONG_SUM_SIZE);
+  }
+}
+
+UINT32 FileSignature::getBlockSize() const
+{
+  return m_blockSize;
+}
+
+UINT64 FileSignature::getFileSize() const
+{
+  return m_fileSize;
+}
+
+size_t FileSignature::getBlockCount() const
+{
+  return m_weakSums.size();
+}
+
+UINT32 FileSignature::getBlockLength(size_t index) const
+{
+  UINT64 rest = m_fileSize - getBlockOffset(index);
+  return rest < m_blockSize ? (UINT32)rest : m_blockSize;
+}
+
+UINT64 FileSignature::getBlockOffset(size_t index) const
+{
+  return (UINT64)index * m_blockSize;
+}
+
+UINT32 FileSignature::getWeakSum(size_t index) const
+{
+  return m_weakSums[index];
+}
+
+const UINT8 *FileSignature::getStrongSum(size_t index) const
+{
+  return &m_strongSums[index * STRONG_SUM_SIZE];
+}
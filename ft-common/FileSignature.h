@@ -0,0 +1,108 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FILE_SIGNATURE_H_
+#define _FILE_SIGNATURE_H_
+
+#include "util/inttypes.h"
+#include "file-lib/MappedFileChannel.h"
+#include "io-lib/DataInputStream.h"
+#include "io-lib/DataOutputStream.h"
+#include "io-lib/IOException.h"
+
+#include <vector>
+
+//
+// Signature of file for delta transfer: file is split to blocks of
+// equal size (the last block can be shorter), every block has weak
+// rolling checksum and strong MD5 hash.
+//
+// Format of signature in file transfer protocol:
+//   UINT32 blockSize size of blocks in bytes.
+//   UINT64 fileSize size of file in bytes.
+//   UINT32 blockCount count of blocks.
+//   struct {
+//     UINT32 weakSum rolling checksum of block (see RollingChecksum class).
+//     UINT8 strongSum[16] MD5 hash of block.
+//   } blocks[blockCount].
+//
+
+class FileSignature
+{
+public:
+  const static UINT32 MIN_BLOCK_SIZE = 512;
+  const static UINT32 MAX_BLOCK_SIZE = 1024 * 1024;
+  const static size_t STRONG_SUM_SIZE = 16;
+
+public:
+  FileSignature();
+  virtual ~FileSignature();
+
+  //
+  // Calculates signature of file reading it to the end in one pass.
+  //
+
+  void calculate(MappedFileChannel *file, UINT32 blockSize) throw(IOException);
+
+  //
+  // Writes signature in protocol format.
+  //
+
+  void write(DataOutputStream *output) const throw(IOException);
+
+  //
+  // Reads signature in protocol format.
+  // Throws IOException if signature is not consistent.
+  //
+
+  void read(DataInputStream *input) throw(IOException);
+
+  UINT32 getBlockSize() const;
+  UINT64 getFileSize() const;
+  size_t getBlockCount() const;
+
+  //
+  // Returns size of block, it's equal to block size for all blocks
+  // but the last one.
+  //
+
+  UINT32 getBlockLength(size_t index) const;
+
+  //
+  // Returns offset of block in file.
+  //
+
+  UINT64 getBlockOffset(size_t index) const;
+
+  UINT32 getWeakSum(size_t index) const;
+  const UINT8 *getStrongSum(size_t index) const;
+
+protected:
+  UINT32 m_blockSize;
+  UINT64 m_fileSize;
+  std::vector<UINT32> m_weakSums;
+  // STRONG_SUM_SIZE bytes per block
+  std::vector<UINT8> m_strongSums;
+};
+
+#endif
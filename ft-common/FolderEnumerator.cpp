@@ -0,0 +1,96 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FolderEnumerator.h"
+
+#include "util/DateTime.h"
+
+FolderEnumerator::FolderEnumerator(const TCHAR *folderPath)
+: m_findHandle(INVALID_HANDLE_VALUE),
+  m_hasFindData(false)
+{
+  m_folderPath.setString(folderPath);
+}
+
+FolderEnumerator::~FolderEnumerator()
+{
+  if (m_findHandle != INVALID_HANDLE_VALUE) {
+    FindClose(m_findHandle);
+  }
+}
+
+bool FolderEnumerator::open()
+{
+  StringStorage searchPath(m_folderPath.getString());
+  searchPath.appendString(_T("\\*"));
+
+  //
+  // Change error mode to avoid windows error message in message box
+  // when we attemt to find first file on unmounted device
+  //
+
+  UINT savedErrorMode = SetErrorMode(SEM_FAILCRITICALERRORS);
+
+  m_findHandle = FindFirstFile(searchPath.getString(), &m_findData);
+
+  // Restore error mode
+  SetErrorMode(savedErrorMode);
+
+  m_hasFindData = m_findHandle != INVALID_HANDLE_VALUE;
+
+  return m_hasFindData;
+}
+
+bool FolderEnumerator::next(FileInfo *fileInfo)
+{
+  while (m_hasFindData) {
+    const TCHAR *fileName = m_findData.cFileName;
+
+    //
+    // Skip "fake" file names
+    //
+
+    bool isFake = _tcscmp(fileName, _T(".")) == 0 ||
+                  _tcscmp(fileName, _T("..")) == 0;
+
+    if (!isFake) {
+      if ((m_findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+        *fileInfo = FileInfo(0, 0, FileInfo::DIRECTORY, fileName);
+      } else {
+        INT64 maxDWORDPlusOne = 1 + (INT64)MAXDWORD;
+        UINT64 size = m_findData.nFileSizeHigh * maxDWORDPlusOne +
+                      m_findData.nFileSizeLow;
+        DateTime lastModified(m_findData.ftLastWriteTime);
+
+        *fileInfo = FileInfo(size, lastModified.getTime(), 0, fileName);
+      }
+    }
+
+    m_hasFindData = FindNextFile(m_findHandle, &m_findData) != FALSE;
+
+    if (!isFake) {
+      return true;
+    }
+  }
+  return false;
+}
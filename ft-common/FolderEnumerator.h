@@ -0,0 +1,73 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FOLDER_ENUMERATOR_H_
+#define _FOLDER_ENUMERATOR_H_
+
+#include "util/inttypes.h"
+#include "util/CommonHeader.h"
+#include "ft-common/FileInfo.h"
+
+//
+// This class is used to list files from specified directory one by one,
+// so the files info is available before whole directory is listed
+// and it's never kept in memory at once.
+//
+// Unlike FolderListener, files info is taken from directory entries,
+// files are not queried one by one.
+//
+// Class usage:
+//
+// First, create instance, call open() method, after that call next()
+// method until it returns false.
+//
+
+class FolderEnumerator
+{
+public:
+  FolderEnumerator(const TCHAR *folderPath);
+  ~FolderEnumerator();
+
+  //
+  // Starts listing of folder, returns false on error.
+  //
+
+  bool open();
+
+  //
+  // Puts information about next file of folder to fileInfo argument.
+  // Returns false if there are no more files.
+  //
+
+  bool next(FileInfo *fileInfo);
+
+protected:
+  StringStorage m_folderPath;
+
+  HANDLE m_findHandle;
+  WIN32_FIND_DATA m_findData;
+  // m_findData contains entry that is not returned by next() yet
+  bool m_hasFindData;
+};
+
+#endif
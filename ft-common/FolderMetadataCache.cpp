@@ -0,0 +1,147 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FolderMetadataCache.h"
+
+#include "file-lib/File.h"
+#include "thread/AutoLock.h"
+
+FolderMetadataCache::FolderMetadataCache(DWORD lifetime)
+: m_filesCount(0),
+  m_lifetime(lifetime)
+{
+}
+
+FolderMetadataCache::~FolderMetadataCache()
+{
+  clear();
+}
+
+void FolderMetadataCache::put(const TCHAR *folderPath, UINT64 lastModified,
+                              std::vector<FileInfo> *files)
+{
+  if (lastModified == 0) {
+    return ;
+  }
+
+  AutoLock al(&m_lock);
+
+  StringStorage key(folderPath);
+
+  EntryMap::iterator it = m_entries.find(key);
+  if (it != m_entries.end()) {
+    removeEntry(it);
+  }
+
+  if (m_filesCount + files->size() > MAX_FILES_COUNT) {
+    removeExpiredEntries();
+    if (m_filesCount + files->size() > MAX_FILES_COUNT) {
+      return ;
+    }
+  }
+
+  Entry *entry = new Entry;
+  entry->lastModified = lastModified;
+  entry->creationTime = GetTickCount();
+  entry->files.swap(*files);
+
+  m_filesCount += entry->files.size();
+  m_entries[key] = entry;
+}
+
+bool FolderMetadataCache::get(const TCHAR *folderPath,
+                              std::vector<FileInfo> *files,
+                              bool remove)
+{
+  // Checked without lock, file system query can be long
+  UINT64 lastModified = getFolderModificationTime(folderPath);
+
+  AutoLock al(&m_lock);
+
+  EntryMap::iterator it = m_entries.find(StringStorage(folderPath));
+  if (it == m_entries.end()) {
+    return false;
+  }
+
+  Entry *entry = it->second;
+
+  if (isExpired(entry, GetTickCount()) || entry->lastModified != lastModified) {
+    removeEntry(it);
+    return false;
+  }
+
+  if (remove) {
+    // Listing is moved from entry, so entry is empty when it's removed
+    files->clear();
+    m_filesCount -= entry->files.size();
+    files->swap(entry->files);
+    removeEntry(it);
+  } else {
+    *files = entry->files;
+  }
+  return true;
+}
+
+void FolderMetadataCache::clear()
+{
+  AutoLock al(&m_lock);
+
+  while (!m_entries.empty()) {
+    removeEntry(m_entries.begin());
+  }
+}
+
+UINT64 FolderMetadataCache::getFolderModificationTime(const TCHAR *folderPath)
+{
+  File folder(folderPath);
+
+  return folder.lastModified();
+}
+
+void FolderMetadataCache::removeEntry(EntryMap::iterator it)
+{
+  m_filesCount -= it->second->files.size();
+  delete it->second;
+  m_entries.erase(it);
+}
+
+void FolderMetadataCache::removeExpiredEntries()
+{
+  DWORD now = GetTickCount();
+
+  EntryMap::iterator it = m_entries.begin();
+  while (it != m_entries.end()) {
+    EntryMap::iterator current = it++;
+    if (isExpired(current->second, now)) {
+      removeEntry(current);
+    }
+  }
+}
+
+bool FolderMetadataCache::isExpired(const Entry *entry, DWORD now) const
+{
+  if (m_lifetime == INFINITE) {
+    return false;
+  }
+  return now - entry->creationTime > m_lifetime;
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FOLDER_METADATA_CACHE_H_
+#define _FOLDER_METADATA_CACHE_H_
+
+#include "util/inttypes.h"
+#include "util/StringStorage.h"
+#include "ft-common/FileInfo.h"
+#include "thread/LocalMutex.h"
+
+#include <map>
+#include <vector>
+
+//
+// Short-lived cache of folder listings.
+//
+// Listing is returned from cache only while it's not expired and
+// modification time of folder is the same as it was before listing,
+// so folder that is listed to know its size is not listed again
+// when its content is transferred.
+//
+// Remark: class is thread-safe.
+//
+
+class FolderMetadataCache
+{
+public:
+
+  //
+  // Parameters:
+  //
+  // [IN] lifetime - time in milliseconds while listing is valid
+  // (INFINITE means that listing is valid while folder is not modified)
+  //
+
+  FolderMetadataCache(DWORD lifetime);
+  virtual ~FolderMetadataCache();
+
+  //
+  // Puts listing of folder to cache, content of files argument is taken.
+  // lastModified must be modification time of folder that is got
+  // before listing.
+  //
+
+  void put(const TCHAR *folderPath, UINT64 lastModified,
+           std::vector<FileInfo> *files);
+
+  //
+  // Puts listing of folder to files argument if it's cached and folder
+  // is not modified since. If remove is true, listing is removed from
+  // cache. Returns false if there is no valid listing in cache.
+  //
+
+  bool get(const TCHAR *folderPath, std::vector<FileInfo> *files,
+           bool remove = false);
+
+  // Removes all listings
+  void clear();
+
+  //
+  // Returns modification time of folder or zero if it cannot be got
+  // (listing of such folder is not cached).
+  //
+
+  static UINT64 getFolderModificationTime(const TCHAR *folderPath);
+
+protected:
+  struct Entry
+  {
+    UINT64 lastModified;
+    DWORD creationTime;
+    std::vector<FileInfo> files;
+  };
+
+  typedef std::map<StringStorage, Entry *> EntryMap;
+
+  // Removes entry and updates m_filesCount
+  void removeEntry(EntryMap::iterator it);
+  void removeExpiredEntries();
+  bool isExpired(const Entry *entry, DWORD now) const;
+
+  LocalMutex m_lock;
+  EntryMap m_entries;
+  // Total count of files info in cache
+  size_t m_filesCount;
+  DWORD m_lifetime;
+
+  // Listings are not cached when cache is full
+  static const size_t MAX_FILES_COUNT = 256 * 1024;
+};
+
+#endif
@@ -0,0 +1,236 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FolderWalker.h"
+
+#include "FolderEnumerator.h"
+#include "file-lib/File.h"
+#include "thread/AutoLock.h"
+#include "thread/Thread.h"
+
+//
+// Helper thread of folder walker.
+//
+
+class FolderWalkerThread : public Thread
+{
+public:
+  FolderWalkerThread(FolderWalker *walker, HANDLE token)
+  : m_walker(walker),
+    m_token(token)
+  {
+    resume();
+  }
+
+protected:
+  virtual void execute()
+  {
+    // Impersonation is per thread, so the helper takes the token of the
+    // thread that walks the tree. Folders are left to other threads if
+    // the token cannot be set.
+    if (m_token != 0 && !SetThreadToken(NULL, m_token)) {
+      return ;
+    }
+    m_walker->walkFolders();
+  }
+
+  FolderWalker *m_walker;
+  HANDLE m_token;
+};
+
+FolderWalker::FolderWalker(FolderMetadataCache *cache)
+: m_cache(cache),
+  m_activeCount(0),
+  m_totalSize(0)
+{
+}
+
+FolderWalker::~FolderWalker()
+{
+}
+
+bool FolderWalker::getFolderSize(const TCHAR *folderPath, UINT64 *folderSize)
+{
+  std::vector<FileInfo> files;
+
+  if (!listFolder(folderPath, &files)) {
+    return false;
+  }
+
+  m_folders.clear();
+  m_activeCount = 0;
+  m_totalSize = 0;
+
+  addFolderContent(folderPath, &files);
+
+  //
+  // Walk subfolders with helper threads
+  //
+
+  if (!m_folders.empty()) {
+    // Helper threads must list folders as the same user as calling thread
+    // does. If the calling thread impersonates a user but its token cannot
+    // be got, the tree is walked by the calling thread alone.
+    HANDLE token = 0;
+    bool canUseHelpers = true;
+    if (!OpenThreadToken(GetCurrentThread(), TOKEN_IMPERSONATE, TRUE, &token)) {
+      token = 0;
+      canUseHelpers = GetLastError() == ERROR_NO_TOKEN;
+    }
+
+    std::vector<FolderWalkerThread *> threads;
+    for (size_t i = 1; canUseHelpers && i < THREAD_COUNT; i++) {
+      threads.push_back(new FolderWalkerThread(this, token));
+    }
+
+    walkFolders();
+
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->wait();
+      delete threads[i];
+    }
+
+    if (token != 0) {
+      CloseHandle(token);
+    }
+  }
+
+  *folderSize = m_totalSize;
+
+  return true;
+}
+
+bool FolderWalker::listFolder(const TCHAR *folderPath,
+                              std::vector<FileInfo> *files)
+{
+  if (m_cache != NULL && m_cache->get(folderPath, files)) {
+    return true;
+  }
+
+  // Modification time is got before listing, so changes made
+  // during listing invalidate the cached listing
+  UINT64 lastModified = FolderMetadataCache::getFolderModificationTime(folderPath);
+
+  if (!listFolderContent(folderPath, files)) {
+    return false;
+  }
+
+  if (m_cache != NULL) {
+    std::vector<FileInfo> cached(*files);
+    m_cache->put(folderPath, lastModified, &cached);
+  }
+  return true;
+}
+
+bool FolderWalker::listFolderContent(const TCHAR *folderPath,
+                                     std::vector<FileInfo> *files)
+{
+  files->clear();
+
+  FolderEnumerator enumerator(folderPath);
+  if (!enumerator.open()) {
+    return false;
+  }
+
+  FileInfo fileInfo;
+  while (enumerator.next(&fileInfo)) {
+    files->push_back(fileInfo);
+  }
+  return true;
+}
+
+void FolderWalker::walkFolders()
+{
+  std::vector<FileInfo> files;
+
+  while (true) {
+    StringStorage folderPath;
+    bool hasFolder = false;
+
+    {
+      AutoLock al(&m_lock);
+
+      if (!m_folders.empty()) {
+        folderPath = m_folders.front();
+        m_folders.pop_front();
+        m_activeCount++;
+        hasFolder = true;
+
+        // Wake next waiting thread if there is more work
+        if (!m_folders.empty()) {
+          m_queueEvent.notify();
+        }
+      } else if (m_activeCount == 0) {
+        // Tree is walked, wake next waiting thread to let it finish
+        m_queueEvent.notify();
+        return ;
+      }
+    }
+
+    if (!hasFolder) {
+      m_queueEvent.waitForEvent();
+      continue;
+    }
+
+    if (listFolder(folderPath.getString(), &files)) {
+      addFolderContent(folderPath.getString(), &files);
+    }
+
+    {
+      AutoLock al(&m_lock);
+
+      m_activeCount--;
+      if (m_activeCount == 0 && m_folders.empty()) {
+        m_queueEvent.notify();
+      }
+    }
+  }
+}
+
+void FolderWalker::addFolderContent(const TCHAR *folderPath,
+                                    const std::vector<FileInfo> *files)
+{
+  UINT64 size = 0;
+  std::vector<StringStorage> subfolders;
+
+  for (size_t i = 0; i < files->size(); i++) {
+    const FileInfo *fileInfo = &(*files)[i];
+
+    if (fileInfo->isDirectory()) {
+      File subfolder(folderPath, fileInfo->getFileName());
+      StringStorage subfolderPath;
+      subfolder.getPath(&subfolderPath);
+      subfolders.push_back(subfolderPath);
+    } else {
+      size += fileInfo->getSize();
+    }
+  }
+
+  AutoLock al(&m_lock);
+
+  m_totalSize += size;
+  if (!subfolders.empty()) {
+    m_folders.insert(m_folders.end(), subfolders.begin(), subfolders.end());
+    m_queueEvent.notify();
+  }
+}
@@ -0,0 +1,118 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FOLDER_WALKER_H_
+#define _FOLDER_WALKER_H_
+
+#include "util/inttypes.h"
+#include "util/StringStorage.h"
+#include "ft-common/FileInfo.h"
+#include "ft-common/FolderMetadataCache.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+#include <deque>
+#include <vector>
+
+//
+// Walks folder trees to calculate their size.
+//
+// Subfolders are listed by several threads at once (listing of large
+// trees is limited by latency of file system, not by processor), listings
+// of all walked folders are put to cache, so the content of the tree can
+// be transferred without listing it again.
+//
+// Helper threads impersonate the same user as the calling thread does.
+//
+
+class FolderWalker
+{
+public:
+
+  //
+  // Parameters:
+  //
+  // [IN] cache - cache for folder listings (can be NULL)
+  //
+
+  FolderWalker(FolderMetadataCache *cache);
+  virtual ~FolderWalker();
+
+  //
+  // Calculates total size of files in folder and all of its subfolders.
+  // Returns false if folder cannot be listed (subfolders that cannot be
+  // listed are skipped).
+  //
+
+  bool getFolderSize(const TCHAR *folderPath, UINT64 *folderSize);
+
+  //
+  // Lists content of folder, the listing is taken from cache if it's
+  // possible. Returns false if folder cannot be listed.
+  //
+
+  bool listFolder(const TCHAR *folderPath, std::vector<FileInfo> *files);
+
+  //
+  // Lists content of folder (without cache).
+  //
+
+  static bool listFolderContent(const TCHAR *folderPath,
+                                std::vector<FileInfo> *files);
+
+protected:
+  friend class FolderWalkerThread;
+
+  //
+  // Walks folders from queue until all folders of tree are walked.
+  // Executed by several threads at once.
+  //
+
+  void walkFolders();
+
+  //
+  // Adds sizes of files of listed folder to total size and
+  // its subfolders to queue.
+  //
+
+  void addFolderContent(const TCHAR *folderPath,
+                        const std::vector<FileInfo> *files);
+
+  FolderMetadataCache *m_cache;
+
+  // Members below are protected by m_lock
+  LocalMutex m_lock;
+  // Folders that are not walked yet
+  std::deque<StringStorage> m_folders;
+  // Count of folders that are walked now
+  size_t m_activeCount;
+  UINT64 m_totalSize;
+
+  // Notified when folder is added to queue or walk is finished
+  WindowsEvent m_queueEvent;
+
+  // Count of threads that walk folders (including calling one)
+  static const size_t THREAD_COUNT = 4;
+};
+
+#endif
@@ -0,0 +1,65 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "RollingChecksum.h"
+
+RollingChecksum::RollingChecksum()
+: m_a(0),
+  m_b(0),
+  m_size(0)
+{
+}
+
+void RollingChecksum::reset(const char *data, size_t size)
+{
+  m_a = 0;
+  m_b = 0;
+  m_size = size;
+
+  for (size_t i = 0; i < size; i++) {
+    UINT8 x = (UINT8)data[i];
+    m_a += x;
+    m_b += (UINT32)(size - i) * x;
+  }
+}
+
+void RollingChecksum::roll(char out, char in)
+{
+  UINT8 x = (UINT8)out;
+  UINT8 y = (UINT8)in;
+
+  m_a += y - x;
+  m_b += m_a - (UINT32)m_size * x;
+}
+
+UINT32 RollingChecksum::getValue() const
+{
+  return (m_a & 0xffff) | (m_b << 16);
+}
+
+UINT32 RollingChecksum::calculate(const char *data, size_t size)
+{
+  RollingChecksum checksum;
+  checksum.reset(data, size);
+  return checksum.getValue();
+}
@@ -0,0 +1,72 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _ROLLING_CHECKSUM_H_
+#define _ROLLING_CHECKSUM_H_
+
+#include "util/inttypes.h"
+
+#include <stddef.h>
+
+//
+// Weak checksum of data block that can be moved along data by one byte
+// in constant time (rsync algorithm, two 16 bit sums of bytes).
+//
+
+class RollingChecksum
+{
+public:
+  RollingChecksum();
+
+  //
+  // Calculates checksum of block of specified size.
+  //
+
+  void reset(const char *data, size_t size);
+
+  //
+  // Moves block by one byte: removes first byte of block (out) and
+  // appends next byte after block (in). Size of block is not changed.
+  //
+
+  void roll(char out, char in);
+
+  //
+  // Returns checksum of current block.
+  //
+
+  UINT32 getValue() const;
+
+  //
+  // Returns checksum of data block (helper method).
+  //
+
+  static UINT32 calculate(const char *data, size_t size);
+
+protected:
+  UINT32 m_a;
+  UINT32 m_b;
+  size_t m_size;
+};
+
+#endif
@@ -28,12 +28,16 @@
 
 #include "ft-common/FileTransferException.h"
 #include "io-lib/ByteArrayOutputStream.h"
+#include "io-lib/ByteArrayInputStream.h"
 #include "file-lib/File.h"
 #include "file-lib/EOFException.h"
 #include "ft-common/FolderListener.h"
+#include "ft-common/FolderEnumerator.h"
+#include "ft-common/FolderWalker.h"
 #include "ft-common/FTMessage.h"
 #include "ft-common/WinFilePath.h"
 #include "ft-common/FileInfo.h"
+#include "ft-common/FileSignature.h"
 #include "util/md5.h"
 #include "network/RfbOutputGate.h"
 #include "network/RfbInputGate.h"
@@ -42,15 +46,19 @@
 #include "win-system/Environment.h"
 #include "server-config-lib/Configurator.h"
 #include "win-system/SystemException.h"
+#include "win-system/security/SecurityIdentifier.h"
 #include "rfb/VendorDefs.h"
 
+const TCHAR FileTransferRequestHandler::DELTA_TEMP_FILE_SUFFIX[] = _T(".tvndelta");
+
 FileTransferRequestHandler::FileTransferRequestHandler(RfbCodeRegistrator *registrator,
                                                        RfbOutputGate *output,
                                                        Desktop *desktop,
                                                        LogWriter *log,
                                                        bool enabled)
-: m_downloadFile(NULL), m_fileInputStream(NULL),
-  m_uploadFile(NULL), m_fileOutputStream(NULL),
+: m_worker(NULL), m_downloadFile(NULL), m_fileInputStream(NULL),
+  m_uploadFile(NULL), m_fileOutputStream(NULL), m_uploadBasis(NULL),
+  m_folderCache(FOLDER_CACHE_LIFETIME),
   m_output(output), m_enabled(enabled),
   m_log(log)
 {
@@ -74,6 +82,10 @@ FileTransferRequestHandler::FileTransferRequestHandler(RfbCodeRegistrator *regis
   registrator->addSrvToClCap(FTMessage::RENAME_REPLY, VendorDefs::TIGHTVNC, FTMessage::RENAME_REPLY_SIG);
   registrator->addSrvToClCap(FTMessage::DIRSIZE_REPLY, VendorDefs::TIGHTVNC, FTMessage::DIRSIZE_REPLY_SIG);
   registrator->addSrvToClCap(FTMessage::LAST_REQUEST_FAILED_REPLY, VendorDefs::TIGHTVNC, FTMessage::LAST_REQUEST_FAILED_REPLY_SIG);
+  registrator->addSrvToClCap(FTMessage::FILE_SIGNATURE_REPLY, VendorDefs::TIGHTVNC, FTMessage::FILE_SIGNATURE_REPLY_SIG);
+  registrator->addSrvToClCap(FTMessage::FILE_LIST_PAGE_REPLY, VendorDefs::TIGHTVNC, FTMessage::FILE_LIST_PAGE_REPLY_SIG);
+  registrator->addSrvToClCap(FTMessage::UPLOAD_BATCH_REPLY, VendorDefs::TIGHTVNC, FTMessage::UPLOAD_BATCH_REPLY_SIG);
+  registrator->addSrvToClCap(FTMessage::DOWNLOAD_BATCH_REPLY, VendorDefs::TIGHTVNC, FTMessage::DOWNLOAD_BATCH_REPLY_SIG);
 
   registrator->addClToSrvCap(FTMessage::COMPRESSION_SUPPORT_REQUEST, VendorDefs::TIGHTVNC, FTMessage::COMPRESSION_SUPPORT_REQUEST_SIG);
   registrator->addClToSrvCap(FTMessage::FILE_LIST_REQUEST, VendorDefs::TIGHTVNC, FTMessage::FILE_LIST_REQUEST_SIG);
@@ -87,6 +99,12 @@ FileTransferRequestHandler::FileTransferRequestHandler(RfbCodeRegistrator *regis
   registrator->addClToSrvCap(FTMessage::REMOVE_REQUEST, VendorDefs::TIGHTVNC, FTMessage::REMOVE_REQUEST_SIG);
   registrator->addClToSrvCap(FTMessage::RENAME_REQUEST, VendorDefs::TIGHTVNC, FTMessage::RENAME_REQUEST_SIG);
   registrator->addClToSrvCap(FTMessage::DIRSIZE_REQUEST, VendorDefs::TIGHTVNC, FTMessage::DIRSIZE_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST, VendorDefs::TIGHTVNC, FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::FILE_SIGNATURE_REQUEST, VendorDefs::TIGHTVNC, FTMessage::FILE_SIGNATURE_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::UPLOAD_COPY_REQUEST, VendorDefs::TIGHTVNC, FTMessage::UPLOAD_COPY_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::FILE_LIST_PAGED_REQUEST, VendorDefs::TIGHTVNC, FTMessage::FILE_LIST_PAGED_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::UPLOAD_BATCH_REQUEST, VendorDefs::TIGHTVNC, FTMessage::UPLOAD_BATCH_REQUEST_SIG);
+  registrator->addClToSrvCap(FTMessage::DOWNLOAD_BATCH_REQUEST, VendorDefs::TIGHTVNC, FTMessage::DOWNLOAD_BATCH_REQUEST_SIG);
 
   UINT32 rfbMessagesToProcess[] = {
     FTMessage::COMPRESSION_SUPPORT_REQUEST,
@@ -100,18 +118,31 @@ FileTransferRequestHandler::FileTransferRequestHandler(RfbCodeRegistrator *regis
     FTMessage::MKDIR_REQUEST,
     FTMessage::REMOVE_REQUEST,
     FTMessage::RENAME_REQUEST,
-    FTMessage::DIRSIZE_REQUEST
+    FTMessage::DIRSIZE_REQUEST,
+    FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST,
+    FTMessage::FILE_SIGNATURE_REQUEST,
+    FTMessage::UPLOAD_COPY_REQUEST,
+    FTMessage::FILE_LIST_PAGED_REQUEST,
+    FTMessage::UPLOAD_BATCH_REQUEST,
+    FTMessage::DOWNLOAD_BATCH_REQUEST
   };
 
   for (size_t i = 0; i < sizeof(rfbMessagesToProcess) / sizeof(UINT32); i++) {
     registrator->regCode(rfbMessagesToProcess[i], this);
   }
 
+  m_worker = new FileTransferWorker(this, m_log);
+
   m_log->message(_T("File transfer request handler created"));
 }
 
 FileTransferRequestHandler::~FileTransferRequestHandler()
 {
+  // Worker must be stopped before state of transfers is deleted
+  if (m_worker != NULL) {
+    delete m_worker;
+  }
+
   delete m_security;
 
   if (m_fileInputStream != NULL) {
@@ -122,7 +153,9 @@ FileTransferRequestHandler::~FileTransferRequestHandler()
   }
   if (m_fileOutputStream != NULL) {
     delete m_fileOutputStream;
+    m_fileOutputStream = NULL;
   }
+  releaseUploadBasis();
   if (m_uploadFile != NULL) {
     delete m_uploadFile;
   }
@@ -131,10 +164,130 @@ FileTransferRequestHandler::~FileTransferRequestHandler()
 }
 
 void FileTransferRequestHandler::onRequest(UINT32 reqCode, RfbInputGate *backGate)
+{
+  std::vector<char> body;
+
+  readRequestBody(reqCode, backGate, &body);
+
+  m_worker->addRequest(reqCode, &body);
+}
+
+void FileTransferRequestHandler::readRequestBody(UINT32 reqCode,
+                                                 RfbInputGate *input,
+                                                 std::vector<char> *body)
+{
+  ByteArrayOutputStream bodyStream;
+  DataOutputStream output(&bodyStream);
+
+  // Size of raw data that follows fields of the message
+  UINT32 dataSize = 0;
+
+  switch (reqCode) {
+  case FTMessage::COMPRESSION_SUPPORT_REQUEST:
+    break;
+  case FTMessage::FILE_LIST_REQUEST:
+  case FTMessage::FILE_LIST_PAGED_REQUEST:
+    output.writeUInt8(input->readUInt8());
+    copyUTF8(input, &output);
+    break;
+  case FTMessage::MKDIR_REQUEST:
+  case FTMessage::REMOVE_REQUEST:
+  case FTMessage::DIRSIZE_REQUEST:
+    copyUTF8(input, &output);
+    break;
+  case FTMessage::RENAME_REQUEST:
+    copyUTF8(input, &output);
+    copyUTF8(input, &output);
+    break;
+  case FTMessage::MD5_REQUEST:
+    copyUTF8(input, &output);
+    output.writeUInt64(input->readUInt64());
+    output.writeUInt64(input->readUInt64());
+    break;
+  case FTMessage::FILE_SIGNATURE_REQUEST:
+    copyUTF8(input, &output);
+    output.writeUInt32(input->readUInt32());
+    break;
+  case FTMessage::UPLOAD_START_REQUEST:
+    copyUTF8(input, &output);
+    output.writeUInt8(input->readUInt8());
+    output.writeUInt64(input->readUInt64());
+    break;
+  case FTMessage::UPLOAD_DATA_REQUEST:
+    output.writeUInt8(input->readUInt8());
+    dataSize = input->readUInt32();
+    output.writeUInt32(dataSize);
+    output.writeUInt32(input->readUInt32());
+    break;
+  case FTMessage::UPLOAD_BATCH_REQUEST:
+    output.writeUInt32(input->readUInt32());
+    output.writeUInt8(input->readUInt8());
+    dataSize = input->readUInt32();
+    output.writeUInt32(dataSize);
+    output.writeUInt32(input->readUInt32());
+    break;
+  case FTMessage::UPLOAD_END_REQUEST:
+    output.writeUInt16(input->readUInt16());
+    output.writeUInt64(input->readUInt64());
+    break;
+  case FTMessage::UPLOAD_COPY_REQUEST:
+    output.writeUInt64(input->readUInt64());
+    output.writeUInt64(input->readUInt64());
+    break;
+  case FTMessage::DOWNLOAD_START_REQUEST:
+    copyUTF8(input, &output);
+    output.writeUInt64(input->readUInt64());
+    break;
+  case FTMessage::DOWNLOAD_DATA_REQUEST:
+  case FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST:
+    output.writeUInt8(input->readUInt8());
+    output.writeUInt32(input->readUInt32());
+    break;
+  case FTMessage::DOWNLOAD_BATCH_REQUEST:
+    {
+      output.writeUInt8(input->readUInt8());
+      UINT32 filesCount = input->readUInt32();
+      if (filesCount > MAX_DOWNLOAD_BATCH_FILES_COUNT) {
+        throw Exception(_T("Too many files in download batch request"));
+      }
+      output.writeUInt32(filesCount);
+      for (UINT32 i = 0; i < filesCount; i++) {
+        copyUTF8(input, &output);
+      }
+    }
+    break;
+  } // switch.
+
+  size_t fieldsSize = bodyStream.size();
+
+  body->resize(fieldsSize + dataSize);
+  if (fieldsSize != 0) {
+    memcpy(&body->front(), bodyStream.toByteArray(), fieldsSize);
+  }
+  if (dataSize != 0) {
+    input->readFully(&(*body)[fieldsSize], dataSize);
+  }
+}
+
+void FileTransferRequestHandler::copyUTF8(DataInputStream *input,
+                                          DataOutputStream *output)
+{
+  UINT32 sizeInBytes = input->readUInt32();
+  output->writeUInt32(sizeInBytes);
+  if (sizeInBytes > 0) {
+    std::vector<char> buffer(sizeInBytes);
+    input->readFully(&buffer.front(), sizeInBytes);
+    output->writeFully(&buffer.front(), sizeInBytes);
+  }
+}
+
+void FileTransferRequestHandler::processRequest(UINT32 reqCode, DataInputStream *input)
 {
   m_security->beginMessageProcessing();
 
-  m_input = backGate;
+  checkFolderCacheUser();
+
+  m_input = input;
 
   try {
     switch (reqCode) {
@@ -144,6 +297,9 @@ void FileTransferRequestHandler::onRequest(UINT32 reqCode, RfbInputGate *backGat
     case FTMessage::FILE_LIST_REQUEST:
       fileListRequested();
       break;
+    case FTMessage::FILE_LIST_PAGED_REQUEST:
+      fileListPagedRequested();
+      break;
     case FTMessage::MKDIR_REQUEST:
       mkDirRequested();
       break;
@@ -171,9 +327,24 @@ void FileTransferRequestHandler::onRequest(UINT32 reqCode, RfbInputGate *backGat
     case FTMessage::DOWNLOAD_DATA_REQUEST:
       downloadDataRequested();
       break;
+    case FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST:
+      downloadDataWindowRequested();
+      break;
     case FTMessage::MD5_REQUEST:
       md5Requested();
       break;
+    case FTMessage::FILE_SIGNATURE_REQUEST:
+      fileSignatureRequested();
+      break;
+    case FTMessage::UPLOAD_COPY_REQUEST:
+      uploadCopyRequested();
+      break;
+    case FTMessage::UPLOAD_BATCH_REQUEST:
+      uploadBatchRequested();
+      break;
+    case FTMessage::DOWNLOAD_BATCH_REQUEST:
+      downloadBatchRequested();
+      break;
     } // switch.
   } catch (Exception &someEx) {
     lastRequestFailed(someEx.getMessage());
@@ -189,6 +360,32 @@ bool FileTransferRequestHandler::isFileTransferEnabled()
   return m_enabled && Configurator::getInstance()->getServerConfig()->isFileTransfersEnabled();
 }
 
+void FileTransferRequestHandler::checkFolderCacheUser()
+{
+  StringStorage user;
+
+  try {
+    SecurityIdentifier *sid = SecurityIdentifier::getThreadUser();
+    try {
+      sid->toString(&user);
+    } catch (...) {
+      delete sid;
+      throw;
+    }
+    delete sid;
+  } catch (SystemException &ex) {
+    m_log->error(_T("Cannot get user of file transfer request: %s"),
+                 ex.getMessage());
+    user.setString(_T(""));
+  }
+
+  // Listings of unknown user are never reused.
+  if (user.isEmpty() || !user.isEqualTo(&m_folderCacheUser)) {
+    m_folderCache.clear();
+  }
+  m_folderCacheUser = user;
+}
+
 void FileTransferRequestHandler::compressionSupportRequested()
 {
   m_log->message(_T("%s"), _T("compression support requested"));
@@ -203,7 +400,7 @@ void FileTransferRequestHandler::compressionSupportRequested()
   m_log->debug(_T("sending compression support reply: %s"), (compressionSupport == 1) ? _T("supported") : _T("not supported"));
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::COMPRESSION_SUPPORT_REPLY);
     m_output->writeUInt8(compressionSupport);
@@ -244,13 +441,28 @@ void FileTransferRequestHandler::fileListRequested()
   //
 
   FolderListener folderListener(fullPathName.getString());
+  std::vector<FileInfo> folderFiles;
 
-  if (!folderListener.list()) {
-    throw SystemException();
-  }
+  if (fullPathName.isEmpty()) {
+    if (!folderListener.list()) {
+      throw SystemException();
+    }
+
+    files = folderListener.getFilesInfo();
+    filesCount = folderListener.getFilesCount();
+  } else {
+    FolderWalker folderWalker(&m_folderCache);
 
-  files = folderListener.getFilesInfo();
-  filesCount = folderListener.getFilesCount();
+    if (!folderWalker.listFolder(fullPathName.getString(), &folderFiles)) {
+      throw SystemException();
+    }
+
+    _ASSERT((UINT32)folderFiles.size() == folderFiles.size());
+    filesCount = (UINT32)folderFiles.size();
+    if (filesCount != 0) {
+      files = &folderFiles.front();
+    }
+  }
 
   //
   // Create buffer with "CompressedData" block inside
@@ -288,7 +500,7 @@ void FileTransferRequestHandler::fileListRequested()
   //
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::FILE_LIST_REPLY);
 
@@ -306,6 +518,160 @@ void FileTransferRequestHandler::fileListRequested()
   } // synchronized(m_output)
 } // void
 
+void FileTransferRequestHandler::fileListPagedRequested()
+{
+  UINT8 compressionLevel;
+  WinFilePath fullPathName;
+
+  //
+  // Read input data
+  //
+
+  {
+    compressionLevel = m_input->readUInt8();
+
+    m_input->readUTF8(&fullPathName);
+  }
+
+  m_log->message(_T("Paged file list of folder '%s' requested"),
+               fullPathName.getString());
+
+  checkAccess();
+
+  ByteArrayOutputStream memStream;
+  DataOutputStream outMemStream(&memStream);
+  UINT32 filesCount = 0;
+
+  //
+  // System roots are few, they are sent in one page
+  //
+
+  if (fullPathName.isEmpty()) {
+    FolderListener folderListener(fullPathName.getString());
+
+    if (!folderListener.list()) {
+      throw SystemException();
+    }
+
+    const FileInfo *files = folderListener.getFilesInfo();
+    filesCount = folderListener.getFilesCount();
+
+    for (UINT32 i = 0; i < filesCount; i++) {
+      outMemStream.writeUInt64(files[i].getSize());
+      outMemStream.writeUInt64(files[i].lastModified());
+      outMemStream.writeUInt16(files[i].getFlags());
+      outMemStream.writeUTF8(files[i].getFileName());
+    } // for
+
+    sendFileListPage(compressionLevel, &memStream, filesCount, true);
+    return ;
+  }
+
+  //
+  // Folder that is listed recently (for example, to know its size)
+  // is not listed again
+  //
+
+  std::vector<FileInfo> cachedFiles;
+
+  if (m_folderCache.get(fullPathName.getString(), &cachedFiles)) {
+    for (size_t i = 0; i < cachedFiles.size(); i++) {
+      outMemStream.writeUInt64(cachedFiles[i].getSize());
+      outMemStream.writeUInt64(cachedFiles[i].lastModified());
+      outMemStream.writeUInt16(cachedFiles[i].getFlags());
+      outMemStream.writeUTF8(cachedFiles[i].getFileName());
+      filesCount++;
+
+      if (memStream.size() >= FILE_LIST_PAGE_SIZE) {
+        sendFileListPage(compressionLevel, &memStream, filesCount, false);
+
+        memStream.reset();
+        filesCount = 0;
+      }
+    } // for
+
+    sendFileListPage(compressionLevel, &memStream, filesCount, true);
+    return ;
+  }
+
+  //
+  // Files info is sent by pages while folder is listed
+  //
+
+  FolderEnumerator folderEnumerator(fullPathName.getString());
+
+  if (!folderEnumerator.open()) {
+    throw SystemException();
+  }
+
+  FileInfo fileInfo;
+
+  while (folderEnumerator.next(&fileInfo)) {
+    outMemStream.writeUInt64(fileInfo.getSize());
+    outMemStream.writeUInt64(fileInfo.lastModified());
+    outMemStream.writeUInt16(fileInfo.getFlags());
+    outMemStream.writeUTF8(fileInfo.getFileName());
+    filesCount++;
+
+    if (memStream.size() >= FILE_LIST_PAGE_SIZE) {
+      sendFileListPage(compressionLevel, &memStream, filesCount, false);
+
+      memStream.reset();
+      filesCount = 0;
+    }
+  } // while
+
+  sendFileListPage(compressionLevel, &memStream, filesCount, true);
+} // void
+
+void FileTransferRequestHandler::sendFileListPage(UINT8 compressionLevel,
+                                                  const ByteArrayOutputStream *entries,
+                                                  UINT32 filesCount,
+                                                  bool isLast)
+{
+  //
+  // Create buffer with "CompressedData" block inside
+  //
+
+  ByteArrayOutputStream memStream(entries->size() + sizeof(UINT32));
+  DataOutputStream outMemStream(&memStream);
+
+  outMemStream.writeUInt32(filesCount);
+  if (entries->size() != 0) {
+    outMemStream.writeFully(entries->toByteArray(), entries->size());
+  }
+
+  _ASSERT((UINT32)memStream.size() == memStream.size());
+  UINT32 uncompressedSize = (UINT32)memStream.size();
+  UINT32 compressedSize = uncompressedSize;
+
+  if (compressionLevel != 0) {
+    m_deflater.setInput(memStream.toByteArray(), memStream.size());
+    m_deflater.deflate();
+    _ASSERT((UINT32)m_deflater.getOutputSize() == m_deflater.getOutputSize());
+    compressedSize = (UINT32)m_deflater.getOutputSize();
+  }
+
+  {
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
+
+    m_output->writeUInt32(FTMessage::FILE_LIST_PAGE_REPLY);
+
+    m_output->writeUInt8(isLast ? 0x1 : 0x0);
+    m_output->writeUInt8(compressionLevel);
+    m_output->writeUInt32(compressedSize);
+    m_output->writeUInt32(uncompressedSize);
+
+    if (compressionLevel != 0) {
+      m_output->writeFully(m_deflater.getOutput(), compressedSize);
+    } else {
+      m_output->writeFully(memStream.toByteArray(), uncompressedSize);
+    }
+
+    m_output->flush();
+  } // synchronized(m_output)
+}
+
 void FileTransferRequestHandler::mkDirRequested()
 {
   WinFilePath folderPath;
@@ -318,6 +684,9 @@ void FileTransferRequestHandler::mkDirRequested()
 
   checkAccess();
 
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
   if (folderPath.parentPathIsRoot()) {
     throw FileTransferException(_T("Cannot create folder in root folder"));
   }
@@ -333,7 +702,7 @@ void FileTransferRequestHandler::mkDirRequested()
   }
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::MKDIR_REPLY);
 
@@ -353,6 +722,9 @@ void FileTransferRequestHandler::rmFileRequested()
 
   checkAccess();
 
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
   File file(fullPathName.getString());
 
   if (!file.exists()) {
@@ -364,7 +736,7 @@ void FileTransferRequestHandler::rmFileRequested()
   } // if cannot delete file
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::REMOVE_REPLY);
 
@@ -386,6 +758,9 @@ void FileTransferRequestHandler::mvFileRequested()
 
   checkAccess();
 
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
   File srcFile(oldFileName.getString());
   File dstFile(newFileName.getString());
 
@@ -394,7 +769,7 @@ void FileTransferRequestHandler::mvFileRequested()
   }
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::RENAME_REPLY);
 
@@ -417,12 +792,15 @@ void FileTransferRequestHandler::dirSizeRequested()
 
   UINT64 directorySize = 0;
 
-  if (!getDirectorySize(fullPathName.getString(), &directorySize)) {
+  // Listings of walked folders are cached for following file list requests
+  FolderWalker folderWalker(&m_folderCache);
+
+  if (!folderWalker.getFolderSize(fullPathName.getString(), &directorySize)) {
     throw SystemException();
   }
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::DIRSIZE_REPLY);
     m_output->writeUInt64(directorySize);
@@ -459,40 +837,35 @@ void FileTransferRequestHandler::md5Requested()
 
   StringStorage path;
   file.getPath(&path);
-  WinFileChannel fileInputStream(path.getString(), F_READ, FM_OPEN);
+  MappedFileChannel fileInputStream(path.getString());
   fileInputStream.seek(offset);
 
   //
-  // Begin reading needed file data
+  // File data is hashed directly in the file mapping
   //
 
   DWORD bytesToRead = 1024 * 1024;
   UINT64 bytesToReadTotal = dataLen;
-  size_t bytesRead = 0;
-  UINT64 bytesReadTotal = 0;
-
-  if (dataLen < (UINT64)bytesToRead) {
-    bytesToRead = (DWORD)dataLen;
-  }
-
-  std::vector<UINT8> buffer(bytesToRead);
 
   while (bytesToReadTotal > 0) {
-    bytesRead = fileInputStream.read(&buffer.front(), bytesToRead);
-    bytesReadTotal += bytesRead;
-    bytesToReadTotal -= bytesRead;
-
     if (bytesToReadTotal < (UINT64)bytesToRead) {
       bytesToRead = (DWORD)bytesToReadTotal;
     }
 
-    md5calculator.update(&buffer.front(), (UINT32)bytesRead);
+    const char *data;
+    size_t bytesRead = fileInputStream.map(&data, bytesToRead);
+    if (bytesRead == 0) {
+      throw EOFException();
+    }
+    bytesToReadTotal -= bytesRead;
+
+    md5calculator.update(data, (UINT32)bytesRead);
   } // while
 
   md5calculator.finalize();
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::MD5_REPLY);
     m_output->writeFully((const char *)md5calculator.getHash(), 16);
@@ -501,6 +874,49 @@ void FileTransferRequestHandler::md5Requested()
   }
 }
 
+void FileTransferRequestHandler::fileSignatureRequested()
+{
+  WinFilePath fullPathName;
+  UINT32 blockSize;
+
+  {
+    m_input->readUTF8(&fullPathName);
+    blockSize = m_input->readUInt32();
+  } // end of reading block.
+
+  m_log->message(_T("signature of \"%s\" with block size %d requested"),
+                 fullPathName.getString(), blockSize);
+
+  checkAccess();
+
+  if (blockSize < FileSignature::MIN_BLOCK_SIZE ||
+      blockSize > FileSignature::MAX_BLOCK_SIZE) {
+    throw FileTransferException(_T("Invalid signature block size"));
+  }
+
+  //
+  // Signature is calculated in one pass over the file
+  //
+
+  File file(fullPathName.getString());
+
+  StringStorage path;
+  file.getPath(&path);
+  MappedFileChannel fileInputStream(path.getString());
+
+  FileSignature signature;
+  signature.calculate(&fileInputStream, blockSize);
+
+  {
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
+
+    m_output->writeUInt32(FTMessage::FILE_SIGNATURE_REPLY);
+    signature.write(m_output);
+
+    m_output->flush();
+  }
+}
+
 void FileTransferRequestHandler::uploadStartRequested()
 {
   //
@@ -521,6 +937,9 @@ void FileTransferRequestHandler::uploadStartRequested()
 
   checkAccess();
 
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
   //
   // Closing previous upload if it was broken
   //
@@ -529,6 +948,7 @@ void FileTransferRequestHandler::uploadStartRequested()
     delete m_fileOutputStream;
     m_fileOutputStream = 0;
   }
+  releaseUploadBasis();
   if (m_uploadFile != NULL) {
     delete m_uploadFile;
     m_uploadFile = 0;
@@ -538,7 +958,30 @@ void FileTransferRequestHandler::uploadStartRequested()
     throw FileTransferException(_T("Cannot upload file to root folder"));
   }
 
-  m_uploadFile = new File(fullPathName.getString());
+  //
+  // Delta upload writes new version of file to temporary file,
+  // existing file is used as source of copied data until end of upload
+  //
+
+  StringStorage uploadPath(fullPathName.getString());
+
+  if (uploadFlags & 0x2) {
+    if (!(uploadFlags & 0x1) || initialOffset != 0) {
+      throw FileTransferException(_T("Delta upload cannot append to file"));
+    }
+
+    File targetFile(fullPathName.getString());
+    targetFile.getPath(&m_uploadTargetPath);
+
+    m_uploadBasis = new WinFileChannel(m_uploadTargetPath.getString(),
+                                       F_READ,
+                                       FM_OPEN);
+
+    uploadPath.setString(m_uploadTargetPath.getString());
+    uploadPath.appendString(DELTA_TEMP_FILE_SUFFIX);
+  }
+
+  m_uploadFile = new File(uploadPath.getString());
 
   //
   // Trying to create file or overwrite existing
@@ -551,7 +994,7 @@ void FileTransferRequestHandler::uploadStartRequested()
   //
   // Trying to open file and seek to initial file position
   //
-  m_fileOutputStream = new WinFileChannel(fullPathName.getString(),
+  m_fileOutputStream = new WinFileChannel(uploadPath.getString(),
                                           F_WRITE,
                                           FM_OPEN);
   m_fileOutputStream->seek(initialOffset);
@@ -561,7 +1004,7 @@ void FileTransferRequestHandler::uploadStartRequested()
   //
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::UPLOAD_START_REPLY);
 
@@ -589,29 +1032,60 @@ void FileTransferRequestHandler::uploadDataRequested()
 
   m_log->info(_T("upload data (cs = %d, us = %d) requested"), compressedSize, uncompressedSize);
 
-  checkAccess();
+  //
+  // The client can have more chunks in flight, so compressed data is
+  // always decompressed to keep zlib stream in sync for them, even if
+  // the chunk is rejected or cannot be written.
+  //
 
-  if (m_uploadFile == NULL) {
-    throw FileTransferException(_T("No active upload at the moment"));
+  bool isRejected = false;
+  StringStorage rejectReason;
+  try {
+    checkAccess();
+
+    if (m_uploadFile == NULL) {
+      throw FileTransferException(_T("No active upload at the moment"));
+    }
+  } catch (Exception &someEx) {
+    isRejected = true;
+    rejectReason.setString(someEx.getMessage());
   }
 
   if (compressedSize != 0) {
     if (compressionLevel == 0) {
-      DataOutputStream dataOutStream(m_fileOutputStream);
-      dataOutStream.writeFully(&buffer.front(), uncompressedSize);
+      if (!isRejected) {
+        DataOutputStream dataOutStream(m_fileOutputStream);
+        dataOutStream.writeFully(&buffer.front(), uncompressedSize);
+      }
     } else {
-      m_inflater.setInput(&buffer.front(), compressedSize);
-      m_inflater.setUnpackedSize(uncompressedSize);
-      m_inflater.inflate();
-
+      // Decompress to the file in small pieces, the uncompressed data is
+      // never kept in memory as a whole.
       DataOutputStream dataOutStream(m_fileOutputStream);
-
-      dataOutStream.writeFully(m_inflater.getOutput(), m_inflater.getOutputSize());
+      const char *input = &buffer.front();
+      size_t inputSize = compressedSize;
+      char piece[8192];
+      size_t pieceSize;
+      do {
+        pieceSize = m_inflater.inflate(&input, &inputSize,
+                                       piece, sizeof(piece));
+        if (!isRejected) {
+          try {
+            dataOutStream.writeFully(piece, pieceSize);
+          } catch (IOException &ioEx) {
+            isRejected = true;
+            rejectReason.setString(ioEx.getMessage());
+          }
+        }
+      } while (inputSize != 0 || pieceSize == sizeof(piece));
     } // if using compression
   }
 
+  if (isRejected) {
+    throw FileTransferException(rejectReason.getString());
+  }
+
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::UPLOAD_DATA_REPLY);
 
@@ -619,6 +1093,156 @@ void FileTransferRequestHandler::uploadDataRequested()
   }
 }
 
+void FileTransferRequestHandler::uploadBatchRequested()
+{
+  //
+  // Request input variables.
+  //
+
+  UINT32 filesCount;
+  UINT8 compressionLevel;
+  UINT32 compressedSize;
+  UINT32 uncompressedSize;
+
+  filesCount = m_input->readUInt32();
+  compressionLevel = m_input->readUInt8();
+  compressedSize = m_input->readUInt32();
+  uncompressedSize = m_input->readUInt32();
+  std::vector<char> buffer(compressedSize);
+  if (compressedSize != 0) {
+    m_input->readFully(&buffer.front(), compressedSize);
+  }
+
+  m_log->info(_T("upload batch of %d files (cs = %d, us = %d) requested"),
+              filesCount, compressedSize, uncompressedSize);
+
+  //
+  // Compressed data is always decompressed to keep zlib stream in sync
+  // with the client, even if the batch is not processed.
+  //
+
+  std::vector<char> batch;
+  bool isTooLarge = uncompressedSize > MAX_UPLOAD_BATCH_SIZE;
+
+  if (compressionLevel == 0) {
+    batch.swap(buffer);
+  } else if (compressedSize != 0) {
+    if (!isTooLarge) {
+      batch.reserve(uncompressedSize);
+    }
+
+    const char *input = &buffer.front();
+    size_t inputSize = compressedSize;
+    char piece[8192];
+    size_t pieceSize;
+    do {
+      pieceSize = m_inflater.inflate(&input, &inputSize,
+                                     piece, sizeof(piece));
+      if (batch.size() + pieceSize > uncompressedSize) {
+        isTooLarge = true;
+      }
+      if (!isTooLarge) {
+        batch.insert(batch.end(), piece, piece + pieceSize);
+      }
+    } while (inputSize != 0 || pieceSize == sizeof(piece));
+  }
+
+  checkAccess();
+
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
+  if (isTooLarge || batch.size() != uncompressedSize) {
+    throw FileTransferException(_T("Wrong size of upload batch"));
+  }
+
+  //
+  // Files are written one by one, failure of one of them does not
+  // stop the batch
+  //
+
+  ByteArrayInputStream batchStream(batch.empty() ? NULL : &batch.front(),
+                                   batch.size());
+  DataInputStream batchInput(&batchStream);
+
+  std::vector<StringStorage> failedFiles;
+  std::vector<StringStorage> errors;
+  std::vector<char> content;
+
+  for (UINT32 i = 0; i < filesCount; i++) {
+    WinFilePath fullPathName;
+    UINT64 modificationTime;
+    UINT32 fileSize;
+
+    batchInput.readUTF8(&fullPathName);
+    modificationTime = batchInput.readUInt64();
+    fileSize = batchInput.readUInt32();
+    content.resize(fileSize);
+    if (fileSize != 0) {
+      batchInput.readFully(&content.front(), fileSize);
+    }
+
+    try {
+      writeBatchFile(&fullPathName, modificationTime,
+                     content.empty() ? NULL : &content.front(), fileSize);
+    } catch (Exception &someEx) {
+      m_log->error(_T("failed to write \"%s\" file of upload batch: %s"),
+                   fullPathName.getString(), someEx.getMessage());
+
+      failedFiles.push_back(fullPathName);
+      errors.push_back(StringStorage(someEx.getMessage()));
+    }
+  }
+
+  //
+  // Send reply
+  //
+
+  {
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
+
+    m_output->writeUInt32(FTMessage::UPLOAD_BATCH_REPLY);
+    m_output->writeUInt32((UINT32)failedFiles.size());
+    for (size_t i = 0; i < failedFiles.size(); i++) {
+      m_output->writeUTF8(failedFiles[i].getString());
+      m_output->writeUTF8(errors[i].getString());
+    }
+
+    m_output->flush();
+  }
+}
+
+void FileTransferRequestHandler::writeBatchFile(WinFilePath *fullPathName,
+                                                UINT64 modificationTime,
+                                                const char *data,
+                                                UINT32 size)
+{
+  if (fullPathName->parentPathIsRoot()) {
+    throw FileTransferException(_T("Cannot upload file to root folder"));
+  }
+
+  File file(fullPathName->getString());
+
+  if (!file.truncate()) {
+    throw SystemException();
+  }
+
+  {
+    WinFileChannel fileChannel(fullPathName->getString(), F_WRITE, FM_OPEN);
+
+    if (size != 0) {
+      DataOutputStream output(&fileChannel);
+      output.writeFully(data, size);
+    }
+
+    fileChannel.close();
+  }
+
+  if (!file.setLastModified(modificationTime)) {
+    throw FileTransferException(_T("Cannot change last write file time"));
+  }
+}
+
 void FileTransferRequestHandler::uploadEndRequested()
 {
   UINT16 fileFlags;
@@ -633,6 +1257,9 @@ void FileTransferRequestHandler::uploadEndRequested()
 
   checkAccess();
 
+  // Cached folder listings can become outdated after this request
+  m_folderCache.clear();
+
   //
   // No active uploads at the moment.
   // Client is "bad" if send to us this message
@@ -658,12 +1285,32 @@ void FileTransferRequestHandler::uploadEndRequested()
     throw FileTransferException(_T("Cannot change last write file time"));
   } // if cannot set modification time
 
+  //
+  // Replace old version of file with the uploaded one
+  //
+
+  if (m_uploadBasis != NULL) {
+    try {
+      m_uploadBasis->close();
+    } catch (...) { }
+    delete m_uploadBasis;
+    m_uploadBasis = NULL;
+
+    StringStorage uploadPath;
+    m_uploadFile->getPath(&uploadPath);
+
+    if (!File::renameTo(m_uploadTargetPath.getString(), uploadPath.getString())) {
+      m_uploadFile->remove();
+      throw FileTransferException(_T("Cannot replace file with its new version"));
+    }
+  }
+
   //
   // Send reply
   //
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::UPLOAD_END_REPLY);
 
@@ -686,6 +1333,71 @@ void FileTransferRequestHandler::uploadEndRequested()
 
 } // void
 
+void FileTransferRequestHandler::uploadCopyRequested()
+{
+  UINT64 offset;
+  UINT64 length;
+
+  {
+    offset = m_input->readUInt64();
+    length = m_input->readUInt64();
+  } // end of reading block.
+
+  m_log->info(_T("upload copy (offset = %I64u, length = %I64u) requested"), offset, length);
+
+  checkAccess();
+
+  if (m_uploadFile == NULL || m_uploadBasis == NULL) {
+    throw FileTransferException(_T("No active delta upload at the moment"));
+  }
+
+  //
+  // Copy range of old version of file to the new one
+  //
+
+  m_uploadBasis->seek((INT64)offset);
+
+  DataOutputStream dataOutStream(m_fileOutputStream);
+  std::vector<char> buffer(64 * 1024);
+
+  while (length > 0) {
+    size_t pieceSize = (size_t)min(length, (UINT64)buffer.size());
+    try {
+      pieceSize = m_uploadBasis->read(&buffer.front(), pieceSize);
+    } catch (EOFException) {
+      throw FileTransferException(_T("Copied data is out of the file"));
+    }
+    dataOutStream.writeFully(&buffer.front(), pieceSize);
+    length -= pieceSize;
+  }
+
+  {
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
+
+    m_output->writeUInt32(FTMessage::UPLOAD_DATA_REPLY);
+
+    m_output->flush();
+  }
+}
+
+void FileTransferRequestHandler::releaseUploadBasis()
+{
+  if (m_uploadBasis == NULL) {
+    return ;
+  }
+
+  delete m_uploadBasis;
+  m_uploadBasis = NULL;
+
+  if (m_uploadFile != NULL) {
+    if (m_fileOutputStream != NULL) {
+      delete m_fileOutputStream;
+      m_fileOutputStream = NULL;
+    }
+    m_uploadFile->remove();
+  }
+}
+
 void FileTransferRequestHandler::downloadStartRequested()
 {
   WinFilePath fullPathName;
@@ -725,12 +1437,13 @@ void FileTransferRequestHandler::downloadStartRequested()
   // file position.
   //
 
-  m_fileInputStream = new WinFileChannel(fullPathName.getString(), F_READ,
-                                         FM_OPEN);
+  m_fileInputStream = new MappedFileChannel(fullPathName.getString());
   m_fileInputStream->seek(initialOffset);
 
+  m_downloadCompression.reset();
+
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
     m_output->writeUInt32(FTMessage::DOWNLOAD_START_REPLY);
 
@@ -743,6 +1456,16 @@ void FileTransferRequestHandler::downloadStartRequested()
 //
 
 void FileTransferRequestHandler::downloadDataRequested()
+{
+  sendDownloadData(false);
+}
+
+void FileTransferRequestHandler::downloadDataWindowRequested()
+{
+  sendDownloadData(true);
+}
+
+void FileTransferRequestHandler::sendDownloadData(bool isWindowed)
 {
   //
   // Request input variables.
@@ -777,13 +1500,37 @@ void FileTransferRequestHandler::downloadDataRequested()
     throw FileTransferException(_T("No active download at the moment"));
   }
 
-  std::vector<char> buffer(dataSize);
+  //
+  // End of file was already reached, this request was pipelined
+  // after the last chunk.
+  //
+
+  if (m_fileInputStream == NULL) {
+    sendDownloadEnd();
+    return ;
+  }
+
+  if (dataSize > MAX_DOWNLOAD_DATA_SIZE) {
+    dataSize = MAX_DOWNLOAD_DATA_SIZE;
+  }
+
+  //
+  // Framebuffer updates wait for the whole reply, so it is not larger
+  // than the link sends in a moment. The viewer accepts a smaller reply.
+  //
+
+  dataSize = min(dataSize, m_output->getPreemptionSize());
 
+  // File data is sent directly from the file mapping
+  const char *data = NULL;
   DWORD read = 0;
 
   try {
     if (dataSize != 0) {
-      size_t portion = m_fileInputStream->read(&buffer.front(), dataSize);
+      size_t portion = m_fileInputStream->map(&data, dataSize);
+      if (portion == 0) {
+        throw EOFException();
+      }
       read = (DWORD)portion;
       _ASSERT(read == portion);
     }
@@ -795,25 +1542,22 @@ void FileTransferRequestHandler::downloadDataRequested()
 
     try { m_fileInputStream->close(); } catch (...) { }
 
-    UINT8 fileFlags = 0;
-
-    {
-      AutoLock l(m_output);
-
-      m_output->writeUInt32(FTMessage::DOWNLOAD_END_REPLY);
-      m_output->writeUInt8(fileFlags);
-      m_output->writeUInt64(m_downloadFile->lastModified());
-
-      m_output->flush();
-    } // rfb io handle block
+    sendDownloadEnd();
 
     m_log->message(_T("%s"), _T("downloading has finished\n"));
 
     delete m_fileInputStream;
-    delete m_downloadFile;
-
     m_fileInputStream = NULL;
-    m_downloadFile = NULL;
+
+    //
+    // Windowed download keeps the file to answer the rest of
+    // outstanding requests.
+    //
+
+    if (!isWindowed) {
+      delete m_downloadFile;
+      m_downloadFile = NULL;
+    }
 
     return ;
 
@@ -824,20 +1568,38 @@ void FileTransferRequestHandler::downloadDataRequested()
   compressedSize = read;
   uncompressedSize = read;
 
+  //
+  // Client only allows compression, chunks of data that is already
+  // compressed are sent as is.
+  //
+
   if (compressionLevel != 0) {
-    if (dataSize != 0) {
-      m_deflater.setInput(&buffer.front(), uncompressedSize);
-      m_deflater.deflate();
-      _ASSERT((UINT32)m_deflater.getOutputSize() == m_deflater.getOutputSize());
-      compressedSize = (UINT32)m_deflater.getOutputSize();
+    if (read == 0) {
+      compressionLevel = 0;
+    } else {
+      // Default zlib level is used for compressible data
+      int level = m_downloadCompression.chooseLevel(data,
+                                                    read, 6);
+      compressionLevel = (UINT8)level;
     }
   }
 
+  if (compressionLevel != 0) {
+    m_deflater.setLevel(compressionLevel);
+    m_deflater.setInput(data, uncompressedSize);
+    m_deflater.deflate();
+    _ASSERT((UINT32)m_deflater.getOutputSize() == m_deflater.getOutputSize());
+    compressedSize = (UINT32)m_deflater.getOutputSize();
+
+    m_downloadCompression.chunkCompressed(compressionLevel, uncompressedSize,
+                                          compressedSize);
+  }
+
   //
   // Send download data reply
   //
 
-  AutoLock l(m_output);
+  AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
   m_output->writeUInt32(FTMessage::DOWNLOAD_DATA_REPLY);
   m_output->writeUInt8(compressionLevel);
@@ -846,7 +1608,7 @@ void FileTransferRequestHandler::downloadDataRequested()
 
   if (compressionLevel == 0) {
     if (dataSize != 0) {
-      m_output->writeFully(&buffer.front(), uncompressedSize);
+      m_output->writeFully(data, uncompressedSize);
     }
   } else {
     m_output->writeFully((const char *)m_deflater.getOutput(), compressedSize);
@@ -855,70 +1617,184 @@ void FileTransferRequestHandler::downloadDataRequested()
   m_output->flush();
 }
 
-void FileTransferRequestHandler::lastRequestFailed(StringStorage *storage)
+void FileTransferRequestHandler::downloadBatchRequested()
 {
-  lastRequestFailed(storage->getString());
-}
+  //
+  // Request input variables.
+  //
 
-void FileTransferRequestHandler::lastRequestFailed(const TCHAR *description)
-{
-  m_log->error(_T("last request failed: \"%s\""), description);
+  UINT8 requestedCompressionLevel;
+  UINT32 filesCount;
+
+  requestedCompressionLevel = m_input->readUInt8();
+  filesCount = m_input->readUInt32();
+  // Paths are sent back in the reply as the client has sent them
+  std::vector<StringStorage> paths(filesCount);
+  for (UINT32 i = 0; i < filesCount; i++) {
+    m_input->readUTF8(&paths[i]);
+  }
+
+  m_log->info(_T("download batch of %d files (comp flag = %d) requested"),
+              filesCount, requestedCompressionLevel);
+
+  checkAccess();
+
+  //
+  // Files are read one by one, files that cannot be read are listed
+  // in the reply and do not stop the batch
+  //
+
+  ByteArrayOutputStream batchStream;
+  DataOutputStream batchOutput(&batchStream);
+
+  UINT32 readCount = 0;
+  std::vector<StringStorage> failedFiles;
+  std::vector<StringStorage> errors;
+  std::vector<char> content;
+
+  for (UINT32 i = 0; i < filesCount; i++) {
+    WinFilePath fullPathName(paths[i].getString());
+    UINT64 modificationTime;
+    size_t room = MAX_DOWNLOAD_BATCH_SIZE - min(batchStream.size(),
+                                                (size_t)MAX_DOWNLOAD_BATCH_SIZE);
+
+    try {
+      readBatchFile(&fullPathName, &modificationTime, &content, room);
+    } catch (Exception &someEx) {
+      m_log->error(_T("failed to read \"%s\" file of download batch: %s"),
+                   fullPathName.getString(), someEx.getMessage());
+
+      failedFiles.push_back(paths[i]);
+      errors.push_back(StringStorage(someEx.getMessage()));
+      continue;
+    }
+
+    UINT32 fileSize = (UINT32)content.size();
+    batchOutput.writeUTF8(paths[i].getString());
+    batchOutput.writeUInt64(modificationTime);
+    batchOutput.writeUInt32(fileSize);
+    if (fileSize != 0) {
+      batchOutput.writeFully(&content.front(), fileSize);
+    }
+    readCount++;
+  }
+
+  //
+  // Compress the batch with the same stream as download data
+  //
+
+  const char *data = batchStream.toByteArray();
+  UINT32 uncompressedSize = (UINT32)batchStream.size();
+  UINT32 compressedSize = uncompressedSize;
+  UINT8 compressionLevel = requestedCompressionLevel;
+
+  if (compressionLevel != 0) {
+    if (uncompressedSize == 0) {
+      compressionLevel = 0;
+    } else {
+      // Batch consists of several files, so no decisions made for
+      // previous chunks are used
+      m_downloadCompression.reset();
+      compressionLevel = (UINT8)m_downloadCompression.chooseLevel(data,
+                                                                  uncompressedSize,
+                                                                  6);
+    }
+  }
+
+  if (compressionLevel != 0) {
+    m_deflater.setLevel(compressionLevel);
+    m_deflater.setInput(data, uncompressedSize);
+    m_deflater.deflate();
+    _ASSERT((UINT32)m_deflater.getOutputSize() == m_deflater.getOutputSize());
+    compressedSize = (UINT32)m_deflater.getOutputSize();
+    data = m_deflater.getOutput();
+  }
+
+  //
+  // Send reply
+  //
 
   {
-    AutoLock l(m_output);
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
-    m_output->writeUInt32(FTMessage::LAST_REQUEST_FAILED_REPLY);
-    m_output->writeUTF8(description);
+    m_output->writeUInt32(FTMessage::DOWNLOAD_BATCH_REPLY);
+    m_output->writeUInt32(readCount);
+    m_output->writeUInt8(compressionLevel);
+    m_output->writeUInt32(compressedSize);
+    m_output->writeUInt32(uncompressedSize);
+    if (compressedSize != 0) {
+      m_output->writeFully(data, compressedSize);
+    }
+    m_output->writeUInt32((UINT32)failedFiles.size());
+    for (size_t i = 0; i < failedFiles.size(); i++) {
+      m_output->writeUTF8(failedFiles[i].getString());
+      m_output->writeUTF8(errors[i].getString());
+    }
 
     m_output->flush();
   }
 }
 
-bool FileTransferRequestHandler::getDirectorySize(const TCHAR *pathname, UINT64 *dirSize)
+void FileTransferRequestHandler::readBatchFile(const WinFilePath *fullPathName,
+                                               UINT64 *modificationTime,
+                                               std::vector<char> *content,
+                                               size_t maxSize)
 {
-  UINT64 currentDirSize = 0;
-  UINT32 filesCount = 0;
-  UINT32 dataSize = 0;
+  File file(fullPathName->getString());
 
-  File folder(pathname);
+  if (!file.isFile()) {
+    throw FileTransferException(_T("File does not exist"));
+  }
 
-  //
-  // Get files count
-  //
+  *modificationTime = file.lastModified();
 
-  if (!folder.list(NULL, &filesCount)) {
-    return false;
+  UINT64 length = file.length();
+  if (length > maxSize) {
+    throw FileTransferException(_T("File is too large for download batch"));
   }
 
-  if (filesCount != 0) {
-    std::vector<StringStorage> fileNames(filesCount);
+  content->resize((size_t)length);
 
-    //
-    // Get file names
-    //
+  WinFileChannel fileChannel(fullPathName->getString(), F_READ, FM_OPEN);
 
-    folder.list(&fileNames.front(), NULL);
+  if (!content->empty()) {
+    DataInputStream input(&fileChannel);
+    input.readFully(&content->front(), content->size());
+  }
 
-    for (UINT32 i = 0; i < filesCount; i++) {
-      File subfile(pathname, fileNames[i].getString());
-      if (subfile.isDirectory()) {
+  fileChannel.close();
+}
 
-        UINT64 subDirSize = 0;
-        StringStorage subDirPath;
+void FileTransferRequestHandler::sendDownloadEnd()
+{
+  UINT8 fileFlags = 0;
 
-        subfile.getPath(&subDirPath);
+  AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
 
-        if (getDirectorySize(subDirPath.getString(), &subDirSize)) {
-          currentDirSize += subDirSize;
-        }  // if it got sub directory size
-      } else {
-        currentDirSize += subfile.length();
-      } // if subfile is normal file
-    } // for every subfile in file list
-  }
-  *dirSize = currentDirSize;
+  m_output->writeUInt32(FTMessage::DOWNLOAD_END_REPLY);
+  m_output->writeUInt8(fileFlags);
+  m_output->writeUInt64(m_downloadFile->lastModified());
+
+  m_output->flush();
+}
+
+void FileTransferRequestHandler::lastRequestFailed(StringStorage *storage)
+{
+  lastRequestFailed(storage->getString());
+}
+
+void FileTransferRequestHandler::lastRequestFailed(const TCHAR *description)
+{
+  m_log->error(_T("last request failed: \"%s\""), description);
 
-  return true;
+  {
+    AutoLock l(m_output->getClassLock(RfbOutputGate::CLASS_FILE_TRANSFER));
+
+    m_output->writeUInt32(FTMessage::LAST_REQUEST_FAILED_REPLY);
+    m_output->writeUTF8(description);
+
+    m_output->flush();
+  }
 }
 
 void FileTransferRequestHandler::checkAccess()
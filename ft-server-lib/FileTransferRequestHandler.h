@@ -29,20 +29,31 @@
 #include "network/RfbInputGate.h"
 #include "network/RfbOutputGate.h"
 #include "ft-common/FileInfo.h"
+#include "ft-common/FolderMetadataCache.h"
+#include "ft-common/CompressionAdvisor.h"
+#include "ft-common/WinFilePath.h"
 #include "file-lib/WinFileChannel.h"
+#include "file-lib/MappedFileChannel.h"
 #include "util/Inflater.h"
 #include "util/Deflater.h"
+#include "io-lib/ByteArrayOutputStream.h"
 #include "desktop/Desktop.h"
 #include "rfb-sconn/RfbCodeRegistrator.h"
 #include "rfb-sconn/RfbDispatcherListener.h"
 #include "FileTransferSecurity.h"
+#include "FileTransferWorker.h"
 #include "log-writer/LogWriter.h"
 
 /**
  * Handler of file transfer plugin client to server messages.
  * Processes client requests and sends replies.
+ *
+ * Requests are read by the rfb dispatcher thread and executed by own
+ * worker thread (in the same order), so slow file operations do not
+ * delay processing of other client messages.
  */
-class FileTransferRequestHandler : public RfbDispatcherListener
+class FileTransferRequestHandler : public RfbDispatcherListener,
+                                   public FileTransferRequestProcessor
 {
 public:
   /**
@@ -68,29 +79,70 @@ public:
 
   /**
    * Inherited from RfbDispatcherListener.
-   * Processes file transfer client messages.
+   * Reads file transfer client message and queues it to the worker.
    */
   virtual void onRequest(UINT32 reqCode, RfbInputGate *backGate);
 
+  /**
+   * Inherited from FileTransferRequestProcessor.
+   * Processes file transfer client messages, called by the worker thread.
+   */
+  virtual void processRequest(UINT32 reqCode, DataInputStream *input);
+
 protected:
 
+  /**
+   * Reads body of file transfer client message.
+   * @param reqCode code of the message.
+   * @param input gate to read the message from.
+   * @param body [out] body of the message in the same format.
+   */
+  void readRequestBody(UINT32 reqCode, RfbInputGate *input,
+                       std::vector<char> *body);
+
+  /**
+   * Copies string in UTF8 format from input to output.
+   */
+  static void copyUTF8(DataInputStream *input, DataOutputStream *output);
+
   /**
    * Checks if file transfer if enabled.
    * @return true if file transfer is enabled, false otherwise.
    */
   bool isFileTransferEnabled();
 
+  /**
+   * Clears folder cache if the request is processed as another user than
+   * the cached listings were made by (the logged on user may change
+   * between requests).
+   */
+  void checkFolderCacheUser();
+
   //
   // Common request handlers.
   //
 
   void compressionSupportRequested();
   void fileListRequested();
+  void fileListPagedRequested();
+
+  /**
+   * Sends part of folder content as file list page reply.
+   * @param compressionLevel compression level requested by client.
+   * @param entries files info in file list reply format.
+   * @param filesCount count of files info in entries.
+   * @param isLast true if this is the last part of folder content.
+   */
+  void sendFileListPage(UINT8 compressionLevel,
+                        const ByteArrayOutputStream *entries,
+                        UINT32 filesCount,
+                        bool isLast);
   void mkDirRequested();
   void rmFileRequested();
   void mvFileRequested();
   void dirSizeRequested();
   void md5Requested();
+  void fileSignatureRequested();
 
   //
   // Upload requests handlers.
@@ -99,6 +151,26 @@ protected:
   void uploadStartRequested();
   void uploadDataRequested();
   void uploadEndRequested();
+  void uploadCopyRequested();
+
+  /**
+   * Writes all files of upload batch request, files that cannot be
+   * written are listed in the reply.
+   */
+  void uploadBatchRequested();
+
+  /**
+   * Creates (or overwrites) file of upload batch with specified content.
+   * @throws Exception on fail.
+   */
+  void writeBatchFile(WinFilePath *fullPathName, UINT64 modificationTime,
+                      const char *data, UINT32 size);
+
+  /**
+   * Closes old version of file used by broken delta upload and removes
+   * temporary file with its new version.
+   */
+  void releaseUploadBasis();
 
   //
   // Download requests handlers.
@@ -106,6 +178,35 @@ protected:
 
   void downloadStartRequested();
   void downloadDataRequested();
+  void downloadDataWindowRequested();
+
+  /**
+   * Reads body of download data request and sends next chunk of file
+   * (or end of download reply when end of file is reached).
+   * @param isWindowed if true, download state is kept after end of file, so
+   *   requests that were pipelined after the last chunk are answered with
+   *   end of download reply too instead of failing.
+   */
+  void sendDownloadData(bool isWindowed);
+
+  /**
+   * Reads all files of download batch request and sends them in one
+   * reply, files that cannot be read are listed in the reply.
+   */
+  void downloadBatchRequested();
+
+  /**
+   * Reads content and modification time of file of download batch.
+   * @param maxSize maximal size of file that fits to the batch.
+   * @throws Exception on fail.
+   */
+  void readBatchFile(const WinFilePath *fullPathName, UINT64 *modificationTime,
+                     std::vector<char> *content, size_t maxSize);
+
+  /**
+   * Sends end of download reply for current download file.
+   */
+  void sendDownloadEnd();
 
   //
   // Method sends "Last request failed" message with error description.
@@ -114,12 +215,6 @@ protected:
   void lastRequestFailed(StringStorage *storage);
   void lastRequestFailed(const TCHAR *description);
 
-  //
-  // Helper methods
-  //
-
-  bool getDirectorySize(const TCHAR *pathname, UINT64 *dirSize);
-
 protected:
   /**
    * Checks if we can run file transfer now (using FileTransferSecurity).
@@ -134,15 +229,46 @@ protected:
   // Input and output gates.
   //
 
-  RfbInputGate *m_input;
+  // Body of request that is processed now.
+  DataInputStream *m_input;
   RfbOutputGate *m_output;
 
+  // Executes requests.
+  FileTransferWorker *m_worker;
+
   //
   // Download operation members
   //
 
   File *m_downloadFile;
-  WinFileChannel *m_fileInputStream;
+  // File is read through its mapping, so data is sent without copying.
+  MappedFileChannel *m_fileInputStream;
+  // Decides which chunks of current download file are compressed.
+  CompressionAdvisor m_downloadCompression;
+
+  /**
+   * Maximal size of file data that is sent in one download data reply,
+   * larger requests are truncated to this size.
+   */
+  static const UINT32 MAX_DOWNLOAD_DATA_SIZE = 8 * 1024 * 1024;
+
+  /**
+   * Maximal size of uncompressed data of upload batch request.
+   */
+  static const UINT32 MAX_UPLOAD_BATCH_SIZE = 16 * 1024 * 1024;
+
+  /**
+   * Maximal size of uncompressed data and count of files of download
+   * batch. Files that do not fit to the batch are reported as failed.
+   */
+  static const UINT32 MAX_DOWNLOAD_BATCH_SIZE = 16 * 1024 * 1024;
+  static const UINT32 MAX_DOWNLOAD_BATCH_FILES_COUNT = 1024;
+
+  /**
+   * Size of files info data after which part of folder content is sent
+   * as file list page reply.
+   */
+  static const size_t FILE_LIST_PAGE_SIZE = 64 * 1024;
 
   //
   // Upload operation members
@@ -151,6 +277,21 @@ protected:
   File *m_uploadFile;
   WinFileChannel *m_fileOutputStream;
 
+  /**
+   * Old version of file that is replaced by delta upload, data ranges
+   * of upload copy requests are taken from it. New version of the file
+   * is written to m_uploadFile that is temporary file next to the old one
+   * and replaces it at end of upload.
+   */
+  WinFileChannel *m_uploadBasis;
+  // Path to file that is replaced by delta upload.
+  StringStorage m_uploadTargetPath;
+
+  /**
+   * Suffix of name of temporary file that is written by delta upload.
+   */
+  static const TCHAR DELTA_TEMP_FILE_SUFFIX[];
+
   //
   // Zlib encoder / decoder
   //
@@ -158,6 +299,22 @@ protected:
   Deflater m_deflater;
   Inflater m_inflater;
 
+  /**
+   * Listings of folders that are walked by folder size requests,
+   * content of folder is usually requested right after its size.
+   */
+  FolderMetadataCache m_folderCache;
+
+  /**
+   * SID string of user the cached folder listings are made by.
+   */
+  StringStorage m_folderCacheUser;
+
+  /**
+   * Time in milliseconds while cached folder listing is valid.
+   */
+  static const DWORD FOLDER_CACHE_LIFETIME = 30000;
+
   //
   // Security and impersonation.
   //
@@ -0,0 +1,47 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FILE_TRANSFER_REQUEST_PROCESSOR_H_
+#define _FILE_TRANSFER_REQUEST_PROCESSOR_H_
+
+#include "util/inttypes.h"
+#include "io-lib/DataInputStream.h"
+
+/**
+ * Interface of file transfer requests processor that is called
+ * by FileTransferWorker.
+ */
+class FileTransferRequestProcessor
+{
+public:
+  virtual ~FileTransferRequestProcessor() { }
+
+  /**
+   * Executes file transfer request and sends reply to it.
+   * @param reqCode code of file transfer message.
+   * @param input stream with body of the message.
+   */
+  virtual void processRequest(UINT32 reqCode, DataInputStream *input) = 0;
+};
+
+#endif
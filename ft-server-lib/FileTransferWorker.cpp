@@ -0,0 +1,114 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FileTransferWorker.h"
+
+#include "io-lib/ByteArrayInputStream.h"
+#include "thread/AutoLock.h"
+
+FileTransferWorker::FileTransferWorker(FileTransferRequestProcessor *processor,
+                                       LogWriter *log)
+: m_processor(processor),
+  m_queuedBytes(0),
+  m_log(log)
+{
+  resume();
+}
+
+FileTransferWorker::~FileTransferWorker()
+{
+  terminate();
+  wait();
+
+  while (!m_requests.empty()) {
+    delete m_requests.front();
+    m_requests.pop_front();
+  }
+}
+
+void FileTransferWorker::addRequest(UINT32 reqCode, std::vector<char> *body)
+{
+  Request *request = new Request;
+  request->reqCode = reqCode;
+  request->body.swap(*body);
+
+  while (!isTerminating()) {
+    {
+      AutoLock al(&m_lock);
+
+      // Single request is queued even if it exceeds the limit.
+      if (m_requests.empty() ||
+          m_queuedBytes + request->body.size() <= MAX_QUEUED_BYTES) {
+        m_requests.push_back(request);
+        m_queuedBytes += request->body.size();
+        m_requestAddedEvent.notify();
+        return ;
+      }
+    }
+    m_requestTakenEvent.waitForEvent();
+  }
+
+  delete request;
+}
+
+void FileTransferWorker::execute()
+{
+  m_log->info(_T("File transfer worker started"));
+
+  while (!isTerminating()) {
+    Request *request = 0;
+
+    {
+      AutoLock al(&m_lock);
+
+      if (!m_requests.empty()) {
+        request = m_requests.front();
+        m_requests.pop_front();
+        m_queuedBytes -= request->body.size();
+      }
+    }
+
+    if (request == 0) {
+      m_requestAddedEvent.waitForEvent();
+      continue;
+    }
+
+    m_requestTakenEvent.notify();
+
+    const char *body = request->body.empty() ? 0 : &request->body.front();
+    ByteArrayInputStream bodyStream(body, request->body.size());
+    DataInputStream input(&bodyStream);
+
+    m_processor->processRequest(request->reqCode, &input);
+
+    delete request;
+  }
+
+  m_log->info(_T("File transfer worker stopped"));
+}
+
+void FileTransferWorker::onTerminate()
+{
+  m_requestAddedEvent.notify();
+  m_requestTakenEvent.notify();
+}
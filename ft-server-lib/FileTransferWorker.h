@@ -0,0 +1,101 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FILE_TRANSFER_WORKER_H_
+#define _FILE_TRANSFER_WORKER_H_
+
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+#include "log-writer/LogWriter.h"
+#include "FileTransferRequestProcessor.h"
+
+#include <deque>
+#include <vector>
+
+/**
+ * Thread that executes file transfer requests in order of their arrival.
+ *
+ * Bodies of requests are read from network by the rfb dispatcher thread,
+ * file operations (which can take long time) are made by this thread, so
+ * the dispatcher thread is free to process input and update requests
+ * during file transfers.
+ */
+class FileTransferWorker : public Thread
+{
+public:
+  /**
+   * Creates and starts worker.
+   * @param processor processor of requests, it's called from this thread.
+   */
+  FileTransferWorker(FileTransferRequestProcessor *processor, LogWriter *log);
+
+  /**
+   * Stops worker and waits until current request is finished.
+   * Requests that are not started yet are discarded.
+   */
+  virtual ~FileTransferWorker();
+
+  /**
+   * Adds request to queue.
+   * @param reqCode code of file transfer message.
+   * @param body body of the message, content of the vector is taken.
+   * @remark blocks while too much data of upload requests waits in queue,
+   *   so uploads are throttled to speed of the disk.
+   */
+  void addRequest(UINT32 reqCode, std::vector<char> *body);
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  /**
+   * Queued request.
+   */
+  struct Request
+  {
+    UINT32 reqCode;
+    std::vector<char> body;
+  };
+
+  FileTransferRequestProcessor *m_processor;
+
+  // Members below are protected by m_lock.
+  LocalMutex m_lock;
+  std::deque<Request *> m_requests;
+  size_t m_queuedBytes;
+
+  // Notified when request is added to queue.
+  WindowsEvent m_requestAddedEvent;
+  // Notified when request is taken from queue.
+  WindowsEvent m_requestTakenEvent;
+
+  /**
+   * Maximal total size of bodies of queued requests.
+   */
+  static const size_t MAX_QUEUED_BYTES = 32 * 1024 * 1024;
+
+  LogWriter *m_log;
+};
+
+#endif
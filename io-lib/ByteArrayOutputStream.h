@@ -70,6 +70,11 @@ public:
    */
   const char *toByteArray() const;
 
+  /**
+   * Discards written data, memory buffer is kept for next writes.
+   */
+  void reset();
+
 protected:
   bool m_ownMemory;
   char *m_buffer;
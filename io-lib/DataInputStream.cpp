@@ -37,12 +37,12 @@ DataInputStream::~DataInputStream()
 {
 }
 
-size_t DataInputStream::read(void *buffer, size_t len)
+size_t DataInputStream::read(void *buffer, size_t len) throw(IOException)
 {
   return m_inputStream->read(buffer, len);
 }
 
-void DataInputStream::readFully(void *buffer, size_t len)
+void DataInputStream::readFully(void *buffer, size_t len) throw(IOException)
 {
   char *typedBuffer = (char *)buffer;
   size_t totalRead = 0;
@@ -54,14 +54,14 @@ void DataInputStream::readFully(void *buffer, size_t len)
   }
 }
 
-UINT8 DataInputStream::readUInt8()
+UINT8 DataInputStream::readUInt8() throw(IOException)
 {
   UINT8 x;
   readFully(&x, 1);
   return x;
 }
 
-UINT16 DataInputStream::readUInt16()
+UINT16 DataInputStream::readUInt16() throw(IOException)
 {
   UINT16 x = 0;
   UINT8 buf[2];
@@ -71,7 +71,7 @@ UINT16 DataInputStream::readUInt16()
   return x;
 }
 
-UINT32 DataInputStream::readUInt32()
+UINT32 DataInputStream::readUInt32() throw(IOException)
 {
   UINT32 x = 0;
   UINT8 buf[4];
@@ -83,7 +83,7 @@ UINT32 DataInputStream::readUInt32()
   return x;
 }
 
-UINT64 DataInputStream::readUInt64()
+UINT64 DataInputStream::readUInt64() throw(IOException)
 {
   UINT64 x = 0;
   UINT8 buf[8];
@@ -99,29 +99,29 @@ UINT64 DataInputStream::readUInt64()
   return x;
 }
 
-INT8 DataInputStream::readInt8()
+INT8 DataInputStream::readInt8() throw(IOException)
 {
   INT8 x;
   readFully(&x, 1);
   return x;
 }
 
-INT16 DataInputStream::readInt16()
+INT16 DataInputStream::readInt16() throw(IOException)
 {
   return (INT16)readUInt16();
 }
 
-INT32 DataInputStream::readInt32()
+INT32 DataInputStream::readInt32() throw(IOException)
 {
   return (INT32)readUInt32();
 }
 
-INT64 DataInputStream::readInt64()
+INT64 DataInputStream::readInt64() throw(IOException)
 {
   return (INT64)readUInt64();
 }
 
-void DataInputStream::readUTF8(StringStorage *storage)
+void DataInputStream::readUTF8(StringStorage *storage) throw(IOException)
 {
   UINT32 sizeInBytes = readUInt32();
   if (sizeInBytes > 0) {
@@ -0,0 +1,110 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "InflaterInputStream.h"
+#include "util/CommonHeader.h"
+
+InflaterInputStream::InflaterInputStream(Inflater *inflater,
+                                         InputStream *input,
+                                         size_t compressedSize)
+: m_inflater(inflater),
+  m_input(input),
+  m_compressedLeft(compressedSize),
+  m_inPos(m_inBuffer),
+  m_inLeft(0),
+  m_outPos(m_outBuffer),
+  m_outLeft(0)
+{
+}
+
+InflaterInputStream::~InflaterInputStream()
+{
+}
+
+size_t InflaterInputStream::read(void *buffer, size_t len)
+{
+  if (len == 0) {
+    return 0;
+  }
+  if (m_outLeft == 0) {
+    if (len >= BUFFER_SIZE) {
+      return inflateSome((char *)buffer, len);
+    }
+    m_outLeft = inflateSome(m_outBuffer, BUFFER_SIZE);
+    m_outPos = m_outBuffer;
+  }
+  size_t count = min(len, m_outLeft);
+  memcpy(buffer, m_outPos, count);
+  m_outPos += count;
+  m_outLeft -= count;
+  return count;
+}
+
+void InflaterInputStream::finish()
+{
+  m_outLeft = 0;
+  while (true) {
+    // Usually only the empty block of the sync flush is left.
+    size_t inLeft = m_inLeft;
+    size_t count = m_inflater->inflate(&m_inPos, &m_inLeft,
+                                       m_outBuffer, BUFFER_SIZE);
+    if (m_inLeft == 0) {
+      if (m_compressedLeft != 0) {
+        readInput();
+      } else if (count < BUFFER_SIZE) {
+        return;
+      }
+    } else if (count == 0 && m_inLeft == inLeft) {
+      throw IOException(_T("Cannot decompress data"));
+    }
+  }
+}
+
+size_t InflaterInputStream::inflateSome(char *buffer, size_t len)
+{
+  while (true) {
+    // The inflater may keep decompressed data of the previous input.
+    size_t inLeft = m_inLeft;
+    size_t count = m_inflater->inflate(&m_inPos, &m_inLeft, buffer, len);
+    if (count != 0) {
+      return count;
+    }
+    if (m_inLeft == 0) {
+      if (m_compressedLeft == 0) {
+        throw IOException(_T("Unexpected end of compressed data"));
+      }
+      readInput();
+    } else if (m_inLeft == inLeft) {
+      throw IOException(_T("Cannot decompress data"));
+    }
+  }
+}
+
+void InflaterInputStream::readInput()
+{
+  size_t count = min(m_compressedLeft, BUFFER_SIZE);
+  m_input.readFully(m_inBuffer, count);
+  m_compressedLeft -= count;
+  m_inPos = m_inBuffer;
+  m_inLeft = count;
+}
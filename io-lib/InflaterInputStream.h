@@ -0,0 +1,104 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _INFLATER_INPUT_STREAM_H_
+#define _INFLATER_INPUT_STREAM_H_
+
+#include "InputStream.h"
+#include "DataInputStream.h"
+#include "util/Inflater.h"
+
+/**
+ * Inflater input stream (decorator pattern).
+ * Reads the given number of compressed bytes from the real input stream on
+ * demand and returns them decompressed. Only small fixed-size buffers are
+ * used whatever the size of the data is. Big reads are decompressed directly
+ * to the buffer of the caller.
+ */
+class InflaterInputStream : public InputStream
+{
+public:
+  /**
+   * Creates new inflater input stream.
+   * @param inflater zlib stream which decompresses the data. The stream
+   * keeps its state between the compressed blocks, so it is owned by the
+   * caller.
+   * @param input real input stream.
+   * @param compressedSize count of compressed bytes to read from the real
+   * stream.
+   */
+  InflaterInputStream(Inflater *inflater, InputStream *input,
+                      size_t compressedSize);
+  virtual ~InflaterInputStream();
+
+  /**
+   * Reads decompressed data.
+   * @return count of bytes read, at least one.
+   * @throws IOException when the compressed data is over.
+   * @throws ZLibException on corrupted data.
+   */
+  virtual size_t read(void *buffer, size_t len);
+
+  /**
+   * Reads the rest of the compressed data from the real input stream.
+   * The decompressed data which has not been read is dropped.
+   * @remark must be called when the data is read, otherwise the real input
+   * stream stays in the middle of the compressed data.
+   */
+  void finish();
+
+protected:
+  /**
+   * Decompresses data to the buffer, reading the real input stream when
+   * needed. Returns count of bytes decompressed, at least one.
+   */
+  size_t inflateSome(char *buffer, size_t len);
+
+  /**
+   * Reads the next portion of the compressed data to m_inBuffer.
+   */
+  void readInput();
+
+  Inflater *m_inflater;
+  DataInputStream m_input;
+  size_t m_compressedLeft;
+
+  static const size_t BUFFER_SIZE = 8192;
+
+  /**
+   * Compressed data read from the real stream but not decompressed yet.
+   */
+  char m_inBuffer[BUFFER_SIZE];
+  const char *m_inPos;
+  size_t m_inLeft;
+
+  /**
+   * Decompressed data which has not been read yet. It is used for small
+   * reads only.
+   */
+  char m_outBuffer[BUFFER_SIZE];
+  const char *m_outPos;
+  size_t m_outLeft;
+};
+
+#endif
@@ -0,0 +1,74 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "MeteredOutputStream.h"
+#include "thread/AutoLock.h"
+
+MeteredOutputStream::MeteredOutputStream(OutputStream *output)
+: m_output(output),
+  m_bytesWritten(0),
+  m_writeTicks(0),
+  m_ticksPerSecond(0)
+{
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+}
+
+MeteredOutputStream::~MeteredOutputStream()
+{
+}
+
+size_t MeteredOutputStream::write(const void *buffer, size_t len)
+{
+  LARGE_INTEGER start, finish;
+  QueryPerformanceCounter(&start);
+  size_t written = m_output->write(buffer, len);
+  QueryPerformanceCounter(&finish);
+
+  AutoLock al(&m_countersLock);
+  m_bytesWritten += written;
+  m_writeTicks += finish.QuadPart - start.QuadPart;
+  return written;
+}
+
+void MeteredOutputStream::flush()
+{
+  m_output->flush();
+}
+
+UINT64 MeteredOutputStream::getBytesWritten() const
+{
+  AutoLock al(&m_countersLock);
+  return m_bytesWritten;
+}
+
+double MeteredOutputStream::getWriteSeconds() const
+{
+  if (m_ticksPerSecond == 0) {
+    return 0.0;
+  }
+  AutoLock al(&m_countersLock);
+  return (double)m_writeTicks / (double)m_ticksPerSecond;
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _METERED_OUTPUT_STREAM_H_
+#define _METERED_OUTPUT_STREAM_H_
+
+#include "util/CommonHeader.h"
+#include "OutputStream.h"
+#include "thread/LocalMutex.h"
+
+/**
+ * Metered output stream (decorator pattern).
+ * Passes all data to the real output stream and counts the written bytes
+ * and the time spent inside of the real stream. The time shows how long the
+ * writer was blocked by a slow consumer, e.g. by a congested network link.
+ * The counters may be read from a thread other than the writer one.
+ */
+class MeteredOutputStream : public OutputStream
+{
+public:
+  /**
+   * Creates new metered output stream.
+   * @param output real output stream.
+   */
+  MeteredOutputStream(OutputStream *output);
+  virtual ~MeteredOutputStream();
+
+  /**
+   * Writes data to the real output stream and meters the call.
+   * @return count of written bytes.
+   * @throws any kind of exception (depends on implementation of the real
+   * stream).
+   */
+  virtual size_t write(const void *buffer, size_t len);
+
+  /**
+   * Flushes the real output stream.
+   */
+  virtual void flush();
+
+  /**
+   * Returns the number of bytes written since the stream was created.
+   */
+  UINT64 getBytesWritten() const;
+
+  /**
+   * Returns the time (in seconds) spent in the real output stream since
+   * the stream was created.
+   */
+  double getWriteSeconds() const;
+
+protected:
+  OutputStream *m_output;
+
+  UINT64 m_bytesWritten;
+  INT64 m_writeTicks;
+  INT64 m_ticksPerSecond;
+  // Guards m_bytesWritten and m_writeTicks.
+  mutable LocalMutex m_countersLock;
+};
+
+#endif
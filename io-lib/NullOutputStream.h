@@ -0,0 +1,62 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _NULL_OUTPUT_STREAM_H_
+#define _NULL_OUTPUT_STREAM_H_
+
+#include "OutputStream.h"
+#include "util/inttypes.h"
+
+/**
+ * Output stream that discards all data and only counts written bytes.
+ * Useful to measure the size of the data produced by encoders without
+ * spending time on storing it.
+ */
+class NullOutputStream : public OutputStream
+{
+public:
+  NullOutputStream();
+  virtual ~NullOutputStream();
+
+  /**
+   * Discards data.
+   * @return len, all data is always accepted.
+   */
+  virtual size_t write(const void *buffer, size_t len);
+
+  /**
+   * Returns count of bytes written since creation or the last reset().
+   */
+  UINT64 getWrittenSize() const;
+
+  /**
+   * Resets the counter of written bytes.
+   */
+  void reset();
+
+protected:
+  UINT64 m_writtenSize;
+};
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "TeeOutputStream.h"
+
+TeeOutputStream::TeeOutputStream(OutputStream *output, OutputStream *copy)
+: m_output(output),
+  m_copy(copy)
+{
+}
+
+TeeOutputStream::~TeeOutputStream()
+{
+}
+
+size_t TeeOutputStream::write(const void *buffer, size_t len)
+{
+  size_t written = m_output->write(buffer, len);
+
+  const char *typedBuffer = (const char *)buffer;
+  size_t copied = 0;
+  while (copied < written) {
+    copied += m_copy->write(typedBuffer + copied, written - copied);
+  }
+
+  return written;
+}
+
+void TeeOutputStream::flush()
+{
+  m_output->flush();
+  m_copy->flush();
+}
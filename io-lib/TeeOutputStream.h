@@ -0,0 +1,65 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _TEE_OUTPUT_STREAM_H_
+#define _TEE_OUTPUT_STREAM_H_
+
+#include "OutputStream.h"
+
+/**
+ * Tee output stream (decorator pattern).
+ * Writes all data to the real output stream and duplicates everything that
+ * was actually written to a second (copy) stream.
+ */
+class TeeOutputStream : public OutputStream
+{
+public:
+  /**
+   * Creates new tee output stream.
+   * @param output real output stream.
+   * @param copy stream that receives a copy of all written data.
+   */
+  TeeOutputStream(OutputStream *output, OutputStream *copy);
+  virtual ~TeeOutputStream();
+
+  /**
+   * Writes data to the real output stream, then writes the same bytes
+   * to the copy stream.
+   * @return count of bytes written to the real output stream.
+   * @throws any kind of exception (depends on implementation of the
+   * streams).
+   */
+  virtual size_t write(const void *buffer, size_t len);
+
+  /**
+   * Flushes the real output stream, then flushes the copy stream.
+   */
+  virtual void flush();
+
+protected:
+  OutputStream *m_output;
+  OutputStream *m_copy;
+};
+
+#endif
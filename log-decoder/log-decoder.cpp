@@ -0,0 +1,142 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "log-writer/BinaryLogDecoder.h"
+#include "log-writer/LogArguments.h"
+#include "file-lib/EOFException.h"
+#include "file-lib/MappedFileChannel.h"
+#include "file-lib/WinFile.h"
+#include "util/Exception.h"
+#include "util/Unicode.h"
+#include <stdio.h>
+#include <vector>
+
+static void printUsage()
+{
+  _ftprintf(stderr,
+            _T("Usage: log-decoder [options] <binary log> [<text log>]\n")
+            _T("  -level <n>   skip messages above the log level n\n")
+            _T("Writes the messages of the binary log (.blog) as the text\n")
+            _T("log lines to the text log file or to the standard output.\n"));
+}
+
+//
+// Formats the message as FileAccount does in a text log file, with
+// milliseconds in the time.
+//
+static void formatLine(const BinaryLogDecoder::Message *message,
+                       const TCHAR *text, StringStorage *line)
+{
+  SYSTEMTIME st;
+  message->dt.toUtcSystemTime(&st);
+  const TCHAR logLevelSignature[] = _T("@!*+-:    xxxxxx");
+  TCHAR sig = logLevelSignature[message->level & 0x0F];
+
+  line->format(_T("[%5d/%5d] %.4d-%.2d-%.2d %.2d:%.2d:%.2d:%.3d %c %s"),
+               message->processId, message->threadId,
+               st.wYear, st.wMonth, st.wDay,
+               st.wHour, st.wMinute, st.wSecond, st.wMilliseconds,
+               sig, text);
+  const TCHAR badCharacters[] = { 13, 10, 0 };
+  line->removeChars(badCharacters, sizeof(badCharacters) / sizeof(TCHAR));
+}
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  int maxLevel = 9;
+  const TCHAR *inputPath = 0;
+  const TCHAR *outputPath = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (_tcscmp(argv[i], _T("-level")) == 0 && i + 1 < argc) {
+      maxLevel = _ttoi(argv[++i]);
+    } else if (argv[i][0] != _T('-') && inputPath == 0) {
+      inputPath = argv[i];
+    } else if (argv[i][0] != _T('-') && outputPath == 0) {
+      outputPath = argv[i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+  if (inputPath == 0) {
+    printUsage();
+    return 1;
+  }
+
+  unsigned int messageCount = 0;
+  try {
+    MappedFileChannel input(inputPath);
+    BinaryLogDecoder decoder(&input);
+    decoder.readSignature();
+
+    WinFile *output = 0;
+    if (outputPath != 0) {
+      output = new WinFile(outputPath, F_WRITE, FM_CREATE);
+      if (Unicode::isEnabled()) {
+        unsigned short signature = Unicode::SIGNATURE;
+        output->write(&signature, sizeof(signature));
+      }
+    }
+
+    BinaryLogDecoder::Message message;
+    std::vector<TCHAR> text;
+    StringStorage line;
+    try {
+      while (true) {
+        decoder.readMessage(&message);
+        if (message.level > maxLevel) {
+          continue;
+        }
+        const char *args = message.args.empty() ? 0 : &message.args.front();
+        LogArguments::format(message.format, args, message.args.size(), &text);
+        formatLine(&message, &text.front(), &line);
+        if (output != 0) {
+          const TCHAR endLine[] = { 13, 10 };
+          output->write(line.getString(), line.getSize() - sizeof(TCHAR));
+          output->write(endLine, sizeof(endLine));
+        } else {
+          _tprintf(_T("%s\n"), line.getString());
+        }
+        messageCount++;
+      }
+    } catch (EOFException &) {
+      // The end of the log, the last record can be incomplete if the log
+      // is still being written.
+    } catch (...) {
+      if (output != 0) {
+        delete output;
+      }
+      throw;
+    }
+    if (output != 0) {
+      delete output;
+    }
+  } catch (Exception &e) {
+    _ftprintf(stderr, _T("Error after %u messages: %s\n"), messageCount,
+              e.getMessage());
+    return 1;
+  }
+  return 0;
+}
@@ -26,6 +26,8 @@
 #include "win-system/PipeClient.h"
 #include "SecurityPipeClient.h"
 #include "util/DateTime.h"
+#include "log-writer/LogArguments.h"
+#include "log-writer/LogRecordDefs.h"
 
 ClientLogger::ClientLogger(const TCHAR *publicPipeName, const TCHAR *logFileName)
 : LogDump(false, true),
@@ -73,6 +75,8 @@ void ClientLogger::connect()
     m_levListenChan = secLevelPipeClient.getChannel();
 
     m_logOutput->writeUTF8(m_logFileName.getString());
+    m_logOutput->writeFully(LogRecordDefs::SIGNATURE,
+                            LogRecordDefs::SIGNATURE_SIZE);
 
     // Get log level by the m_levListenChan channel.
     DataInputStream m_levInput(m_levListenChan);
@@ -107,13 +111,37 @@ void ClientLogger::connect()
 }
 
 void ClientLogger::print(int logLevel, const TCHAR *line)
+{
+  DateTime currTime = DateTime::now();
+  print(GetCurrentThreadId(), &currTime, logLevel, line);
+}
+
+void ClientLogger::print(unsigned int threadId, const DateTime *dt,
+                         int logLevel, const TCHAR *line)
 {
   UINT32 processId = GetCurrentProcessId();
-  UINT32 threadId = GetCurrentThreadId();
 
   AutoLock al(&m_logWritingMut);
-  updateLogDumpLines(processId, threadId, &DateTime::now(), logLevel, line);
-  flush(processId, threadId, &DateTime::now(), logLevel, line);
+  updateLogDumpLines(processId, threadId, dt, logLevel, line);
+  flush(processId, threadId, dt, logLevel, line);
+}
+
+void ClientLogger::printRecord(unsigned int threadId, const DateTime *dt,
+                               int logLevel, const TCHAR *format,
+                               const char *args, size_t argsSize)
+{
+  UINT32 processId = GetCurrentProcessId();
+
+  AutoLock al(&m_logWritingMut);
+  if (logDumpEnabled()) {
+    LogArguments::format(format, args, argsSize, &m_line);
+    updateLogDumpLines(processId, threadId, dt, logLevel, &m_line.front());
+  }
+  if (logLevel <= getLogBarrier() && m_logOutput != 0) {
+    m_encoder.encode(processId, threadId, dt, logLevel & 0xf, format,
+                     args, argsSize, &m_records);
+    sendRecords();
+  }
 }
 
 bool ClientLogger::acceptsLevel(int logLevel)
@@ -131,18 +159,22 @@ void ClientLogger::flush(unsigned int processId,
 
   if (level <= getLogBarrier()) {
     if (m_logOutput != 0) {
-      try {
-        m_logOutput->writeUInt32(processId);
-        m_logOutput->writeUInt32(threadId);
-        m_logOutput->writeUInt64(dt->getTime());
-        m_logOutput->writeUInt8(level & 0xf);
-        m_logOutput->writeUTF8(message);
-      } catch (...) {
-      }
+      m_encoder.encodeLine(processId, threadId, dt, level & 0xf, message,
+                           &m_records);
+      sendRecords();
     }
   }
 }
 
+void ClientLogger::sendRecords()
+{
+  try {
+    m_logOutput->writeFully(&m_records.front(), m_records.size());
+  } catch (...) {
+  }
+  m_records.clear();
+}
+
 int ClientLogger::getLogBarrier()
 {
   AutoLock al(&m_logBarMut);
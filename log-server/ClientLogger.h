@@ -33,6 +33,9 @@
 #include "log-writer/Logger.h"
 #include "thread/AutoLock.h"
 #include "log-writer/LogDump.h"
+#include "log-writer/BinaryLogEncoder.h"
+
+#include <vector>
 
 class ClientLogger : public Logger, private Thread, public LogDump
 {
@@ -52,6 +55,17 @@ public:
   // Sends log line to the log server.
   virtual void print(int logLevel, const TCHAR *line);
 
+  // Sends log line that has been logged earlier by the threadId thread at
+  // the dt time to the log server.
+  virtual void print(unsigned int threadId, const DateTime *dt,
+                     int logLevel, const TCHAR *line);
+
+  // Sends log message given as a format string and its arguments to the
+  // log server without formatting.
+  virtual void printRecord(unsigned int threadId, const DateTime *dt,
+                           int logLevel, const TCHAR *format,
+                           const char *args, size_t argsSize);
+
   virtual bool acceptsLevel(int logLevel);
 
 private:
@@ -62,6 +76,9 @@ private:
                      int level,
                      const TCHAR *message);
 
+  // Sends the encoded log records to the log server.
+  void sendRecords();
+
   void freeResources();
 
   virtual void execute();
@@ -74,6 +91,11 @@ private:
   DataOutputStream *m_logOutput;
   LocalMutex m_logWritingMut;
 
+  // The log messages are sent as binary log records (see LogRecordDefs.h).
+  BinaryLogEncoder m_encoder;
+  std::vector<char> m_records;
+  std::vector<TCHAR> m_line;
+
   Channel *m_levListenChan;
 
   int m_logBarrier;
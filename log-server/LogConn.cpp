@@ -29,6 +29,7 @@
 #include "io-lib/DataInputStream.h"
 #include "io-lib/DataOutputStream.h"
 #include "util/DateTime.h"
+#include "log-writer/BinaryLogDecoder.h"
 
 LogConn::LogConn(Channel *channel, LogConnAuthListener *extAuthListener,
                  LogListener *extLogListener, unsigned char logLevel)
@@ -108,20 +109,17 @@ void LogConn::assignConnection()
 
 void LogConn::dispatch()
 {
-  DataInputStream input(m_logListenChannel);
-  DataOutputStream output(m_logListenChannel);
   // Simple dispatcher (normal phase)
-  StringStorage logMess;
+  BinaryLogDecoder decoder(m_logListenChannel);
+  decoder.readSignature();
+  BinaryLogDecoder::Message message;
   while (!isTerminating()) {
-    UINT32 processId = input.readUInt32();
-    UINT32 threadId = input.readUInt32();
-    DateTime dt(input.readUInt64());
-    UINT8 level = input.readUInt8();
-    // Receive log message
-    input.readUTF8(&logMess);
-
-    m_extLogListener->onLog(m_handle, processId, threadId, &dt,
-                            level, logMess.getString());
+    decoder.readMessage(&message);
+
+    const char *args = message.args.empty() ? 0 : &message.args.front();
+    m_extLogListener->onLog(m_handle, message.processId, message.threadId,
+                            &message.dt, message.level, message.format,
+                            args, message.args.size());
   }
 }
 
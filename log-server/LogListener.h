@@ -31,12 +31,16 @@
 class LogListener
 {
 public:
+  // The message is given as a format string and its arguments stored by
+  // LogArguments.
   virtual void onLog(FileAccountHandle handle,
                      unsigned int processId,
                      unsigned int threadId,
                      const DateTime *dt,
                      int level,
-                     const TCHAR *message) = 0;
+                     const TCHAR *format,
+                     const char *args,
+                     size_t argsSize) = 0;
   virtual void onAnErrorFromLogConn(const TCHAR *message) = 0;
 };
 
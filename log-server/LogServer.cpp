@@ -29,6 +29,7 @@ LogServer::LogServer(const TCHAR *publicPipeName)
 : m_listenLogServer(0),
   m_publicPipeName(publicPipeName),
   m_logLevel(0),
+  m_binaryFormat(false),
   m_headerLineCount(0),
   m_totalLogLines(0)
 {
@@ -91,6 +92,17 @@ void LogServer::changeLogProps(const TCHAR *newLogDir, unsigned char newLevel)
   }
 }
 
+void LogServer::setBinaryFormat(bool enabled)
+{
+  AutoLock al(&m_logPropsMutex);
+  m_binaryFormat = enabled;
+
+  for (FAccountListIter iter = m_fileAccountList.begin();
+       iter != m_fileAccountList.end(); iter++) {
+    (*iter).second->setBinaryFormat(enabled);
+  }
+}
+
 void LogServer::storeHeader()
 {
   AutoLock al(&m_logPropsMutex);
@@ -159,14 +171,17 @@ void LogServer::onLog(FileAccountHandle handle,
                       unsigned int threadId,
                       const DateTime *dt,
                       int level,
-                      const TCHAR *message)
+                      const TCHAR *format,
+                      const char *args,
+                      size_t argsSize)
 {
   AutoLock al(&m_logPropsMutex);
   FAccountListIter iter = m_fileAccountList.find(handle);
   if (iter == m_fileAccountList.end()) {
     throw Exception(_T("Unhandled log message"));
   }
-  (*iter).second->print(processId, threadId, dt, level, message);
+  (*iter).second->printRecord(processId, threadId, dt, level,
+                              format, args, argsSize);
 
   m_totalLogLines++;
   if (m_totalLogLines == m_headerLineCount) {
@@ -191,6 +206,6 @@ FileAccountHandle LogServer::addConnection(const TCHAR *fileName)
   bool logHeadEnabled = count == 0;
   m_fileAccountList[count] = new FileAccount(m_logDir.getString(),
                                              fileName, m_logLevel,
-                                             logHeadEnabled);
+                                             logHeadEnabled, m_binaryFormat);
   return count;
 }
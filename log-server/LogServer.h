@@ -56,6 +56,10 @@ public:
 
   void changeLogProps(const TCHAR *newLogDir, unsigned char newLevel);
 
+  // Switches the log files between the text and binary formats (see
+  // FileAccount::setBinaryFormat()).
+  void setBinaryFormat(bool enabled);
+
 private:
   virtual void onNewConnection(Channel *channel);
   virtual FileAccountHandle  onLogConnAuth(LogConn *logConn, bool success,
@@ -66,7 +70,9 @@ private:
                      unsigned int threadId,
                      const DateTime *dt,
                      int level,
-                     const TCHAR *message);
+                     const TCHAR *format,
+                     const char *args,
+                     size_t argsSize);
   virtual void onAnErrorFromLogConn(const TCHAR *message);
 
   FileAccountHandle addConnection(const TCHAR *fileName);
@@ -78,6 +84,7 @@ private:
 
   StringStorage m_logDir;
   unsigned char m_logLevel;
+  bool m_binaryFormat;
   ConnList m_notAuthConnList;
   ConnList m_connList;
   FileAccountList m_fileAccountList;
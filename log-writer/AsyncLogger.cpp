@@ -0,0 +1,255 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "AsyncLogger.h"
+#include "LogArguments.h"
+
+#include <new>
+
+AsyncLogger::AsyncLogger(Logger *logger,
+                         size_t capacity,
+                         OverflowPolicy overflowPolicy)
+: m_logger(logger),
+  m_ring(capacity),
+  m_overflowPolicy(overflowPolicy),
+  m_isReaderSleeping(0),
+  m_blockedWriterCount(0),
+  m_storedCount(0),
+  m_writtenCount(0),
+  m_droppedCount(0),
+  m_reportedDroppedCount(0)
+{
+  findConstantSections();
+  resume();
+}
+
+AsyncLogger::~AsyncLogger()
+{
+  terminate();
+  wait();
+  writeRecords();
+}
+
+void AsyncLogger::flush()
+{
+  LONG storedCount = m_storedCount;
+  while (m_writtenCount - storedCount < 0 && isActive()) {
+    m_recordEvent.notify();
+    Thread::sleep(RECHECK_INTERVAL);
+  }
+}
+
+unsigned int AsyncLogger::getDroppedCount() const
+{
+  return (unsigned int)m_droppedCount;
+}
+
+void AsyncLogger::print(int logLevel, const TCHAR *line)
+{
+  storeLine(logLevel, _T("%s"), line);
+}
+
+#pragma warning(push)
+#pragma warning(disable:4996)
+
+void AsyncLogger::vprint(int logLevel, const TCHAR *format, va_list args)
+{
+  if (isConstant(format)) {
+    store(logLevel, format, args);
+    return;
+  }
+
+  // The format string can be changed or freed before the background thread
+  // formats the message, so it is formatted now.
+  int count = _vsctprintf(format, args);
+  std::vector<TCHAR> formattedString(count + 1);
+  _vstprintf(&formattedString.front(), format, args);
+
+  storeLine(logLevel, _T("%s"), &formattedString.front());
+}
+
+#pragma warning(pop)
+
+bool AsyncLogger::acceptsLevel(int logLevel)
+{
+  return m_logger->acceptsLevel(logLevel);
+}
+
+void AsyncLogger::storeLine(int logLevel, const TCHAR *format, ...)
+{
+  va_list vl;
+  va_start(vl, format);
+  store(logLevel, format, vl);
+  va_end(vl);
+}
+
+void AsyncLogger::store(int logLevel, const TCHAR *format, va_list args)
+{
+  LogRing::Record *record = reserve();
+  if (record == 0) {
+    return;
+  }
+
+  record->level = logLevel;
+  record->threadId = GetCurrentThreadId();
+  GetSystemTimeAsFileTime(&record->time);
+  record->format = format;
+  record->heapArgs = 0;
+  record->argsSize = LogArguments::store(format, args,
+                                         record->args, sizeof(record->args));
+  if (record->argsSize > sizeof(record->args)) {
+    record->heapArgs = new(std::nothrow) char[record->argsSize];
+    if (record->heapArgs != 0) {
+      LogArguments::store(format, args, record->heapArgs, record->argsSize);
+    } else {
+      record->format = _T("The log message is too long");
+      record->argsSize = 0;
+    }
+  }
+
+  m_ring.endWrite(record);
+  InterlockedIncrement(&m_storedCount);
+
+  if (m_isReaderSleeping != 0 &&
+      InterlockedExchange(&m_isReaderSleeping, 0) != 0) {
+    m_recordEvent.notify();
+  }
+}
+
+LogRing::Record *AsyncLogger::reserve()
+{
+  LogRing::Record *record;
+  while ((record = m_ring.beginWrite()) == 0) {
+    // The background thread can log only through the logger, but it must
+    // not wait for itself anyway.
+    if (m_overflowPolicy == DROP_WHEN_FULL ||
+        GetCurrentThreadId() == getThreadId() || !isActive()) {
+      InterlockedIncrement(&m_droppedCount);
+      return 0;
+    }
+    InterlockedIncrement(&m_blockedWriterCount);
+    m_spaceEvent.waitForEvent(RECHECK_INTERVAL);
+    InterlockedDecrement(&m_blockedWriterCount);
+  }
+  return record;
+}
+
+void AsyncLogger::execute()
+{
+  while (!isTerminating()) {
+    if (writeRecords()) {
+      continue;
+    }
+    InterlockedExchange(&m_isReaderSleeping, 1);
+    // A record can be written before the flag is set.
+    if (!writeRecords() && !isTerminating()) {
+      m_recordEvent.waitForEvent();
+    }
+    InterlockedExchange(&m_isReaderSleeping, 0);
+  }
+}
+
+void AsyncLogger::onTerminate()
+{
+  m_recordEvent.notify();
+}
+
+bool AsyncLogger::writeRecords()
+{
+  bool hasRecords = false;
+  LogRing::Record *record;
+  while ((record = m_ring.beginRead()) != 0) {
+    hasRecords = true;
+
+    FILETIME localTime;
+    FileTimeToLocalFileTime(&record->time, &localTime);
+    DateTime dt(localTime);
+
+    try {
+      m_logger->printRecord(record->threadId, &dt, record->level,
+                            record->format, record->getArgs(),
+                            record->argsSize);
+    } catch (...) {
+    }
+
+    m_ring.endRead(record);
+    if (m_blockedWriterCount != 0) {
+      m_spaceEvent.notify();
+    }
+    InterlockedIncrement(&m_writtenCount);
+  }
+
+  writeDroppedCount();
+  return hasRecords;
+}
+
+void AsyncLogger::writeDroppedCount()
+{
+  LONG droppedCount = m_droppedCount;
+  if (droppedCount == m_reportedDroppedCount) {
+    return;
+  }
+  StringStorage message;
+  message.format(_T("%d log messages have been dropped because the log")
+                 _T(" buffer was full"),
+                 (int)(droppedCount - m_reportedDroppedCount));
+  m_reportedDroppedCount = droppedCount;
+  try {
+    m_logger->print(DROPPED_COUNT_LEVEL, message.getString());
+  } catch (...) {
+  }
+}
+
+bool AsyncLogger::isConstant(const TCHAR *string) const
+{
+  const char *address = (const char *)string;
+  for (size_t i = 0; i < m_constantSections.size(); i++) {
+    if (address >= m_constantSections[i].begin &&
+        address < m_constantSections[i].end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AsyncLogger::findConstantSections()
+{
+  const char *base = (const char *)GetModuleHandle(0);
+  if (base == 0) {
+    return;
+  }
+  const IMAGE_DOS_HEADER *dosHeader = (const IMAGE_DOS_HEADER *)base;
+  const IMAGE_NT_HEADERS *ntHeaders =
+    (const IMAGE_NT_HEADERS *)(base + dosHeader->e_lfanew);
+  const IMAGE_SECTION_HEADER *section = IMAGE_FIRST_SECTION(ntHeaders);
+
+  for (WORD i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++) {
+    if ((section[i].Characteristics & IMAGE_SCN_MEM_WRITE) == 0) {
+      Section constantSection;
+      constantSection.begin = base + section[i].VirtualAddress;
+      constantSection.end = constantSection.begin + section[i].Misc.VirtualSize;
+      m_constantSections.push_back(constantSection);
+    }
+  }
+}
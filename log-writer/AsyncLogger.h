@@ -0,0 +1,138 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __ASYNCLOGGER_H__
+#define __ASYNCLOGGER_H__
+
+#include "Logger.h"
+#include "LogRing.h"
+#include "thread/Thread.h"
+#include "win-system/WindowsEvent.h"
+
+#include <vector>
+
+// This class is an implementation of the Logger class that passes log
+// messages to other logger on a background thread. The calling thread
+// only stores the format string and raw arguments of a message to a ring
+// buffer, so logging at a high verbosity level does not slow it down.
+// The background thread passes the messages to the other logger with the
+// thread identifiers and times of the calls (see Logger::printRecord()),
+// so the messages are formatted there only if the logger needs text.
+class AsyncLogger : public Logger, private Thread
+{
+public:
+  // Behavior when the ring buffer is full.
+  enum OverflowPolicy
+  {
+    // The message is dropped, the count of dropped messages is written
+    // to the log later.
+    DROP_WHEN_FULL,
+    // The calling thread waits until the background thread frees a place.
+    BLOCK_WHEN_FULL
+  };
+
+  // @param logger - is a logger that writes the messages. It must not be
+  // destroyed before this object.
+  // @param capacity - is a count of messages the ring buffer holds.
+  // @param overflowPolicy - is a behavior when the ring buffer is full.
+  AsyncLogger(Logger *logger,
+              size_t capacity = DEFAULT_CAPACITY,
+              OverflowPolicy overflowPolicy = DROP_WHEN_FULL);
+
+  // Writes the rest of messages and stops the background thread.
+  virtual ~AsyncLogger();
+
+  // Blocks until all messages that have been stored before the call are
+  // passed to the logger.
+  void flush();
+
+  // Returns the count of messages dropped because the ring buffer was full.
+  unsigned int getDroppedCount() const;
+
+  // Stores a log line to the ring buffer.
+  virtual void print(int logLevel, const TCHAR *line);
+
+  // Stores the format string and its arguments to the ring buffer.
+  virtual void vprint(int logLevel, const TCHAR *format, va_list args);
+
+  virtual bool acceptsLevel(int logLevel);
+
+private:
+  // A read-only section of the executable module.
+  struct Section
+  {
+    const char *begin;
+    const char *end;
+  };
+
+  virtual void execute();
+  virtual void onTerminate();
+
+  // Stores a message with a format string that lives until the process
+  // exits.
+  void store(int logLevel, const TCHAR *format, va_list args);
+  void storeLine(int logLevel, const TCHAR *format, ...);
+
+  // Reserves a record in the ring buffer according to the overflow policy.
+  // Returns 0 if the message must be dropped.
+  LogRing::Record *reserve();
+
+  // Passes all written records to the logger. Returns false if the ring
+  // buffer was empty.
+  bool writeRecords();
+
+  // Writes the count of messages dropped since the last call.
+  void writeDroppedCount();
+
+  // Returns true if the string is located in a read-only section of the
+  // executable module, that is it is a string literal.
+  bool isConstant(const TCHAR *string) const;
+  void findConstantSections();
+
+  Logger *m_logger;
+  LogRing m_ring;
+  OverflowPolicy m_overflowPolicy;
+  std::vector<Section> m_constantSections;
+
+  // Notified when a record is written while the background thread sleeps.
+  WindowsEvent m_recordEvent;
+  volatile LONG m_isReaderSleeping;
+  // Notified when records are read while writers are blocked.
+  WindowsEvent m_spaceEvent;
+  volatile LONG m_blockedWriterCount;
+
+  volatile LONG m_storedCount;
+  volatile LONG m_writtenCount;
+  volatile LONG m_droppedCount;
+  LONG m_reportedDroppedCount;
+
+  static const size_t DEFAULT_CAPACITY = 4096;
+  // Interval of rechecking the ring buffer by a blocked writer and by
+  // flush() (in milliseconds).
+  static const DWORD RECHECK_INTERVAL = 10;
+  // Log level of the dropped messages count.
+  static const int DROPPED_COUNT_LEVEL = 2;
+};
+
+#endif // __ASYNCLOGGER_H__
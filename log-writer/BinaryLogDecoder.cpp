@@ -0,0 +1,134 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "BinaryLogDecoder.h"
+#include "util/Exception.h"
+#include "util/Utf8StringStorage.h"
+
+BinaryLogDecoder::BinaryLogDecoder(InputStream *input)
+: m_input(input),
+  m_time(0)
+{
+}
+
+BinaryLogDecoder::~BinaryLogDecoder()
+{
+}
+
+void BinaryLogDecoder::readSignature()
+{
+  if (m_input.readUInt8() != (UINT8)LogRecordDefs::SIGNATURE[0]) {
+    throw Exception(_T("The stream is not a binary log"));
+  }
+  readSignatureTail();
+}
+
+void BinaryLogDecoder::readMessage(Message *message)
+{
+  while (true) {
+    UINT8 type = m_input.readUInt8();
+    switch (type) {
+    case LogRecordDefs::REC_FORMAT:
+      readFormat();
+      break;
+    case LogRecordDefs::REC_TIME:
+      m_time = readVarint();
+      break;
+    case LogRecordDefs::REC_MESSAGE:
+      {
+        m_time += readVarint();
+        message->dt = DateTime(m_time);
+        message->processId = (unsigned int)readVarint();
+        message->threadId = (unsigned int)readVarint();
+        message->level = m_input.readUInt8();
+
+        UINT32 formatId = (UINT32)readVarint();
+        std::map<UINT32, StringStorage>::iterator iter = m_formats.find(formatId);
+        if (iter == m_formats.end()) {
+          throw Exception(_T("A log message refers to an unknown format"));
+        }
+        message->format = iter->second.getString();
+
+        UINT64 argsSize = readVarint();
+        if (argsSize > MAX_ARGUMENTS_SIZE) {
+          throw Exception(_T("The log message arguments are too long"));
+        }
+        message->args.resize((size_t)argsSize);
+        if (argsSize != 0) {
+          m_input.readFully(&message->args.front(), (size_t)argsSize);
+        }
+        return;
+      }
+    default:
+      if (type != (UINT8)LogRecordDefs::SIGNATURE[0]) {
+        throw Exception(_T("Unknown log record type"));
+      }
+      // The writer has reopened the file.
+      readSignatureTail();
+      m_formats.clear();
+      m_time = 0;
+    }
+  }
+}
+
+void BinaryLogDecoder::readSignatureTail()
+{
+  char signature[LogRecordDefs::SIGNATURE_SIZE - 1];
+  m_input.readFully(signature, sizeof(signature));
+  if (memcmp(signature, LogRecordDefs::SIGNATURE + 1, sizeof(signature)) != 0) {
+    throw Exception(_T("The stream is not a binary log"));
+  }
+}
+
+void BinaryLogDecoder::readFormat()
+{
+  UINT32 formatId = (UINT32)readVarint();
+  UINT64 size = readVarint();
+  if (size > MAX_FORMAT_SIZE) {
+    throw Exception(_T("The log format string is too long"));
+  }
+
+  StringStorage *format = &m_formats[formatId];
+  if (size == 0) {
+    format->setString(_T(""));
+    return;
+  }
+  m_buffer.resize((size_t)size);
+  m_input.readFully(&m_buffer.front(), m_buffer.size());
+  Utf8StringStorage utf8Format(&m_buffer);
+  utf8Format.toStringStorage(format);
+}
+
+UINT64 BinaryLogDecoder::readVarint()
+{
+  UINT64 value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    UINT8 b = m_input.readUInt8();
+    value |= (UINT64)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw Exception(_T("A number in the log record is too long"));
+}
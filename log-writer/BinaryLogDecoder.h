@@ -0,0 +1,89 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __BINARYLOGDECODER_H__
+#define __BINARYLOGDECODER_H__
+
+#include "util/CommonHeader.h"
+#include "util/DateTime.h"
+#include "io-lib/DataInputStream.h"
+#include "LogRecordDefs.h"
+
+#include <map>
+#include <vector>
+
+// This class reads log messages from the binary log records (see
+// LogRecordDefs.h).
+class BinaryLogDecoder
+{
+public:
+  // A decoded log message.
+  struct Message
+  {
+    unsigned int processId;
+    unsigned int threadId;
+    DateTime dt;
+    int level;
+    // The format string is owned by the decoder, it is valid until the
+    // next readMessage() call.
+    const TCHAR *format;
+    // The arguments of the format string stored by LogArguments.
+    std::vector<char> args;
+  };
+
+  // @param input - is a stream of the records. It must not be destroyed
+  // before this object.
+  BinaryLogDecoder(InputStream *input);
+  virtual ~BinaryLogDecoder();
+
+  // Reads and checks the signature at the beginning of the stream.
+  // @throw Exception if the stream is not a binary log.
+  void readSignature();
+
+  // Reads the records up to the next message.
+  // @throw EOFException at the end of the stream, Exception if the records
+  // are corrupted.
+  void readMessage(Message *message);
+
+private:
+  // Reads the rest of the signature after its first byte.
+  void readSignatureTail();
+
+  void readFormat();
+
+  UINT64 readVarint();
+
+  DataInputStream m_input;
+
+  std::map<UINT32, StringStorage> m_formats;
+  UINT64 m_time;
+
+  std::vector<char> m_buffer;
+
+  // Limits for corrupted records.
+  static const size_t MAX_FORMAT_SIZE = 64 * 1024;
+  static const size_t MAX_ARGUMENTS_SIZE = 16 * 1024 * 1024;
+};
+
+#endif // __BINARYLOGDECODER_H__
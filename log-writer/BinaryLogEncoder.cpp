@@ -0,0 +1,146 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "BinaryLogEncoder.h"
+#include "LogArguments.h"
+#include "util/Utf8StringStorage.h"
+
+#include <stdarg.h>
+
+BinaryLogEncoder::BinaryLogEncoder()
+: m_nextFormatId(0),
+  m_lastTime(0),
+  m_hasTime(false)
+{
+}
+
+BinaryLogEncoder::~BinaryLogEncoder()
+{
+}
+
+void BinaryLogEncoder::encode(unsigned int processId,
+                              unsigned int threadId,
+                              const DateTime *dt,
+                              int level,
+                              const TCHAR *format,
+                              const char *args,
+                              size_t argsSize,
+                              std::vector<char> *output)
+{
+  UINT32 formatId = getFormatId(format, output);
+
+  UINT64 time = dt->getTime();
+  if (!m_hasTime || time < m_lastTime) {
+    output->push_back((char)LogRecordDefs::REC_TIME);
+    appendVarint(time, output);
+    m_lastTime = time;
+    m_hasTime = true;
+  }
+
+  output->push_back((char)LogRecordDefs::REC_MESSAGE);
+  appendVarint(time - m_lastTime, output);
+  appendVarint(processId, output);
+  appendVarint(threadId, output);
+  output->push_back((char)(level & 0xff));
+  appendVarint(formatId, output);
+  appendVarint(argsSize, output);
+  if (argsSize != 0) {
+    output->insert(output->end(), args, args + argsSize);
+  }
+  m_lastTime = time;
+}
+
+void BinaryLogEncoder::encodeLine(unsigned int processId,
+                                  unsigned int threadId,
+                                  const DateTime *dt,
+                                  int level,
+                                  const TCHAR *line,
+                                  std::vector<char> *output)
+{
+  const TCHAR *format = _T("%s");
+  storeArguments(&m_lineArgs, format, line);
+  encode(processId, threadId, dt, level, format,
+         &m_lineArgs.front(), m_lineArgs.size(), output);
+}
+
+void BinaryLogEncoder::reset()
+{
+  m_formats.clear();
+  m_nextFormatId = 0;
+  m_hasTime = false;
+}
+
+UINT32 BinaryLogEncoder::getFormatId(const TCHAR *format,
+                                     std::vector<char> *output)
+{
+  std::map<const TCHAR *, FormatEntry>::iterator iter = m_formats.find(format);
+  if (iter != m_formats.end() && iter->second.format.isEqualTo(format)) {
+    return iter->second.id;
+  }
+
+  if (iter == m_formats.end() && m_formats.size() >= MAX_FORMAT_COUNT) {
+    m_formats.clear();
+  }
+  FormatEntry *entry = &m_formats[format];
+  entry->id = m_nextFormatId++;
+  entry->format.setString(format);
+
+  StringStorage formatString(format);
+  Utf8StringStorage utf8Format(&formatString);
+  // Without the terminating null character.
+  size_t size = utf8Format.getSize() - 1;
+
+  output->push_back((char)LogRecordDefs::REC_FORMAT);
+  appendVarint(entry->id, output);
+  appendVarint(size, output);
+  output->insert(output->end(), utf8Format.getString(),
+                 utf8Format.getString() + size);
+  return entry->id;
+}
+
+void BinaryLogEncoder::storeArguments(std::vector<char> *args,
+                                      const TCHAR *format, ...)
+{
+  args->resize(max(args->size(), (size_t)1));
+  va_list vl;
+  va_start(vl, format);
+  size_t size = LogArguments::store(format, vl, &args->front(), args->size());
+  va_end(vl);
+  if (size > args->size()) {
+    args->resize(size);
+    va_start(vl, format);
+    LogArguments::store(format, vl, &args->front(), args->size());
+    va_end(vl);
+  }
+  args->resize(size);
+}
+
+void BinaryLogEncoder::appendVarint(UINT64 value, std::vector<char> *output)
+{
+  while (value >= 0x80) {
+    output->push_back((char)((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back((char)value);
+}
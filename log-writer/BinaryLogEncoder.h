@@ -0,0 +1,101 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __BINARYLOGENCODER_H__
+#define __BINARYLOGENCODER_H__
+
+#include "util/CommonHeader.h"
+#include "util/DateTime.h"
+#include "LogRecordDefs.h"
+
+#include <map>
+#include <vector>
+
+// This class encodes log messages to the binary log records (see
+// LogRecordDefs.h). A format string is written once, then messages refer
+// to it by id, and the message time is written as a delta. So the records
+// must be written to one stream in the order of encoding.
+// This class is not thread safe.
+class BinaryLogEncoder
+{
+public:
+  BinaryLogEncoder();
+  virtual ~BinaryLogEncoder();
+
+  // Appends the records of the message to the output buffer.
+  // @param format - is a format string of the message.
+  // @param args - are the arguments of the format string stored by
+  // LogArguments.
+  void encode(unsigned int processId,
+              unsigned int threadId,
+              const DateTime *dt,
+              int level,
+              const TCHAR *format,
+              const char *args,
+              size_t argsSize,
+              std::vector<char> *output);
+
+  // Appends the records of a formatted message to the output buffer.
+  void encodeLine(unsigned int processId,
+                  unsigned int threadId,
+                  const DateTime *dt,
+                  int level,
+                  const TCHAR *line,
+                  std::vector<char> *output);
+
+  // Forgets the written formats and time, so the following records can be
+  // decoded without the previous ones (e.g. at the beginning of a file).
+  void reset();
+
+private:
+  struct FormatEntry
+  {
+    UINT32 id;
+    StringStorage format;
+  };
+
+  // Returns the id of the format and appends its definition to the output
+  // buffer if it has not been written yet.
+  UINT32 getFormatId(const TCHAR *format, std::vector<char> *output);
+
+  void storeArguments(std::vector<char> *args, const TCHAR *format, ...);
+
+  static void appendVarint(UINT64 value, std::vector<char> *output);
+
+  // The formats by their addresses. The content is compared as well because
+  // an address can be reused for another string.
+  std::map<const TCHAR *, FormatEntry> m_formats;
+  UINT32 m_nextFormatId;
+
+  UINT64 m_lastTime;
+  bool m_hasTime;
+
+  std::vector<char> m_lineArgs;
+
+  // The formats are forgotten and written again with new ids when there are
+  // more of them, so the map does not grow with addresses of freed strings.
+  static const size_t MAX_FORMAT_COUNT = 4096;
+};
+
+#endif // __BINARYLOGENCODER_H__
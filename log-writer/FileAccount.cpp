@@ -27,16 +27,19 @@
 #include "file-lib/File.h"
 #include "thread/AutoLock.h"
 #include "file-lib/EOFException.h"
+#include "LogArguments.h"
 
 FileAccount::FileAccount(const TCHAR *logDir,
                          const TCHAR *fileName,
                          unsigned char logLevel,
-                         bool logHeadEnabled)
+                         bool logHeadEnabled,
+                         bool binaryFormat)
 : LogDump(logHeadEnabled, false),
   m_fileName(fileName),
   m_level(0), // Real initialization must be in the setNewFile() function
   m_asFirstOpen(true),
-  m_file(0)
+  m_file(0),
+  m_binaryFormat(binaryFormat)
 {
   setNewFile(logLevel, logDir);
 }
@@ -45,7 +48,8 @@ FileAccount::FileAccount(bool logHeadEnabled)
 : LogDump(logHeadEnabled, true), // This constructor enables writing the log to the dump.
   m_level(0), // Real initialization must be in the setNewFile() function
   m_asFirstOpen(true),
-  m_file(0)
+  m_file(0),
+  m_binaryFormat(false)
 {
 }
 
@@ -83,6 +87,23 @@ bool FileAccount::isTheOurFileName(const TCHAR *fileName)
   return m_fileName.isEqualTo(fileName);
 }
 
+void FileAccount::setBinaryFormat(bool enabled)
+{
+  AutoLock al(&m_logMut);
+  if (enabled == m_binaryFormat) {
+    return;
+  }
+  m_binaryFormat = enabled;
+  if (m_file != 0) {
+    m_asFirstOpen = true;
+    try {
+      openFile();
+    } catch (...) {
+      closeFile();
+    }
+  }
+}
+
 void FileAccount::print(unsigned int processId,
                         unsigned int threadId,
                         const DateTime *dt,
@@ -96,6 +117,34 @@ void FileAccount::print(unsigned int processId,
   flush(processId, threadId, dt, level, message);
 }
 
+void FileAccount::printRecord(unsigned int processId,
+                              unsigned int threadId,
+                              const DateTime *dt,
+                              int level,
+                              const TCHAR *messageFormat,
+                              const char *args,
+                              size_t argsSize)
+{
+  AutoLock al(&m_logMut);
+
+  bool printsRecord = m_binaryFormat && printsLine(level);
+  bool printsText = !m_binaryFormat && printsLine(level);
+  if (logHeadEnabled() || logDumpEnabled() || printsText) {
+    LogArguments::format(messageFormat, args, argsSize, &m_line);
+    const TCHAR *message = &m_line.front();
+    updateLogHeaderLines(processId, threadId, dt, level, message);
+    updateLogDumpLines(processId, threadId, dt, level, message);
+    if (printsText) {
+      format(processId, threadId, dt, level, message);
+    }
+  }
+  if (printsRecord) {
+    m_encoder.encode(processId, threadId, dt, level, messageFormat,
+                     args, argsSize, &m_records);
+    writeRecords();
+  }
+}
+
 bool FileAccount::acceptsLevel(int logLevel)
 {
   return logDumpEnabled() || logHeadEnabled() || printsLine(logLevel);
@@ -115,7 +164,13 @@ void FileAccount::flush(unsigned int processId,
   AutoLock al(&m_logMut);
 
   if (printsLine(level)) {
-    format(processId, threadId, dt, level, message);
+    if (m_binaryFormat) {
+      m_encoder.encodeLine(processId, threadId, dt, level, message,
+                           &m_records);
+      writeRecords();
+    } else {
+      format(processId, threadId, dt, level, message);
+    }
   }
 }
 
@@ -235,8 +290,8 @@ void FileAccount::openFile()
   closeFile();
 
   StringStorage fileName;
-  fileName.format(_T("%s\\%s.log"), m_logDir.getString(),
-                  m_fileName.getString());
+  fileName.format(_T("%s\\%s.%s"), m_logDir.getString(),
+                  m_fileName.getString(), getFileExtension());
   bool shareToRead = true;
   bool asFirstOpen = m_asFirstOpen;
   if (asFirstOpen) {
@@ -252,9 +307,24 @@ void FileAccount::openFile()
                          shareToRead);
   }
 
-  if (Unicode::isEnabled() && asFirstOpen) {
+  if (m_binaryFormat) {
+    // Each opening starts the records from scratch, so the signature
+    // separates them from the records that the file already contains.
+    m_encoder.reset();
+    m_records.clear();
     try {
-      addUnicodeSignature();
+      m_file->write(LogRecordDefs::SIGNATURE, LogRecordDefs::SIGNATURE_SIZE);
+    } catch (...) {
+      closeFile();
+      return;
+    }
+  }
+
+  if ((Unicode::isEnabled() || m_binaryFormat) && asFirstOpen) {
+    try {
+      if (!m_binaryFormat) {
+        addUnicodeSignature();
+      }
       AutoLock al(&m_logMut);
       if (getLogDumpSize() != 0) {
         // The log dump already contains the header and then is not needed to call
@@ -290,23 +360,46 @@ void FileAccount::addUnicodeSignature()
   }
 }
 
+const TCHAR *FileAccount::getFileExtension()
+{
+  return m_binaryFormat ? _T("blog") : _T("log");
+}
+
 void FileAccount::createBackup(unsigned int backupLimit)
 {
   StringStorage oldName, newName;
-  TCHAR fmt[] = _T("%s\\%s.%d.log");
+  TCHAR fmt[] = _T("%s\\%s.%d.%s");
+  const TCHAR *extension = getFileExtension();
   // Shift backup files
   for (int i = backupLimit - 1; i > 0; i--) {
     // Generate valid backup names
-    oldName.format(fmt, m_logDir.getString(), m_fileName.getString(), i);
-    newName.format(fmt, m_logDir.getString(), m_fileName.getString(), i + 1);
+    oldName.format(fmt, m_logDir.getString(), m_fileName.getString(), i,
+                   extension);
+    newName.format(fmt, m_logDir.getString(), m_fileName.getString(), i + 1,
+                   extension);
     File::renameTo(newName.getString(), oldName.getString());
   }
   // Copy log file to backup
-  oldName.format(_T("%s\\%s.log"), m_logDir.getString(), m_fileName.getString());
-  newName.format(fmt, m_logDir.getString(), m_fileName.getString(), 1);
+  oldName.format(_T("%s\\%s.%s"), m_logDir.getString(), m_fileName.getString(),
+                 extension);
+  newName.format(fmt, m_logDir.getString(), m_fileName.getString(), 1,
+                 extension);
   File::renameTo(newName.getString(), oldName.getString());
 }
 
+void FileAccount::writeRecords()
+{
+  size_t size = m_records.size();
+  size_t written = 0;
+  try {
+    while (written < size) {
+      written += m_file->write(&m_records[written], size - written);
+    }
+  } catch (...) {
+  }
+  m_records.clear();
+}
+
 void FileAccount::updateLogDirPath()
 {
   // Creating log directory if it is still no exists.
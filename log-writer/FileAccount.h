@@ -30,6 +30,9 @@
 #include "thread/LocalMutex.h"
 #include "file-lib/WinFile.h"
 #include "LogDump.h"
+#include "BinaryLogEncoder.h"
+
+#include <vector>
 
 class FileAccount : public LogDump
 {
@@ -46,7 +49,10 @@ public:
   // immediately the accumulation will be happening parallelly to writing to the file.
   // If the storeHeader() function will be forgotten the accumulation will be stopped
   // at a maximum log header value automatically.
-  FileAccount(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel, bool logHeadEnabled);
+  // @param binaryFormat - is the initial format of the file (see
+  // setBinaryFormat()).
+  FileAccount(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel, bool logHeadEnabled,
+              bool binaryFormat = false);
 
   // This constructor is a constructor with postponed initialization.
   // This constructor can be used when the log parameters are still unknown.
@@ -81,6 +87,12 @@ public:
   // are equal the function returns true else false.
   bool isTheOurFileName(const TCHAR *fileName);
 
+  // Switches between the text log (the ".log" extension) and the binary
+  // log (the ".blog" extension, see LogRecordDefs.h). If the file is open
+  // the function reopens it in the new format as the first opening, that
+  // is with backup of the old files of this format.
+  void setBinaryFormat(bool enabled);
+
   // Stores a log message to the log file if level is less or equal than
   // the log verbosity level.
   virtual void print(unsigned int processId,
@@ -89,6 +101,17 @@ public:
                      int level,
                      const TCHAR *message);
 
+  // Stores a log message given as a format string and its arguments stored
+  // by LogArguments. In the binary format the message is not formatted if
+  // it is not needed for the log header or dump.
+  void printRecord(unsigned int processId,
+                   unsigned int threadId,
+                   const DateTime *dt,
+                   int level,
+                   const TCHAR *messageFormat,
+                   const char *args,
+                   size_t argsSize);
+
   virtual bool acceptsLevel(int logLevel);
 
 protected:
@@ -117,9 +140,15 @@ private:
   // Adds unicode signature if it is not present
   void addUnicodeSignature();
 
+  // Returns the extension of the log files in the current format.
+  const TCHAR *getFileExtension();
+
   // Creates backup files
   void createBackup(unsigned int backupLimit);
 
+  // Writes the encoded binary records to the file.
+  void writeRecords();
+
   // Formates the message and stores it to the file.
   void format(unsigned int processId,
               unsigned int threadId,
@@ -140,6 +169,11 @@ private:
   bool m_asFirstOpen;
   WinFile *m_file;
 
+  bool m_binaryFormat;
+  BinaryLogEncoder m_encoder;
+  std::vector<char> m_records;
+  std::vector<TCHAR> m_line;
+
   LocalMutex m_logMut;
 };
 
@@ -50,13 +50,31 @@ void FileLogger::storeHeader()
 }
 
 void FileLogger::print(int logLevel, const TCHAR *line)
+{
+  DateTime currTime = DateTime::now();
+  print(GetCurrentThreadId(), &currTime, logLevel, line);
+}
+
+void FileLogger::print(unsigned int threadId, const DateTime *dt,
+                       int logLevel, const TCHAR *line)
+{
+  try {
+    UINT32 processId = GetCurrentProcessId();
+
+    m_fileAccount.print(processId, threadId, dt, logLevel, line);
+  } catch (...) {
+  }
+}
+
+void FileLogger::printRecord(unsigned int threadId, const DateTime *dt,
+                             int logLevel, const TCHAR *format,
+                             const char *args, size_t argsSize)
 {
   try {
     UINT32 processId = GetCurrentProcessId();
-    UINT32 threadId = GetCurrentThreadId();
-    DateTime currTime = DateTime::now();
 
-    m_fileAccount.print(processId, threadId, &currTime, logLevel, line);
+    m_fileAccount.printRecord(processId, threadId, dt, logLevel,
+                              format, args, argsSize);
   } catch (...) {
   }
 }
@@ -70,3 +88,8 @@ void FileLogger::changeLogProps(const TCHAR *newLogDir, unsigned char newLevel)
 {
   m_fileAccount.changeLogProps(newLogDir, newLevel);
 }
+
+void FileLogger::setBinaryFormat(bool enabled)
+{
+  m_fileAccount.setBinaryFormat(enabled);
+}
@@ -68,9 +68,24 @@ public:
   // object creation.
   void changeLogProps(const TCHAR *newLogDir, unsigned char newLevel);
 
+  // Switches between the text and binary log files (see
+  // FileAccount::setBinaryFormat()).
+  void setBinaryFormat(bool enabled);
+
   // Stores a log line to the file.
   virtual void print(int logLevel, const TCHAR *line);
 
+  // Stores a log line that has been logged earlier by the threadId thread
+  // at the dt time.
+  virtual void print(unsigned int threadId, const DateTime *dt,
+                     int logLevel, const TCHAR *line);
+
+  // Stores a log message given as a format string and its arguments to the
+  // file, formatting it only if the file is a text one.
+  virtual void printRecord(unsigned int threadId, const DateTime *dt,
+                           int logLevel, const TCHAR *format,
+                           const char *args, size_t argsSize);
+
   virtual bool acceptsLevel(int logLevel);
 
 private:
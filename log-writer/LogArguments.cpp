@@ -0,0 +1,520 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LogArguments.h"
+
+// Writes the stored arguments to a buffer, counts the needed size even if
+// the buffer is too small.
+class ArgumentWriter
+{
+public:
+  ArgumentWriter(char *buffer, size_t bufferSize)
+  : m_buffer(buffer),
+    m_bufferSize(bufferSize),
+    m_size(0)
+  {
+  }
+
+  void write(const void *data, size_t size)
+  {
+    if (m_size + size <= m_bufferSize) {
+      memcpy(m_buffer + m_size, data, size);
+    }
+    m_size += size;
+  }
+
+  size_t getSize() const
+  {
+    return m_size;
+  }
+
+private:
+  char *m_buffer;
+  size_t m_bufferSize;
+  size_t m_size;
+};
+
+// Reads the stored arguments from a buffer.
+class ArgumentReader
+{
+public:
+  ArgumentReader(const char *buffer, size_t size)
+  : m_buffer(buffer),
+    m_size(size),
+    m_position(0)
+  {
+  }
+
+  // Returns false if there is no more data.
+  bool read(void *data, size_t size)
+  {
+    if (m_position + size > m_size) {
+      return false;
+    }
+    memcpy(data, m_buffer + m_position, size);
+    m_position += size;
+    return true;
+  }
+
+  // Returns pointer to the data and skips it.
+  const char *skip(size_t size)
+  {
+    if (m_position + size > m_size) {
+      return 0;
+    }
+    const char *data = m_buffer + m_position;
+    m_position += size;
+    return data;
+  }
+
+private:
+  const char *m_buffer;
+  size_t m_size;
+  size_t m_position;
+};
+
+void LogArguments::parse(const TCHAR *begin, Specification *spec)
+{
+  const TCHAR *p = begin + 1;
+  spec->begin = begin;
+  spec->starCount = 0;
+  spec->precision = NO_PRECISION;
+  spec->type = ARG_NONE;
+
+  // Flags
+  while (*p != 0 && _tcschr(_T("-+ #0"), *p) != 0) {
+    p++;
+  }
+  // Width and precision
+  for (int field = 0; field < 2; field++) {
+    if (field == 1) {
+      if (*p != _T('.')) {
+        break;
+      }
+      p++;
+    }
+    if (*p == _T('*')) {
+      spec->starCount++;
+      p++;
+      if (field == 1) {
+        spec->precision = STAR_PRECISION;
+      }
+    } else {
+      if (field == 1) {
+        spec->precision = _ttoi(p);
+      }
+      while (*p >= _T('0') && *p <= _T('9')) {
+        p++;
+      }
+    }
+  }
+
+  // Size
+  spec->sizeBegin = p;
+  bool isShort = false;
+  bool isLong = false;
+  ArgumentType integerType = ARG_INT;
+  if (*p == _T('h')) {
+    isShort = true;
+    while (*p == _T('h')) {
+      p++;
+    }
+  } else if (*p == _T('l') || *p == _T('w')) {
+    isLong = true;
+    p++;
+    if (*p == _T('l')) {
+      integerType = ARG_INT64;
+      p++;
+    }
+  } else if (*p == _T('L')) {
+    p++;
+  } else if (*p == _T('j')) {
+    integerType = ARG_INT64;
+    p++;
+  } else if (*p == _T('z') || *p == _T('t')) {
+    integerType = ARG_SIZE;
+    p++;
+  } else if (*p == _T('I')) {
+    p++;
+    if (p[0] == _T('6') && p[1] == _T('4')) {
+      integerType = ARG_INT64;
+      p += 2;
+    } else if (p[0] == _T('3') && p[1] == _T('2')) {
+      p += 2;
+    } else {
+      integerType = ARG_SIZE;
+    }
+  }
+
+  // Type
+  bool isWideDefault = sizeof(TCHAR) == sizeof(WCHAR);
+  switch (*p) {
+  case _T('c'):
+  case _T('C'):
+    // Characters are promoted to int.
+    spec->type = ARG_INT;
+    break;
+  case _T('d'):
+  case _T('i'):
+  case _T('o'):
+  case _T('u'):
+  case _T('x'):
+  case _T('X'):
+    spec->type = integerType;
+    break;
+  case _T('e'):
+  case _T('E'):
+  case _T('f'):
+  case _T('F'):
+  case _T('g'):
+  case _T('G'):
+  case _T('a'):
+  case _T('A'):
+    spec->type = ARG_DOUBLE;
+    break;
+  case _T('p'):
+    spec->type = ARG_POINTER;
+    break;
+  case _T('s'):
+  case _T('S'):
+    {
+      bool isWide;
+      if (isShort) {
+        isWide = false;
+      } else if (isLong) {
+        isWide = true;
+      } else {
+        isWide = (*p == _T('s')) == isWideDefault;
+      }
+      spec->type = isWide ? ARG_WIDE_STRING : ARG_ANSI_STRING;
+    }
+    break;
+  case _T('%'):
+    break;
+  default:
+    // Unknown specification is printed as is.
+    spec->starCount = 0;
+    spec->end = begin + 1;
+    return;
+  }
+  spec->end = p + 1;
+}
+
+size_t LogArguments::getLength(const void *string, bool isWide,
+                               size_t maxLength)
+{
+  size_t length = 0;
+  if (isWide) {
+    const WCHAR *chars = (const WCHAR *)string;
+    while (length < maxLength && chars[length] != 0) {
+      length++;
+    }
+  } else {
+    const char *chars = (const char *)string;
+    while (length < maxLength && chars[length] != 0) {
+      length++;
+    }
+  }
+  return length;
+}
+
+size_t LogArguments::store(const TCHAR *format, va_list args,
+                           char *buffer, size_t bufferSize)
+{
+  ArgumentWriter writer(buffer, bufferSize);
+
+  const TCHAR *p = format;
+  while ((p = _tcschr(p, _T('%'))) != 0) {
+    Specification spec;
+    parse(p, &spec);
+    p = spec.end;
+
+    int starValue = 0;
+    for (int i = 0; i < spec.starCount; i++) {
+      starValue = va_arg(args, int);
+      writer.write(&starValue, sizeof(starValue));
+    }
+
+    UINT8 type = (UINT8)spec.type;
+    switch (spec.type) {
+    case ARG_INT:
+      {
+        int value = va_arg(args, int);
+        writer.write(&type, sizeof(type));
+        writer.write(&value, sizeof(value));
+      }
+      break;
+    case ARG_INT64:
+      {
+        INT64 value = va_arg(args, INT64);
+        writer.write(&type, sizeof(type));
+        writer.write(&value, sizeof(value));
+      }
+      break;
+    case ARG_SIZE:
+      {
+        UINT64 value = va_arg(args, size_t);
+        writer.write(&type, sizeof(type));
+        writer.write(&value, sizeof(value));
+      }
+      break;
+    case ARG_POINTER:
+      {
+        UINT64 value = (UINT64)(size_t)va_arg(args, void *);
+        writer.write(&type, sizeof(type));
+        writer.write(&value, sizeof(value));
+      }
+      break;
+    case ARG_DOUBLE:
+      {
+        double value = va_arg(args, double);
+        writer.write(&type, sizeof(type));
+        writer.write(&value, sizeof(value));
+      }
+      break;
+    case ARG_ANSI_STRING:
+    case ARG_WIDE_STRING:
+      {
+        const void *value = va_arg(args, const void *);
+        if (value == 0) {
+          type = ARG_NULL_STRING;
+          writer.write(&type, sizeof(type));
+          break;
+        }
+        // With a precision the string can be not null-terminated.
+        size_t maxLength = (size_t)-1;
+        if (spec.precision >= 0) {
+          maxLength = spec.precision;
+        } else if (spec.precision == STAR_PRECISION && starValue >= 0) {
+          maxLength = starValue;
+        }
+        bool isWide = spec.type == ARG_WIDE_STRING;
+        size_t charSize = isWide ? sizeof(WCHAR) : 1;
+        UINT32 length = (UINT32)getLength(value, isWide, maxLength);
+        UINT32 terminator = 0;
+        UINT32 storedLength = length + 1;
+        writer.write(&type, sizeof(type));
+        writer.write(&storedLength, sizeof(storedLength));
+        writer.write(value, length * charSize);
+        writer.write(&terminator, charSize);
+      }
+      break;
+    }
+  }
+  return writer.getSize();
+}
+
+#pragma warning(push)
+#pragma warning(disable:4996)
+
+template<class T>
+void LogArguments::append(const TCHAR *spec, T value, std::vector<TCHAR> *line)
+{
+  int count = _sctprintf(spec, value);
+  if (count <= 0) {
+    return;
+  }
+  size_t position = line->size();
+  line->resize(position + count + 1);
+  _stprintf(&(*line)[position], spec, value);
+  line->resize(position + count);
+}
+
+void LogArguments::format(const TCHAR *format,
+                          const char *args, size_t argsSize,
+                          std::vector<TCHAR> *line)
+{
+  ArgumentReader reader(args, argsSize);
+  line->clear();
+
+  // The arguments can come from other process or a file, they are checked
+  // against the format. After the first mismatch the arguments cannot be
+  // matched with the specifications, so the rest of specifications are
+  // printed as is.
+  bool isBroken = false;
+
+  const TCHAR *p = format;
+  while (true) {
+    const TCHAR *percent = _tcschr(p, _T('%'));
+    const TCHAR *textEnd = percent != 0 ? percent : p + _tcslen(p);
+    line->insert(line->end(), p, textEnd);
+    if (percent == 0) {
+      break;
+    }
+
+    Specification spec;
+    parse(percent, &spec);
+    p = spec.end;
+
+    if (spec.type == ARG_NONE) {
+      if (spec.end - spec.begin == 2 && spec.begin[1] == _T('%')) {
+        line->push_back(_T('%'));
+      } else {
+        line->insert(line->end(), spec.begin, spec.end);
+      }
+      continue;
+    }
+    if (isBroken) {
+      line->insert(line->end(), spec.begin, spec.end);
+      continue;
+    }
+
+    // Copy the specification replacing the stars with the stored values.
+    // Width and precision are limited, so that a line cannot take all
+    // memory.
+    TCHAR specString[MAX_SPECIFICATION_LENGTH];
+    size_t length = 0;
+    int fieldValue = 0;
+    bool isValid = true;
+    for (const TCHAR *c = spec.begin; c < spec.sizeBegin && isValid; c++) {
+      if (*c == _T('*')) {
+        int value = 0;
+        isValid = reader.read(&value, sizeof(value)) &&
+                  value >= -MAX_FIELD_VALUE && value <= MAX_FIELD_VALUE;
+        TCHAR number[16];
+        _stprintf(number, _T("%d"), value);
+        for (size_t i = 0; number[i] != 0; i++) {
+          specString[length++] = number[i];
+        }
+      } else {
+        if (*c >= _T('0') && *c <= _T('9')) {
+          fieldValue = fieldValue * 10 + (*c - _T('0'));
+          isValid = fieldValue <= MAX_FIELD_VALUE;
+        } else {
+          fieldValue = 0;
+        }
+        specString[length++] = *c;
+      }
+      isValid = isValid && length + 16 < MAX_SPECIFICATION_LENGTH;
+    }
+
+    UINT8 type = ARG_NONE;
+    isValid = isValid && reader.read(&type, sizeof(type)) &&
+              isCompatible(spec.type, type);
+
+    // A string is formatted according to its stored width, so the
+    // arguments can be formatted by a program built with other TCHAR.
+    if (type == ARG_ANSI_STRING || type == ARG_WIDE_STRING) {
+      specString[length++] = type == ARG_ANSI_STRING ? _T('h') : _T('l');
+      specString[length++] = _T('s');
+    } else if (length + (spec.end - spec.sizeBegin) < MAX_SPECIFICATION_LENGTH) {
+      for (const TCHAR *c = spec.sizeBegin; c < spec.end; c++) {
+        specString[length++] = *c;
+      }
+    } else {
+      isValid = false;
+    }
+    specString[length] = 0;
+
+    if (isValid) {
+      switch (type) {
+      case ARG_INT:
+        {
+          int value = 0;
+          isValid = reader.read(&value, sizeof(value));
+          if (isValid) {
+            append(specString, value, line);
+          }
+        }
+        break;
+      case ARG_INT64:
+        {
+          INT64 value = 0;
+          isValid = reader.read(&value, sizeof(value));
+          if (isValid) {
+            append(specString, value, line);
+          }
+        }
+        break;
+      case ARG_SIZE:
+        {
+          UINT64 value = 0;
+          isValid = reader.read(&value, sizeof(value));
+          if (isValid) {
+            append(specString, (size_t)value, line);
+          }
+        }
+        break;
+      case ARG_POINTER:
+        {
+          UINT64 value = 0;
+          isValid = reader.read(&value, sizeof(value));
+          if (isValid) {
+            append(specString, (void *)(size_t)value, line);
+          }
+        }
+        break;
+      case ARG_DOUBLE:
+        {
+          double value = 0;
+          isValid = reader.read(&value, sizeof(value));
+          if (isValid) {
+            append(specString, value, line);
+          }
+        }
+        break;
+      case ARG_ANSI_STRING:
+      case ARG_WIDE_STRING:
+        {
+          // The stored length includes the terminator.
+          UINT32 stringLength = 0;
+          size_t charSize = type == ARG_WIDE_STRING ? sizeof(WCHAR) : 1;
+          isValid = reader.read(&stringLength, sizeof(stringLength)) &&
+                    stringLength != 0 && stringLength <= argsSize;
+          const char *value = 0;
+          if (isValid) {
+            value = reader.skip(stringLength * charSize);
+            isValid = value != 0 &&
+                      getLength(value + (stringLength - 1) * charSize,
+                                type == ARG_WIDE_STRING, 1) == 0;
+          }
+          if (isValid) {
+            append(specString, (const void *)value, line);
+          }
+        }
+        break;
+      case ARG_NULL_STRING:
+        append(specString, (const void *)0, line);
+        break;
+      }
+    }
+
+    if (!isValid) {
+      isBroken = true;
+      line->insert(line->end(), spec.begin, spec.end);
+    }
+  }
+  line->push_back(0);
+}
+
+bool LogArguments::isCompatible(ArgumentType specType, UINT8 storedType)
+{
+  if (specType == ARG_ANSI_STRING || specType == ARG_WIDE_STRING) {
+    return storedType == ARG_ANSI_STRING || storedType == ARG_WIDE_STRING ||
+           storedType == ARG_NULL_STRING;
+  }
+  return storedType == specType;
+}
+
+#pragma warning(pop)
@@ -0,0 +1,113 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOGARGUMENTS_H__
+#define __LOGARGUMENTS_H__
+
+#include "util/CommonHeader.h"
+
+#include <stdarg.h>
+#include <vector>
+
+// This class stores arguments of a printf-like format string to a byte
+// buffer, so that the string can be formatted later by other thread.
+// Strings are copied to the buffer, other arguments are stored by value.
+class LogArguments
+{
+public:
+  // Stores the arguments of the format string to the buffer.
+  // Returns count of bytes that the arguments take. If it is greater than
+  // bufferSize then the buffer has been filled partially, and the function
+  // must be called again with a larger buffer.
+  static size_t store(const TCHAR *format, va_list args,
+                      char *buffer, size_t bufferSize);
+
+  // Formats the string from the format and the arguments that have been
+  // stored by the store() function. Puts the null-terminated result to
+  // the line argument.
+  // The arguments are checked, so they can come from untrusted sources:
+  // specifications with mismatched or malformed arguments are printed as
+  // is.
+  static void format(const TCHAR *format,
+                     const char *args, size_t argsSize,
+                     std::vector<TCHAR> *line);
+
+private:
+  // Types of stored arguments.
+  enum ArgumentType
+  {
+    ARG_NONE,
+    ARG_INT,
+    ARG_INT64,
+    ARG_SIZE,
+    ARG_POINTER,
+    ARG_DOUBLE,
+    ARG_ANSI_STRING,
+    ARG_WIDE_STRING,
+    ARG_NULL_STRING
+  };
+
+  // Conversion specification of a format string.
+  struct Specification
+  {
+    // Points to the '%' character.
+    const TCHAR *begin;
+    // Points to the size field (e.g. "l" in "%5ld") or to the type
+    // character if there is no size.
+    const TCHAR *sizeBegin;
+    // Points to the character after the specification.
+    const TCHAR *end;
+    // Count of '*' in the width and precision fields.
+    int starCount;
+    // Precision, NO_PRECISION if it is not set or STAR_PRECISION if it
+    // is given by an argument.
+    int precision;
+    // Type of the argument, ARG_NONE if the specification does not
+    // take an argument (e.g. "%%").
+    ArgumentType type;
+  };
+
+  // Parses the specification that starts at the '%' character.
+  static void parse(const TCHAR *begin, Specification *spec);
+
+  // Returns length of the string (in characters) that is not longer
+  // than maxLength.
+  static size_t getLength(const void *string, bool isWide, size_t maxLength);
+
+  // Returns true if the stored argument type can be formatted by the
+  // specification of the specType type.
+  static bool isCompatible(ArgumentType specType, UINT8 storedType);
+
+  // Appends the value formatted by the specification to the line.
+  template<class T>
+  static void append(const TCHAR *spec, T value, std::vector<TCHAR> *line);
+
+  static const int NO_PRECISION = -1;
+  static const int STAR_PRECISION = -2;
+  static const size_t MAX_SPECIFICATION_LENGTH = 64;
+  // Maximum width and precision in the formatted specifications.
+  static const int MAX_FIELD_VALUE = 1024;
+};
+
+#endif // __LOGARGUMENTS_H__
@@ -0,0 +1,68 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOGRECORDDEFS_H__
+#define __LOGRECORDDEFS_H__
+
+#include "util/CommonHeader.h"
+
+// Layout of the binary log.
+//
+// A binary log file starts with the signature (SIGNATURE_SIZE bytes),
+// followed by records. The signature can appear again between records,
+// it means that the writer has reopened the file and the following
+// records do not depend on the previous ones. Each record starts with
+// UINT8 record type:
+//   REC_FORMAT  - defines a format string for the following messages:
+//                 varint format id, varint size of the string in bytes
+//                 and the UTF-8 string without the terminating null
+//                 character. A format id can be defined again, then the
+//                 new definition replaces the previous one.
+//   REC_TIME    - sets the time of the following message: varint
+//                 milliseconds since the unix epoch (the local time as
+//                 DateTime::now() returns).
+//   REC_MESSAGE - varint time delta in milliseconds since the previous
+//                 message or REC_TIME, varint process id, varint thread id,
+//                 UINT8 log level, varint format id, varint size of the
+//                 arguments and the arguments of the format string as
+//                 LogArguments stores them.
+//
+// Varints are unsigned numbers stored by 7 bits in each byte starting from
+// the lowest ones, the high bit is set in all bytes except the last one.
+// The arguments are stored in the byte order of the writer (little-endian).
+//
+// The log server pipe carries the same signature and records after the
+// log file name.
+class LogRecordDefs
+{
+public:
+  static const size_t SIGNATURE_SIZE = 8;
+  static const char SIGNATURE[SIGNATURE_SIZE];
+
+  static const UINT8 REC_FORMAT = 1;
+  static const UINT8 REC_TIME = 2;
+  static const UINT8 REC_MESSAGE = 3;
+};
+
+#endif // __LOGRECORDDEFS_H__
@@ -0,0 +1,107 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LogRing.h"
+
+const char *LogRing::Record::getArgs() const
+{
+  return heapArgs != 0 ? heapArgs : args;
+}
+
+LogRing::LogRing(size_t capacity)
+: m_writePosition(0),
+  m_readPosition(0)
+{
+  size_t size = 2;
+  while (size < capacity) {
+    size *= 2;
+  }
+  m_mask = (LONG)size - 1;
+
+  m_records = new Record[size];
+  for (size_t i = 0; i < size; i++) {
+    // A record is free for writing when its sequence is equal to
+    // the write position.
+    m_records[i].sequence = (LONG)i;
+    m_records[i].heapArgs = 0;
+  }
+}
+
+LogRing::~LogRing()
+{
+  Record *record;
+  while ((record = beginRead()) != 0) {
+    endRead(record);
+  }
+  delete[] m_records;
+}
+
+LogRing::Record *LogRing::beginWrite()
+{
+  LONG position = m_writePosition;
+  while (true) {
+    Record *record = &m_records[position & m_mask];
+    LONG difference = record->sequence - position;
+    if (difference == 0) {
+      LONG oldPosition = InterlockedCompareExchange(&m_writePosition,
+                                                    position + 1, position);
+      if (oldPosition == position) {
+        return record;
+      }
+      position = oldPosition;
+    } else if (difference < 0) {
+      // The record is not read yet since the previous round.
+      return 0;
+    } else {
+      position = m_writePosition;
+    }
+  }
+}
+
+void LogRing::endWrite(Record *record)
+{
+  // The record becomes readable when its sequence is equal to
+  // the read position plus one.
+  InterlockedIncrement(&record->sequence);
+}
+
+LogRing::Record *LogRing::beginRead()
+{
+  Record *record = &m_records[m_readPosition & m_mask];
+  if (record->sequence - (m_readPosition + 1) != 0) {
+    return 0;
+  }
+  return record;
+}
+
+void LogRing::endRead(Record *record)
+{
+  if (record->heapArgs != 0) {
+    delete[] record->heapArgs;
+    record->heapArgs = 0;
+  }
+  // Free the record for the write position of the next round.
+  InterlockedExchange(&record->sequence, m_readPosition + m_mask + 1);
+  m_readPosition++;
+}
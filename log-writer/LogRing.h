@@ -0,0 +1,82 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOGRING_H__
+#define __LOGRING_H__
+
+#include "util/CommonHeader.h"
+
+// This class is a bounded queue of log records. Many threads can write to
+// it and one thread can read from it at the same time without locks.
+// Records are kept in slots of fixed size, arguments of a record that do
+// not fit to the slot are kept in the heap.
+class LogRing
+{
+public:
+  struct Record
+  {
+    // Used by the ring to order writers and the reader.
+    volatile LONG sequence;
+
+    int level;
+    unsigned int threadId;
+    // System (UTC) time of the record.
+    FILETIME time;
+    // Printf-like format string, it must stay valid until the record
+    // is read.
+    const TCHAR *format;
+    // Arguments stored by LogArguments.
+    size_t argsSize;
+    // Arguments allocated with new[] if they do not fit to args, else 0.
+    char *heapArgs;
+    char args[200];
+
+    const char *getArgs() const;
+  };
+
+  // The capacity (count of records) is rounded up to a power of two.
+  LogRing(size_t capacity);
+  virtual ~LogRing();
+
+  // Reserves a record for writing. Returns 0 if the ring is full.
+  Record *beginWrite();
+
+  // Passes the record reserved by beginWrite() to the reader.
+  void endWrite(Record *record);
+
+  // Returns the oldest written record or 0 if there is no one.
+  // Must be called by one thread only.
+  Record *beginRead();
+
+  // Frees the record returned by beginRead().
+  void endRead(Record *record);
+
+private:
+  Record *m_records;
+  LONG m_mask;
+  volatile LONG m_writePosition;
+  LONG m_readPosition;
+};
+
+#endif // __LOGRING_H__
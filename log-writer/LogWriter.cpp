@@ -24,7 +24,6 @@
 
 #include "LogWriter.h"
 #include <cstdarg>
-#include <vector>
 
 LogWriter::LogWriter(Logger *logger)
 : m_logger(logger)
@@ -112,19 +111,9 @@ void LogWriter::debug(const TCHAR *fmt, ...)
   }
 }
 
-#pragma warning(push)
-#pragma warning(disable:4996)
-
 void LogWriter::vprintLog(int logLevel, const TCHAR *fmt, va_list argList)
 {
   if (m_logger != 0) {
-    // Format the original string.
-    int count = _vsctprintf(fmt, argList);
-    std::vector<TCHAR> formattedString(count + 1);
-    _vstprintf(&formattedString.front(), fmt, argList);
-
-    m_logger->print(logLevel, &formattedString.front());
+    m_logger->vprint(logLevel, fmt, argList);
   }
 }
-
-#pragma warning(pop)
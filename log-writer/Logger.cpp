@@ -0,0 +1,57 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "Logger.h"
+#include "LogArguments.h"
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4996)
+
+void Logger::vprint(int logLevel, const TCHAR *format, va_list args)
+{
+  // Format the original string.
+  int count = _vsctprintf(format, args);
+  std::vector<TCHAR> formattedString(count + 1);
+  _vstprintf(&formattedString.front(), format, args);
+
+  print(logLevel, &formattedString.front());
+}
+
+#pragma warning(pop)
+
+void Logger::print(unsigned int threadId, const DateTime *dt,
+                   int logLevel, const TCHAR *line)
+{
+  print(logLevel, line);
+}
+
+void Logger::printRecord(unsigned int threadId, const DateTime *dt,
+                         int logLevel, const TCHAR *format,
+                         const char *args, size_t argsSize)
+{
+  std::vector<TCHAR> line;
+  LogArguments::format(format, args, argsSize, &line);
+  print(threadId, dt, logLevel, &line.front());
+}
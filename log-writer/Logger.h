@@ -26,6 +26,9 @@
 #define _LOGGER_H_
 
 #include "util/CharDefs.h"
+#include "util/DateTime.h"
+
+#include <stdarg.h>
 
 //
 // The Logger class defines abstract low-level interface for logging
@@ -70,6 +73,34 @@ public:
   // for accepting or declining before calling the print() function.
   //
   virtual bool acceptsLevel(int logLevel) = 0;
+
+  //
+  // Processes a log event given as a printf-like format string and its
+  // arguments. The default implementation formats the string and passes it
+  // to print(). A Logger implementation can override this function to
+  // postpone the formatting (see AsyncLogger).
+  //
+  virtual void vprint(int logLevel, const TCHAR *format, va_list args);
+
+  //
+  // Processes a log event that has happened earlier on the thread with the
+  // threadId identifier at the dt local time. The default implementation
+  // ignores the thread and time and calls print().
+  //
+  virtual void print(unsigned int threadId, const DateTime *dt,
+                     int logLevel, const TCHAR *line);
+
+  //
+  // Processes a log event that has happened earlier on the thread with the
+  // threadId identifier at the dt local time. The event is given as a
+  // format string and its arguments stored by LogArguments. The default
+  // implementation formats the string and calls print(). A Logger
+  // implementation can override this function to store the event without
+  // formatting (see BinaryLogEncoder).
+  //
+  virtual void printRecord(unsigned int threadId, const DateTime *dt,
+                           int logLevel, const TCHAR *format,
+                           const char *args, size_t argsSize);
 };
 
 #endif // _LOGGER_H_
@@ -23,24 +23,151 @@
 //
 
 #include "RfbOutputGate.h"
+#include "SessionRecorder.h"
 
 #include <exception>
+#include <math.h>
 
 RfbOutputGate::RfbOutputGate(OutputStream *stream)
-: DataOutputStream(0)
+: DataOutputStream(0),
+  m_scheduler(CLASS_COUNT),
+  m_lockBytes(0),
+  m_preemptionSize(MAX_PREEMPTION_SIZE),
+  m_recentBytes(0),
+  m_recentSeconds(0),
+  m_lastBytes(0),
+  m_lastSeconds(0),
+  m_lastSpeedTime(GetTickCount()),
+  m_recorder(0),
+  m_tee(0)
 {
-  m_tunnel = new BufferedOutputStream(stream);
+  m_meter = new MeteredOutputStream(stream);
+  m_tunnel = new BufferedOutputStream(m_meter);
 
   // Change real output stream for data output stream to our tunnel.
   m_outStream = m_tunnel;
+
+  for (int i = 0; i < CLASS_COUNT; i++) {
+    m_classLocks[i].setClass(this, i);
+  }
+
+  // Bulk data gets a part of the link while the screen is updated, and
+  // the whole link when nothing else is sent.
+  m_scheduler.setShare(CLASS_CLIPBOARD, 20);
+  m_scheduler.setShare(CLASS_FILE_TRANSFER, 25);
 }
 
 RfbOutputGate::~RfbOutputGate()
 {
+  delete m_tee;
   delete m_tunnel;
+  delete m_meter;
 }
 
 void RfbOutputGate::flush()
 {
-  m_tunnel->flush();
+  m_outStream->flush();
+}
+
+void RfbOutputGate::lock()
+{
+  lock(CLASS_CONTROL);
+}
+
+void RfbOutputGate::lock(int messageClass)
+{
+  if (m_scheduler.acquire(messageClass)) {
+    m_lockBytes = m_meter->getBytesWritten();
+  }
+}
+
+void RfbOutputGate::unlock()
+{
+  updatePreemptionSize();
+  m_scheduler.release(m_meter->getBytesWritten() - m_lockBytes);
+}
+
+Lockable *RfbOutputGate::getClassLock(int messageClass)
+{
+  _ASSERT(messageClass >= 0 && messageClass < CLASS_COUNT);
+  return &m_classLocks[messageClass];
+}
+
+UINT32 RfbOutputGate::getPreemptionSize() const
+{
+  return m_preemptionSize;
+}
+
+void RfbOutputGate::updatePreemptionSize()
+{
+  UINT64 bytes = m_meter->getBytesWritten();
+  double seconds = m_meter->getWriteSeconds();
+  DWORD now = GetTickCount();
+
+  double factor = pow(0.5, (double)(now - m_lastSpeedTime) / SPEED_HALF_LIFE);
+  m_recentBytes = m_recentBytes * factor + (double)(bytes - m_lastBytes);
+  m_recentSeconds = m_recentSeconds * factor + (seconds - m_lastSeconds);
+  m_lastBytes = bytes;
+  m_lastSeconds = seconds;
+  m_lastSpeedTime = now;
+
+  if (m_recentSeconds <= 0) {
+    return;
+  }
+  double size = m_recentBytes / m_recentSeconds * PREEMPTION_PERIOD / 1000;
+  size = max(size, (double)MIN_PREEMPTION_SIZE);
+  size = min(size, (double)MAX_PREEMPTION_SIZE);
+  m_preemptionSize = (UINT32)size;
+}
+
+void RfbOutputGate::setRecorder(SessionRecorder *recorder)
+{
+  if (m_tee != 0) {
+    delete m_tee;
+    m_tee = 0;
+  }
+  m_recorder = recorder;
+  if (m_recorder != 0) {
+    m_tee = new TeeOutputStream(m_tunnel, m_recorder);
+    m_outStream = m_tee;
+  } else {
+    m_outStream = m_tunnel;
+  }
+}
+
+SessionRecorder *RfbOutputGate::getRecorder() const
+{
+  return m_recorder;
+}
+
+UINT64 RfbOutputGate::getBytesSent() const
+{
+  return m_meter->getBytesWritten();
+}
+
+double RfbOutputGate::getSendSeconds() const
+{
+  return m_meter->getWriteSeconds();
+}
+
+RfbOutputGate::ClassLock::ClassLock()
+: m_gate(0),
+  m_messageClass(CLASS_CONTROL)
+{
+}
+
+void RfbOutputGate::ClassLock::setClass(RfbOutputGate *gate, int messageClass)
+{
+  m_gate = gate;
+  m_messageClass = messageClass;
+}
+
+void RfbOutputGate::ClassLock::lock()
+{
+  m_gate->lock(m_messageClass);
+}
+
+void RfbOutputGate::ClassLock::unlock()
+{
+  m_gate->unlock();
 }
@@ -27,8 +27,14 @@
 
 #include "io-lib/DataOutputStream.h"
 #include "io-lib/BufferedOutputStream.h"
+#include "io-lib/TeeOutputStream.h"
+#include "io-lib/MeteredOutputStream.h"
 
-#include "thread/LocalMutex.h"
+#include "thread/Lockable.h"
+
+#include "RfbOutputScheduler.h"
+
+class SessionRecorder;
 
 /**
  * Gate for writting rfb messages.
@@ -37,12 +43,29 @@
  * typized data).
  * @remark: after every message you want to send to must manually call flush() cause
  * "autoflush on unlock" is removed.
+ * @remark: the gate is locked for one whole message. When several threads
+ * wait for the gate, it is given to them by priority of their message
+ * classes (see RfbOutputScheduler), the lock() method locks it for a
+ * control message.
  * @author enikey.
  */
 class RfbOutputGate : public DataOutputStream,
-                      public LocalMutex
+                      public Lockable
 {
 public:
+  /**
+   * Classes of messages in order of priority. Messages other than
+   * framebuffer updates, clipboard and file transfer are control messages.
+   */
+  enum MessageClass
+  {
+    CLASS_CONTROL = 0,
+    CLASS_FRAMEBUFFER = 1,
+    CLASS_CLIPBOARD = 2,
+    CLASS_FILE_TRANSFER = 3,
+    CLASS_COUNT = 4
+  };
+
   /**
    * Creates new rfb output gate.
    * @param stream real output stream.
@@ -59,11 +82,139 @@ public:
    */
   virtual void flush() throw(IOException);
 
+  /**
+   * Locks the gate for a control message.
+   */
+  virtual void lock();
+
+  /**
+   * Locks the gate for a message of the given class.
+   */
+  void lock(int messageClass);
+
+  /**
+   * Unlocks the gate.
+   */
+  virtual void unlock();
+
+  /**
+   * Returns object that locks the gate for messages of the class, to be
+   * used with AutoLock.
+   */
+  Lockable *getClassLock(int messageClass);
+
+  /**
+   * Returns the size of a message that the peer receives in about
+   * PREEMPTION_PERIOD. Bulk data split into messages of this size can be
+   * preempted by a more urgent message without a noticeable delay.
+   * @remark can be called without the gate lock.
+   */
+  UINT32 getPreemptionSize() const;
+
+  /**
+   * Starts or stops duplicating of all data written to the gate to the
+   * session recorder. The recorder is flushed each time the gate is flushed.
+   * When no recorder is set (default) the data goes directly to the
+   * buffering tunnel.
+   * @param recorder session recorder or 0 to stop recording. The gate does
+   * not take ownership of the recorder.
+   * @remark must be called under the gate lock.
+   */
+  void setRecorder(SessionRecorder *recorder);
+
+  /**
+   * Returns current session recorder or 0 if recording is disabled.
+   */
+  SessionRecorder *getRecorder() const;
+
+  /**
+   * Returns the number of bytes passed to the real output stream since
+   * the gate was created.
+   * @remark must be called under the gate lock.
+   */
+  UINT64 getBytesSent() const;
+
+  /**
+   * Returns the time (in seconds) spent in the real output stream since
+   * the gate was created. A growing value means that the peer does not
+   * receive the data as fast as it is written.
+   * @remark must be called under the gate lock.
+   */
+  double getSendSeconds() const;
+
 private:
+  /**
+   * Lockable that locks the gate for messages of one class.
+   */
+  class ClassLock : public Lockable
+  {
+  public:
+    ClassLock();
+
+    void setClass(RfbOutputGate *gate, int messageClass);
+
+    virtual void lock();
+    virtual void unlock();
+
+  private:
+    RfbOutputGate *m_gate;
+    int m_messageClass;
+  };
+
+  /**
+   * Calculates the preemption size from the recent speed of the real
+   * output stream.
+   * @remark must be called under the gate lock.
+   */
+  void updatePreemptionSize();
+
+  RfbOutputScheduler m_scheduler;
+  ClassLock m_classLocks[CLASS_COUNT];
+  /**
+   * Count of bytes sent before the gate was locked.
+   */
+  UINT64 m_lockBytes;
+  volatile UINT32 m_preemptionSize;
+  /**
+   * Bytes written to the real output stream and time spent in it, decayed
+   * with SPEED_HALF_LIFE, so that the preemption size follows the current
+   * speed of the link.
+   */
+  double m_recentBytes;
+  double m_recentSeconds;
+  /**
+   * Counters of the meter at the last update of the preemption size.
+   */
+  UINT64 m_lastBytes;
+  double m_lastSeconds;
+  DWORD m_lastSpeedTime;
+
+  /**
+   * Meter of the real output stream.
+   */
+  MeteredOutputStream *m_meter;
   /**
    * Tunnel that adds buffering.
    */
   BufferedOutputStream *m_tunnel;
+  /**
+   * Recorder stream and the tee that duplicates the data to it.
+   * Both are zero when recording is disabled.
+   */
+  SessionRecorder *m_recorder;
+  TeeOutputStream *m_tee;
+
+  /**
+   * Time (in milliseconds) in which a message of the preemption size
+   * is sent.
+   */
+  static const UINT32 PREEMPTION_PERIOD = 50;
+  /**
+   * Time (in milliseconds) in which the recent speed counters fall twice.
+   */
+  static const DWORD SPEED_HALF_LIFE = 2000;
+  static const UINT32 MIN_PREEMPTION_SIZE = 16 * 1024;
+  static const UINT32 MAX_PREEMPTION_SIZE = 8 * 1024 * 1024;
 };
 
 #endif
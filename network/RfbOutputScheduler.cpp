@@ -0,0 +1,178 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "RfbOutputScheduler.h"
+
+#include "thread/AutoLock.h"
+
+#include <math.h>
+
+RfbOutputScheduler::RfbOutputScheduler(int classCount)
+: m_ownerThread(0),
+  m_ownerClass(0),
+  m_ownerDepth(0),
+  m_lastDecayTime(GetTickCount())
+{
+  _ASSERT(classCount > 0);
+
+  ClassState state;
+  state.share = 0;
+  state.waiters = 0;
+  state.recentBytes = 0;
+  m_classes.assign(classCount, state);
+
+  m_events = new WindowsEvent[classCount];
+}
+
+RfbOutputScheduler::~RfbOutputScheduler()
+{
+  delete[] m_events;
+}
+
+void RfbOutputScheduler::setShare(int messageClass, unsigned int percent)
+{
+  AutoLock al(&m_lock);
+
+  _ASSERT(messageClass >= 0 && messageClass < (int)m_classes.size());
+  m_classes[messageClass].share = min(percent, (unsigned int)100);
+}
+
+bool RfbOutputScheduler::acquire(int messageClass)
+{
+  _ASSERT(messageClass >= 0 && messageClass < (int)m_classes.size());
+
+  DWORD threadId = GetCurrentThreadId();
+
+  {
+    AutoLock al(&m_lock);
+
+    if (m_ownerThread == threadId) {
+      m_ownerDepth++;
+      return false;
+    }
+    m_classes[messageClass].waiters++;
+  }
+
+  while (true) {
+    {
+      AutoLock al(&m_lock);
+
+      if (m_ownerThread == 0 && chooseClass(GetTickCount()) == messageClass) {
+        m_classes[messageClass].waiters--;
+        m_ownerThread = threadId;
+        m_ownerClass = messageClass;
+        m_ownerDepth = 1;
+        return true;
+      }
+    }
+    m_events[messageClass].waitForEvent(RECHECK_INTERVAL);
+  }
+}
+
+void RfbOutputScheduler::release(UINT64 bytesSent)
+{
+  int nextClass;
+
+  {
+    AutoLock al(&m_lock);
+
+    _ASSERT(m_ownerThread == GetCurrentThreadId() && m_ownerDepth > 0);
+
+    if (--m_ownerDepth > 0) {
+      return;
+    }
+
+    DWORD now = GetTickCount();
+    decayTraffic(now);
+
+    m_classes[m_ownerClass].recentBytes += (double)bytesSent;
+    m_ownerThread = 0;
+
+    nextClass = chooseClass(now);
+  }
+
+  if (nextClass >= 0) {
+    m_events[nextClass].notify();
+  }
+}
+
+int RfbOutputScheduler::chooseClass(DWORD now)
+{
+  decayTraffic(now);
+
+  double totalBytes = 0;
+  for (size_t i = 0; i < m_classes.size(); i++) {
+    totalBytes += m_classes[i].recentBytes;
+  }
+
+  // A class that has not got its share goes first, so that it is not
+  // starved by more urgent classes.
+  for (size_t i = 0; i < m_classes.size(); i++) {
+    const ClassState *state = &m_classes[i];
+    if (state->waiters != 0 && state->share != 0 &&
+        state->recentBytes <= totalBytes * state->share / 100) {
+      return (int)i;
+    }
+  }
+
+  // The most urgent class without a share, the classes that have got more
+  // than their share wait for it.
+  for (size_t i = 0; i < m_classes.size(); i++) {
+    const ClassState *state = &m_classes[i];
+    if (state->waiters != 0 && state->share == 0) {
+      return (int)i;
+    }
+  }
+
+  // Only classes over their share wait, the link is given to the one that
+  // is the least over it. The decay keeps the ratios, so waiting for them
+  // to change would stall the gate.
+  int chosenClass = -1;
+  double chosenRatio = 0;
+  for (size_t i = 0; i < m_classes.size(); i++) {
+    const ClassState *state = &m_classes[i];
+    if (state->waiters != 0) {
+      double ratio = state->recentBytes / state->share;
+      if (chosenClass < 0 || ratio < chosenRatio) {
+        chosenClass = (int)i;
+        chosenRatio = ratio;
+      }
+    }
+  }
+  return chosenClass;
+}
+
+void RfbOutputScheduler::decayTraffic(DWORD now)
+{
+  DWORD elapsed = now - m_lastDecayTime;
+  if (elapsed == 0) {
+    return;
+  }
+  m_lastDecayTime = now;
+
+  double factor = pow(0.5, (double)elapsed / TRAFFIC_HALF_LIFE);
+  for (size_t i = 0; i < m_classes.size(); i++) {
+    m_classes[i].recentBytes *= factor;
+  }
+}
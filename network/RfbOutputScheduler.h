@@ -0,0 +1,128 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _RFB_OUTPUT_SCHEDULER_H_
+#define _RFB_OUTPUT_SCHEDULER_H_
+
+#include <vector>
+
+#include "util/CommonHeader.h"
+#include "util/inttypes.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+/**
+ * Decides which writer of the rfb output gate gets it next.
+ *
+ * Writers send messages of classes numbered in order of priority, class 0
+ * is the most urgent one. The gate is given to a writer for a whole
+ * message, so a message is preempted by a more urgent one at its boundary
+ * only.
+ *
+ * A class can have a traffic share. While other classes wait for the gate,
+ * a class with a share gets the gate before more urgent classes when it
+ * has sent less than its share of the recent traffic, and waits for
+ * classes without a share when it has sent more. So bulk data neither
+ * stalls urgent messages nor is stalled by them. When only classes over
+ * their share wait, the one that is the least over it goes first, and a
+ * class that nobody competes with gets the whole link. Classes without a
+ * share are served strictly by priority.
+ *
+ * The gate can be acquired again by the thread that owns it.
+ */
+class RfbOutputScheduler
+{
+public:
+  /**
+   * Creates scheduler for the given count of message classes, none of
+   * the classes has a traffic share.
+   */
+  RfbOutputScheduler(int classCount);
+  virtual ~RfbOutputScheduler();
+
+  /**
+   * Sets the traffic share of the message class.
+   * @param percent share of the recent traffic in percents, zero means
+   * that the class is served strictly by priority.
+   */
+  void setShare(int messageClass, unsigned int percent);
+
+  /**
+   * Blocks until the calling thread owns the gate for sending a message
+   * of the class.
+   * @return true if the gate has been acquired, false if the calling
+   * thread owns it already.
+   */
+  bool acquire(int messageClass);
+
+  /**
+   * Releases the gate acquired by the calling thread.
+   * @param bytesSent count of bytes sent since the gate has been acquired,
+   * it is used when the last nested acquire() is released.
+   */
+  void release(UINT64 bytesSent);
+
+private:
+  struct ClassState
+  {
+    unsigned int share;
+    // Count of threads waiting in acquire().
+    unsigned int waiters;
+    // Bytes sent by the class, decayed with TRAFFIC_HALF_LIFE.
+    double recentBytes;
+  };
+
+  /**
+   * Returns index of the class that must get the free gate, or -1 if no
+   * class waits for it.
+   */
+  int chooseClass(DWORD now);
+
+  void decayTraffic(DWORD now);
+
+  std::vector<ClassState> m_classes;
+  // Auto-reset events, one per class, notified when the class must
+  // get the gate.
+  WindowsEvent *m_events;
+
+  LocalMutex m_lock;
+  // Thread that owns the gate, zero if the gate is free.
+  DWORD m_ownerThread;
+  int m_ownerClass;
+  unsigned int m_ownerDepth;
+  DWORD m_lastDecayTime;
+
+  /**
+   * Time (in milliseconds) in which the recent traffic counters fall
+   * twice.
+   */
+  static const DWORD TRAFFIC_HALF_LIFE = 1000;
+  /**
+   * Interval (in milliseconds) of rechecking by a waiting thread, a class
+   * over its share can get the gate when the others stop waiting.
+   */
+  static const DWORD RECHECK_INTERVAL = 10;
+};
+
+#endif
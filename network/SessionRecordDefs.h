@@ -0,0 +1,99 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _SESSION_RECORD_DEFS_H_
+#define _SESSION_RECORD_DEFS_H_
+
+#include <stddef.h>
+
+#include "util/inttypes.h"
+
+//
+// Layout of the session recording files written by SessionRecorder.
+//
+// The file starts with a header:
+//   8 bytes  signature ("TVNREC01");
+//   UINT32   format version;
+//   UINT64   start time (milliseconds since the unix epoch).
+//
+// The header is followed by a sequence of records. Each record starts with
+// a 9-byte record header:
+//   UINT8    record type (one of the REC_* constants below);
+//   UINT32   timestamp (milliseconds since the start of the recording);
+//   UINT32   length of the record payload that follows.
+//
+// Payload of the individual record types:
+//   REC_DATA      - raw bytes sent from the server to the client. Records
+//                   are cut at the points where the output gate is flushed,
+//                   that is at RFB message boundaries.
+//   REC_FORMAT    - UINT16 width, UINT16 height and the client pixel format
+//                   (16 bytes, the same layout as in the ServerInit
+//                   message). Written before the first update and each time
+//                   the client pixel format changes.
+//   REC_KEYFRAME  - UINT16 width, UINT16 height, pixel format (16 bytes),
+//                   UINT8 flags (KEYFRAME_* constants), UINT32 size of the
+//                   uncompressed pixels, then the zlib stream with the
+//                   pixels of the whole frame buffer in the client pixel
+//                   format. The frame buffer equals the client's one right
+//                   after the preceding REC_DATA record.
+//   REC_GAP       - no payload. Some data was dropped because the writer
+//                   could not keep up. Decoding must resume from the next
+//                   keyframe.
+//   REC_INDEX     - UINT32 number of entries, then for each keyframe:
+//                   UINT32 timestamp, UINT64 file offset of the keyframe
+//                   record and UINT8 keyframe flags.
+//
+// All integers are stored in network byte order, as everywhere in RFB.
+//
+// A properly closed file ends with a REC_INDEX record followed by the
+// trailer: UINT64 file offset of the index record and 8 bytes of the trailer
+// signature ("TVNRINDX"). A file without the trailer (e.g. after a crash) is
+// still valid and can be read sequentially up to the last complete record.
+//
+
+class SessionRecordDefs
+{
+public:
+  static const char SIGNATURE[8];
+  static const char TRAILER_SIGNATURE[8];
+  static const UINT32 VERSION = 1;
+
+  static const size_t FILE_HEADER_SIZE = 20;
+  static const size_t RECORD_HEADER_SIZE = 9;
+  static const size_t TRAILER_SIZE = 16;
+
+  static const UINT8 REC_DATA = 1;
+  static const UINT8 REC_FORMAT = 2;
+  static const UINT8 REC_KEYFRAME = 3;
+  static const UINT8 REC_GAP = 4;
+  static const UINT8 REC_INDEX = 5;
+
+  // The stateful encoders (zlib streams) were reset right after the
+  // keyframe, so decoding can start from this keyframe with fresh
+  // decoders. Without this flag the keyframe is only good for preview and
+  // the stream must be decoded from the beginning.
+  static const UINT8 KEYFRAME_DECODERS_RESET = 0x01;
+};
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "SessionRecordReader.h"
+
+#include "io-lib/ByteArrayInputStream.h"
+#include "file-lib/EOFException.h"
+#include "util/Inflater.h"
+
+SessionRecordReader::SessionRecordReader(const TCHAR *fileName)
+: m_file(fileName),
+  m_input(&m_file),
+  m_startTime(0)
+{
+  char signature[sizeof(SessionRecordDefs::SIGNATURE)];
+  m_input.readFully(signature, sizeof(signature));
+  if (memcmp(signature, SessionRecordDefs::SIGNATURE, sizeof(signature)) != 0) {
+    throw Exception(_T("The file is not a session recording"));
+  }
+  UINT32 version = m_input.readUInt32();
+  if (version != SessionRecordDefs::VERSION) {
+    StringStorage errMess;
+    errMess.format(_T("Unsupported session recording version: %u"), version);
+    throw Exception(errMess.getString());
+  }
+  m_startTime = m_input.readUInt64();
+}
+
+SessionRecordReader::~SessionRecordReader()
+{
+}
+
+UINT64 SessionRecordReader::getStartTime() const
+{
+  return m_startTime;
+}
+
+bool SessionRecordReader::readRecord(UINT8 *type, UINT32 *timestamp,
+                                     std::vector<char> *payload)
+{
+  try {
+    *type = m_input.readUInt8();
+    *timestamp = m_input.readUInt32();
+    UINT32 length = m_input.readUInt32();
+    payload->resize(length);
+    if (length != 0) {
+      m_input.readFully(&payload->front(), length);
+    }
+  } catch (EOFException &) {
+    return false;
+  }
+  // The index is the last record, the trailer follows it.
+  return *type != SessionRecordDefs::REC_INDEX;
+}
+
+void SessionRecordReader::parseFormat(const std::vector<char> *payload,
+                                      Dimension *dim, PixelFormat *pf)
+{
+  if (payload->size() != 20) {
+    throw Exception(_T("Malformed format record"));
+  }
+  ByteArrayInputStream stream(&payload->front(), payload->size());
+  DataInputStream input(&stream);
+  dim->width = input.readUInt16();
+  dim->height = input.readUInt16();
+  readPixelFormat(&input, pf);
+}
+
+void SessionRecordReader::parseKeyFrame(const std::vector<char> *payload,
+                                        Dimension *dim, PixelFormat *pf,
+                                        UINT8 *flags,
+                                        std::vector<char> *pixels)
+{
+  const size_t headerSize = 25;
+  if (payload->size() < headerSize) {
+    throw Exception(_T("Malformed keyframe record"));
+  }
+  ByteArrayInputStream stream(&payload->front(), headerSize);
+  DataInputStream input(&stream);
+  dim->width = input.readUInt16();
+  dim->height = input.readUInt16();
+  readPixelFormat(&input, pf);
+  *flags = input.readUInt8();
+  UINT32 pixelsSize = input.readUInt32();
+
+  pixels->resize(pixelsSize);
+  if (pixelsSize == 0) {
+    return;
+  }
+  // Decompress directly to the pixels.
+  Inflater inflater;
+  const char *packed = &payload->front() + headerSize;
+  size_t packedSize = payload->size() - headerSize;
+  size_t outputSize = inflater.inflate(&packed, &packedSize,
+                                       &pixels->front(), pixelsSize);
+  if (outputSize != pixelsSize || packedSize != 0) {
+    throw Exception(_T("Malformed keyframe record"));
+  }
+}
+
+void SessionRecordReader::readPixelFormat(DataInputStream *input,
+                                          PixelFormat *pf)
+{
+  pf->bitsPerPixel = input->readUInt8();
+  pf->colorDepth = input->readUInt8();
+  pf->bigEndian = input->readUInt8() != 0;
+  input->readUInt8(); // true color
+  pf->redMax = input->readUInt16();
+  pf->greenMax = input->readUInt16();
+  pf->blueMax = input->readUInt16();
+  pf->redShift = input->readUInt8();
+  pf->greenShift = input->readUInt8();
+  pf->blueShift = input->readUInt8();
+  input->readUInt8(); // padding
+  input->readUInt16();
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _SESSION_RECORD_READER_H_
+#define _SESSION_RECORD_READER_H_
+
+#include <vector>
+
+#include "io-lib/DataInputStream.h"
+#include "file-lib/MappedFileChannel.h"
+#include "rfb/PixelFormat.h"
+#include "region/Dimension.h"
+#include "SessionRecordDefs.h"
+
+/**
+ * Sequential reader of the session recording files written by
+ * SessionRecorder (see SessionRecordDefs.h for the file layout).
+ */
+class SessionRecordReader
+{
+public:
+  /**
+   * Opens the file and checks its header.
+   * @throws Exception if the file cannot be opened or it is not a session
+   * recording.
+   */
+  SessionRecordReader(const TCHAR *fileName);
+  virtual ~SessionRecordReader();
+
+  /**
+   * Returns the start time of the recording (milliseconds since the unix
+   * epoch).
+   */
+  UINT64 getStartTime() const;
+
+  /**
+   * Reads the next record.
+   * @param type [out] record type, one of SessionRecordDefs::REC_*.
+   * @param timestamp [out] milliseconds since the start of the recording.
+   * @param payload [out] record payload.
+   * @return false at the end of the file, including the case of a
+   * truncated last record.
+   * @throws IOException on a read error.
+   */
+  bool readRecord(UINT8 *type, UINT32 *timestamp, std::vector<char> *payload);
+
+  /**
+   * Parses the payload of a REC_FORMAT record.
+   * @throws Exception if the payload is malformed.
+   */
+  static void parseFormat(const std::vector<char> *payload,
+                          Dimension *dim, PixelFormat *pf);
+
+  /**
+   * Parses the payload of a REC_KEYFRAME record and unpacks its pixels.
+   * @param flags [out] SessionRecordDefs::KEYFRAME_* flags.
+   * @param pixels [out] frame buffer pixels in the pf pixel format.
+   * @throws Exception if the payload is malformed.
+   */
+  static void parseKeyFrame(const std::vector<char> *payload,
+                            Dimension *dim, PixelFormat *pf, UINT8 *flags,
+                            std::vector<char> *pixels);
+
+protected:
+  // Reads the pixel format in the ServerInit layout.
+  static void readPixelFormat(DataInputStream *input, PixelFormat *pf);
+
+  MappedFileChannel m_file;
+  DataInputStream m_input;
+
+  UINT64 m_startTime;
+};
+
+#endif
@@ -0,0 +1,370 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "SessionRecorder.h"
+
+#include "thread/AutoLock.h"
+#include "io-lib/ByteArrayOutputStream.h"
+#include "util/Deflater.h"
+#include "util/DateTime.h"
+
+SessionRecorder::SessionRecorder(const TCHAR *fileName, LogWriter *log,
+                                 size_t maxQueueSize,
+                                 unsigned int keyFrameInterval)
+: m_log(log),
+  m_fileOffset(0),
+  m_failed(false),
+  m_keyFrameInterval(keyFrameInterval),
+  m_lastKeyFrameTime(0),
+  m_pendingDropped(false),
+  m_formatRecorded(false),
+  m_queueSize(0),
+  m_maxQueueSize(maxQueueSize),
+  m_keyFrameRequested(true)
+{
+  m_file.open(fileName, F_WRITE, FM_CREATE);
+  m_startTicks = GetTickCount();
+
+  ByteArrayOutputStream header(SessionRecordDefs::FILE_HEADER_SIZE);
+  DataOutputStream output(&header);
+  output.writeFully(SessionRecordDefs::SIGNATURE,
+                    sizeof(SessionRecordDefs::SIGNATURE));
+  output.writeUInt32(SessionRecordDefs::VERSION);
+  output.writeUInt64(DateTime::now().getTime());
+  writeBytes(header.toByteArray(), header.size());
+
+  m_log->info(_T("Session recording started: %s"), fileName);
+
+  resume();
+}
+
+SessionRecorder::~SessionRecorder()
+{
+  terminate();
+  wait();
+
+  {
+    AutoLock al(&m_queueMutex);
+    while (!m_queue.empty()) {
+      delete m_queue.front();
+      m_queue.pop_front();
+    }
+  }
+
+  if (!m_failed) {
+    try {
+      writeIndex();
+    } catch (Exception &e) {
+      m_log->error(_T("Cannot write session recording index: %s"),
+                   e.getMessage());
+    }
+  }
+  m_file.close();
+  m_log->info(_T("Session recording finished (%d keyframes)"),
+              (int)m_index.size());
+}
+
+size_t SessionRecorder::write(const void *buffer, size_t len)
+{
+  if (m_failed || m_pendingDropped) {
+    return len;
+  }
+  if (m_pending.size() + len > m_maxQueueSize) {
+    // A single message does not fit in the queue at all.
+    m_pending.clear();
+    m_pendingDropped = true;
+    return len;
+  }
+  const char *typedBuffer = (const char *)buffer;
+  m_pending.insert(m_pending.end(), typedBuffer, typedBuffer + len);
+  return len;
+}
+
+void SessionRecorder::flush()
+{
+  if (m_failed) {
+    return;
+  }
+  if (!m_pendingDropped && m_pending.empty()) {
+    return;
+  }
+
+  Record *record = new Record;
+  record->type = m_pendingDropped ? SessionRecordDefs::REC_GAP
+                                  : SessionRecordDefs::REC_DATA;
+  record->timestamp = getTimestamp();
+  record->keyFrameFlags = 0;
+  // Swap the data instead of copying it, m_pending starts from scratch.
+  record->data.swap(m_pending);
+  record->compressFrom = record->data.size();
+  m_pendingDropped = false;
+
+  enqueue(record);
+}
+
+void SessionRecorder::setFormat(const Dimension *dim, const PixelFormat *pf)
+{
+  // Keep the order of records if some data was written without flushing.
+  flush();
+  if (m_formatRecorded && m_lastDim.isEqualTo(dim) && m_lastPf.isEqualTo(pf)) {
+    return;
+  }
+  m_lastDim = *dim;
+  m_lastPf = *pf;
+  m_formatRecorded = true;
+
+  ByteArrayOutputStream payload(20);
+  DataOutputStream output(&payload);
+  output.writeUInt16((UINT16)dim->width);
+  output.writeUInt16((UINT16)dim->height);
+  putPixelFormat(&output, pf);
+
+  Record *record = new Record;
+  record->type = SessionRecordDefs::REC_FORMAT;
+  record->timestamp = getTimestamp();
+  record->keyFrameFlags = 0;
+  record->data.assign(payload.toByteArray(),
+                      payload.toByteArray() + payload.size());
+  record->compressFrom = record->data.size();
+
+  enqueue(record);
+}
+
+bool SessionRecorder::isKeyFrameNeeded()
+{
+  if (m_failed) {
+    return false;
+  }
+  AutoLock al(&m_queueMutex);
+  return m_keyFrameRequested ||
+         getTimestamp() - m_lastKeyFrameTime >= m_keyFrameInterval;
+}
+
+void SessionRecorder::addKeyFrame(const FrameBuffer *fb, bool decodersReset)
+{
+  if (m_failed) {
+    return;
+  }
+  flush();
+
+  Dimension dim = fb->getDimension();
+  PixelFormat pf = fb->getPixelFormat();
+  UINT8 flags = decodersReset ? SessionRecordDefs::KEYFRAME_DECODERS_RESET : 0;
+  size_t pixelsSize = fb->getBufferSize();
+
+  ByteArrayOutputStream payload(32);
+  DataOutputStream output(&payload);
+  output.writeUInt16((UINT16)dim.width);
+  output.writeUInt16((UINT16)dim.height);
+  putPixelFormat(&output, &pf);
+  output.writeUInt8(flags);
+  output.writeUInt32((UINT32)pixelsSize);
+
+  Record *record = new Record;
+  record->type = SessionRecordDefs::REC_KEYFRAME;
+  record->timestamp = getTimestamp();
+  record->keyFrameFlags = flags;
+  record->data.reserve(payload.size() + pixelsSize);
+  record->data.assign(payload.toByteArray(),
+                      payload.toByteArray() + payload.size());
+  record->compressFrom = record->data.size();
+  const char *pixels = (const char *)fb->getBuffer();
+  record->data.insert(record->data.end(), pixels, pixels + pixelsSize);
+
+  {
+    AutoLock al(&m_queueMutex);
+    m_lastKeyFrameTime = record->timestamp;
+    m_keyFrameRequested = false;
+  }
+  enqueue(record);
+}
+
+UINT32 SessionRecorder::getTimestamp() const
+{
+  return GetTickCount() - m_startTicks;
+}
+
+void SessionRecorder::enqueue(Record *record)
+{
+  {
+    AutoLock al(&m_queueMutex);
+    if (m_queueSize + record->data.size() <= m_maxQueueSize) {
+      m_queueSize += record->data.size();
+      m_queue.push_back(record);
+      record = 0;
+    } else {
+      // Replace the record by a gap marker, unless the previous queued
+      // record is a gap marker already.
+      m_keyFrameRequested = true;
+      if (m_queue.empty() ||
+          m_queue.back()->type != SessionRecordDefs::REC_GAP) {
+        record->type = SessionRecordDefs::REC_GAP;
+        record->data.clear();
+        record->compressFrom = 0;
+        m_queue.push_back(record);
+        record = 0;
+      }
+    }
+  }
+  if (record != 0) {
+    delete record;
+  }
+  m_queueEvent.notify();
+}
+
+void SessionRecorder::execute()
+{
+  while (!isTerminating()) {
+    m_queueEvent.waitForEvent();
+    writeQueuedRecords();
+  }
+  // Write the rest of the queue before exit.
+  writeQueuedRecords();
+}
+
+void SessionRecorder::onTerminate()
+{
+  m_queueEvent.notify();
+}
+
+void SessionRecorder::writeQueuedRecords()
+{
+  std::list<Record *> records;
+  {
+    AutoLock al(&m_queueMutex);
+    records.swap(m_queue);
+  }
+
+  while (!records.empty()) {
+    Record *record = records.front();
+    records.pop_front();
+    size_t queuedSize = record->data.size();
+    if (!m_failed) {
+      try {
+        writeRecord(record);
+      } catch (Exception &e) {
+        m_log->error(_T("Session recording stopped: %s"), e.getMessage());
+        m_failed = true;
+      }
+    }
+    delete record;
+
+    // The memory is released only now, so the limit covers the records
+    // being written as well.
+    AutoLock al(&m_queueMutex);
+    m_queueSize -= queuedSize;
+  }
+}
+
+void SessionRecorder::writeRecord(Record *record)
+{
+  if (record->compressFrom >= record->data.size()) {
+    writeRecordHeader(record->type, record->timestamp, record->data.size());
+    if (!record->data.empty()) {
+      writeBytes(&record->data.front(), record->data.size());
+    }
+    return;
+  }
+
+  // Compress the tail of the payload (frame buffer pixels).
+  Deflater deflater;
+  deflater.setInput(&record->data[record->compressFrom],
+                    record->data.size() - record->compressFrom);
+  deflater.deflate();
+
+  if (record->type == SessionRecordDefs::REC_KEYFRAME) {
+    IndexEntry entry;
+    entry.timestamp = record->timestamp;
+    entry.offset = m_fileOffset;
+    entry.flags = record->keyFrameFlags;
+    m_index.push_back(entry);
+  }
+
+  writeRecordHeader(record->type, record->timestamp,
+                    record->compressFrom + deflater.getOutputSize());
+  writeBytes(&record->data.front(), record->compressFrom);
+  writeBytes(deflater.getOutput(), deflater.getOutputSize());
+}
+
+void SessionRecorder::writeRecordHeader(UINT8 type, UINT32 timestamp,
+                                        size_t length)
+{
+  ByteArrayOutputStream header(SessionRecordDefs::RECORD_HEADER_SIZE);
+  DataOutputStream output(&header);
+  output.writeUInt8(type);
+  output.writeUInt32(timestamp);
+  _ASSERT((UINT32)length == length);
+  output.writeUInt32((UINT32)length);
+  writeBytes(header.toByteArray(), header.size());
+}
+
+void SessionRecorder::writeIndex()
+{
+  UINT64 indexOffset = m_fileOffset;
+
+  ByteArrayOutputStream index;
+  DataOutputStream output(&index);
+  output.writeUInt32((UINT32)m_index.size());
+  for (size_t i = 0; i < m_index.size(); i++) {
+    output.writeUInt32(m_index[i].timestamp);
+    output.writeUInt64(m_index[i].offset);
+    output.writeUInt8(m_index[i].flags);
+  }
+  writeRecordHeader(SessionRecordDefs::REC_INDEX, getTimestamp(), index.size());
+  writeBytes(index.toByteArray(), index.size());
+
+  ByteArrayOutputStream trailer(SessionRecordDefs::TRAILER_SIZE);
+  DataOutputStream trailerOutput(&trailer);
+  trailerOutput.writeUInt64(indexOffset);
+  trailerOutput.writeFully(SessionRecordDefs::TRAILER_SIGNATURE,
+                           sizeof(SessionRecordDefs::TRAILER_SIGNATURE));
+  writeBytes(trailer.toByteArray(), trailer.size());
+}
+
+void SessionRecorder::writeBytes(const void *buffer, size_t len)
+{
+  const char *typedBuffer = (const char *)buffer;
+  size_t written = 0;
+  while (written < len) {
+    written += m_file.write(typedBuffer + written, len - written);
+  }
+  m_fileOffset += len;
+}
+
+void SessionRecorder::putPixelFormat(DataOutputStream *output,
+                                     const PixelFormat *pf)
+{
+  output->writeUInt8((UINT8)pf->bitsPerPixel);
+  output->writeUInt8((UINT8)pf->colorDepth);
+  output->writeUInt8(pf->bigEndian ? 1 : 0);
+  output->writeUInt8(1); // true color
+  output->writeUInt16((UINT16)pf->redMax);
+  output->writeUInt16((UINT16)pf->greenMax);
+  output->writeUInt16((UINT16)pf->blueMax);
+  output->writeUInt8((UINT8)pf->redShift);
+  output->writeUInt8((UINT8)pf->greenShift);
+  output->writeUInt8((UINT8)pf->blueShift);
+  output->writeUInt8(0); // padding
+  output->writeUInt16(0);
+}
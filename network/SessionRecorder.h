@@ -0,0 +1,188 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _SESSION_RECORDER_H_
+#define _SESSION_RECORDER_H_
+
+#include <list>
+#include <vector>
+
+#include "io-lib/OutputStream.h"
+#include "io-lib/DataOutputStream.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+#include "file-lib/WinFile.h"
+#include "rfb/FrameBuffer.h"
+#include "log-writer/LogWriter.h"
+#include "SessionRecordDefs.h"
+
+/**
+ * Records the server to client half of an RFB session to a file.
+ *
+ * The recorder is an output stream which is plugged into RfbOutputGate (see
+ * RfbOutputGate::setRecorder()). Everything written to the gate is appended
+ * to the current record, and the record is closed when the gate is flushed,
+ * that is after every RFB message. Closed records are put to a queue and
+ * written to the file by the recorder's own thread, so threads sending data
+ * to the client never wait for the disk.
+ *
+ * Memory is bounded by the maxQueueSize constructor argument. If the writer
+ * thread cannot keep up and the queue is full, new records are dropped and a
+ * REC_GAP record is written instead. A new keyframe is requested in this
+ * case so a replay can continue from it.
+ *
+ * Keyframes are produced by UpdateSender which asks isKeyFrameNeeded() and
+ * then passes a frame buffer snapshot to addKeyFrame().
+ *
+ * The file layout is described in SessionRecordDefs.h.
+ *
+ * @remark write(), flush(), setFormat() and addKeyFrame() must be called
+ * under the lock of the output gate the recorder is plugged into.
+ */
+class SessionRecorder : public OutputStream, private Thread
+{
+public:
+  static const size_t DEFAULT_MAX_QUEUE_SIZE = 32 * 1024 * 1024;
+  static const unsigned int DEFAULT_KEY_FRAME_INTERVAL = 30000;
+
+  /**
+   * Creates the file and starts the writer thread.
+   * @param fileName path to the file to create (overwritten if exists).
+   * @param maxQueueSize maximum number of bytes waiting to be written.
+   * @param keyFrameInterval interval between keyframes, in milliseconds.
+   * @throws Exception if the file cannot be created.
+   */
+  SessionRecorder(const TCHAR *fileName, LogWriter *log,
+                  size_t maxQueueSize = DEFAULT_MAX_QUEUE_SIZE,
+                  unsigned int keyFrameInterval = DEFAULT_KEY_FRAME_INTERVAL);
+  /**
+   * Writes all queued records, the index and the trailer, then closes the
+   * file.
+   */
+  virtual ~SessionRecorder();
+
+  /**
+   * Appends data to the current record.
+   * @return len, the data is always accepted (but may be dropped).
+   */
+  virtual size_t write(const void *buffer, size_t len);
+
+  /**
+   * Closes the current record and queues it for writing.
+   */
+  virtual void flush();
+
+  /**
+   * Records the client frame buffer dimension and pixel format if they
+   * differ from the previously recorded ones.
+   */
+  void setFormat(const Dimension *dim, const PixelFormat *pf);
+
+  /**
+   * Returns true if it's time to produce a new keyframe.
+   */
+  bool isKeyFrameNeeded();
+
+  /**
+   * Records a keyframe.
+   * @param fb frame buffer in the client pixel format which equals the
+   * client's frame buffer at this point of the stream.
+   * @param decodersReset true if all stateful encoders have been reset
+   * after this keyframe, see SessionRecordDefs::KEYFRAME_DECODERS_RESET.
+   */
+  void addKeyFrame(const FrameBuffer *fb, bool decodersReset);
+
+protected:
+  struct Record
+  {
+    UINT8 type;
+    UINT32 timestamp;
+    UINT8 keyFrameFlags;
+    // Payload. Bytes starting from compressFrom are deflated by the writer
+    // thread before writing.
+    std::vector<char> data;
+    size_t compressFrom;
+  };
+
+  struct IndexEntry
+  {
+    UINT32 timestamp;
+    UINT64 offset;
+    UINT8 flags;
+  };
+
+  // Returns milliseconds since the start of the recording.
+  UINT32 getTimestamp() const;
+
+  // Puts the record to the queue or drops it if the queue is full.
+  // Takes ownership of the record.
+  void enqueue(Record *record);
+
+  // Writes everything that is queued at the moment.
+  void writeQueuedRecords();
+  void writeRecord(Record *record);
+  void writeRecordHeader(UINT8 type, UINT32 timestamp, size_t length);
+  void writeIndex();
+  void writeBytes(const void *buffer, size_t len);
+
+  // Writes the pixel format in the ServerInit layout.
+  static void putPixelFormat(DataOutputStream *output, const PixelFormat *pf);
+
+  // Inherited from Thread.
+  virtual void execute();
+  virtual void onTerminate();
+
+  LogWriter *m_log;
+
+  WinFile m_file;
+  // Current position in the file, in bytes. Used only by the writer thread.
+  UINT64 m_fileOffset;
+  // Set when a file error occurs, all data is dropped after that.
+  volatile bool m_failed;
+
+  DWORD m_startTicks;
+  unsigned int m_keyFrameInterval;
+  UINT32 m_lastKeyFrameTime;
+
+  // The record being filled by write(). Protected by the output gate lock.
+  std::vector<char> m_pending;
+  bool m_pendingDropped;
+  Dimension m_lastDim;
+  PixelFormat m_lastPf;
+  bool m_formatRecorded;
+
+  // The queue of records to write and its size in bytes.
+  std::list<Record *> m_queue;
+  size_t m_queueSize;
+  size_t m_maxQueueSize;
+  bool m_keyFrameRequested;
+  LocalMutex m_queueMutex;
+  WindowsEvent m_queueEvent;
+
+  // Keyframes written so far. Used only by the writer thread.
+  std::vector<IndexEntry> m_index;
+};
+
+#endif
@@ -0,0 +1,242 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "RegionBenchmark.h"
+
+extern "C" {
+#include "region/x11region.h"
+}
+
+RegionBenchmark::RegionBenchmark(int frameWidth, int frameHeight,
+                                 int frameCount, int maxDirtyRects)
+: m_frameRect(frameWidth, frameHeight),
+  m_seed(12345),
+  m_ticksPerSecond(1)
+{
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+  generateFrames(frameCount, maxDirtyRects);
+}
+
+RegionBenchmark::~RegionBenchmark()
+{
+}
+
+void RegionBenchmark::run(double seconds, FILE *out)
+{
+  Engine engines[] = { ENGINE_X11, ENGINE_REGION, ENGINE_REGION_BATCH };
+  size_t engineCount = sizeof(engines) / sizeof(engines[0]);
+  INT64 budget = (INT64)(seconds * m_ticksPerSecond);
+  std::vector<Rect> rects;
+  rects.reserve(1024);
+
+  _ftprintf(out, _T("%-14s %10s %12s %14s %12s\n"),
+            _T("engine"), _T("frames"), _T("us/frame"), _T("allocs/frame"),
+            _T("rects/frame"));
+  for (size_t e = 0; e < engineCount; e++) {
+    // A warm-up pass fills the pool and the caches.
+    if (engines[e] == ENGINE_X11) {
+      runX11(&rects);
+    } else {
+      runRegion(engines[e] == ENGINE_REGION_BATCH, &rects);
+    }
+
+    UINT64 frames = 0;
+    UINT64 outputRects = 0;
+    unsigned long x11Allocations = miHeapAllocations;
+    UINT64 poolAllocations = RegionBoxPool::getHeapAllocationCount();
+    INT64 startTicks = getTicks();
+    INT64 spent;
+    do {
+      if (engines[e] == ENGINE_X11) {
+        outputRects += runX11(&rects);
+      } else {
+        outputRects += runRegion(engines[e] == ENGINE_REGION_BATCH, &rects);
+      }
+      frames += m_frames.size();
+      spent = getTicks() - startTicks;
+    } while (spent < budget);
+    UINT64 allocations = (miHeapAllocations - x11Allocations) +
+      (RegionBoxPool::getHeapAllocationCount() - poolAllocations);
+
+    _ftprintf(out, _T("%-14s %10I64u %12.3f %14.3f %12.1f\n"),
+              getEngineName(engines[e]), frames,
+              (double)spent * 1000000 / m_ticksPerSecond / frames,
+              (double)allocations / frames,
+              (double)outputRects / frames);
+  }
+}
+
+size_t RegionBenchmark::runX11(std::vector<Rect> *rects)
+{
+  size_t totalRects = 0;
+  BoxRec frameBox = { m_frameRect.left, m_frameRect.top,
+                      m_frameRect.right, m_frameRect.bottom };
+  for (size_t i = 0; i < m_frames.size(); i++) {
+    const Frame *frame = &m_frames[i];
+
+    RegionRec changed;
+    miRegionInit(&changed, NullBox, 0);
+    for (size_t j = 0; j < frame->dirtyRects.size(); j++) {
+      const Rect *r = &frame->dirtyRects[j];
+      BoxRec box = { r->left, r->top, r->right, r->bottom };
+      RegionRec temp;
+      miRegionInit(&temp, &box, 0);
+      miUnion(&changed, &changed, &temp);
+      miRegionUninit(&temp);
+    }
+
+    const Rect *c = &frame->copiedRect;
+    BoxRec copiedBox = { c->left, c->top, c->right, c->bottom };
+    RegionRec copied;
+    miRegionInit(&copied, &copiedBox, 0);
+    miSubtract(&changed, &changed, &copied);
+
+    const Rect *q = &frame->requestedRect;
+    BoxRec requestedBox = { q->left, q->top, q->right, q->bottom };
+    RegionRec requested;
+    miRegionInit(&requested, &requestedBox, 0);
+    miIntersect(&changed, &changed, &requested);
+
+    RegionRec frameRegion;
+    miRegionInit(&frameRegion, &frameBox, 0);
+    miIntersect(&changed, &changed, &frameRegion);
+
+    RegionRec sent;
+    miRegionInit(&sent, NullBox, 0);
+    miRegionCopy(&sent, &changed);
+
+    rects->clear();
+    if (miRegionNotEmpty(&sent)) {
+      const BoxRec *boxes = REGION_RECTS(&sent);
+      long count = REGION_NUM_RECTS(&sent);
+      for (long j = 0; j < count; j++) {
+        rects->push_back(Rect(boxes[j].x1, boxes[j].y1,
+                              boxes[j].x2, boxes[j].y2));
+      }
+    }
+    totalRects += rects->size();
+
+    miRegionUninit(&sent);
+    miRegionUninit(&frameRegion);
+    miRegionUninit(&requested);
+    miRegionUninit(&copied);
+    miRegionUninit(&changed);
+  }
+  return totalRects;
+}
+
+size_t RegionBenchmark::runRegion(bool batch, std::vector<Rect> *rects)
+{
+  size_t totalRects = 0;
+  for (size_t i = 0; i < m_frames.size(); i++) {
+    const Frame *frame = &m_frames[i];
+
+    Region changed;
+    if (batch) {
+      changed.addRects(&frame->dirtyRects);
+    } else {
+      for (size_t j = 0; j < frame->dirtyRects.size(); j++) {
+        changed.addRect(&frame->dirtyRects[j]);
+      }
+    }
+
+    Region copied(&frame->copiedRect);
+    changed.subtract(&copied);
+    Region requested(&frame->requestedRect);
+    changed.intersect(&requested);
+    changed.crop(&m_frameRect);
+
+    Region sent;
+    sent.move(&changed);
+
+    sent.getRectVector(rects);
+    totalRects += rects->size();
+  }
+  return totalRects;
+}
+
+void RegionBenchmark::generateFrames(int frameCount, int maxDirtyRects)
+{
+  int width = m_frameRect.getWidth();
+  int height = m_frameRect.getHeight();
+  m_frames.resize(frameCount);
+  for (int i = 0; i < frameCount; i++) {
+    Frame *frame = &m_frames[i];
+    // Dirty rectangles are clustered around a few spots (a typing caret,
+    // a scrolled window, animations), like the grabbers report them.
+    int dirtyCount = 1 + (int)(random() % maxDirtyRects);
+    int spotX = (int)(random() % width);
+    int spotY = (int)(random() % height);
+    for (int j = 0; j < dirtyCount; j++) {
+      if (random() % 8 == 0) {
+        spotX = (int)(random() % width);
+        spotY = (int)(random() % height);
+      }
+      int x = spotX + (int)(random() % 129) - 64;
+      int y = spotY + (int)(random() % 129) - 64;
+      int w = 4 + (int)(random() % 96);
+      int h = 4 + (int)(random() % 48);
+      frame->dirtyRects.push_back(Rect(x, y, x + w, y + h));
+    }
+    int x = (int)(random() % width);
+    int y = (int)(random() % height);
+    frame->copiedRect.setRect(x, y, x + (int)(random() % 300),
+                              y + (int)(random() % 200));
+    // Usually the whole screen is requested, sometimes a part of it.
+    if (random() % 4 == 0) {
+      frame->requestedRect.setRect(0, 0, width / 2, height);
+    } else {
+      frame->requestedRect = m_frameRect;
+    }
+  }
+}
+
+UINT32 RegionBenchmark::random()
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) & 0x7fff;
+}
+
+INT64 RegionBenchmark::getTicks()
+{
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart;
+}
+
+const TCHAR *RegionBenchmark::getEngineName(Engine engine)
+{
+  switch (engine) {
+  case ENGINE_X11:
+    return _T("x11region");
+  case ENGINE_REGION:
+    return _T("Region");
+  case ENGINE_REGION_BATCH:
+    return _T("Region batch");
+  }
+  return _T("unknown");
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _REGION_BENCHMARK_H_
+#define _REGION_BENCHMARK_H_
+
+#include <vector>
+#include <stdio.h>
+
+#include "region/Region.h"
+
+//
+// RegionBenchmark compares Region with the X11 region code it replaced on
+// the region algebra done per frame by the server: the changed region is
+// collected from dirty rectangles, the copied region is subtracted from it,
+// the result is intersected with the requested region and cropped to the
+// frame buffer, then copied and converted to the list of rectangles to send.
+//
+// Frames are generated in advance with a deterministic generator, so every
+// engine processes exactly the same input.
+//
+
+class RegionBenchmark
+{
+public:
+  // frameWidth, frameHeight - size of the frame buffer.
+  // frameCount - count of different frames to generate.
+  // maxDirtyRects - maximal count of dirty rectangles per frame.
+  RegionBenchmark(int frameWidth, int frameHeight, int frameCount,
+                  int maxDirtyRects);
+  virtual ~RegionBenchmark();
+
+  // Runs every engine for at least the given time and prints the results.
+  void run(double seconds, FILE *out);
+
+protected:
+  struct Frame
+  {
+    std::vector<Rect> dirtyRects;
+    Rect copiedRect;
+    Rect requestedRect;
+  };
+
+  enum Engine
+  {
+    ENGINE_X11,
+    ENGINE_REGION,
+    ENGINE_REGION_BATCH
+  };
+
+  // Processes all frames once, returns count of resulting rectangles.
+  size_t runX11(std::vector<Rect> *rects);
+  size_t runRegion(bool batch, std::vector<Rect> *rects);
+
+  void generateFrames(int frameCount, int maxDirtyRects);
+  UINT32 random();
+
+  static INT64 getTicks();
+  static const TCHAR *getEngineName(Engine engine);
+
+  Rect m_frameRect;
+  std::vector<Frame> m_frames;
+  UINT32 m_seed;
+  INT64 m_ticksPerSecond;
+};
+
+#endif
@@ -0,0 +1,60 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "RegionBenchmark.h"
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  int width = 1920;
+  int height = 1080;
+  int maxDirtyRects = 64;
+  double seconds = 2.0;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (_tcscmp(argv[i], _T("-s")) == 0 && hasValue) {
+      if (_stscanf(argv[++i], _T("%dx%d"), &width, &height) != 2 ||
+          width <= 0 || height <= 0) {
+        width = 0;
+        break;
+      }
+    } else if (_tcscmp(argv[i], _T("-r")) == 0 && hasValue) {
+      maxDirtyRects = _ttoi(argv[++i]);
+    } else if (_tcscmp(argv[i], _T("-t")) == 0 && hasValue) {
+      seconds = _tstof(argv[++i]);
+    } else {
+      width = 0;
+      break;
+    }
+  }
+  if (width == 0 || maxDirtyRects <= 0) {
+    _ftprintf(stderr, _T("Usage: region-bench [-s WIDTHxHEIGHT]")
+                      _T(" [-r MAX_DIRTY_RECTS] [-t SECONDS]\n"));
+    return 1;
+  }
+
+  RegionBenchmark benchmark(width, height, 1000, maxDirtyRects);
+  benchmark.run(seconds, stdout);
+  return 0;
+}
@@ -24,45 +24,58 @@
 
 #include "Region.h"
 
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+
 Region::Region()
+: m_boxes(m_inline),
+  m_count(0),
+  m_capacity(INLINE_CAPACITY)
 {
-  miRegionInit(&m_reg, NullBox, 0);
 }
 
-// FIXME: Make BoxRec and Rect identical to get rid of conversions.
 Region::Region(const Rect *rect)
+: m_boxes(m_inline),
+  m_count(0),
+  m_capacity(INLINE_CAPACITY)
 {
   if (!rect->isEmpty()) {
-    BoxRec box;
-    box.x1 = rect->left;
-    box.x2 = rect->right;
-    box.y1 = rect->top;
-    box.y2 = rect->bottom;
-    miRegionInit(&m_reg, &box, 0);
-  } else {
-    miRegionInit(&m_reg, NullBox, 0);
+    setSingleBox(rect->left, rect->top, rect->right, rect->bottom);
   }
 }
 
 Region::Region(const Region &src)
+: m_boxes(m_inline),
+  m_count(0),
+  m_capacity(INLINE_CAPACITY)
 {
-  miRegionInit(&m_reg, NullBox, 0);
   set(&src);
 }
 
 Region::~Region()
 {
-  miRegionUninit(&m_reg);
+  releaseStorage();
 }
 
 void Region::clear()
 {
-  miRegionEmpty(&m_reg);
+  m_count = 0;
+  if (m_capacity > MAX_KEPT_CAPACITY) {
+    releaseStorage();
+  }
 }
 
 void Region::set(const Region *src)
 {
-  miRegionCopy(&m_reg, (RegionPtr)&src->m_reg);
+  if (src == this) {
+    return;
+  }
+  m_count = 0;
+  reserve(src->m_count);
+  memcpy(m_boxes, src->m_boxes, src->m_count * sizeof(RegionBox));
+  m_count = src->m_count;
+  m_extents = src->m_extents;
 }
 
 Region & Region::operator=(const Region &src)
@@ -71,97 +84,689 @@ Region & Region::operator=(const Region &src)
   return *this;
 }
 
+void Region::swap(Region *other)
+{
+  if (other == this) {
+    return;
+  }
+  bool thisInline = isInline();
+  bool otherInline = other->isInline();
+  if (thisInline && otherInline) {
+    RegionBox temp[INLINE_CAPACITY];
+    memcpy(temp, m_inline, m_count * sizeof(RegionBox));
+    memcpy(m_inline, other->m_inline, other->m_count * sizeof(RegionBox));
+    memcpy(other->m_inline, temp, m_count * sizeof(RegionBox));
+  } else if (thisInline) {
+    memcpy(other->m_inline, m_inline, m_count * sizeof(RegionBox));
+    m_boxes = other->m_boxes;
+    other->m_boxes = other->m_inline;
+  } else if (otherInline) {
+    memcpy(m_inline, other->m_inline, other->m_count * sizeof(RegionBox));
+    other->m_boxes = m_boxes;
+    m_boxes = m_inline;
+  } else {
+    std::swap(m_boxes, other->m_boxes);
+  }
+  std::swap(m_count, other->m_count);
+  std::swap(m_capacity, other->m_capacity);
+  std::swap(m_extents, other->m_extents);
+}
+
+void Region::move(Region *src)
+{
+  if (src == this) {
+    return;
+  }
+  swap(src);
+  src->clear();
+}
+
 void Region::addRect(const Rect *rect)
 {
-  if (!rect->isEmpty()) {
-    Region temp(rect);
-    add(&temp);
+  if (rect->isEmpty()) {
+    return;
+  }
+  if (m_count == 0) {
+    setSingleBox(rect->left, rect->top, rect->right, rect->bottom);
+    return;
+  }
+  // Nothing to add if a single-box region already covers the rectangle.
+  if (m_count == 1 &&
+      m_extents.x1 <= rect->left && m_extents.x2 >= rect->right &&
+      m_extents.y1 <= rect->top && m_extents.y2 >= rect->bottom) {
+    return;
+  }
+  // Rectangles added in the top to bottom order (e.g. by pollers) just
+  // make a new band at the end.
+  if (rect->top >= m_extents.y2) {
+    size_t lastBand = m_count - 1;
+    while (lastBand > 0 && m_boxes[lastBand - 1].y1 == m_boxes[m_count - 1].y1) {
+      lastBand--;
+    }
+    appendBox(rect->left, rect->top, rect->right, rect->bottom);
+    coalesce(lastBand, m_count - 1);
+    m_extents.x1 = min(m_extents.x1, rect->left);
+    m_extents.x2 = max(m_extents.x2, rect->right);
+    m_extents.y2 = rect->bottom;
+    return;
+  }
+  Region temp(rect);
+  apply(&temp, OP_UNION);
+}
+
+void Region::addRects(const std::vector<Rect> *rects)
+{
+  Region batch;
+  batch.buildFromRects(rects);
+  if (m_count == 0) {
+    swap(&batch);
+  } else {
+    apply(&batch, OP_UNION);
   }
 }
 
 void Region::translate(int dx, int dy)
 {
-  miTranslateRegion(&m_reg, dx, dy);
+  for (size_t i = 0; i < m_count; i++) {
+    m_boxes[i].x1 += dx;
+    m_boxes[i].x2 += dx;
+    m_boxes[i].y1 += dy;
+    m_boxes[i].y2 += dy;
+  }
+  m_extents.x1 += dx;
+  m_extents.x2 += dx;
+  m_extents.y1 += dy;
+  m_extents.y2 += dy;
 }
 
 void Region::add(const Region *other)
 {
-  miUnion(&m_reg, &m_reg, (RegionPtr)&other->m_reg);
+  apply(other, OP_UNION);
 }
 
 void Region::subtract(const Region *other)
 {
-  miSubtract(&m_reg, &m_reg, (RegionPtr)&other->m_reg);
+  apply(other, OP_SUBTRACT);
 }
 
 void Region::intersect(const Region *other)
 {
-  miIntersect(&m_reg, &m_reg, (RegionPtr)&other->m_reg);
+  apply(other, OP_INTERSECT);
 }
 
 void Region::crop(const Rect *rect)
 {
+  if (m_count == 0) {
+    return;
+  }
+  if (rect->left <= m_extents.x1 && rect->right >= m_extents.x2 &&
+      rect->top <= m_extents.y1 && rect->bottom >= m_extents.y2) {
+    return;
+  }
   Region temp(rect);
-  intersect(&temp);
+  apply(&temp, OP_INTERSECT);
 }
 
 bool Region::isEmpty() const
 {
-  return (miRegionNotEmpty((RegionPtr)&m_reg) == FALSE);
+  return m_count == 0;
 }
 
 bool Region::isPointInside(int x, int y) const
 {
-  BoxRec stubBox; // Ignore returning rect.
-  return !!miPointInRegion((RegionPtr)&m_reg, x, y, &stubBox);
+  if (m_count == 0 ||
+      x < m_extents.x1 || x >= m_extents.x2 ||
+      y < m_extents.y1 || y >= m_extents.y2) {
+    return false;
+  }
+  for (size_t i = 0; i < m_count && m_boxes[i].y1 <= y; i++) {
+    const RegionBox *box = &m_boxes[i];
+    if (y < box->y2 && x >= box->x1 && x < box->x2) {
+      return true;
+    }
+  }
+  return false;
 }
 
 bool Region::equals(const Region *other) const
 {
-  // Handle a special case when both regions are empty.
-  // Such regions may be considered different by miRegionsEqual().
-  if (this->isEmpty() && other->isEmpty()) {
-    return true;
+  // The banded form is canonical, so equal regions have equal boxes.
+  if (m_count != other->m_count) {
+    return false;
   }
-
-  return (miRegionsEqual((RegionPtr)&m_reg,
-                         (RegionPtr)&other->m_reg) == TRUE);
+  return memcmp(m_boxes, other->m_boxes, m_count * sizeof(RegionBox)) == 0;
 }
 
-// FIXME: Optimize, make BoxRec and Rect identical to get rid of conversions.
 void Region::getRectVector(std::vector<Rect> *dst) const
 {
   dst->clear();
-
-  const BoxRec *boxPtr = REGION_RECTS(&m_reg);
-  long numRects = REGION_NUM_RECTS(&m_reg);
-  dst->reserve((size_t)numRects);
-  for (long i = 0; i < numRects; i++) {
-    Rect rect(boxPtr[i].x1, boxPtr[i].y1, boxPtr[i].x2, boxPtr[i].y2);
-    dst->push_back(rect);
+  dst->reserve(m_count);
+  for (size_t i = 0; i < m_count; i++) {
+    const RegionBox *box = &m_boxes[i];
+    dst->push_back(Rect(box->x1, box->y1, box->x2, box->y2));
   }
 }
 
-// FIXME: Optimize, make BoxRec and Rect identical to get rid of conversions.
 void Region::getRectList(std::list<Rect> *dst) const
 {
   dst->clear();
-
-  const BoxRec *boxPtr = REGION_RECTS(&m_reg);
-  long numRects = REGION_NUM_RECTS(&m_reg);
-  for (long i = 0; i < numRects; i++) {
-    Rect rect(boxPtr[i].x1, boxPtr[i].y1, boxPtr[i].x2, boxPtr[i].y2);
-    dst->push_back(rect);
+  for (size_t i = 0; i < m_count; i++) {
+    const RegionBox *box = &m_boxes[i];
+    dst->push_back(Rect(box->x1, box->y1, box->x2, box->y2));
   }
 }
 
 size_t Region::getCount() const
 {
-  return REGION_NUM_RECTS(&m_reg);
+  return m_count;
 }
 
 Rect Region::getBounds() const
 {
-  const BoxRec *boxPtr = REGION_EXTENTS(&m_reg);
-  return Rect(boxPtr->x1, boxPtr->y1, boxPtr->x2, boxPtr->y2);
+  if (m_count == 0) {
+    return Rect();
+  }
+  return Rect(m_extents.x1, m_extents.y1, m_extents.x2, m_extents.y2);
+}
+
+void Region::apply(const Region *other, Operation op)
+{
+  if (other == this) {
+    if (op == OP_SUBTRACT) {
+      clear();
+    }
+    return;
+  }
+
+  bool overlap = m_count != 0 && other->m_count != 0 &&
+                 m_extents.x1 < other->m_extents.x2 &&
+                 other->m_extents.x1 < m_extents.x2 &&
+                 m_extents.y1 < other->m_extents.y2 &&
+                 other->m_extents.y1 < m_extents.y2;
+
+  // Trivial cases that need no band sweep.
+  switch (op) {
+  case OP_UNION:
+    if (other->m_count == 0) {
+      return;
+    }
+    if (m_count == 0) {
+      set(other);
+      return;
+    }
+    break;
+  case OP_INTERSECT:
+    if (!overlap) {
+      clear();
+      return;
+    }
+    if (m_count == 1 && other->m_count == 1) {
+      setSingleBox(max(m_extents.x1, other->m_extents.x1),
+                   max(m_extents.y1, other->m_extents.y1),
+                   min(m_extents.x2, other->m_extents.x2),
+                   min(m_extents.y2, other->m_extents.y2));
+      return;
+    }
+    break;
+  case OP_SUBTRACT:
+    if (!overlap) {
+      return;
+    }
+    break;
+  }
+
+  Region result;
+  result.combine(this, other, op);
+  swap(&result);
+}
+
+void Region::combine(const Region *reg1, const Region *reg2, Operation op)
+{
+  m_count = 0;
+  if (reg1->m_count == 0 || reg2->m_count == 0) {
+    if (op == OP_UNION) {
+      set(reg1->m_count != 0 ? reg1 : reg2);
+    } else if (op == OP_SUBTRACT) {
+      set(reg1);
+    }
+    return;
+  }
+
+  bool appendNon1 = op != OP_INTERSECT;
+  bool appendNon2 = op == OP_UNION;
+
+  const RegionBox *r1 = reg1->m_boxes;
+  const RegionBox *r1End = r1 + reg1->m_count;
+  const RegionBox *r2 = reg2->m_boxes;
+  const RegionBox *r2End = r2 + reg2->m_count;
+  const RegionBox *r1BandEnd;
+  const RegionBox *r2BandEnd;
+
+  reserve(max(reg1->m_count, reg2->m_count) * 2);
+
+  int ybot = min(r1->y1, r2->y1);
+  int ytop;
+  size_t prevBand = 0;
+  size_t curBand;
+
+  do {
+    int r1y1 = r1->y1;
+    for (r1BandEnd = r1 + 1; r1BandEnd != r1End && r1BandEnd->y1 == r1y1;
+         r1BandEnd++) {
+    }
+    int r2y1 = r2->y1;
+    for (r2BandEnd = r2 + 1; r2BandEnd != r2End && r2BandEnd->y1 == r2y1;
+         r2BandEnd++) {
+    }
+
+    // First handle the part of a band that has no pair in the other region.
+    if (r1y1 < r2y1) {
+      if (appendNon1) {
+        int top = max(r1y1, ybot);
+        int bot = min(r1->y2, r2y1);
+        if (top != bot) {
+          curBand = m_count;
+          appendBand(r1, r1BandEnd, top, bot);
+          prevBand = coalesce(prevBand, curBand);
+        }
+      }
+      ytop = r2y1;
+    } else if (r2y1 < r1y1) {
+      if (appendNon2) {
+        int top = max(r2y1, ybot);
+        int bot = min(r2->y2, r1y1);
+        if (top != bot) {
+          curBand = m_count;
+          appendBand(r2, r2BandEnd, top, bot);
+          prevBand = coalesce(prevBand, curBand);
+        }
+      }
+      ytop = r1y1;
+    } else {
+      ytop = r1y1;
+    }
+
+    // Then the overlapping part, if any.
+    ybot = min(r1->y2, r2->y2);
+    if (ybot > ytop) {
+      curBand = m_count;
+      switch (op) {
+      case OP_UNION:
+        unionBand(r1, r1BandEnd, r2, r2BandEnd, ytop, ybot);
+        break;
+      case OP_INTERSECT:
+        intersectBand(r1, r1BandEnd, r2, r2BandEnd, ytop, ybot);
+        break;
+      case OP_SUBTRACT:
+        subtractBand(r1, r1BandEnd, r2, r2BandEnd, ytop, ybot);
+        break;
+      }
+      prevBand = coalesce(prevBand, curBand);
+    }
+
+    if (r1->y2 == ybot) {
+      r1 = r1BandEnd;
+    }
+    if (r2->y2 == ybot) {
+      r2 = r2BandEnd;
+    }
+  } while (r1 != r1End && r2 != r2End);
+
+  // Only the first band of the rest can be coalesced, the others are
+  // copied as is.
+  if (r1 != r1End && appendNon1) {
+    int r1y1 = r1->y1;
+    for (r1BandEnd = r1 + 1; r1BandEnd != r1End && r1BandEnd->y1 == r1y1;
+         r1BandEnd++) {
+    }
+    curBand = m_count;
+    appendBand(r1, r1BandEnd, max(r1y1, ybot), r1->y2);
+    prevBand = coalesce(prevBand, curBand);
+    size_t rest = r1End - r1BandEnd;
+    reserve(m_count + rest);
+    memcpy(m_boxes + m_count, r1BandEnd, rest * sizeof(RegionBox));
+    m_count += rest;
+  } else if (r2 != r2End && appendNon2) {
+    int r2y1 = r2->y1;
+    for (r2BandEnd = r2 + 1; r2BandEnd != r2End && r2BandEnd->y1 == r2y1;
+         r2BandEnd++) {
+    }
+    curBand = m_count;
+    appendBand(r2, r2BandEnd, max(r2y1, ybot), r2->y2);
+    prevBand = coalesce(prevBand, curBand);
+    size_t rest = r2End - r2BandEnd;
+    reserve(m_count + rest);
+    memcpy(m_boxes + m_count, r2BandEnd, rest * sizeof(RegionBox));
+    m_count += rest;
+  }
+
+  if (m_count == 0) {
+    return;
+  }
+  if (op == OP_UNION) {
+    // The union covers both bounding boxes entirely.
+    m_extents.x1 = min(reg1->m_extents.x1, reg2->m_extents.x1);
+    m_extents.y1 = min(reg1->m_extents.y1, reg2->m_extents.y1);
+    m_extents.x2 = max(reg1->m_extents.x2, reg2->m_extents.x2);
+    m_extents.y2 = max(reg1->m_extents.y2, reg2->m_extents.y2);
+  } else {
+    updateExtents();
+  }
+}
+
+void Region::appendBand(const RegionBox *r, const RegionBox *rEnd,
+                        int y1, int y2)
+{
+  reserve(m_count + (rEnd - r));
+  for (; r != rEnd; r++) {
+    appendBox(r->x1, y1, r->x2, y2);
+  }
+}
+
+void Region::unionBand(const RegionBox *r1, const RegionBox *r1End,
+                       const RegionBox *r2, const RegionBox *r2End,
+                       int y1, int y2)
+{
+  int x1;
+  int x2;
+  if (r1->x1 < r2->x1) {
+    x1 = r1->x1;
+    x2 = r1->x2;
+    r1++;
+  } else {
+    x1 = r2->x1;
+    x2 = r2->x2;
+    r2++;
+  }
+  // Picks the leftmost box each time and merges it with the current one.
+  while (r1 != r1End || r2 != r2End) {
+    const RegionBox *r;
+    if (r2 == r2End || (r1 != r1End && r1->x1 < r2->x1)) {
+      r = r1++;
+    } else {
+      r = r2++;
+    }
+    if (r->x1 <= x2) {
+      if (x2 < r->x2) {
+        x2 = r->x2;
+      }
+    } else {
+      appendBox(x1, y1, x2, y2);
+      x1 = r->x1;
+      x2 = r->x2;
+    }
+  }
+  appendBox(x1, y1, x2, y2);
+}
+
+void Region::intersectBand(const RegionBox *r1, const RegionBox *r1End,
+                           const RegionBox *r2, const RegionBox *r2End,
+                           int y1, int y2)
+{
+  do {
+    int x1 = max(r1->x1, r2->x1);
+    int x2 = min(r1->x2, r2->x2);
+    if (x1 < x2) {
+      appendBox(x1, y1, x2, y2);
+    }
+    // Advance the box with the leftmost right side, the next box of that
+    // band may still overlap the current box of the other one.
+    if (r1->x2 == x2) {
+      r1++;
+    }
+    if (r2->x2 == x2) {
+      r2++;
+    }
+  } while (r1 != r1End && r2 != r2End);
+}
+
+void Region::subtractBand(const RegionBox *r1, const RegionBox *r1End,
+                          const RegionBox *r2, const RegionBox *r2End,
+                          int y1, int y2)
+{
+  // x1 is the leftmost point of the minuend not checked yet.
+  int x1 = r1->x1;
+  do {
+    if (r2->x2 <= x1) {
+      // Subtrahend is entirely to the left, go to the next one.
+      r2++;
+    } else if (r2->x1 <= x1) {
+      // Subtrahend covers the left edge of the minuend.
+      x1 = r2->x2;
+      if (x1 >= r1->x2) {
+        r1++;
+        if (r1 != r1End) {
+          x1 = r1->x1;
+        }
+      } else {
+        r2++;
+      }
+    } else if (r2->x1 < r1->x2) {
+      // Subtrahend covers a middle part, add the uncovered left part.
+      appendBox(x1, y1, r2->x1, y2);
+      x1 = r2->x2;
+      if (x1 >= r1->x2) {
+        r1++;
+        if (r1 != r1End) {
+          x1 = r1->x1;
+        }
+      } else {
+        r2++;
+      }
+    } else {
+      // Subtrahend is entirely to the right, add the rest of the minuend.
+      if (r1->x2 > x1) {
+        appendBox(x1, y1, r1->x2, y2);
+      }
+      r1++;
+      if (r1 != r1End) {
+        x1 = r1->x1;
+      }
+    }
+  } while (r1 != r1End && r2 != r2End);
+
+  while (r1 != r1End) {
+    appendBox(x1, y1, r1->x2, y2);
+    r1++;
+    if (r1 != r1End) {
+      x1 = r1->x1;
+    }
+  }
+}
+
+size_t Region::coalesce(size_t prevStart, size_t curStart)
+{
+  size_t numBoxes = curStart - prevStart;
+  // The bands can be merged only if they have the same box count, touch
+  // each other and have boxes at the same places.
+  if (numBoxes == 0 || numBoxes != m_count - curStart) {
+    return curStart;
+  }
+  RegionBox *prevBox = m_boxes + prevStart;
+  RegionBox *curBox = m_boxes + curStart;
+  if (prevBox->y2 != curBox->y1) {
+    return curStart;
+  }
+  for (size_t i = 0; i < numBoxes; i++) {
+    if (prevBox[i].x1 != curBox[i].x1 || prevBox[i].x2 != curBox[i].x2) {
+      return curStart;
+    }
+  }
+  int y2 = curBox->y2;
+  for (size_t i = 0; i < numBoxes; i++) {
+    prevBox[i].y2 = y2;
+  }
+  m_count -= numBoxes;
+  return prevStart;
+}
+
+static bool topEdgeLess(const RegionBox &a, const RegionBox &b)
+{
+  return a.y1 < b.y1;
+}
+
+void Region::buildFromRects(const std::vector<Rect> *rects)
+{
+  m_count = 0;
+  size_t count = 0;
+  for (size_t i = 0; i < rects->size(); i++) {
+    if (!(*rects)[i].isEmpty()) {
+      count++;
+    }
+  }
+  if (count == 0) {
+    return;
+  }
+
+  // One pooled array holds the input sorted by top edges and the active
+  // boxes (crossing the current band) sorted by left edges.
+  size_t scratchCapacity;
+  RegionBox *input = RegionBoxPool::allocate(count * 2, &scratchCapacity);
+  RegionBox *active = input + count;
+  size_t activeCount = 0;
+
+  size_t n = 0;
+  for (size_t i = 0; i < rects->size(); i++) {
+    const Rect *rect = &(*rects)[i];
+    if (!rect->isEmpty()) {
+      input[n].x1 = rect->left;
+      input[n].y1 = rect->top;
+      input[n].x2 = rect->right;
+      input[n].y2 = rect->bottom;
+      n++;
+    }
+  }
+  std::sort(input, input + count, topEdgeLess);
+
+  try {
+    size_t next = 0;
+    size_t prevBand = 0;
+    int y = input[0].y1;
+    while (next < count || activeCount != 0) {
+      if (activeCount == 0 && input[next].y1 > y) {
+        y = input[next].y1;
+      }
+      for (; next < count && input[next].y1 <= y; next++) {
+        size_t pos = activeCount++;
+        while (pos > 0 && active[pos - 1].x1 > input[next].x1) {
+          active[pos] = active[pos - 1];
+          pos--;
+        }
+        active[pos] = input[next];
+      }
+
+      int bottom = next < count ? input[next].y1 : INT_MAX;
+      for (size_t i = 0; i < activeCount; i++) {
+        bottom = min(bottom, active[i].y2);
+      }
+
+      // The active boxes are sorted by left edges, so the merged spans of
+      // the band come out in order.
+      size_t curBand = m_count;
+      int x1 = active[0].x1;
+      int x2 = active[0].x2;
+      for (size_t i = 1; i < activeCount; i++) {
+        if (active[i].x1 <= x2) {
+          x2 = max(x2, active[i].x2);
+        } else {
+          reserve(m_count + 1);
+          appendBox(x1, y, x2, bottom);
+          x1 = active[i].x1;
+          x2 = active[i].x2;
+        }
+      }
+      reserve(m_count + 1);
+      appendBox(x1, y, x2, bottom);
+      prevBand = coalesce(prevBand, curBand);
+
+      size_t kept = 0;
+      for (size_t i = 0; i < activeCount; i++) {
+        if (active[i].y2 > bottom) {
+          active[kept++] = active[i];
+        }
+      }
+      activeCount = kept;
+      y = bottom;
+    }
+  } catch (...) {
+    RegionBoxPool::release(input, scratchCapacity);
+    throw;
+  }
+  RegionBoxPool::release(input, scratchCapacity);
+
+  updateExtents();
+}
+
+void Region::reserve(size_t capacity)
+{
+  if (capacity <= m_capacity) {
+    return;
+  }
+  // Grow at least twice to keep appending linear.
+  capacity = max(capacity, m_capacity * 2);
+  size_t newCapacity;
+  RegionBox *boxes = RegionBoxPool::allocate(capacity, &newCapacity);
+  memcpy(boxes, m_boxes, m_count * sizeof(RegionBox));
+  if (!isInline()) {
+    RegionBoxPool::release(m_boxes, m_capacity);
+  }
+  m_boxes = boxes;
+  m_capacity = newCapacity;
+}
+
+void Region::releaseStorage()
+{
+  if (!isInline()) {
+    RegionBoxPool::release(m_boxes, m_capacity);
+    m_boxes = m_inline;
+    m_capacity = INLINE_CAPACITY;
+  }
+  m_count = 0;
+}
+
+inline void Region::appendBox(int x1, int y1, int x2, int y2)
+{
+  if (m_count == m_capacity) {
+    reserve(m_count + 1);
+  }
+  RegionBox *box = &m_boxes[m_count++];
+  box->x1 = x1;
+  box->y1 = y1;
+  box->x2 = x2;
+  box->y2 = y2;
+}
+
+void Region::setSingleBox(int x1, int y1, int x2, int y2)
+{
+  m_count = 0;
+  if (x1 < x2 && y1 < y2) {
+    appendBox(x1, y1, x2, y2);
+    m_extents = m_boxes[0];
+  }
+}
+
+void Region::updateExtents()
+{
+  if (m_count == 0) {
+    return;
+  }
+  // Because of banding, the first box has the smallest top and the last one
+  // has the biggest bottom.
+  m_extents.x1 = m_boxes[0].x1;
+  m_extents.y1 = m_boxes[0].y1;
+  m_extents.x2 = m_boxes[m_count - 1].x2;
+  m_extents.y2 = m_boxes[m_count - 1].y2;
+  for (size_t i = 0; i < m_count; i++) {
+    if (m_boxes[i].x1 < m_extents.x1) {
+      m_extents.x1 = m_boxes[i].x1;
+    }
+    if (m_boxes[i].x2 > m_extents.x2) {
+      m_extents.x2 = m_boxes[i].x2;
+    }
+  }
+}
+
+bool Region::isInline() const
+{
+  return m_boxes == m_inline;
 }
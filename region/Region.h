@@ -29,10 +29,7 @@
 #include <list>
 
 #include "Rect.h"
-
-extern "C" {
-#include "x11region.h"
-}
+#include "RegionBoxPool.h"
 
 /**
  * A Region is an area which can be represented by a set of rectangles with
@@ -42,6 +39,13 @@ extern "C" {
  * rectangle will not necessarily increment the number of rectangles by one.
  * On such addition, the underlying list of rectangles may change dramatically
  * and its length may increase, decrease or remain the same.
+ *
+ * Rectangles are kept in the y-x banded form (the same as in X11 regions):
+ * sorted by top then left edge, grouped in horizontal bands of equal top and
+ * bottom, with vertically adjacent identical bands coalesced. Up to
+ * INLINE_CAPACITY rectangles are stored inside the object itself, bigger
+ * regions use arrays from RegionBoxPool, so the region algebra on typical
+ * update regions does not touch the heap.
  */
 class Region {
 public:
@@ -79,12 +83,31 @@ public:
    * @param src a reference to the source region.
    */
   Region & operator=(const Region &src);
+  /**
+   * Exchanges contents of this region and another region. Rectangles stored
+   * in the pool are not copied.
+   * @param other a pointer to the region to swap with.
+   */
+  void swap(Region *other);
+  /**
+   * Replaces this region with contents of another region, leaving the
+   * other region empty. Rectangles stored in the pool are not copied.
+   * @param src a pointer to the source region.
+   */
+  void move(Region *src);
 
   /**
    * Adds a rectangle to this region.
    * @param rect rectangle to add.
    */
   void addRect(const Rect *rect);
+  /**
+   * Adds a set of rectangles to this region. The rectangles may overlap,
+   * they are merged into bands in one pass, that is much faster than
+   * adding them one by one.
+   * @param rects rectangles to add, empty rectangles are ignored.
+   */
+  void addRects(const std::vector<Rect> *rects);
   /**
    * Adds offset to all rectangles in region.
    * @param dx horizontal offset to add.
@@ -151,10 +174,58 @@ public:
   Rect getBounds() const;
 
 private:
-  /**
-   * The underlying X11 region structure.
-   */
-  RegionRec m_reg;
+  enum Operation
+  {
+    OP_UNION,
+    OP_INTERSECT,
+    OP_SUBTRACT
+  };
+
+  static const size_t INLINE_CAPACITY = 16;
+  // Storage bigger than this is given back to the pool by clear().
+  static const size_t MAX_KEPT_CAPACITY = 1024;
+
+  // Sets this (empty) region to the result of the operation on reg1 and
+  // reg2, both must differ from this region.
+  void combine(const Region *reg1, const Region *reg2, Operation op);
+  // Replaces this region with the result of the operation on itself and
+  // another region.
+  void apply(const Region *other, Operation op);
+
+  // Functions of the band sweep used by combine(), see miRegionOp() in
+  // x11region.c for the description of the algorithm.
+  void appendBand(const RegionBox *r, const RegionBox *rEnd, int y1, int y2);
+  void unionBand(const RegionBox *r1, const RegionBox *r1End,
+                 const RegionBox *r2, const RegionBox *r2End,
+                 int y1, int y2);
+  void intersectBand(const RegionBox *r1, const RegionBox *r1End,
+                     const RegionBox *r2, const RegionBox *r2End,
+                     int y1, int y2);
+  void subtractBand(const RegionBox *r1, const RegionBox *r1End,
+                    const RegionBox *r2, const RegionBox *r2End,
+                    int y1, int y2);
+  // Merges the band starting at curStart with the previous band if they
+  // have the same horizontal layout. Returns the start of the last band.
+  size_t coalesce(size_t prevStart, size_t curStart);
+
+  // Builds this (empty) region from arbitrary rectangles.
+  void buildFromRects(const std::vector<Rect> *rects);
+
+  // Makes room for at least capacity boxes keeping the existing ones.
+  void reserve(size_t capacity);
+  void releaseStorage();
+  inline void appendBox(int x1, int y1, int x2, int y2);
+  void setSingleBox(int x1, int y1, int x2, int y2);
+  // Recalculates m_extents from the boxes.
+  void updateExtents();
+  bool isInline() const;
+
+  RegionBox *m_boxes;
+  size_t m_count;
+  size_t m_capacity;
+  // Bounding box, valid if m_count is not zero.
+  RegionBox m_extents;
+  RegionBox m_inline[INLINE_CAPACITY];
 };
 
 #endif // __REGION_REGION_H_INCLUDED__
@@ -0,0 +1,138 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "RegionBoxPool.h"
+
+#include <new>
+#include <stdlib.h>
+
+RegionBoxPool::FreeBlock *RegionBoxPool::m_freeLists[CLASS_COUNT];
+size_t RegionBoxPool::m_freeCounts[CLASS_COUNT];
+UINT64 RegionBoxPool::m_heapAllocations = 0;
+volatile LONG RegionBoxPool::m_lock = 0;
+
+RegionBox *RegionBoxPool::allocate(size_t minCapacity, size_t *capacity)
+{
+  size_t classIndex = getClass(minCapacity);
+  if (classIndex < CLASS_COUNT) {
+    *capacity = MIN_CAPACITY << classIndex;
+    lock();
+    FreeBlock *block = m_freeLists[classIndex];
+    if (block != 0) {
+      m_freeLists[classIndex] = block->next;
+      m_freeCounts[classIndex]--;
+    } else {
+      m_heapAllocations++;
+    }
+    unlock();
+    if (block != 0) {
+      return (RegionBox *)block;
+    }
+  } else {
+    *capacity = minCapacity;
+    lock();
+    m_heapAllocations++;
+    unlock();
+  }
+
+  RegionBox *boxes = (RegionBox *)malloc(*capacity * sizeof(RegionBox));
+  if (boxes == 0) {
+    throw std::bad_alloc();
+  }
+  return boxes;
+}
+
+void RegionBoxPool::release(RegionBox *boxes, size_t capacity)
+{
+  if (boxes == 0) {
+    return;
+  }
+  size_t classIndex = getClass(capacity);
+  // Only arrays allocated by the pool with exactly the class capacity can
+  // be reused.
+  if (classIndex < CLASS_COUNT && (MIN_CAPACITY << classIndex) == capacity) {
+    lock();
+    if (m_freeCounts[classIndex] < MAX_FREE_PER_CLASS) {
+      FreeBlock *block = (FreeBlock *)boxes;
+      block->next = m_freeLists[classIndex];
+      m_freeLists[classIndex] = block;
+      m_freeCounts[classIndex]++;
+      boxes = 0;
+    }
+    unlock();
+  }
+  free(boxes);
+}
+
+UINT64 RegionBoxPool::getHeapAllocationCount()
+{
+  lock();
+  UINT64 count = m_heapAllocations;
+  unlock();
+  return count;
+}
+
+void RegionBoxPool::trim()
+{
+  FreeBlock *lists[CLASS_COUNT];
+  lock();
+  for (size_t i = 0; i < CLASS_COUNT; i++) {
+    lists[i] = m_freeLists[i];
+    m_freeLists[i] = 0;
+    m_freeCounts[i] = 0;
+  }
+  unlock();
+  for (size_t i = 0; i < CLASS_COUNT; i++) {
+    while (lists[i] != 0) {
+      FreeBlock *next = lists[i]->next;
+      free(lists[i]);
+      lists[i] = next;
+    }
+  }
+}
+
+size_t RegionBoxPool::getClass(size_t capacity)
+{
+  size_t classIndex = 0;
+  size_t classCapacity = MIN_CAPACITY;
+  while (classCapacity < capacity && classIndex < CLASS_COUNT) {
+    classCapacity <<= 1;
+    classIndex++;
+  }
+  return classIndex;
+}
+
+void RegionBoxPool::lock()
+{
+  // The lock is held only for a few instructions, so spinning is cheaper
+  // than a kernel object here.
+  while (InterlockedExchange(&m_lock, 1) != 0) {
+    SwitchToThread();
+  }
+}
+
+void RegionBoxPool::unlock()
+{
+  InterlockedExchange(&m_lock, 0);
+}
@@ -0,0 +1,105 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __REGION_REGIONBOXPOOL_H_INCLUDED__
+#define __REGION_REGIONBOXPOOL_H_INCLUDED__
+
+#include "util/CommonHeader.h"
+
+/**
+ * Rectangle of a Region in the internal representation (left, top, right,
+ * bottom). Unlike Rect, it has no virtual functions and can be copied with
+ * memcpy().
+ */
+struct RegionBox
+{
+  int x1;
+  int y1;
+  int x2;
+  int y2;
+};
+
+/**
+ * Process-wide pool of RegionBox arrays used by Region when its inline
+ * storage is not enough. Arrays are grouped by capacity classes (powers of
+ * two), released arrays are kept in per-class free lists and given out again
+ * without touching the heap. Arrays larger than the biggest class are
+ * allocated and freed directly.
+ *
+ * All functions are thread-safe.
+ */
+class RegionBoxPool
+{
+public:
+  /**
+   * Returns an array for at least minCapacity boxes.
+   * @param capacity [out] real capacity of the returned array, must be
+   * passed to release() together with the array.
+   * @throws std::bad_alloc if there is no memory.
+   */
+  static RegionBox *allocate(size_t minCapacity, size_t *capacity);
+
+  /**
+   * Returns the array to the pool.
+   */
+  static void release(RegionBox *boxes, size_t capacity);
+
+  /**
+   * Returns count of heap allocations made by the pool since the program
+   * start. Pooled reuse of arrays is not counted.
+   */
+  static UINT64 getHeapAllocationCount();
+
+  /**
+   * Frees all arrays kept in the free lists.
+   */
+  static void trim();
+
+private:
+  static const size_t MIN_CAPACITY = 32;
+  static const size_t CLASS_COUNT = 8;
+  // Maximal count of free arrays kept per class.
+  static const size_t MAX_FREE_PER_CLASS = 4;
+
+  // Returns capacity class of the array or CLASS_COUNT if the array is too
+  // big for pooling.
+  static size_t getClass(size_t capacity);
+
+  static void lock();
+  static void unlock();
+
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  static FreeBlock *m_freeLists[CLASS_COUNT];
+  static size_t m_freeCounts[CLASS_COUNT];
+  static UINT64 m_heapAllocations;
+  // Spin lock flag, plain zero-initialized data, so the pool is usable
+  // during static initialization as well.
+  static volatile LONG m_lock;
+};
+
+#endif // __REGION_REGIONBOXPOOL_H_INCLUDED__
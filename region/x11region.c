@@ -167,7 +167,7 @@ SOFTWARE.
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 
-#define xallocData(n)    (RegDataPtr)malloc(REGION_SZOF(n))
+#define xallocData(n)    (RegDataPtr)xalloc(REGION_SZOF(n))
 #define xfreeData(reg)   if ((reg)->data && (reg)->data->size) \
                            free((reg)->data)
 
@@ -215,6 +215,8 @@ if (((numRects) < ((reg)->data->size >> 1)) && ((reg)->data->size > 50)) \
 }
 
 
+unsigned long miHeapAllocations = 0;
+
 BoxRec miEmptyBox = {0, 0, 0, 0};
 RegDataRec miEmptyData = {0, 0};
 
@@ -68,8 +68,15 @@ SOFTWARE.
 
 #define CT_YXBANDED 18
 
-#define xalloc(n)        malloc(n)
-#define xrealloc(ptr, n) realloc((ptr), (n))
+/*
+ * Count of heap allocations made by the region code. Region does not use
+ * this code anymore, it is kept as the reference implementation for
+ * region-bench.
+ */
+extern unsigned long miHeapAllocations;
+
+#define xalloc(n)        (miHeapAllocations++, malloc(n))
+#define xrealloc(ptr, n) (miHeapAllocations++, realloc((ptr), (n)))
 #define xfree(ptr)       free(ptr)
 
 /*
@@ -0,0 +1,306 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "Corpus.h"
+
+#include <math.h>
+
+#include "network/SessionRecordReader.h"
+#include "network/SessionRecordDefs.h"
+#include "rfb/PixelConverter.h"
+#include "util/Exception.h"
+
+Corpus::Corpus()
+: m_seed(12345)
+{
+}
+
+Corpus::~Corpus()
+{
+  for (size_t i = 0; i < m_items.size(); i++) {
+    Item *item = m_items[i];
+    for (size_t j = 0; j < item->frames.size(); j++) {
+      delete item->frames[j];
+    }
+    delete item;
+  }
+}
+
+void Corpus::addSynthetic(const Dimension *dim, int videoFrames)
+{
+  fillText(addFrame(addItem(_T("text")), dim));
+  fillUi(addFrame(addItem(_T("ui")), dim));
+  fillGradient(addFrame(addItem(_T("gradient")), dim));
+  fillPhoto(addFrame(addItem(_T("photo")), dim), 0);
+
+  Item *video = addItem(_T("video"));
+  for (int i = 0; i < videoFrames; i++) {
+    fillPhoto(addFrame(video, dim), i * 3);
+  }
+}
+
+void Corpus::addRecording(const TCHAR *fileName, int maxFrames)
+{
+  SessionRecordReader reader(fileName);
+
+  StringStorage name;
+  name.format(_T("captured:%s"), fileName);
+  Item *item = 0;
+
+  UINT8 type;
+  UINT32 timestamp;
+  std::vector<char> payload;
+  std::vector<char> pixels;
+  PixelFormat serverPf = getServerPixelFormat();
+  PixelConverter converter;
+  while ((int)(item != 0 ? item->frames.size() : 0) < maxFrames &&
+         reader.readRecord(&type, &timestamp, &payload)) {
+    if (type != SessionRecordDefs::REC_KEYFRAME) {
+      continue;
+    }
+    Dimension dim;
+    PixelFormat pf;
+    UINT8 flags;
+    SessionRecordReader::parseKeyFrame(&payload, &dim, &pf, &flags, &pixels);
+    if (dim.width <= 0 || dim.height <= 0) {
+      continue;
+    }
+
+    FrameBuffer recordedFb;
+    recordedFb.setProperties(&dim, &pf);
+    if (pixels.size() != (size_t)recordedFb.getBufferSize()) {
+      throw Exception(_T("Keyframe size does not match its format"));
+    }
+    memcpy(recordedFb.getBuffer(), &pixels.front(), pixels.size());
+
+    if (item == 0) {
+      item = addItem(name.getString());
+    }
+    FrameBuffer *fb = addFrame(item, &dim);
+    Rect rect = dim.getRect();
+    converter.setPixelFormats(&serverPf, &pf);
+    converter.convert(&rect, fb, &recordedFb);
+  }
+  if (item == 0) {
+    StringStorage message;
+    message.format(_T("No keyframes found in %s"), fileName);
+    throw Exception(message.getString());
+  }
+}
+
+size_t Corpus::getItemCount() const
+{
+  return m_items.size();
+}
+
+const Corpus::Item *Corpus::getItem(size_t index) const
+{
+  return m_items[index];
+}
+
+PixelFormat Corpus::getServerPixelFormat()
+{
+  PixelFormat pf;
+  pf.bitsPerPixel = 32;
+  pf.colorDepth = 24;
+  pf.redMax = 255;
+  pf.greenMax = 255;
+  pf.blueMax = 255;
+  pf.redShift = 16;
+  pf.greenShift = 8;
+  pf.blueShift = 0;
+  pf.bigEndian = false;
+  return pf;
+}
+
+Corpus::Item *Corpus::addItem(const TCHAR *name)
+{
+  Item *item = new Item;
+  item->name.setString(name);
+  m_items.push_back(item);
+  return item;
+}
+
+FrameBuffer *Corpus::addFrame(Item *item, const Dimension *dim)
+{
+  FrameBuffer *fb = new FrameBuffer;
+  PixelFormat pf = getServerPixelFormat();
+  fb->setProperties(dim, &pf);
+  item->frames.push_back(fb);
+  return fb;
+}
+
+UINT32 Corpus::random()
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) & 0x7fff;
+}
+
+UINT32 Corpus::makeColor(int r, int g, int b)
+{
+  return (clamp(r) << 16) | (clamp(g) << 8) | clamp(b);
+}
+
+int Corpus::clamp(int value)
+{
+  return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+void Corpus::fillText(FrameBuffer *fb)
+{
+  Dimension dim = fb->getDimension();
+  Rect all = dim.getRect();
+  fb->fillRect(&all, makeColor(255, 255, 255));
+
+  // Lines of pseudo-glyphs with word gaps, mostly black with some colored
+  // (hyperlink-like) words, as in documents and terminals.
+  const int glyphWidth = 7;
+  const int lineHeight = 16;
+  for (int y = 4; y + lineHeight <= dim.height; y += lineHeight) {
+    int lineEnd = dim.width - 8 - (int)(random() % (dim.width / 3 + 1));
+    UINT32 color = 0;
+    for (int x = 8; x + glyphWidth <= lineEnd; x += glyphWidth + 1) {
+      if (random() % 6 == 0) {
+        // Word gap, the next word may get another color.
+        color = random() % 8 == 0 ? makeColor(0, 0, 204) : 0;
+        continue;
+      }
+      drawGlyph(fb, x, y + 2, glyphWidth, lineHeight - 5, color);
+    }
+  }
+}
+
+void Corpus::fillUi(FrameBuffer *fb)
+{
+  Dimension dim = fb->getDimension();
+  Rect all = dim.getRect();
+
+  // Desktop background and a task bar.
+  fb->fillRect(&all, makeColor(58, 110, 165));
+  Rect taskBar(0, dim.height - 30, dim.width, dim.height);
+  drawHorizontalGradient(fb, &taskBar, makeColor(32, 48, 80),
+                         makeColor(64, 96, 144));
+
+  // Overlapping windows with title bars, borders, buttons and text.
+  int windowCount = 5;
+  for (int i = 0; i < windowCount; i++) {
+    int w = dim.width / 3 + (int)(random() % (dim.width / 3 + 1));
+    int h = dim.height / 3 + (int)(random() % (dim.height / 3 + 1));
+    int x = (int)(random() % (dim.width - w + 1));
+    int y = (int)(random() % (dim.height - 30 - h + 1));
+    Rect window(x, y, x + w, y + h);
+    fb->fillRect(&window, makeColor(100, 100, 100));
+    Rect client(x + 1, y + 1, x + w - 1, y + h - 1);
+    fb->fillRect(&client, makeColor(240, 240, 240));
+
+    Rect title(x + 1, y + 1, x + w - 1, y + 24);
+    drawHorizontalGradient(fb, &title, makeColor(0, 84, 227),
+                           makeColor(61, 149, 255));
+    for (int b = 0; b < 3; b++) {
+      Rect button(x + w - 22 * (b + 1), y + 4, x + w - 22 * b - 4, y + 20);
+      fb->fillRect(&button, b == 0 ? makeColor(200, 60, 40)
+                                   : makeColor(220, 220, 220));
+    }
+
+    // Toolbar buttons, input fields and a few text lines.
+    for (int bx = x + 6; bx + 60 < x + w; bx += 66) {
+      Rect button(bx, y + 30, bx + 60, y + 52);
+      fb->fillRect(&button, makeColor(160, 160, 160));
+      Rect face(bx + 1, y + 31, bx + 59, y + 51);
+      fb->fillRect(&face, makeColor(225, 225, 225));
+    }
+    for (int ty = y + 60; ty + 12 < y + h - 4; ty += 16) {
+      for (int tx = x + 8; tx + 6 < x + w - 8; tx += 7) {
+        if (random() % 5 != 0) {
+          drawGlyph(fb, tx, ty, 6, 10, makeColor(20, 20, 20));
+        }
+      }
+    }
+  }
+}
+
+void Corpus::fillGradient(FrameBuffer *fb)
+{
+  Dimension dim = fb->getDimension();
+  UINT32 *pixels = (UINT32 *)fb->getBuffer();
+  for (int y = 0; y < dim.height; y++) {
+    for (int x = 0; x < dim.width; x++) {
+      int r = x * 255 / dim.width;
+      int g = y * 255 / dim.height;
+      int b = 255 - (x + y) * 255 / (dim.width + dim.height);
+      pixels[y * dim.width + x] = makeColor(r, g, b);
+    }
+  }
+}
+
+void Corpus::fillPhoto(FrameBuffer *fb, int phase)
+{
+  Dimension dim = fb->getDimension();
+  UINT32 *pixels = (UINT32 *)fb->getBuffer();
+  for (int y = 0; y < dim.height; y++) {
+    for (int x = 0; x < dim.width; x++) {
+      double u = (x + phase) / 37.0;
+      double v = (y + phase / 2) / 23.0;
+      int noise = (int)(random() % 17) - 8;
+      int r = (int)(128 + 80 * sin(u) * cos(v * 0.7)) + noise;
+      int g = (int)(128 + 70 * sin(u * 0.6 + v)) + noise;
+      int b = (int)(110 + 90 * cos(u * 0.3 - v * 0.9)) + noise;
+      pixels[y * dim.width + x] = makeColor(r, g, b);
+    }
+  }
+}
+
+void Corpus::drawGlyph(FrameBuffer *fb, int x, int y, int w, int h,
+                       UINT32 color)
+{
+  // A random set of vertical and horizontal strokes looks enough like a
+  // glyph for the encoders.
+  UINT32 strokes = random();
+  for (int i = 0; i < 4; i++) {
+    if ((strokes >> i) & 1) {
+      int sx = x + (i * (w - 1)) / 3;
+      Rect stroke(sx, y, sx + 1, y + h);
+      fb->fillRect(&stroke, color);
+    }
+    if ((strokes >> (i + 4)) & 1) {
+      int sy = y + (i * (h - 1)) / 3;
+      Rect stroke(x, sy, x + w - 1, sy + 1);
+      fb->fillRect(&stroke, color);
+    }
+  }
+}
+
+void Corpus::drawHorizontalGradient(FrameBuffer *fb, const Rect *rect,
+                                    UINT32 from, UINT32 to)
+{
+  int width = rect->getWidth();
+  for (int x = rect->left; x < rect->right; x++) {
+    int k = x - rect->left;
+    int r = ((from >> 16 & 0xff) * (width - k) + (to >> 16 & 0xff) * k) / width;
+    int g = ((from >> 8 & 0xff) * (width - k) + (to >> 8 & 0xff) * k) / width;
+    int b = ((from & 0xff) * (width - k) + (to & 0xff) * k) / width;
+    Rect column(x, rect->top, x + 1, rect->bottom);
+    fb->fillRect(&column, makeColor(r, g, b));
+  }
+}
@@ -0,0 +1,96 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _CORPUS_H_
+#define _CORPUS_H_
+
+#include <vector>
+
+#include "rfb/FrameBuffer.h"
+#include "util/StringStorage.h"
+
+//
+// Corpus is a set of named frame sequences used as the input of the encoder
+// benchmark. Synthetic frames are generated by deterministic pseudo-random
+// generators, so that results are comparable between runs and machines.
+// Captured screens are taken from keyframes of session recordings.
+//
+// All frames are stored in the 32-bit pixel format the server grabbers
+// provide (see getServerPixelFormat()).
+//
+
+class Corpus
+{
+public:
+  struct Item
+  {
+    StringStorage name;
+    // Frames of the item, owned by Corpus. Encoding the frames one by one
+    // with the same encoders models consecutive updates of the screen.
+    std::vector<FrameBuffer *> frames;
+  };
+
+  Corpus();
+  virtual ~Corpus();
+
+  // Adds all synthetic items of the given size: "text", "ui", "gradient",
+  // "photo" and "video" (several frames of a moving photo-like picture).
+  void addSynthetic(const Dimension *dim, int videoFrames);
+
+  // Adds keyframes of a session recording as a "captured" item, at most
+  // maxFrames of them. Frames in other pixel formats are converted.
+  // Throws Exception on a file or format error.
+  void addRecording(const TCHAR *fileName, int maxFrames);
+
+  size_t getItemCount() const;
+  const Item *getItem(size_t index) const;
+
+  static PixelFormat getServerPixelFormat();
+
+protected:
+  Item *addItem(const TCHAR *name);
+  FrameBuffer *addFrame(Item *item, const Dimension *dim);
+
+  // Deterministic linear congruential generator.
+  UINT32 random();
+
+  static UINT32 makeColor(int r, int g, int b);
+  static int clamp(int value);
+
+  void fillText(FrameBuffer *fb);
+  void fillUi(FrameBuffer *fb);
+  void fillGradient(FrameBuffer *fb);
+  // Draws a smooth picture with noise, shifted by phase pixels.
+  void fillPhoto(FrameBuffer *fb, int phase);
+
+  // Draws a pseudo-glyph of the given size at (x, y).
+  void drawGlyph(FrameBuffer *fb, int x, int y, int w, int h, UINT32 color);
+  void drawHorizontalGradient(FrameBuffer *fb, const Rect *rect,
+                              UINT32 from, UINT32 to);
+
+  std::vector<Item *> m_items;
+  UINT32 m_seed;
+};
+
+#endif
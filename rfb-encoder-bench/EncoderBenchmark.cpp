@@ -0,0 +1,249 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "EncoderBenchmark.h"
+
+#include "rfb/EncodingDefs.h"
+#include "rfb/MsgDefs.h"
+#include "rfb/PixelConverter.h"
+#include "rfb-sconn/EncoderStore.h"
+#include "rfb-sconn/EncodeOptions.h"
+
+EncoderBenchmark::EncoderBenchmark(const Corpus *corpus)
+: m_corpus(corpus),
+  m_timePerConfig(1.0),
+  m_output(&m_nullStream),
+  m_ticksPerSecond(1)
+{
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+}
+
+EncoderBenchmark::~EncoderBenchmark()
+{
+}
+
+void EncoderBenchmark::setTimePerConfig(double seconds)
+{
+  m_timePerConfig = seconds;
+}
+
+void EncoderBenchmark::setEncodingFilter(const TCHAR *name)
+{
+  m_encodingFilter.setString(name);
+}
+
+void EncoderBenchmark::run(FILE *out)
+{
+  std::vector<ClientFormat> formats = getClientFormats();
+  std::vector<EncoderConfig> configs = getEncoderConfigs();
+
+  writeHeader(out);
+  for (size_t i = 0; i < m_corpus->getItemCount(); i++) {
+    const Corpus::Item *item = m_corpus->getItem(i);
+    for (size_t f = 0; f < formats.size(); f++) {
+      for (size_t c = 0; c < configs.size(); c++) {
+        const EncoderConfig *config = &configs[c];
+        if (!m_encodingFilter.isEmpty() &&
+            _tcsicmp(m_encodingFilter.getString(), config->name) != 0) {
+          continue;
+        }
+        // JpegEncoder falls back to lossless Tight for low color formats,
+        // that would only duplicate the Tight results.
+        if (config->jpeg && formats[f].pf.bitsPerPixel < 16) {
+          continue;
+        }
+        int levelCount = config->hasLevels ? 10 : 1;
+        for (int level = 0; level < levelCount; level++) {
+          Result result;
+          runConfig(item, &formats[f], config, level, &result);
+          writeResult(out, item, &formats[f], config,
+                      config->hasLevels ? level : -1, &result);
+          fflush(out);
+        }
+      }
+    }
+  }
+}
+
+void EncoderBenchmark::runConfig(const Corpus::Item *item,
+                                 const ClientFormat *format,
+                                 const EncoderConfig *config, int level,
+                                 Result *result)
+{
+  PixelFormat serverPf = Corpus::getServerPixelFormat();
+  PixelConverter pixelConverter;
+  pixelConverter.setPixelFormats(&format->pf, &serverPf);
+
+  std::vector<int> encodings;
+  encodings.push_back(config->encoding);
+  if (config->hasLevels) {
+    if (config->jpeg) {
+      encodings.push_back(PseudoEncDefs::QUALITY_LEVEL_0 + level);
+    } else {
+      encodings.push_back(PseudoEncDefs::COMPR_LEVEL_0 + level);
+    }
+  }
+  EncodeOptions encodeOptions;
+  encodeOptions.setEncodings(&encodings);
+
+  // A fresh store per configuration, so the zlib streams start from
+  // scratch as with a new client.
+  EncoderStore encoderStore(&pixelConverter, &m_output);
+  encoderStore.selectEncoder(config->encoding);
+  Encoder *encoder = encoderStore.getEncoder();
+  if (config->jpeg) {
+    encoderStore.validateJpegEncoder();
+    encoder = encoderStore.getJpegEncoder();
+  }
+
+  size_t clientBytesPerPixel = format->pf.bitsPerPixel / 8;
+  INT64 budget = (INT64)(m_timePerConfig * m_ticksPerSecond);
+  INT64 spent = 0;
+  m_nullStream.reset();
+  std::vector<Rect> rects;
+
+  // Whole frame sequences are encoded, at least once.
+  do {
+    for (size_t i = 0; i < item->frames.size(); i++) {
+      const FrameBuffer *frameBuffer = item->frames[i];
+      Dimension dim = frameBuffer->getDimension();
+      Rect frameRect = dim.getRect();
+
+      INT64 startTicks = getTicks();
+
+      rects.clear();
+      encoder->splitRectangle(&frameRect, &rects, frameBuffer,
+                              &encodeOptions);
+      m_output.writeUInt8(ServerMsgDefs::FB_UPDATE);
+      m_output.writeUInt8(0); // padding
+      m_output.writeUInt16((UINT16)rects.size());
+      std::vector<Rect>::iterator it;
+      for (it = rects.begin(); it != rects.end(); it++) {
+        m_output.writeUInt16(it->left);
+        m_output.writeUInt16(it->top);
+        m_output.writeUInt16(it->getWidth());
+        m_output.writeUInt16(it->getHeight());
+        m_output.writeInt32(encoder->getCode());
+        encoder->sendRectangle(&*it, frameBuffer, &encodeOptions);
+      }
+
+      spent += getTicks() - startTicks;
+      result->frames++;
+      result->rawBytes += (UINT64)dim.area() * clientBytesPerPixel;
+    }
+  } while (spent < budget);
+
+  result->encodedBytes = m_nullStream.getWrittenSize();
+  result->seconds = (double)spent / m_ticksPerSecond;
+}
+
+void EncoderBenchmark::writeHeader(FILE *out)
+{
+  _ftprintf(out, _T("corpus,frames,width,height,pixel_format,encoder,level,")
+                 _T("iterations,seconds,mb_per_s,mpixels_per_s,")
+                 _T("bytes_per_frame,ratio\n"));
+}
+
+void EncoderBenchmark::writeResult(FILE *out, const Corpus::Item *item,
+                                   const ClientFormat *format,
+                                   const EncoderConfig *config, int level,
+                                   const Result *result)
+{
+  Dimension dim = item->frames.front()->getDimension();
+  size_t clientBytesPerPixel = format->pf.bitsPerPixel / 8;
+  double pixels = (double)result->rawBytes / clientBytesPerPixel;
+  double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+
+  _ftprintf(out, _T("%s,%u,%d,%d,%s,%s,%d,%I64u,%.4f,%.2f,%.2f,%.1f,%.3f\n"),
+            item->name.getString(),
+            (unsigned int)item->frames.size(),
+            dim.width, dim.height,
+            format->name, config->name, level,
+            result->frames,
+            result->seconds,
+            (double)result->rawBytes / (1024 * 1024) / seconds,
+            pixels / 1000000 / seconds,
+            (double)result->encodedBytes / result->frames,
+            result->encodedBytes != 0 ?
+              (double)result->rawBytes / result->encodedBytes : 0.0);
+}
+
+INT64 EncoderBenchmark::getTicks()
+{
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return counter.QuadPart;
+}
+
+std::vector<EncoderBenchmark::ClientFormat>
+EncoderBenchmark::getClientFormats()
+{
+  std::vector<ClientFormat> formats;
+  ClientFormat format;
+
+  format.name = _T("rgb888");
+  format.pf = Corpus::getServerPixelFormat();
+  formats.push_back(format);
+
+  format.name = _T("rgb565");
+  format.pf.bitsPerPixel = 16;
+  format.pf.colorDepth = 16;
+  format.pf.redMax = 31;
+  format.pf.greenMax = 63;
+  format.pf.blueMax = 31;
+  format.pf.redShift = 11;
+  format.pf.greenShift = 5;
+  format.pf.blueShift = 0;
+  formats.push_back(format);
+
+  format.name = _T("bgr233");
+  format.pf.bitsPerPixel = 8;
+  format.pf.colorDepth = 8;
+  format.pf.redMax = 7;
+  format.pf.greenMax = 7;
+  format.pf.blueMax = 3;
+  format.pf.redShift = 0;
+  format.pf.greenShift = 3;
+  format.pf.blueShift = 6;
+  formats.push_back(format);
+
+  return formats;
+}
+
+std::vector<EncoderBenchmark::EncoderConfig>
+EncoderBenchmark::getEncoderConfigs()
+{
+  EncoderConfig configs[] = {
+    { _T("tight"), EncodingDefs::TIGHT, false, true },
+    { _T("zrle"), EncodingDefs::ZRLE, false, true },
+    { _T("hextile"), EncodingDefs::HEXTILE, false, false },
+    { _T("rre"), EncodingDefs::RRE, false, false },
+    { _T("jpeg"), EncodingDefs::TIGHT, true, true },
+  };
+  return std::vector<EncoderConfig>(configs,
+                                    configs + sizeof(configs) / sizeof(configs[0]));
+}
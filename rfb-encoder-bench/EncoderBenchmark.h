@@ -0,0 +1,117 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _ENCODER_BENCHMARK_H_
+#define _ENCODER_BENCHMARK_H_
+
+#include <vector>
+#include <stdio.h>
+
+#include "io-lib/DataOutputStream.h"
+#include "io-lib/NullOutputStream.h"
+#include "rfb/PixelFormat.h"
+#include "Corpus.h"
+
+//
+// EncoderBenchmark runs the server encoders (Tight, ZRLE, Hextile, RRE and
+// Tight with JPEG) over every frame of a Corpus, for every client pixel
+// format and compression or quality level, and writes one CSV line of
+// results per configuration.
+//
+// The encoded data is sent to a NullOutputStream, exactly as UpdateSender
+// would send it to a client (with rectangle headers), so only the encoders
+// are measured. Each configuration starts with a fresh EncoderStore and
+// runs whole frame sequences until the time budget is spent.
+//
+
+class EncoderBenchmark
+{
+public:
+  EncoderBenchmark(const Corpus *corpus);
+  virtual ~EncoderBenchmark();
+
+  // Sets the minimal time to spend on each configuration.
+  void setTimePerConfig(double seconds);
+
+  // Restricts the benchmark to one encoder name ("tight", "zrle",
+  // "hextile", "rre" or "jpeg"), an empty name means all of them.
+  void setEncodingFilter(const TCHAR *name);
+
+  // Runs all configurations and writes the CSV results to out.
+  void run(FILE *out);
+
+protected:
+  struct ClientFormat
+  {
+    const TCHAR *name;
+    PixelFormat pf;
+  };
+
+  struct EncoderConfig
+  {
+    const TCHAR *name;
+    int encoding;
+    // Encoding is done via JpegEncoder.
+    bool jpeg;
+    // Compression (or JPEG quality) levels are iterated from 0 to 9,
+    // otherwise the encoder has no level and runs once.
+    bool hasLevels;
+  };
+
+  struct Result
+  {
+    Result() : frames(0), rawBytes(0), encodedBytes(0), seconds(0) {}
+
+    UINT64 frames;
+    UINT64 rawBytes;
+    UINT64 encodedBytes;
+    double seconds;
+  };
+
+  // Encodes frames of the item in a loop with a fresh EncoderStore.
+  void runConfig(const Corpus::Item *item, const ClientFormat *format,
+                 const EncoderConfig *config, int level, Result *result);
+
+  static void writeHeader(FILE *out);
+  static void writeResult(FILE *out, const Corpus::Item *item,
+                          const ClientFormat *format,
+                          const EncoderConfig *config, int level,
+                          const Result *result);
+
+  static INT64 getTicks();
+
+  static std::vector<ClientFormat> getClientFormats();
+  static std::vector<EncoderConfig> getEncoderConfigs();
+
+  const Corpus *m_corpus;
+  double m_timePerConfig;
+  StringStorage m_encodingFilter;
+
+  NullOutputStream m_nullStream;
+  DataOutputStream m_output;
+
+  INT64 m_ticksPerSecond;
+};
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "EncoderBenchmark.h"
+#include "util/Exception.h"
+#include <stdio.h>
+
+static void printUsage()
+{
+  _ftprintf(stderr,
+            _T("Usage: rfb-encoder-bench [-s WIDTHxHEIGHT] [-t SECONDS]")
+            _T(" [-f FRAMES] [-e ENCODER] [recording.tvr ...]\n")
+            _T("  -s  size of the synthetic frames (default 1024x768)\n")
+            _T("  -t  minimal time per configuration (default 1)\n")
+            _T("  -f  video frames and captured keyframes per item")
+            _T(" (default 8)\n")
+            _T("  -e  tight, zrle, hextile, rre or jpeg (default all)\n")
+            _T("Results are written to stdout in CSV format.\n"));
+}
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  Dimension dim(1024, 768);
+  double seconds = 1.0;
+  int frames = 8;
+  const TCHAR *encoder = _T("");
+  std::vector<const TCHAR *> recordings;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (_tcscmp(argv[i], _T("-s")) == 0 && hasValue) {
+      if (_stscanf(argv[++i], _T("%dx%d"), &dim.width, &dim.height) != 2 ||
+          dim.width <= 0 || dim.height <= 0) {
+        printUsage();
+        return 1;
+      }
+    } else if (_tcscmp(argv[i], _T("-t")) == 0 && hasValue) {
+      seconds = _tstof(argv[++i]);
+    } else if (_tcscmp(argv[i], _T("-f")) == 0 && hasValue) {
+      frames = _ttoi(argv[++i]);
+    } else if (_tcscmp(argv[i], _T("-e")) == 0 && hasValue) {
+      encoder = argv[++i];
+    } else if (argv[i][0] == _T('-')) {
+      printUsage();
+      return 1;
+    } else {
+      recordings.push_back(argv[i]);
+    }
+  }
+  if (frames < 1) {
+    frames = 1;
+  }
+
+  try {
+    Corpus corpus;
+    corpus.addSynthetic(&dim, frames);
+    for (size_t i = 0; i < recordings.size(); i++) {
+      _ftprintf(stderr, _T("Loading %s\n"), recordings[i]);
+      corpus.addRecording(recordings[i], frames);
+    }
+
+    EncoderBenchmark benchmark(&corpus);
+    benchmark.setTimePerConfig(seconds);
+    benchmark.setEncodingFilter(encoder);
+    benchmark.run(stdout);
+  } catch (Exception &e) {
+    _ftprintf(stderr, _T("Error: %s\n"), e.getMessage());
+    return 1;
+  }
+  return 0;
+}
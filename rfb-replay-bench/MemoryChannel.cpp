@@ -0,0 +1,67 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "MemoryChannel.h"
+
+MemoryChannel::MemoryChannel(const char *buffer, size_t size)
+: m_buffer(buffer),
+  m_size(size),
+  m_position(0)
+{
+}
+
+MemoryChannel::~MemoryChannel()
+{
+}
+
+size_t MemoryChannel::getPosition() const
+{
+  return m_position;
+}
+
+size_t MemoryChannel::getLeft() const
+{
+  return m_size - m_position;
+}
+
+size_t MemoryChannel::read(void *buffer, size_t len) throw(IOException)
+{
+  size_t left = getLeft();
+  if (left == 0) {
+    throw IOException(_T("Unexpected end of the data"));
+  }
+  size_t count = min(len, left);
+  memcpy(buffer, m_buffer + m_position, count);
+  m_position += count;
+  return count;
+}
+
+size_t MemoryChannel::write(const void *buffer, size_t len) throw(IOException)
+{
+  throw IOException(_T("The memory channel is read-only"));
+}
+
+void MemoryChannel::close() throw(Exception)
+{
+}
@@ -0,0 +1,77 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _MEMORY_CHANNEL_H_
+#define _MEMORY_CHANNEL_H_
+
+#include "io-lib/Channel.h"
+#include "io-lib/IOException.h"
+
+/**
+ * Read-only channel over a memory buffer which keeps track of the read
+ * position, so that the caller can tell how many bytes were consumed.
+ */
+class MemoryChannel : public Channel
+{
+public:
+  /**
+   * Creates the channel. The buffer is not copied and must stay valid
+   * during the channel lifetime.
+   */
+  MemoryChannel(const char *buffer, size_t size);
+  virtual ~MemoryChannel();
+
+  /**
+   * Returns the number of bytes read so far.
+   */
+  size_t getPosition() const;
+
+  /**
+   * Returns the number of bytes left to read.
+   */
+  size_t getLeft() const;
+
+  /**
+   * Reads data from the buffer.
+   * @throws IOException when no data left in the buffer.
+   */
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Always throws IOException, the channel is read-only.
+   */
+  virtual size_t write(const void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Does nothing.
+   */
+  virtual void close() throw(Exception);
+
+protected:
+  const char *m_buffer;
+  size_t m_size;
+  size_t m_position;
+};
+
+#endif
@@ -0,0 +1,430 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "ReplayBenchmark.h"
+
+#include <algorithm>
+#include <time.h>
+
+#include "rfb/MsgDefs.h"
+#include "rfb/EncodingDefs.h"
+#include "util/Exception.h"
+#include "viewer-core/DecoderOfRectangle.h"
+#include "viewer-core/RawDecoder.h"
+#include "viewer-core/CopyRectDecoder.h"
+#include "viewer-core/RreDecoder.h"
+#include "viewer-core/HexTileDecoder.h"
+#include "viewer-core/TightDecoder.h"
+#include "viewer-core/ZrleDecoder.h"
+#include "viewer-core/TileCacheDecoder.h"
+
+ReplayBenchmark::ReplayBenchmark()
+: m_log(0),
+  m_decoders(0),
+  m_waitingKeyFrame(false),
+  m_ticksPerSecond(1),
+  m_files(0),
+  m_dataBytes(0),
+  m_skippedBytes(0),
+  m_updates(0),
+  m_gaps(0),
+  m_keyFramesChecked(0),
+  m_keyFramesMismatched(0),
+  m_keyFramesRestarted(0)
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = frequency.QuadPart;
+  }
+#else
+  m_ticksPerSecond = 1000000000;
+#endif
+  resetDecoders();
+}
+
+ReplayBenchmark::~ReplayBenchmark()
+{
+  delete m_decoders;
+}
+
+void ReplayBenchmark::replay(const TCHAR *fileName)
+{
+  SessionRecordReader reader(fileName);
+  m_files++;
+
+  // Each recording starts with fresh decoders, as a new connection does.
+  resetDecoders();
+  m_waitingKeyFrame = false;
+
+  UINT8 type;
+  UINT32 timestamp;
+  std::vector<char> payload;
+  while (reader.readRecord(&type, &timestamp, &payload)) {
+    switch (type) {
+    case SessionRecordDefs::REC_FORMAT:
+      {
+        Dimension dim;
+        PixelFormat pf;
+        SessionRecordReader::parseFormat(&payload, &dim, &pf);
+        setFbProperties(&dim, &pf);
+      }
+      break;
+    case SessionRecordDefs::REC_KEYFRAME:
+      processKeyFrame(&payload);
+      break;
+    case SessionRecordDefs::REC_GAP:
+      m_gaps++;
+      m_waitingKeyFrame = true;
+      break;
+    case SessionRecordDefs::REC_DATA:
+      if (m_waitingKeyFrame) {
+        m_skippedBytes += payload.size();
+      } else {
+        processData(&payload);
+      }
+      break;
+    default:
+      // Unknown records are skipped for compatibility with newer versions.
+      break;
+    }
+  }
+}
+
+void ReplayBenchmark::printReport(FILE *out)
+{
+  UINT64 totalPixels = 0;
+  INT64 totalTicks = 0;
+  std::map<int, EncodingStats>::iterator it;
+  for (it = m_stats.begin(); it != m_stats.end(); it++) {
+    totalPixels += it->second.pixels;
+    totalTicks += it->second.ticks;
+  }
+  double seconds = (double)totalTicks / m_ticksPerSecond;
+
+  _ftprintf(out, _T("Recordings:          %u\n"), m_files);
+  _ftprintf(out, _T("Updates:             %llu\n"),
+            (unsigned long long)m_updates);
+  _ftprintf(out, _T("Data decoded:        %.2f MB\n"),
+            (double)m_dataBytes / (1024 * 1024));
+  _ftprintf(out, _T("Data skipped:        %.2f MB (%u gaps)\n"),
+            (double)m_skippedBytes / (1024 * 1024), m_gaps);
+  _ftprintf(out, _T("Keyframes:           %u checked, %u mismatched,")
+                 _T(" %u used to restart\n"),
+            m_keyFramesChecked, m_keyFramesMismatched, m_keyFramesRestarted);
+  _ftprintf(out, _T("Decoding time:       %.3f s\n"), seconds);
+  if (seconds > 0) {
+    _ftprintf(out, _T("Throughput:          %.2f MB/s, %.2f Mpixels/s\n"),
+              (double)m_dataBytes / (1024 * 1024) / seconds,
+              (double)totalPixels / 1000000 / seconds);
+  }
+  _ftprintf(out, _T("\n"));
+
+  _ftprintf(out, _T("%-10s %10s %12s %12s %10s %9s %9s %9s %9s %9s\n"),
+            _T("encoding"), _T("rects"), _T("pixels"), _T("bytes"),
+            _T("time,ms"), _T("MB/s"), _T("p50,us"), _T("p90,us"),
+            _T("p99,us"), _T("max,us"));
+  for (it = m_stats.begin(); it != m_stats.end(); it++) {
+    EncodingStats *stats = &it->second;
+    std::sort(stats->rectTicks.begin(), stats->rectTicks.end());
+    double encSeconds = (double)stats->ticks / m_ticksPerSecond;
+    double mbPerSecond = encSeconds > 0 ?
+      (double)stats->bytes / (1024 * 1024) / encSeconds : 0;
+    _ftprintf(out, _T("%-10s %10llu %12llu %12llu %10.1f %9.2f")
+                   _T(" %9.1f %9.1f %9.1f %9.1f\n"),
+              getEncodingName(it->first),
+              (unsigned long long)stats->rects,
+              (unsigned long long)stats->pixels,
+              (unsigned long long)stats->bytes,
+              encSeconds * 1000, mbPerSecond,
+              ticksToMicroseconds(getPercentile(&stats->rectTicks, 50)),
+              ticksToMicroseconds(getPercentile(&stats->rectTicks, 90)),
+              ticksToMicroseconds(getPercentile(&stats->rectTicks, 99)),
+              ticksToMicroseconds(getPercentile(&stats->rectTicks, 100)));
+  }
+}
+
+void ReplayBenchmark::onUpdate(const Rect *rect)
+{
+}
+
+void ReplayBenchmark::resetDecoders()
+{
+  delete m_decoders;
+  m_decoders = new DecoderStore(&m_log);
+  m_decoders->addDecoder(new RawDecoder(&m_log), 0);
+  m_decoders->addDecoder(new CopyRectDecoder(&m_log), 10);
+  m_decoders->addDecoder(new RreDecoder(&m_log), 1);
+  m_decoders->addDecoder(new HexTileDecoder(&m_log), 4);
+  m_decoders->addDecoder(new TightDecoder(&m_log), 9);
+  m_decoders->addDecoder(new ZrleDecoder(&m_log), 9);
+  m_decoders->addDecoder(new TileCacheDecoder(&m_log), -1);
+}
+
+void ReplayBenchmark::setFbProperties(const Dimension *dim,
+                                      const PixelFormat *pf)
+{
+  AutoLock al(&m_fbLock);
+  if (!m_frameBuffer.setProperties(dim, pf) ||
+      !m_rectangleFb.setProperties(dim, pf)) {
+    StringStorage errMess;
+    errMess.format(_T("Cannot set frame buffer properties (%dx%d, %d bpp)"),
+                   dim->width, dim->height, (int)pf->bitsPerPixel);
+    throw Exception(errMess.getString());
+  }
+}
+
+void ReplayBenchmark::processKeyFrame(const std::vector<char> *payload)
+{
+  Dimension dim;
+  PixelFormat pf;
+  UINT8 flags;
+  std::vector<char> pixels;
+  SessionRecordReader::parseKeyFrame(payload, &dim, &pf, &flags, &pixels);
+
+  bool canRestart = (flags & SessionRecordDefs::KEYFRAME_DECODERS_RESET) != 0;
+  if (m_waitingKeyFrame) {
+    if (!canRestart) {
+      return;
+    }
+    setFbProperties(&dim, &pf);
+    AutoLock al(&m_fbLock);
+    if (pixels.size() != (size_t)m_frameBuffer.getBufferSize()) {
+      throw Exception(_T("Keyframe size does not match its dimension"));
+    }
+    if (!pixels.empty()) {
+      memcpy(m_frameBuffer.getBuffer(), &pixels.front(), pixels.size());
+    }
+    resetDecoders();
+    m_waitingKeyFrame = false;
+    m_keyFramesRestarted++;
+    return;
+  }
+
+  m_keyFramesChecked++;
+  AutoLock al(&m_fbLock);
+  PixelFormat fbPf = m_frameBuffer.getPixelFormat();
+  if (!m_frameBuffer.getDimension().isEqualTo(&dim) || !fbPf.isEqualTo(&pf) ||
+      pixels.size() != (size_t)m_frameBuffer.getBufferSize() ||
+      (!pixels.empty() &&
+       memcmp(m_frameBuffer.getBuffer(), &pixels.front(), pixels.size()) != 0)) {
+    m_keyFramesMismatched++;
+  }
+}
+
+void ReplayBenchmark::processData(const std::vector<char> *payload)
+{
+  if (payload->empty()) {
+    return;
+  }
+  m_dataBytes += payload->size();
+
+  MemoryChannel channel(&payload->front(), payload->size());
+  RfbInputGate input(&channel);
+
+  // Records are cut at message boundaries, so a record holds a whole
+  // number of messages.
+  while (channel.getLeft() != 0) {
+    UINT8 msgType = input.readUInt8();
+    switch (msgType) {
+    case ServerMsgDefs::FB_UPDATE:
+      processFbUpdate(&input, &channel);
+      break;
+    case ServerMsgDefs::SET_COLOR_MAP_ENTRIES:
+      {
+        input.readUInt8(); // padding
+        input.readUInt16(); // first color
+        UINT16 numberOfColors = input.readUInt16();
+        std::vector<char> colors(numberOfColors * 6 + 1);
+        input.readFully(&colors.front(), numberOfColors * 6);
+      }
+      break;
+    case ServerMsgDefs::BELL:
+      break;
+    case ServerMsgDefs::SERVER_CUT_TEXT:
+      {
+        input.readUInt16(); // padding
+        input.readUInt8();
+        UINT32 length = input.readUInt32();
+        std::vector<char> text(length + 1);
+        input.readFully(&text.front(), length);
+      }
+      break;
+    default:
+      // TightVNC extension messages (e.g. file transfer replies) have
+      // message specific layouts, skip the rest of the record.
+      m_skippedBytes += channel.getLeft();
+      return;
+    }
+  }
+}
+
+void ReplayBenchmark::processFbUpdate(RfbInputGate *input,
+                                      MemoryChannel *channel)
+{
+  m_updates++;
+
+  input->readUInt8(); // padding
+  UINT16 numberOfRectangles = input->readUInt16();
+  for (int i = 0; i < numberOfRectangles; i++) {
+    if (processRect(input, channel)) {
+      break;
+    }
+  }
+}
+
+bool ReplayBenchmark::processRect(RfbInputGate *input, MemoryChannel *channel)
+{
+  Rect rect;
+  rect.left = input->readUInt16();
+  rect.top = input->readUInt16();
+  rect.setWidth(input->readUInt16());
+  rect.setHeight(input->readUInt16());
+  int encoding = input->readInt32();
+
+  if (encoding == PseudoEncDefs::LAST_RECT) {
+    return true;
+  }
+  if (Decoder::isPseudo(encoding)) {
+    processPseudoRect(input, &rect, encoding);
+    return false;
+  }
+
+  if (!m_frameBuffer.getDimension().getRect().intersection(&rect).isEqualTo(&rect)) {
+    throw Exception(_T("Error in protocol: incorrect size of rectangle"));
+  }
+  DecoderOfRectangle *decoder =
+    dynamic_cast<DecoderOfRectangle *>(m_decoders->getDecoder(encoding));
+  if (decoder == 0) {
+    StringStorage errMess;
+    errMess.format(_T("Unsupported encoding: %d"), encoding);
+    throw Exception(errMess.getString());
+  }
+
+  size_t startPosition = channel->getPosition();
+  INT64 startTicks = getTicks();
+  decoder->process(input, &m_frameBuffer, &m_rectangleFb, &rect, &m_fbLock,
+                   this);
+  INT64 rectTicks = getTicks() - startTicks;
+
+  EncodingStats *stats = &m_stats[encoding];
+  stats->rects++;
+  stats->pixels += rect.area();
+  stats->bytes += channel->getPosition() - startPosition;
+  stats->ticks += rectTicks;
+  stats->rectTicks.push_back(rectTicks);
+  return false;
+}
+
+void ReplayBenchmark::processPseudoRect(RfbInputGate *input, const Rect *rect,
+                                        int encoding)
+{
+  switch (encoding) {
+  case PseudoEncDefs::DESKTOP_SIZE:
+    {
+      Dimension dim(rect);
+      PixelFormat pf = m_frameBuffer.getPixelFormat();
+      setFbProperties(&dim, &pf);
+    }
+    break;
+  case PseudoEncDefs::RICH_CURSOR:
+    {
+      size_t cursorLen = rect->area() * m_frameBuffer.getBytesPerPixel();
+      if (cursorLen != 0) {
+        size_t bitmaskLen = ((rect->getWidth() + 7) / 8) * rect->getHeight();
+        std::vector<char> cursor(cursorLen + bitmaskLen);
+        input->readFully(&cursor.front(), cursor.size());
+      }
+    }
+    break;
+  case PseudoEncDefs::X_CURSOR:
+    if (rect->area() != 0) {
+      size_t bitmaskLen = ((rect->getWidth() + 7) / 8) * rect->getHeight();
+      std::vector<char> cursor(6 + bitmaskLen * 2);
+      input->readFully(&cursor.front(), cursor.size());
+    }
+    break;
+  case PseudoEncDefs::POINTER_POS:
+    break;
+  default:
+    {
+      StringStorage errMess;
+      errMess.format(_T("Unsupported pseudo encoding: %d"), encoding);
+      throw Exception(errMess.getString());
+    }
+  }
+}
+
+INT64 ReplayBenchmark::getTicks()
+{
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  if (QueryPerformanceCounter(&counter) == 0) {
+    return 0;
+  }
+  return counter.QuadPart;
+#else
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+    return 0;
+  }
+  return (INT64)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+const TCHAR *ReplayBenchmark::getEncodingName(int encoding)
+{
+  switch (encoding) {
+  case EncodingDefs::RAW:
+    return _T("Raw");
+  case EncodingDefs::COPYRECT:
+    return _T("CopyRect");
+  case EncodingDefs::RRE:
+    return _T("RRE");
+  case EncodingDefs::HEXTILE:
+    return _T("Hextile");
+  case EncodingDefs::TIGHT:
+    return _T("Tight");
+  case EncodingDefs::ZRLE:
+    return _T("ZRLE");
+  case PseudoEncDefs::TILE_CACHE:
+    return _T("TileCache");
+  }
+  return _T("Unknown");
+}
+
+INT64 ReplayBenchmark::getPercentile(const std::vector<INT64> *sorted,
+                                     int percentile)
+{
+  if (sorted->empty()) {
+    return 0;
+  }
+  size_t index = (sorted->size() - 1) * percentile / 100;
+  return (*sorted)[index];
+}
+
+double ReplayBenchmark::ticksToMicroseconds(INT64 ticks) const
+{
+  return (double)ticks * 1000000 / m_ticksPerSecond;
+}
@@ -0,0 +1,132 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _REPLAY_BENCHMARK_H_
+#define _REPLAY_BENCHMARK_H_
+
+#include <map>
+#include <vector>
+#include <stdio.h>
+
+#include "log-writer/LogWriter.h"
+#include "network/RfbInputGate.h"
+#include "network/SessionRecordReader.h"
+#include "rfb/FrameBuffer.h"
+#include "thread/LocalMutex.h"
+#include "viewer-core/DecoderStore.h"
+#include "viewer-core/FbUpdateListener.h"
+#include "MemoryChannel.h"
+
+//
+// ReplayBenchmark feeds server to client streams recorded by SessionRecorder
+// through the viewer-core decoders into a frame buffer, the same way
+// RemoteViewerCore does it, but without network and GUI. It measures the
+// time spent in the decoders and collects per-encoding statistics.
+//
+// Recordings are replayed from the beginning. After a gap in the recording
+// the data is skipped up to the next keyframe that allows restarting the
+// decoders. Other keyframes are compared with the decoded frame buffer to
+// catch decoding errors (mismatches are expected for lossy JPEG updates).
+//
+
+class ReplayBenchmark : public FbUpdateListener
+{
+public:
+  ReplayBenchmark();
+  virtual ~ReplayBenchmark();
+
+  // Replays one recording file and adds the results to the statistics.
+  // Throws Exception on a file or protocol error.
+  void replay(const TCHAR *fileName);
+
+  // Prints the statistics collected by all replay() calls.
+  void printReport(FILE *out);
+
+  // Inherited from FbUpdateListener.
+  // The frame buffer is only checked against keyframes, so there is
+  // nothing to do with updated rectangles.
+  virtual void onUpdate(const Rect *rect);
+
+protected:
+  struct EncodingStats
+  {
+    EncodingStats() : rects(0), pixels(0), bytes(0), ticks(0) {}
+
+    UINT64 rects;
+    UINT64 pixels;
+    UINT64 bytes;
+    INT64 ticks;
+    // Decoding time of every rectangle, used for percentiles.
+    std::vector<INT64> rectTicks;
+  };
+
+  // (Re)creates all decoders, so that their zlib streams start from
+  // scratch.
+  void resetDecoders();
+
+  void setFbProperties(const Dimension *dim, const PixelFormat *pf);
+
+  void processKeyFrame(const std::vector<char> *payload);
+  void processData(const std::vector<char> *payload);
+
+  void processFbUpdate(RfbInputGate *input, MemoryChannel *channel);
+  // Returns true if it was a LastRect pseudo-rectangle.
+  bool processRect(RfbInputGate *input, MemoryChannel *channel);
+  void processPseudoRect(RfbInputGate *input, const Rect *rect,
+                         int encoding);
+
+  // Returns a monotonic time in m_ticksPerSecond units.
+  static INT64 getTicks();
+  static const TCHAR *getEncodingName(int encoding);
+  // Returns the value at the given percentile (0..100) of sorted values.
+  static INT64 getPercentile(const std::vector<INT64> *sorted,
+                             int percentile);
+  double ticksToMicroseconds(INT64 ticks) const;
+
+  LogWriter m_log;
+
+  DecoderStore *m_decoders;
+  FrameBuffer m_frameBuffer;
+  FrameBuffer m_rectangleFb;
+  LocalMutex m_fbLock;
+
+  // Set after a gap, the data is skipped until a keyframe with reset
+  // decoders.
+  bool m_waitingKeyFrame;
+
+  std::map<int, EncodingStats> m_stats;
+
+  INT64 m_ticksPerSecond;
+
+  unsigned int m_files;
+  UINT64 m_dataBytes;
+  UINT64 m_skippedBytes;
+  UINT64 m_updates;
+  unsigned int m_gaps;
+  unsigned int m_keyFramesChecked;
+  unsigned int m_keyFramesMismatched;
+  unsigned int m_keyFramesRestarted;
+};
+
+#endif
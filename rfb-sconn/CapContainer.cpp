@@ -72,3 +72,10 @@ bool CapContainer::includes(UINT32 code) const
   }
   return result;
 }
+
+void CapContainer::getCodes(std::vector<UINT32> *codes) const
+{
+  for (CapVectorConstIter iter = m_caps.begin(); iter < m_caps.end(); iter++) {
+    codes->push_back((*iter).code);
+  }
+}
@@ -54,6 +54,9 @@ public:
 
   bool includes(UINT32 code) const;
 
+  // Appends codes of all capabilities to the codes vector.
+  void getCodes(std::vector<UINT32> *codes) const;
+
 private:
   CapVector m_caps;
 };
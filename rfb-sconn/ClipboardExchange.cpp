@@ -101,7 +101,7 @@ void ClipboardExchange::execute()
     if (m_hasNewClip && !isTerminating() && !m_viewOnly) {
 
       try {
-        AutoLock al(m_output);
+        AutoLock al(m_output->getClassLock(RfbOutputGate::CLASS_CLIPBOARD));
         m_output->writeUInt8(ServerMsgDefs::SERVER_CUT_TEXT); // type
         m_output->writeUInt8(0); // pad
         m_output->writeUInt16(0); // pad
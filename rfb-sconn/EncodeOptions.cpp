@@ -26,6 +26,7 @@
 #include "rfb/EncodingDefs.h"
 
 EncodeOptions::EncodeOptions()
+: m_zlibTuner(0)
 {
   reset();
 }
@@ -50,6 +51,7 @@ void EncodeOptions::reset()
   m_enableRichCursor = false;
   m_enablePointerPos = false;
   m_enableDesktopSize = false;
+  m_enableTileCache = false;
 }
 
 void EncodeOptions::setEncodings(std::vector<int> *list)
@@ -81,6 +83,8 @@ void EncodeOptions::setEncodings(std::vector<int> *list)
       m_enablePointerPos = true;
     } else if (code == PseudoEncDefs::DESKTOP_SIZE) {
       m_enableDesktopSize = true;
+    } else if (code == PseudoEncDefs::TILE_CACHE) {
+      m_enableTileCache = true;
     } else if (code >= PseudoEncDefs::COMPR_LEVEL_0 &&
                code <= PseudoEncDefs::COMPR_LEVEL_9) {
       int level = code - PseudoEncDefs::COMPR_LEVEL_0;
@@ -131,6 +135,11 @@ bool EncodeOptions::jpegEnabled() const
   return (m_jpegQualityLevel != EO_DEFAULT);
 }
 
+void EncodeOptions::disableJpeg()
+{
+  m_jpegQualityLevel = EO_DEFAULT;
+}
+
 bool EncodeOptions::copyRectEnabled() const
 {
   return m_enableCopyRect;
@@ -151,6 +160,21 @@ bool EncodeOptions::desktopSizeEnabled() const
   return m_enableDesktopSize;
 }
 
+bool EncodeOptions::tileCacheEnabled() const
+{
+  return m_enableTileCache;
+}
+
+void EncodeOptions::setZlibTuner(ZlibTuner *tuner)
+{
+  m_zlibTuner = tuner;
+}
+
+ZlibTuner *EncodeOptions::getZlibTuner() const
+{
+  return m_zlibTuner;
+}
+
 bool EncodeOptions::normalEncoding(int code)
 {
   return (code == EncodingDefs::RAW ||
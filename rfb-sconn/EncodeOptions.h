@@ -27,6 +27,8 @@
 
 #include <vector>
 
+class ZlibTuner;
+
 class EncodeOptions
 {
 public:
@@ -70,6 +72,10 @@ public:
   // false otherwise.
   bool jpegEnabled() const;
 
+  // Forget the JPEG quality level so that the encoders use only lossless
+  // compression, as if the client has not requested JPEG.
+  void disableJpeg();
+
   //
   // Accessor functions to boolean values.
   //
@@ -78,6 +84,14 @@ public:
   bool richCursorEnabled() const;
   bool pointerPosEnabled() const;
   bool desktopSizeEnabled() const;
+  bool tileCacheEnabled() const;
+
+  // Set the object choosing zlib parameters for the encoders. When it is
+  // not set (by default), the encoders use their static tables indexed by
+  // the compression level. The object is not owned by EncodeOptions, it is
+  // kept by the reset() call.
+  void setZlibTuner(ZlibTuner *tuner);
+  ZlibTuner *getZlibTuner() const;
 
 protected:
 
@@ -104,6 +118,9 @@ protected:
   bool m_enableRichCursor;
   bool m_enablePointerPos;
   bool m_enableDesktopSize;
+  bool m_enableTileCache;
+
+  ZlibTuner *m_zlibTuner;
 };
 
 #endif // __RFB_ENCODE_OPTIONS_H_INCLUDED__
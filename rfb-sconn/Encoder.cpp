@@ -39,6 +39,11 @@ int Encoder::getCode() const
   return EncodingDefs::RAW;
 }
 
+bool Encoder::resetCompression()
+{
+  return true;
+}
+
 void Encoder::splitRectangle(const Rect *rect,
                              std::vector<Rect> *rectList,
                              const FrameBuffer *serverFb,
@@ -63,6 +63,14 @@ public:
   // protocol specification.
   virtual int getCode() const;
 
+  // Reset the internal compression state (e.g. zlib streams) so that the
+  // data sent after this call can be decoded by a decoder created from
+  // scratch, provided the decoder honors the reset requests of the
+  // encoding. Returns false if this encoder has a state that cannot be
+  // reset this way. The default implementation has no state to reset and
+  // returns true.
+  virtual bool resetCompression();
+
   // splitRectangle() is used to let the encoder split one big rectangle to a
   // number of smaller ones for efficient encoding or for satisfying the
   // limitations on maximum rectangle width and height. The resulting list of
@@ -77,11 +85,15 @@ public:
   // region, then calls sendRectangle() for the same list of rectangles.
   //
   // The arguments of splitRectangle() are similar to those of
-  // sendRectangle(). It's guaranteed that options and serverFb will point to
-  // the same data as in the subsequent calls to sendRectanle(). Also, it's
-  // guaranteed that the state of m_pixelConverter will not be changed between
-  // splitRectangle() and sendRectangle() calls. splitRectangles() may change
-  // the state of PixelConverter that's why it cannot be declared const.
+  // sendRectangle(). It's guaranteed that options and the pixel format of
+  // serverFb will be the same as in the subsequent calls to sendRectanle(),
+  // but the splitting must not depend on the pixels of serverFb: UpdateSender
+  // reads the pixels of each resulting rectangle into a frame buffer of its
+  // own and passes the rectangle moved to (0, 0) to sendRectangle(). Also,
+  // it's guaranteed that the state of m_pixelConverter will not be changed
+  // between splitRectangle() and sendRectangle() calls. splitRectangles() may
+  // change the state of PixelConverter that's why it cannot be declared
+  // const.
   virtual void splitRectangle(const Rect *rect,
                               std::vector<Rect> *rectList,
                               const FrameBuffer *serverFb,
@@ -73,6 +73,20 @@ void EncoderStore::validateJpegEncoder()
   }
 }
 
+bool EncoderStore::resetCompression()
+{
+  // JpegEncoder is not checked here, it works via TightEncoder which is
+  // always in m_map.
+  bool result = true;
+  std::map<int, Encoder *>::iterator it;
+  for (it = m_map.begin(); it != m_map.end(); it++) {
+    if (!it->second->resetCompression()) {
+      result = false;
+    }
+  }
+  return result;
+}
+
 //---------------------------- Internal methods ----------------------------//
 
 Encoder *EncoderStore::validateEncoder(int encType)
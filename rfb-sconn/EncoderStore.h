@@ -63,6 +63,11 @@ public:
   void selectEncoder(int encType);
   void validateJpegEncoder();
 
+  // Reset compression state of all allocated encoders (see
+  // Encoder::resetCompression()). Returns true if all of them could be
+  // reset.
+  bool resetCompression();
+
 protected:
   // This function makes sure the specified encoder is allocated and stored in
   // m_map. If it's already there, this function returns a pointer to the
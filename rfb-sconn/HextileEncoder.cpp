@@ -72,8 +72,9 @@ void HextileEncoder::hextileFunction(const Rect &r,
                                      const FrameBuffer *frameBuffer)
 {
   Rect t;
-  PIXEL_T *buf;
-  FrameBuffer fb;
+  // Pixels of the current tile, stored without gaps between rows.
+  PIXEL_T buf[16 * 16];
+  const int fbStride = frameBuffer->getDimension().width;
   PIXEL_T oldBg = 0, oldFg = 0;
   bool oldBgValid = false;
   bool oldFgValid = false;
@@ -89,9 +90,11 @@ void HextileEncoder::hextileFunction(const Rect &r,
 
       t.right = min(r.right, t.left + 16);
 
-      fb.setProperties(&t, &frameBuffer->getPixelFormat());
-      fb.copyFrom(frameBuffer, t.left, t.top);
-      buf = (PIXEL_T *)fb.getBuffer();
+      const PIXEL_T *src = (const PIXEL_T *)frameBuffer->getBufferPtr(t.left, t.top);
+      for (int y = 0; y < t.getHeight(); y++) {
+        memcpy(&buf[y * t.getWidth()], src, t.getWidth() * sizeof(PIXEL_T));
+        src += fbStride;
+      }
 
       tile.newTile(buf, t.getWidth(), t.getHeight());
       int tileType = tile.getFlags();
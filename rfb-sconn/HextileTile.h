@@ -28,6 +28,85 @@
 #include "TightPalette.h"
 #include "util/inttypes.h"
 #include <crtdbg.h>
+#include <intrin.h>
+
+// SSE2 is always present on x64 and is enabled by /arch:SSE2 on x86.
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEXTILE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+//
+// Row masks of a tile. Bit x of a row mask is set when the pixel x of
+// the row has the specified color. A complete 16-pixel row is compared
+// with SSE2 instructions, other rows are compared pixel by pixel.
+//
+
+inline UINT16 getHextileRowMask(const UINT8 *row, int w, UINT8 color)
+{
+#ifdef HEXTILE_USE_SSE2
+  if (w == 16) {
+    __m128i c = _mm_set1_epi8((char)color);
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)row), c);
+    return (UINT16)_mm_movemask_epi8(eq);
+  }
+#endif
+  UINT16 mask = 0;
+  for (int x = 0; x < w; x++) {
+    mask |= (UINT16)((row[x] == color) << x);
+  }
+  return mask;
+}
+
+inline UINT16 getHextileRowMask(const UINT16 *row, int w, UINT16 color)
+{
+#ifdef HEXTILE_USE_SSE2
+  if (w == 16) {
+    __m128i c = _mm_set1_epi16((short)color);
+    __m128i eq0 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)row), c);
+    __m128i eq1 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)row + 1), c);
+    return (UINT16)_mm_movemask_epi8(_mm_packs_epi16(eq0, eq1));
+  }
+#endif
+  UINT16 mask = 0;
+  for (int x = 0; x < w; x++) {
+    mask |= (UINT16)((row[x] == color) << x);
+  }
+  return mask;
+}
+
+inline UINT16 getHextileRowMask(const UINT32 *row, int w, UINT32 color)
+{
+#ifdef HEXTILE_USE_SSE2
+  if (w == 16) {
+    __m128i c = _mm_set1_epi32((int)color);
+    const __m128i *src = (const __m128i *)row;
+    __m128i eq0 = _mm_cmpeq_epi32(_mm_loadu_si128(src), c);
+    __m128i eq1 = _mm_cmpeq_epi32(_mm_loadu_si128(src + 1), c);
+    __m128i eq2 = _mm_cmpeq_epi32(_mm_loadu_si128(src + 2), c);
+    __m128i eq3 = _mm_cmpeq_epi32(_mm_loadu_si128(src + 3), c);
+    // Saturating packs keep 0 and -1 values, so one byte per pixel remains.
+    __m128i eq = _mm_packs_epi16(_mm_packs_epi32(eq0, eq1),
+                                 _mm_packs_epi32(eq2, eq3));
+    return (UINT16)_mm_movemask_epi8(eq);
+  }
+#endif
+  UINT16 mask = 0;
+  for (int x = 0; x < w; x++) {
+    mask |= (UINT16)((row[x] == color) << x);
+  }
+  return mask;
+}
+
+//
+// Returns the index of the least significant bit set in a non-zero mask.
+//
+inline int getHextileLowestBit(unsigned long mask)
+{
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+}
 
 template<class PIXEL_T> class HextileTile
 {
@@ -79,6 +158,13 @@ public:
   //
   void analyze();
 
+  //
+  // Return the row mask of the tile row y for the color.
+  //
+  UINT16 getRowMask(int y, PIXEL_T color) const {
+    return getHextileRowMask(&m_tile[y * m_width], m_width, color);
+  }
+
   const PIXEL_T *m_tile;
   int m_width;
   int m_height;
@@ -94,7 +180,6 @@ public:
 
  private:
 
-  bool m_processed[16][16];
   TightPalette m_pal;
 };
 
@@ -123,23 +208,22 @@ template<class PIXEL_T> void HextileTile<PIXEL_T>::analyze()
 {
   _ASSERT(m_tile && m_width && m_height);
 
-  const PIXEL_T *ptr = m_tile;
-  const PIXEL_T *end = &m_tile[m_width * m_height];
-  PIXEL_T color = *ptr++;
-  while (ptr != end && *ptr == color)
-    ptr++;
+  const UINT16 fullRow = (UINT16)((1 << m_width) - 1);
+
+  // Compute number of complete rows of the same color, at the top
+  PIXEL_T color = m_tile[0];
+  int y = 0;
+  while (y < m_height && getRowMask(y, color) == fullRow)
+    y++;
 
   // Handle solid tile
-  if (ptr == end) {
-    m_background = m_tile[0];
+  if (y == m_height) {
+    m_background = color;
     m_flags = 0;
     m_size = 0;
     return;
   }
 
-  // Compute number of complete rows of the same color, at the top
-  int y = (int)(ptr - m_tile) / m_width;
-
   PIXEL_T *colorsPtr = m_colors;
   UINT8 *coordsPtr = m_coords;
   m_pal.reset();
@@ -154,31 +238,27 @@ template<class PIXEL_T> void HextileTile<PIXEL_T>::analyze()
     m_numSubrects++;
   }
 
-  memset(m_processed, 0, 16 * 16 * sizeof(bool));
+  // Bit x of processed[y] is set when the pixel is covered by a subrect
+  // which starts in one of the rows above.
+  UINT16 processed[16];
+  memset(processed, 0, sizeof(processed));
 
-  int x, sx, sy, sw, sh, max_x;
+  int x, sy, sw, sh;
 
   for (; y < m_height; y++) {
-    for (x = 0; x < m_width; x++) {
-      // Skip pixels that were processed earlier
-      if (m_processed[y][x]) {
-        continue;
-      }
+    unsigned long todo = fullRow & ~processed[y];
+    while (todo != 0) {
+      x = getHextileLowestBit(todo);
+
       // Determine dimensions of the horizontal subrect
       color = m_tile[y * m_width + x];
-      for (sx = x + 1; sx < m_width; sx++) {
-        if (m_tile[y * m_width + sx] != color)
-          break;
-      }
-      sw = sx - x;
-      max_x = sx;
+      unsigned long run = ~((unsigned long)getRowMask(y, color) >> x);
+      sw = getHextileLowestBit(run);
+      UINT16 spanMask = (UINT16)(((1 << sw) - 1) << x);
       for (sy = y + 1; sy < m_height; sy++) {
-        for (sx = x; sx < max_x; sx++) {
-          if (m_tile[sy * m_width + sx] != color)
-            goto done;
-        }
+        if ((getRowMask(sy, color) & spanMask) != spanMask)
+          break;
       }
-    done:
       sh = sy - y;
 
       // Save properties of this subrect
@@ -197,12 +277,11 @@ template<class PIXEL_T> void HextileTile<PIXEL_T>::analyze()
 
       // Mark pixels of this subrect as processed, below this row
       for (sy = y + 1; sy < y + sh; sy++) {
-        for (sx = x; sx < x + sw; sx++)
-          m_processed[sy][sx] = true;
+        processed[sy] |= spanMask;
       }
 
       // Skip processed pixels of this row
-      x += (sw - 1);
+      todo &= ~((1UL << (x + sw)) - 1);
     }
   }
 
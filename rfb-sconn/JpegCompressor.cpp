@@ -162,8 +162,9 @@ StandardJpegCompressor::initDestination()
 bool
 StandardJpegCompressor::emptyOutputBuffer()
 {
+  // Double the buffer, it is kept for the next images.
   size_t oldSize = m_numBytesAllocated;
-  size_t newSize = oldSize + ALLOC_CHUNK_SIZE;
+  size_t newSize = oldSize * 2;
 
   m_outputBuffer = (unsigned char *)realloc(m_outputBuffer, newSize);
   m_numBytesAllocated = newSize;
@@ -214,8 +215,13 @@ StandardJpegCompressor::compress(const void *buf,
     (fmt->bitsPerPixel == 32 && fmt->colorDepth == 24 &&
      fmt->redMax == 255 && fmt->greenMax == 255 && fmt->blueMax == 255);
 
+  J_COLOR_SPACE colorSpace = getDirectColorSpace(fmt);
+  bool passRowsDirectly = colorSpace != JCS_RGB;
+
   m_jpeg.cinfo.image_width = w;
   m_jpeg.cinfo.image_height = h;
+  m_jpeg.cinfo.in_color_space = colorSpace;
+  m_jpeg.cinfo.input_components = passRowsDirectly ? 4 : 3;
 
   if (m_newQuality != m_quality) {
     jpeg_set_quality(&m_jpeg.cinfo, m_newQuality, true);
@@ -227,10 +233,14 @@ StandardJpegCompressor::compress(const void *buf,
   const char *src = (const char *)buf;
 
   // We'll pass up to 8 rows to jpeg_write_scanlines().
-  JSAMPLE *rgb = new JSAMPLE[w * 3 * 8];
   JSAMPROW rowPointer[8];
-  for (int i = 0; i < 8; i++)
-    rowPointer[i] = &rgb[w * 3 * i];
+  if (!passRowsDirectly) {
+    if (m_rgbRows.size() < (size_t)w * 3 * 8) {
+      m_rgbRows.resize((size_t)w * 3 * 8);
+    }
+    for (int i = 0; i < 8; i++)
+      rowPointer[i] = &m_rgbRows[w * 3 * i];
+  }
 
   // Feed the pixels to the JPEG library.
   while (m_jpeg.cinfo.next_scanline < m_jpeg.cinfo.image_height) {
@@ -239,7 +249,10 @@ StandardJpegCompressor::compress(const void *buf,
       maxRows = 8;
     }
     for (int dy = 0; dy < maxRows; dy++) {
-      if (useQuickConversion) {
+      if (passRowsDirectly) {
+        // The library does not modify the input rows.
+        rowPointer[dy] = (JSAMPROW)src;
+      } else if (useQuickConversion) {
         convertRow24(rowPointer[dy], src, fmt, w);
       } else {
         convertRow(rowPointer[dy], src, fmt, w);
@@ -249,8 +262,6 @@ StandardJpegCompressor::compress(const void *buf,
     jpeg_write_scanlines(&m_jpeg.cinfo, rowPointer, maxRows);
   }
 
-  delete[] rgb;
-
   jpeg_finish_compress(&m_jpeg.cinfo);
 }
 
@@ -264,6 +275,34 @@ const char *StandardJpegCompressor::getOutputData()
   return (const char *)m_outputBuffer;
 }
 
+J_COLOR_SPACE
+StandardJpegCompressor::getDirectColorSpace(const PixelFormat *fmt)
+{
+#ifdef JCS_EXTENSIONS
+  if (fmt->bitsPerPixel != 32 || fmt->colorDepth != 24 || fmt->bigEndian ||
+      fmt->redMax != 255 || fmt->greenMax != 255 || fmt->blueMax != 255 ||
+      fmt->redShift % 8 != 0 || fmt->greenShift % 8 != 0 ||
+      fmt->blueShift % 8 != 0) {
+    return JCS_RGB;
+  }
+  // Pixels are in the little-endian byte order (checked above), so the
+  // byte holding a color component has the index of its shift divided by 8.
+  int redByte = fmt->redShift / 8;
+  int greenByte = fmt->greenShift / 8;
+  int blueByte = fmt->blueShift / 8;
+  if (redByte == 0 && greenByte == 1 && blueByte == 2) {
+    return JCS_EXT_RGBX;
+  } else if (redByte == 2 && greenByte == 1 && blueByte == 0) {
+    return JCS_EXT_BGRX;
+  } else if (redByte == 1 && greenByte == 2 && blueByte == 3) {
+    return JCS_EXT_XRGB;
+  } else if (redByte == 3 && greenByte == 2 && blueByte == 1) {
+    return JCS_EXT_XBGR;
+  }
+#endif
+  return JCS_RGB;
+}
+
 void
 StandardJpegCompressor::convertRow24(JSAMPLE *dst, const void *src,
                                      const PixelFormat *fmt, int numPixels)
@@ -26,6 +26,7 @@
 #define __RFB_JPEG_COMPRESSOR_H_INCLUDED__
 
 #include <stdio.h>
+#include <vector>
 
 #include "util/CommonHeader.h"
 #include "rfb/PixelFormat.h"
@@ -115,6 +116,16 @@ protected:
   size_t m_numBytesAllocated;
   size_t m_numBytesReady;
 
+  // Buffer for up to 8 converted rows, it only grows and is reused by
+  // subsequent compress() calls.
+  std::vector<JSAMPLE> m_rgbRows;
+
+  // Return the extended color space of libjpeg-turbo which describes the
+  // pixel format byte for byte, so that the rows of the pixel buffer can be
+  // passed to the library without conversion. Return JCS_RGB if there is no
+  // such color space or the library does not support extended color spaces.
+  static J_COLOR_SPACE getDirectColorSpace(const PixelFormat *fmt);
+
   // Convert one row (scanline) from the specified pixel format to the format
   // supported by the IJG JPEG library (one byte per one color component).
   void convertRow(JSAMPLE *dst, const void *src,
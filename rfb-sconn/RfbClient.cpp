@@ -30,6 +30,8 @@
 #include "RfbInitializer.h"
 #include "ClientAuthListener.h"
 #include "server-config-lib/Configurator.h"
+#include "file-lib/File.h"
+#include "util/DateTime.h"
 
 RfbClient::RfbClient(NewConnectionEvents *newConnectionEvents,
                      SocketIPv4 *socket,
@@ -159,6 +161,33 @@ void RfbClient::onTerminate()
   disconnect();
 }
 
+SessionRecorder *RfbClient::createSessionRecorder(ServerConfig *config)
+{
+  StringStorage recordDir;
+  config->getSessionRecordDir(&recordDir);
+  if (recordDir.isEmpty()) {
+    return 0;
+  }
+
+  SYSTEMTIME st;
+  DateTime::now().toLocalSystemTime(&st);
+  StringStorage fileName;
+  fileName.format(_T("session-%u-%04d%02d%02d-%02d%02d%02d.tvr"), m_id,
+                  st.wYear, st.wMonth, st.wDay,
+                  st.wHour, st.wMinute, st.wSecond);
+  File recordFile(recordDir.getString(), fileName.getString());
+  StringStorage pathToFile;
+  recordFile.getPath(&pathToFile);
+
+  try {
+    return new SessionRecorder(pathToFile.getString(), m_log);
+  } catch (Exception &e) {
+    m_log->error(_T("Cannot start session recording to %s: %s"),
+                 pathToFile.getString(), e.getMessage());
+  }
+  return 0;
+}
+
 void RfbClient::execute()
 {
   // Initialized by default message that will be logged on normal way
@@ -179,6 +208,7 @@ void RfbClient::execute()
   RfbInputGate input(&sockStream);
 
   FileTransferRequestHandler *fileTransfer = 0;
+  SessionRecorder *recorder = 0;
 
   RfbInitializer rfbInitializer(&sockStream, m_extAuthListener, this,
                                 !m_isOutgoing);
@@ -256,6 +286,14 @@ void RfbClient::execute()
                                   &encCaps, &Dimension(&viewPort), &pf);
     m_log->debug(_T("RFB initialization phase 2 completed"));
 
+    // Start session recording, it does not include the initialization
+    // phase, the recording starts with the pixel format record.
+    recorder = createSessionRecorder(config);
+    if (recorder != 0) {
+      AutoLock al(&output);
+      output.setRecorder(recorder);
+    }
+
     // Start normal phase
     setClientState(IN_NORMAL_PHASE);
 
@@ -281,14 +319,18 @@ void RfbClient::execute()
   if (m_clientInputHandler) delete m_clientInputHandler;
   if (m_updateSender)       delete m_updateSender;
 
+  if (recorder != 0) {
+    output.setRecorder(0);
+    delete recorder;
+  }
+
   // Let the client manager remove us from the client lists.
   notifyAbStateChanging(IN_READY_TO_REMOVE);
 }
 
-void RfbClient::sendUpdate(const UpdateContainer *updateContainer,
-                           const CursorShape *cursorShape)
+void RfbClient::sendUpdate(UpdateSnapshot *snapshot)
 {
-  m_updateSender->newUpdates(updateContainer, cursorShape);
+  m_updateSender->newUpdates(snapshot);
 }
 
 void RfbClient::sendClipboard(const StringStorage *newClipboard)
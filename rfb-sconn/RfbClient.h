@@ -30,9 +30,11 @@
 #include "win-system/WindowsEvent.h"
 #include "thread/Thread.h"
 #include "network/RfbOutputGate.h"
+#include "network/SessionRecorder.h"
 #include "desktop/Desktop.h"
 #include "fb-update-sender/UpdateSender.h"
 #include "log-writer/LogWriter.h"
+#include "server-config-lib/ServerConfig.h"
 
 #include "RfbDispatcher.h"
 #include "ClipboardExchange.h"
@@ -88,8 +90,8 @@ public:
   void changeDynViewPort(const ViewPortState *dynViewPort);
 
   bool clientIsReady() const { return m_updateSender->clientIsReady(); }
-  void sendUpdate(const UpdateContainer *updateContainer,
-                  const CursorShape *cursorShape);
+  // Passes the update snapshot to the update sender of this client.
+  void sendUpdate(UpdateSnapshot *snapshot);
   void sendClipboard(const StringStorage *newClipboard);
 
 protected:
@@ -112,6 +114,11 @@ private:
 
   void setClientState(ClientState newState);
 
+  // Creates a recorder for this session if session recording is enabled in
+  // the server configuration. Returns 0 if recording is disabled or the
+  // recording file cannot be created.
+  SessionRecorder *createSessionRecorder(ServerConfig *config);
+
   Rect getViewPortRect(const Dimension *fbDimension);
   virtual void onGetViewPort(Rect *viewRect, bool *shareApp, Region *shareAppRegion);
   void getViewPortInfo(const Dimension *fbDimension, Rect *resultRect,
@@ -25,9 +25,11 @@
 #include "TightEncoder.h"
 
 #include "io-lib/ByteArrayOutputStream.h"
+#include "ZlibTuner.h"
 
 TightEncoder::TightEncoder(PixelConverter *conv, DataOutputStream *output)
-: Encoder(conv, output)
+: Encoder(conv, output),
+  m_zsResetFlags(0)
 {
   for (int i = 0; i < NUM_ZLIB_STREAMS; i++) {
     m_zsActive[i] = false;
@@ -48,6 +50,20 @@ int TightEncoder::getCode() const
   return EncodingDefs::TIGHT;
 }
 
+bool TightEncoder::resetCompression()
+{
+  for (int i = 0; i < NUM_ZLIB_STREAMS; i++) {
+    if (m_zsActive[i]) {
+      deflateEnd(&m_zsStruct[i]);
+      m_zsActive[i] = false;
+    }
+    // The decoder should reset its stream as well, even if it was never
+    // used by the encoder.
+    m_zsResetFlags |= (UINT8)(1 << i);
+  }
+  return true;
+}
+
 void TightEncoder::splitRectangle(const Rect *rect,
                                   std::vector<Rect> *rectList,
                                   const FrameBuffer *serverFb,
@@ -161,7 +177,7 @@ void TightEncoder::sendSolidRect(const Rect *r, const FrameBuffer *fb)
     pixelSize = 3;
   }
 
-  m_output->writeUInt8(SUBENCODING_FILL);
+  sendControl(SUBENCODING_FILL);
   m_output->writeFully(buf, pixelSize);
 }
 
@@ -172,7 +188,7 @@ void TightEncoder::sendMonoRect(const Rect *rect,
 {
   // Send control info.
   const int zlibStreamId = ZLIB_STREAM_MONO;
-  m_output->writeUInt8(EXPLICIT_FILTER | zlibStreamId << 4);
+  sendControl(EXPLICIT_FILTER | zlibStreamId << 4);
   m_output->writeUInt8(FILTER_PALETTE);
   m_output->writeUInt8(1); // the number of colors minus 1
 
@@ -202,7 +218,8 @@ void TightEncoder::sendMonoRect(const Rect *rect,
 
   // Compress and send.
   int zlibLevel = getConf(options).monoZlibLevel;
-  sendCompressed(encoded.toByteArray(), dataLen, zlibStreamId, zlibLevel);
+  sendCompressed(encoded.toByteArray(), dataLen, zlibStreamId, zlibLevel,
+                 options->getZlibTuner());
 }
 
 template <class PIXEL_T>
@@ -212,7 +229,7 @@ void TightEncoder::sendIndexedRect(const Rect *rect,
 {
   // Send control info.
   const int zlibStreamId = ZLIB_STREAM_IDX;
-  m_output->writeUInt8(EXPLICIT_FILTER | zlibStreamId << 4);
+  sendControl(EXPLICIT_FILTER | zlibStreamId << 4);
   m_output->writeUInt8(FILTER_PALETTE);
   int numColors = m_pal.getNumColors();
   m_output->writeUInt8((UINT8)(numColors - 1));
@@ -242,7 +259,8 @@ void TightEncoder::sendIndexedRect(const Rect *rect,
 
   // Compress and send.
   int zlibLevel = getConf(options).idxZlibLevel;
-  sendCompressed(encoded.toByteArray(), dataLen, zlibStreamId, zlibLevel);
+  sendCompressed(encoded.toByteArray(), dataLen, zlibStreamId, zlibLevel,
+                 options->getZlibTuner());
 }
 
 template <class PIXEL_T>
@@ -252,7 +270,7 @@ void TightEncoder::sendFullColorRect(const Rect *rect,
 {
   // Send control info.
   const int zlibStreamId = ZLIB_STREAM_RAW;
-  m_output->writeUInt8(zlibStreamId << 4);
+  sendControl(zlibStreamId << 4);
 
   // Prepare output buffer.
   int dataLen = rect->area() * sizeof(PIXEL_T);
@@ -274,7 +292,7 @@ void TightEncoder::sendFullColorRect(const Rect *rect,
   int zlibLevel = getConf(options).rawZlibLevel;
   // FIXME: Get rid of explicit conversions between chars and bytes.
   sendCompressed((const char *)&rgbData.front(), rgbData.size(),
-                 zlibStreamId, zlibLevel);
+                 zlibStreamId, zlibLevel, options->getZlibTuner());
 }
 
 void TightEncoder::sendJpegRect(const Rect *rect,
@@ -301,7 +319,7 @@ void TightEncoder::sendJpegRect(const Rect *rect,
   size_t dataLength = m_compressor.getOutputLength();
 
   // Actually send the encoded data.
-  m_output->writeUInt8(SUBENCODING_JPEG);
+  sendControl(SUBENCODING_JPEG);
   sendCompactLength(dataLength);
   m_output->writeFully(m_compressor.getOutputData(), dataLength);
 }
@@ -466,14 +484,33 @@ void TightEncoder::encodeIndexedRect(const Rect *rect, const FrameBuffer *fb,
   }
 }
 
+void TightEncoder::sendControl(UINT8 control)
+{
+  m_output->writeUInt8(control | m_zsResetFlags);
+  m_zsResetFlags = 0;
+}
+
 void TightEncoder::sendCompressed(const char *data, size_t dataLen,
-                                  int streamId, int zlibLevel)
+                                  int streamId, int zlibLevel,
+                                  ZlibTuner *tuner)
 {
   if (dataLen < TIGHT_MIN_TO_COMPRESS) {
     m_output->writeFully(data, dataLen);
     return;
   }
 
+  // The tuner replaces the parameters of the static configuration.
+  int tunerStream = ZlibTuner::STREAM_RAW;
+  if (streamId == ZLIB_STREAM_MONO) {
+    tunerStream = ZlibTuner::STREAM_MONO;
+  } else if (streamId == ZLIB_STREAM_IDX) {
+    tunerStream = ZlibTuner::STREAM_INDEXED;
+  }
+  int zlibStrategy = Z_DEFAULT_STRATEGY;
+  if (tuner != 0) {
+    tuner->getParams(tunerStream, zlibLevel, &zlibLevel, &zlibStrategy);
+  }
+
   z_streamp pz = &m_zsStruct[streamId];
 
   // Initialize compression stream if needed.
@@ -483,13 +520,14 @@ void TightEncoder::sendCompressed(const char *data, size_t dataLen,
     pz->opaque = Z_NULL;
 
     int err = deflateInit2(pz, zlibLevel, Z_DEFLATED, MAX_WBITS,
-                           MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+                           MAX_MEM_LEVEL, zlibStrategy);
     if (err != Z_OK) {
       throw IOException(_T("Zlib stream initialization failed in Tight encoder"));
     }
 
     m_zsActive[streamId] = true;
     m_zsLevel[streamId] = zlibLevel;
+    m_zsStrategy[streamId] = zlibStrategy;
   }
 
   // Prepare buffers.
@@ -506,22 +544,29 @@ void TightEncoder::sendCompressed(const char *data, size_t dataLen,
   pz->avail_out = (unsigned int)compressedBufferSize;
 
   // Change compression parameters if needed.
-  if (zlibLevel != m_zsLevel[streamId]) {
-    int err = deflateParams(pz, zlibLevel, Z_DEFAULT_STRATEGY);
+  if (zlibLevel != m_zsLevel[streamId] ||
+      zlibStrategy != m_zsStrategy[streamId]) {
+    int err = deflateParams(pz, zlibLevel, zlibStrategy);
     if (err != Z_OK) {
       throw IOException(_T("Error configuring Zlib stream in Tight encoder"));
     }
     m_zsLevel[streamId] = zlibLevel;
+    m_zsStrategy[streamId] = zlibStrategy;
   }
 
   // Actual compression.
+  INT64 startTicks = tuner != 0 ? ZlibTuner::getTicks() : 0;
   int err = deflate(pz, Z_SYNC_FLUSH);
   if (err != Z_OK || pz->avail_in != 0 || pz->avail_out == 0) {
       throw IOException(_T("Zlib compression failed in Tight encoder"));
   }
+  size_t compressedLength = compressedBufferSize - pz->avail_out;
+  if (tuner != 0) {
+    tuner->addSample(tunerStream, dataLen, compressedLength,
+                     ZlibTuner::getTicks() - startTicks);
+  }
 
   try {
-    size_t compressedLength = compressedBufferSize - pz->avail_out;
     sendCompactLength(compressedLength);
     m_output->writeFully(compressedData, compressedLength);
   } catch (...) {
@@ -32,6 +32,8 @@
 #include "TightPalette.h"
 #include "JpegCompressor.h"
 
+class ZlibTuner;
+
 class TightEncoder : public Encoder
 {
   friend class JpegEncoder;
@@ -42,6 +44,10 @@ public:
 
   virtual int getCode() const;
 
+  // Destroys all zlib streams. The reset flags are sent to the client
+  // together with the next rectangle so that it resets its streams too.
+  virtual bool resetCompression();
+
   // Splits big rectangles according to the configuration setings (m_conf)
   // corresponding to the compression level set in EncodeOptions.
   virtual void splitRectangle(const Rect *rect,
@@ -122,9 +128,17 @@ protected:
     void encodeIndexedRect(const Rect *rect, const FrameBuffer *fb,
                            DataOutputStream *out) throw(IOException);
 
+  // Send the compression control byte, adding pending stream reset flags
+  // to its lower bits.
+  void sendControl(UINT8 control) throw(IOException);
+
+  // Compress the data with the zlib stream and send it. The zlibLevel comes
+  // from the static configuration, the tuner (if not 0) may change it and
+  // the strategy.
   // FIXME: Throw ZlibException instead.
   void sendCompressed(const char *data, size_t dataLen,
-                      int streamId, int zlibLevel) throw(IOException);
+                      int streamId, int zlibLevel,
+                      ZlibTuner *tuner) throw(IOException);
 
   // Send the number of the compressed bytes following. The number (dataLen)
   // is represented by a variable-length code (1..3 bytes).
@@ -176,6 +190,11 @@ protected:
   // initialized.
   bool m_zsActive[NUM_ZLIB_STREAMS];
   int m_zsLevel[NUM_ZLIB_STREAMS];
+  int m_zsStrategy[NUM_ZLIB_STREAMS];
+
+  // Bit mask of zlib streams that should be reset on the decoder side, sent
+  // in the next compression control byte.
+  UINT8 m_zsResetFlags;
 
   // Color palette which maps color samples to color indexes and keeps track
   // of the number of colors allocated.
@@ -0,0 +1,264 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "ZlibTuner.h"
+
+#include "zlib/zlib.h"
+
+// Mono and indexed data is a sequence of small values with long runs,
+// Z_RLE compresses it nearly as well as level 1 and much faster.
+const ZlibTuner::Rung ZlibTuner::m_indexedLadder[] = {
+  { 1, Z_RLE },
+  { 1, Z_DEFAULT_STRATEGY },
+  { 3, Z_DEFAULT_STRATEGY },
+  { 5, Z_DEFAULT_STRATEGY },
+  { 6, Z_DEFAULT_STRATEGY },
+  { 7, Z_DEFAULT_STRATEGY },
+  { 9, Z_DEFAULT_STRATEGY }
+};
+
+// Long matches are rare in true color pixels, Z_FILTERED does not spend
+// time on lazy matching of the short ones at middle levels. Z_RLE is left
+// for the case of the exhausted CPU budget only.
+const ZlibTuner::Rung ZlibTuner::m_rawLadder[] = {
+  { 1, Z_RLE },
+  { 1, Z_DEFAULT_STRATEGY },
+  { 3, Z_DEFAULT_STRATEGY },
+  { 5, Z_FILTERED },
+  { 6, Z_FILTERED },
+  { 7, Z_DEFAULT_STRATEGY },
+  { 9, Z_DEFAULT_STRATEGY }
+};
+
+const ZlibTuner::Rung ZlibTuner::m_mixedLadder[] = {
+  { 1, Z_DEFAULT_STRATEGY },
+  { 2, Z_DEFAULT_STRATEGY },
+  { 3, Z_DEFAULT_STRATEGY },
+  { 5, Z_DEFAULT_STRATEGY },
+  { 6, Z_DEFAULT_STRATEGY },
+  { 7, Z_DEFAULT_STRATEGY },
+  { 9, Z_DEFAULT_STRATEGY }
+};
+
+ZlibTuner::ZlibTuner()
+: m_cpuBudget(DEFAULT_CPU_BUDGET_PERCENT / 100.0),
+  m_ticksPerSecond(0),
+  m_periodStart(0),
+  m_periodBytesSent(0),
+  m_periodSendSeconds(0),
+  m_periodStarted(false),
+  m_linkSpeed(0)
+{
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    m_streams[i].rung = -1;
+    m_streams[i].baseLevel = -1;
+    m_streams[i].inputBytes = 0;
+    m_streams[i].outputBytes = 0;
+    m_streams[i].ticks = 0;
+  }
+  LARGE_INTEGER frequency;
+  if (QueryPerformanceFrequency(&frequency) != 0) {
+    m_ticksPerSecond = (double)frequency.QuadPart;
+  }
+}
+
+ZlibTuner::~ZlibTuner()
+{
+}
+
+void ZlibTuner::setCpuBudget(double cpuBudget)
+{
+  m_cpuBudget = cpuBudget;
+}
+
+void ZlibTuner::getParams(int stream, int baseLevel, int *level, int *strategy)
+{
+  *level = baseLevel;
+  *strategy = Z_DEFAULT_STRATEGY;
+  if (baseLevel <= 0 || m_ticksPerSecond == 0) {
+    return;
+  }
+
+  StreamState *state = &m_streams[stream];
+  // Start over from the client level when it is changed by SetEncodings.
+  if (state->rung < 0 || state->baseLevel != baseLevel) {
+    state->baseLevel = baseLevel;
+    state->rung = findRung(stream, baseLevel);
+  }
+  int rungCount;
+  const Rung *ladder = getLadder(stream, &rungCount);
+  *level = ladder[state->rung].level;
+  *strategy = ladder[state->rung].strategy;
+}
+
+void ZlibTuner::addSample(int stream, size_t inputSize, size_t outputSize,
+                          INT64 ticks)
+{
+  StreamState *state = &m_streams[stream];
+  state->inputBytes += inputSize;
+  state->outputBytes += outputSize;
+  state->ticks += ticks;
+}
+
+void ZlibTuner::addOutputStats(UINT64 bytesSent, double sendSeconds)
+{
+  if (m_ticksPerSecond == 0) {
+    return;
+  }
+  INT64 now = getTicks();
+  if (!m_periodStarted) {
+    m_periodStart = now;
+    m_periodBytesSent = bytesSent;
+    m_periodSendSeconds = sendSeconds;
+    m_periodStarted = true;
+    return;
+  }
+
+  double periodSeconds = (double)(now - m_periodStart) / m_ticksPerSecond;
+  if (periodSeconds * 1000 < PERIOD_MILLISECONDS) {
+    return;
+  }
+
+  double periodSendSeconds = sendSeconds - m_periodSendSeconds;
+  UINT64 periodBytesSent = bytesSent - m_periodBytesSent;
+  // The time spent in the link is only informative when the link holds the
+  // sender back, otherwise it measures copying to the socket buffer.
+  if (periodSendSeconds > periodSeconds * LINK_BUSY_PERCENT / 100) {
+    m_linkSpeed = (double)periodBytesSent / periodSendSeconds;
+  }
+
+  decide(periodSeconds, periodSendSeconds);
+
+  m_periodStart = now;
+  m_periodBytesSent = bytesSent;
+  m_periodSendSeconds = sendSeconds;
+}
+
+double ZlibTuner::getLinkSpeed() const
+{
+  return m_linkSpeed;
+}
+
+INT64 ZlibTuner::getTicks()
+{
+  LARGE_INTEGER counter;
+  if (QueryPerformanceCounter(&counter) == 0) {
+    return 0;
+  }
+  return counter.QuadPart;
+}
+
+const ZlibTuner::Rung *ZlibTuner::getLadder(int stream, int *rungCount)
+{
+  switch (stream) {
+  case STREAM_MONO:
+  case STREAM_INDEXED:
+    *rungCount = sizeof(m_indexedLadder) / sizeof(Rung);
+    return m_indexedLadder;
+  case STREAM_RAW:
+    *rungCount = sizeof(m_rawLadder) / sizeof(Rung);
+    return m_rawLadder;
+  default:
+    *rungCount = sizeof(m_mixedLadder) / sizeof(Rung);
+    return m_mixedLadder;
+  }
+}
+
+int ZlibTuner::findRung(int stream, int level)
+{
+  int rungCount;
+  const Rung *ladder = getLadder(stream, &rungCount);
+  int rung = 0;
+  for (int i = 0; i < rungCount; i++) {
+    if (ladder[i].level <= level) {
+      rung = i;
+    }
+  }
+  return rung;
+}
+
+bool ZlibTuner::stepUp(int stream)
+{
+  int rungCount;
+  getLadder(stream, &rungCount);
+  StreamState *state = &m_streams[stream];
+  if (state->rung < 0 || state->rung + 1 >= rungCount) {
+    return false;
+  }
+  state->rung++;
+  return true;
+}
+
+bool ZlibTuner::stepDown(int stream, int lowestRung)
+{
+  StreamState *state = &m_streams[stream];
+  if (state->rung <= lowestRung) {
+    return false;
+  }
+  state->rung--;
+  return true;
+}
+
+void ZlibTuner::decide(double periodSeconds, double sendSeconds)
+{
+  // Find the streams which took the most CPU time and produced the most
+  // bytes: stepping them gives the biggest effect.
+  INT64 totalTicks = 0;
+  int costliest = -1;
+  int biggest = -1;
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    StreamState *state = &m_streams[i];
+    if (state->inputBytes != 0) {
+      totalTicks += state->ticks;
+      if (costliest < 0 || state->ticks > m_streams[costliest].ticks) {
+        costliest = i;
+      }
+      if (biggest < 0 ||
+          state->outputBytes > m_streams[biggest].outputBytes) {
+        biggest = i;
+      }
+    }
+  }
+
+  if (costliest >= 0) {
+    double cpuLoad = (double)totalTicks / m_ticksPerSecond / periodSeconds;
+    double linkLoad = sendSeconds / periodSeconds;
+
+    if (cpuLoad > m_cpuBudget) {
+      stepDown(costliest, 0);
+    } else if (linkLoad * 100 >= LINK_BUSY_PERCENT) {
+      // Going one rung up costs roughly a half more of CPU time.
+      if (cpuLoad * 1.5 < m_cpuBudget) {
+        stepUp(biggest);
+      }
+    } else if (linkLoad * 100 < LINK_IDLE_PERCENT) {
+      stepDown(costliest, IDLE_LOWEST_RUNG);
+    }
+  }
+
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    m_streams[i].inputBytes = 0;
+    m_streams[i].outputBytes = 0;
+    m_streams[i].ticks = 0;
+  }
+}
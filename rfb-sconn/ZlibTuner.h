@@ -0,0 +1,141 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __RFB_ZLIB_TUNER_H_INCLUDED__
+#define __RFB_ZLIB_TUNER_H_INCLUDED__
+
+#include "util/CommonHeader.h"
+
+// ZlibTuner chooses zlib level and strategy for the compression streams of
+// one client. The encoders report how long the compression took and how
+// well it compressed, the update sender reports how busy the network link
+// is. Once in a period the tuner moves one stream a step along its ladder of
+// zlib parameters:
+//   - down, if the compression takes more CPU time than the budget allows;
+//   - up, if the link is congested and the CPU budget has enough headroom;
+//   - down, if the link is idle, as spending CPU time on bytes gives nothing.
+// The encoders get the tuner via EncodeOptions::getZlibTuner().
+class ZlibTuner
+{
+public:
+  // Kinds of compressed data, each one is tuned independently.
+  static const int STREAM_MONO = 0;
+  static const int STREAM_INDEXED = 1;
+  static const int STREAM_RAW = 2;
+  static const int STREAM_MIXED = 3;
+  static const int NUM_STREAMS = 4;
+
+  ZlibTuner();
+  virtual ~ZlibTuner();
+
+  // Sets the share of one processor the compression of this client may
+  // take, in the range (0..1].
+  void setCpuBudget(double cpuBudget);
+
+  // Returns zlib level and strategy to be used for the next data of the
+  // stream. The baseLevel is the level the static configuration of the
+  // encoder gives, the tuning starts from it. Level 0 (no compression) is
+  // never tuned, the client has asked for it.
+  void getParams(int stream, int baseLevel, int *level, int *strategy);
+
+  // Reports compression of inputSize bytes into outputSize bytes which
+  // took the given number of ticks (see getTicks()).
+  void addSample(int stream, size_t inputSize, size_t outputSize,
+                 INT64 ticks);
+
+  // Reports the total counters of the output of the client (see
+  // RfbOutputGate::getBytesSent() and getSendSeconds()). The tuning
+  // decisions are made here.
+  void addOutputStats(UINT64 bytesSent, double sendSeconds);
+
+  // Returns the speed of the link (in bytes per second) measured while it
+  // was congested, or 0 if it has not been measured yet.
+  double getLinkSpeed() const;
+
+  // High resolution timer used to measure the compression time.
+  static INT64 getTicks();
+
+private:
+  struct Rung {
+    int level;
+    int strategy;
+  };
+
+  struct StreamState {
+    // Current rung of the ladder, -1 until the stream is used first time.
+    int rung;
+    // Compression level requested by the client for the current rung.
+    int baseLevel;
+    // Compression statistics of the current period.
+    UINT64 inputBytes;
+    UINT64 outputBytes;
+    INT64 ticks;
+  };
+
+  // Returns the ladder of the stream and the number of its rungs.
+  static const Rung *getLadder(int stream, int *rungCount);
+
+  // Returns the highest rung which level does not exceed the given one.
+  static int findRung(int stream, int level);
+
+  // Moves the stream one rung up or down if it is possible.
+  // Returns true if the rung has been changed.
+  bool stepUp(int stream);
+  bool stepDown(int stream, int lowestRung);
+
+  // Makes a tuning decision for the period which has passed and starts
+  // a new one.
+  void decide(double periodSeconds, double sendSeconds);
+
+  StreamState m_streams[NUM_STREAMS];
+
+  double m_cpuBudget;
+  double m_ticksPerSecond;
+
+  // Start of the current period and output counters at that moment.
+  INT64 m_periodStart;
+  UINT64 m_periodBytesSent;
+  double m_periodSendSeconds;
+  bool m_periodStarted;
+
+  double m_linkSpeed;
+
+  static const Rung m_indexedLadder[];
+  static const Rung m_rawLadder[];
+  static const Rung m_mixedLadder[];
+
+  // Period of the tuning decisions.
+  static const int PERIOD_MILLISECONDS = 1000;
+  // Share of one processor used when no budget is set.
+  static const int DEFAULT_CPU_BUDGET_PERCENT = 25;
+  // Share of the period the sender may be blocked by the link for the link
+  // to be considered idle, and the share starting from which it is
+  // considered congested.
+  static const int LINK_IDLE_PERCENT = 2;
+  static const int LINK_BUSY_PERCENT = 20;
+  // Lowest rung an idle link moves a stream to. Lower rungs are left for
+  // the case of the exhausted CPU budget.
+  static const int IDLE_LOWEST_RUNG = 1;
+};
+
+#endif // __RFB_ZLIB_TUNER_H_INCLUDED__
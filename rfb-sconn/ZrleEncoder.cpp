@@ -23,15 +23,15 @@
 //
 
 #include "ZrleEncoder.h"
+#include "ZlibTuner.h"
 
 ZrleEncoder::ZrleEncoder(PixelConverter *conv, DataOutputStream *output)
 : Encoder(conv, output),
-  // FIXME: This values (zlib options) is not used now.
-  // May be to improve Deflater class?
-  // FIXME: To make some experiments with other zlib values in the future.
-  m_idxZlibLevel(ZLIB_IDX_LEVEL_DEFAULT),
-  m_monoZlibLevel(ZLIB_MONO_LEVEL_DEFAULT),
-  m_rawZlibLevel(ZLIB_RAW_LEVEL_DEFAULT),
+  m_clientFb(0),
+  m_tilesPerRow(0),
+  m_tileSlotSize(0),
+  m_workerPool(0),
+  m_pixelMask(0),
   m_bytesPerPixel(0),
   m_numberFirstByte(0)
 {
@@ -39,6 +39,12 @@ ZrleEncoder::ZrleEncoder(PixelConverter *conv, DataOutputStream *output)
 
 ZrleEncoder::~ZrleEncoder()
 {
+  if (m_workerPool != 0) {
+    WorkerPool::releaseShared();
+  }
+  for (size_t i = 0; i < m_palettes.size(); i++) {
+    delete m_palettes[i];
+  }
 }
 
 int ZrleEncoder::getCode() const
@@ -46,6 +52,11 @@ int ZrleEncoder::getCode() const
   return EncodingDefs::ZRLE;
 }
 
+bool ZrleEncoder::resetCompression()
+{
+  return false;
+}
+
 void ZrleEncoder::splitRectangle(const Rect *rect,
                                  std::vector<Rect> *rectList,
                                  const FrameBuffer *serverFb,
@@ -64,20 +75,24 @@ void ZrleEncoder::sendRectangle(const Rect *rect,
   // Used for futher work with CPIXELs.
   m_bytesPerPixel = 0;
   m_numberFirstByte = 0;
-  const FrameBuffer *clientFb = m_pixelConverter->convert(rect, serverFb);
+  m_clientFb = m_pixelConverter->convert(rect, serverFb);
   //client pixel format
-  m_pxFormat = clientFb->getPixelFormat();
+  PixelFormat pxFormat = m_clientFb->getPixelFormat();
   //server pixel format
   PixelFormat serverPxFormat = serverFb->getPixelFormat();
-  bool bigEndianDiffs = m_pxFormat.bigEndian != serverPxFormat.bigEndian;
-  if (m_pxFormat.bitsPerPixel == 8) {
+  bool bigEndianDiffs = pxFormat.bigEndian != serverPxFormat.bigEndian;
+  UINT32 colorMaxValue =  pxFormat.blueMax  << pxFormat.blueShift  |
+                          pxFormat.greenMax << pxFormat.greenShift |
+                          pxFormat.redMax   << pxFormat.redShift;
+  if (pxFormat.bitsPerPixel == 8) {
     m_bytesPerPixel = 1;
-  } else if (m_pxFormat.bitsPerPixel == 16) {
+  } else if (pxFormat.bitsPerPixel == 16) {
     m_bytesPerPixel = 2;
-  } else if (m_pxFormat.bitsPerPixel == 32) {
-    UINT32 colorMaxValue =  m_pxFormat.blueMax  << m_pxFormat.blueShift  |
-                            m_pxFormat.greenMax << m_pxFormat.greenShift |
-                            m_pxFormat.redMax   << m_pxFormat.redShift;
+    //from big-endian to local
+    if (bigEndianDiffs) {
+      colorMaxValue = ntohs((UINT16)colorMaxValue);
+    }
+  } else if (pxFormat.bitsPerPixel == 32) {
     //from big-endian to local
     if (bigEndianDiffs) {
       colorMaxValue = ntohl(colorMaxValue);
@@ -93,424 +108,366 @@ void ZrleEncoder::sendRectangle(const Rect *rect,
       m_bytesPerPixel = 4;
       m_numberFirstByte = 0;
     }
-  }
- 
-  // Reserve data once for potentional transmitting of whole frame buffer
-  // in raw encoding with CPIXELs.
-  // If vector will be small it will be resized automatically.
-  m_rgbData.reserve(rect->area() * 3);
-  
-  m_fbWidth = clientFb->getDimension().width;
-  size_t bpp = clientFb->getBitsPerPixel();
-  if (bpp == 8) {
-    sendRect<UINT8>(rect, serverFb, clientFb, options);
-  } else if (bpp == 16) {
-    sendRect<UINT16>(rect, serverFb, clientFb, options);
-  } else if (bpp == 32) {
-    sendRect<UINT32>(rect, serverFb, clientFb, options);
   } else {
     _ASSERT(0);
+    return;
   }
-}
-
-template <class PIXEL_T>
-void ZrleEncoder::sendRect(const Rect *rect,
-                           const FrameBuffer *serverFb,
-                           const FrameBuffer *clientFb,
-                           const EncodeOptions *options)
-{
-  m_rgbData.resize(0);
-  const PIXEL_T *buffer = static_cast<const PIXEL_T *>(clientFb->getBuffer());
-  
-  Rect tileRect;
-  for (tileRect.top = rect->top; tileRect.top < rect->bottom; tileRect.top += TILE_SIZE) {
-
-    tileRect.bottom = min(rect->bottom, tileRect.top + TILE_SIZE);
-
-    for (tileRect.left = rect->left; tileRect.left < rect->right; tileRect.left += TILE_SIZE) {
-
-      tileRect.right = min(rect->right, tileRect.left + TILE_SIZE);
-
-      // Clear sizes and vector with plain RLE tile.
-      m_rawTileSize = 0;
-      m_paletteTileSize = 0;
-      m_paletteRleTileSize = 0;
-      m_plainRleTile.clear();
-
-      fillPalette<PIXEL_T>(&tileRect, clientFb);
-      int numColors = m_pal.getNumColors();
-      m_oldSize = m_rgbData.size();
-      
-      // If number of colors is 1 the tile with minimal size is solid.
-      if (numColors == 1) {
-        writeSolidTile();
-      // Else calculate sizes of tile with other encodings
-      // and choose encoding type when size is the minimal.
-      } else {
-        // Calculate size of packed pixels in palette.
-        if (numColors == 2) {
-          m_mSize = ((tileRect.getWidth() + 7) / 8) * tileRect.getHeight();
-        } else if (numColors == 3 || numColors == 4) {
-          m_mSize = ((tileRect.getWidth() + 3) / 4) * tileRect.getHeight();
-        } else {
-          m_mSize = ((tileRect.getWidth() + 1) / 2) * tileRect.getHeight();
-        }
-        
-        //TODO: Test this code
-        // Size of raw tile is (1 + width * height * pixelSize).
-        m_rawTileSize = 1 + tileRect.area() * m_bytesPerPixel;
-        // Size of palette tile.
-        if (numColors > 1 && numColors <= 16) {
-          m_paletteTileSize = 1 + numColors * m_bytesPerPixel + m_mSize;
-        } else {
-          m_paletteTileSize = THIS_TYPE_OF_TILE_IS_NOT_POSSIBLE;
-        }
-        // Size of palette RLE tile.
-        if (numColors > 16 && numColors <= 127) {
-          m_paletteRleTileSize += numColors * m_bytesPerPixel;
-        } else {
-          m_paletteRleTileSize = THIS_TYPE_OF_TILE_IS_NOT_POSSIBLE;
-        }
-        // Choose the size of the min tile.
-        size_t minSizeOfTile = m_rawTileSize;
-        if (m_paletteTileSize < minSizeOfTile) {
-          minSizeOfTile = m_paletteTileSize;
-        }
-        if (m_plainRleTile.size() < minSizeOfTile) {
-          minSizeOfTile = m_plainRleTile.size();
-        }
-        if (m_paletteRleTileSize < minSizeOfTile) {
-          minSizeOfTile = m_paletteRleTileSize;
-        }
-
-        // Write the tile with the min size.
-        if (minSizeOfTile == m_rawTileSize) {
-          writeRawTile<PIXEL_T>(&tileRect, clientFb);
-        } else if (minSizeOfTile == m_paletteTileSize) {
-          writePackedPaletteTile<PIXEL_T>(&tileRect, clientFb);
-        } else if (minSizeOfTile == m_plainRleTile.size()) {
-          m_rgbData.resize(m_oldSize + m_plainRleTile.size());
-          memcpy(&m_rgbData[m_oldSize],
-                 &m_plainRleTile.front(),
-                 m_plainRleTile.size());
-        } else if (minSizeOfTile == m_paletteRleTileSize) {
-          writePaletteRleTile<PIXEL_T>(&tileRect, clientFb);
-        }
-      }
-    }
-  }
+  m_pixelMask = colorMaxValue;
 
   // If area of rect == 0, send length of zlib data == 0.
-  if (m_rgbData.empty()) {
+  if (rect->area() == 0) {
     m_output->writeUInt32(0);
-  } else {
-    m_deflater.setInput(reinterpret_cast<const char *>(&m_rgbData.front()),
-                        m_rgbData.size());
-    m_deflater.deflate();
-  
-    m_output->writeUInt32(m_deflater.getOutputSize());
-    m_output->writeFully(m_deflater.getOutput(),
-                         m_deflater.getOutputSize());
+    return;
   }
-}
 
-template <class PIXEL_T>
-void ZrleEncoder::writeRawTile(const Rect *tileRect,
-                               const FrameBuffer *fb)
-{
-  m_oldSize = m_rgbData.size();
-  m_rgbData.resize(m_oldSize + tileRect->area() * m_bytesPerPixel + 1);
-  m_rgbData[m_oldSize] = 0;
-  if (m_bytesPerPixel == 3) {
-    copyCPixels(tileRect, fb, &m_rgbData[m_oldSize + 1]);
-  } else {
-    copyPixels<PIXEL_T>(tileRect, fb, &m_rgbData[m_oldSize + 1]);
+  m_rect = *rect;
+  m_tilesPerRow = (rect->getWidth() + TILE_SIZE - 1) / TILE_SIZE;
+  int tilesPerColumn = (rect->getHeight() + TILE_SIZE - 1) / TILE_SIZE;
+  size_t tileCount = (size_t)m_tilesPerRow * tilesPerColumn;
+
+  // A raw tile is never chosen when it is bigger than the others, so the
+  // size of a raw tile is enough for a tile of any subencoding.
+  m_tileSlotSize = 1 + TILE_SIZE * TILE_SIZE * m_bytesPerPixel;
+  if (m_tileArena.size() < tileCount * m_tileSlotSize) {
+    m_tileArena.resize(tileCount * m_tileSlotSize);
+  }
+  if (m_tileSizes.size() < tileCount) {
+    m_tileSizes.resize(tileCount);
   }
-}
 
-void ZrleEncoder::writeSolidTile() throw(IOException)
-{
-  m_oldSize = m_rgbData.size();
-  UINT32 colorPixel = m_pal.getEntry(0);
-  m_rgbData.resize(m_oldSize + m_bytesPerPixel + 1);
-  m_rgbData[m_oldSize] = 1;
-  memcpy(&m_rgbData[m_oldSize + 1], &colorPixel + m_numberFirstByte, m_bytesPerPixel);
-}
+  bool parallel = tileCount >= MIN_TILES_FOR_PARALLEL_ENCODING &&
+                  WorkerPool::getProcessorCount() > 1;
+  if (parallel && m_workerPool == 0) {
+    m_workerPool = WorkerPool::getShared();
+  }
+  size_t slotCount = parallel ? m_workerPool->getSlotCount() : 1;
+  while (m_palettes.size() < slotCount) {
+    m_palettes.push_back(new TightPalette);
+  }
 
-template <class PIXEL_T>
-void ZrleEncoder::writePackedPaletteTile(const Rect *tileRect,
-                                         const FrameBuffer *fb)
-{
-  int numColors = m_pal.getNumColors();
-  m_oldSize = m_rgbData.size();
-  UINT8 deltaOffset;
-  if (numColors == 2) {
-    deltaOffset = 1;
-  } else if (numColors == 3 || numColors == 4) {
-    deltaOffset = 2;
+  if (parallel) {
+    m_workerPool->run(this, tileCount);
   } else {
-    deltaOffset = 4;
+    for (size_t i = 0; i < tileCount; i++) {
+      execute(i, 0);
+    }
   }
 
-  // Resize of m_rgbData for a new chunk of data.
-  // m_oldSize + sizeof(subencodingByte + palette + packedPixels)
-  m_rgbData.resize(m_oldSize + 1 + numColors * m_bytesPerPixel + m_mSize);
-
-  // Write type of subencoding.
-  m_rgbData[m_oldSize] = numColors;
-
-  // Write palette.
-  for (int i = 0; i < numColors; i++) {
-    UINT32 buf = m_pal.getEntry(i);
-    memcpy(&m_rgbData[m_oldSize + 1 + i * m_bytesPerPixel],
-             &buf + m_numberFirstByte,
-             m_bytesPerPixel);
+  // Join the encoded tiles in tile order. A tile never moves forward, so
+  // the tiles can be moved inside the arena.
+  size_t dataSize = 0;
+  for (size_t i = 0; i < tileCount; i++) {
+    memmove(&m_tileArena[dataSize],
+            &m_tileArena[i * m_tileSlotSize],
+            m_tileSizes[i]);
+    dataSize += m_tileSizes[i];
   }
 
-  // Pack pixels.
-  const PIXEL_T *buffer = static_cast<const PIXEL_T *>(fb->getBuffer());
-  UINT8 packedByte = 0;
-  int indexOfM = 0;
-  int offset = 8;
-
-  Rect rect;
-  for (rect.top = tileRect->top; rect.top < tileRect->bottom; rect.top++) {
-    for (rect.left = tileRect->left; rect.left < tileRect->right; rect.left++) {
-      PIXEL_T px = buffer[rect.top * m_fbWidth + rect.left];
-      UINT8 indexOfColor = m_pal.getIndex(px);
-      if (offset != 0) {
-        packedByte = packedByte << deltaOffset;
-        packedByte = packedByte | indexOfColor;
-        offset -= deltaOffset;
-      }
-      else {
-        // Write next packed byte.
-        m_rgbData[m_oldSize + 1 + numColors * m_bytesPerPixel + indexOfM] = packedByte;
-        indexOfM++;
-        packedByte = 0;
-        offset = 8;
-
-        packedByte = packedByte << deltaOffset;
-        packedByte = packedByte | indexOfColor;
-        offset -= deltaOffset;
-      }
-    }
-    while (offset != 0) {
-      packedByte = packedByte << deltaOffset;
-      offset -= deltaOffset;
-    }
-    // Write next packed byte.
-    m_rgbData[m_oldSize + 1 + numColors * m_bytesPerPixel + indexOfM] = packedByte;
-    indexOfM++;
-    packedByte = 0;
-    offset = 8;
+  int level = options->getCompressionLevel(DEFAULT_COMPRESSION_LEVEL);
+  int strategy = Z_DEFAULT_STRATEGY;
+  ZlibTuner *tuner = options->getZlibTuner();
+  if (tuner != 0) {
+    tuner->getParams(ZlibTuner::STREAM_MIXED, level, &level, &strategy);
   }
+  m_deflater.setLevel(level);
+  m_deflater.setStrategy(strategy);
+  m_deflater.setInput(reinterpret_cast<const char *>(&m_tileArena.front()),
+                      dataSize);
+  INT64 startTicks = tuner != 0 ? ZlibTuner::getTicks() : 0;
+  m_deflater.deflate();
+  if (tuner != 0) {
+    tuner->addSample(ZlibTuner::STREAM_MIXED, dataSize,
+                     m_deflater.getOutputSize(),
+                     ZlibTuner::getTicks() - startTicks);
+  }
+
+  m_output->writeUInt32((UINT32)m_deflater.getOutputSize());
+  m_output->writeFully(m_deflater.getOutput(),
+                       m_deflater.getOutputSize());
 }
 
-void ZrleEncoder::pushRunLengthPaletteRle(int runLength,
-                                          std::vector<UINT8> *paletteRleData)
+void ZrleEncoder::execute(size_t index, size_t slot)
 {
-  do {
-    if (runLength > 255) {
-      paletteRleData->push_back(255); 
-    } else {
-      paletteRleData->push_back(runLength);
-    }
-    runLength -= 255;
-  } while (runLength >= 0);
+  int tileLeft = m_rect.left + (int)(index % m_tilesPerRow) * TILE_SIZE;
+  int tileTop = m_rect.top + (int)(index / m_tilesPerRow) * TILE_SIZE;
+  Rect tileRect(tileLeft, tileTop,
+                min(m_rect.right, tileLeft + TILE_SIZE),
+                min(m_rect.bottom, tileTop + TILE_SIZE));
+  UINT8 *dst = &m_tileArena[index * m_tileSlotSize];
+  TightPalette *pal = m_palettes[slot];
+
+  switch (m_clientFb->getBitsPerPixel()) {
+  case 8:
+    m_tileSizes[index] = encodeTile<UINT8>(&tileRect, pal, dst);
+    break;
+  case 16:
+    m_tileSizes[index] = encodeTile<UINT16>(&tileRect, pal, dst);
+    break;
+  case 32:
+    m_tileSizes[index] = encodeTile<UINT32>(&tileRect, pal, dst);
+    break;
+  default:
+    _ASSERT(0);
+    m_tileSizes[index] = 0;
+  }
 }
 
 template <class PIXEL_T>
-void ZrleEncoder::writePaletteRleTile(const Rect *tileRect,
-                                      const FrameBuffer *fb)
+size_t ZrleEncoder::encodeTile(const Rect *tileRect,
+                               TightPalette *pal,
+                               UINT8 *dst)
 {
-  int numColors = m_pal.getNumColors();
-  std::vector<UINT8> paletteRleData;
-  paletteRleData.resize(1 + numColors * m_bytesPerPixel);
-
-  // Write type of subencoding.
-  paletteRleData[0] = numColors + 128;
-
-  // Write palette.
-  for (int i = 0; i < numColors; i++) {
-    UINT32 buf = m_pal.getEntry(i);
-    memcpy(&paletteRleData[1 + i * m_bytesPerPixel],
-             &buf + m_numberFirstByte,
-             m_bytesPerPixel);
-  }
-
-  const PIXEL_T *buffer = static_cast<const PIXEL_T *>(fb->getBuffer());
-  PixelFormat pxFormat = fb->getPixelFormat();
-
-  // There is the first iteration of loop below.
-  PIXEL_T px = buffer[tileRect->top * m_fbWidth + tileRect->left];
-  UINT8 indexOfColor = m_pal.getIndex(px);
-
-  // Processing of the first pixel.
-  paletteRleData.push_back(indexOfColor);
-  UINT8 previousIndexOfColor = indexOfColor;
-  
+  const int width = tileRect->getWidth();
+  const int height = tileRect->getHeight();
+  const int stride = m_clientFb->getDimension().width;
+  const PIXEL_T mask = (PIXEL_T)m_pixelMask;
+  const PIXEL_T *row = static_cast<const PIXEL_T *>(
+    m_clientFb->getBufferPtr(tileRect->left, tileRect->top));
+
+  pal->reset();
+  pal->setMaxColors(MAX_NUMBER_OF_COLORS_IN_PALETTE);
+
+  // One pass over the tile fills the palette and counts the exact sizes of
+  // both RLE subencodings. A run of equal pixels is a run of equal palette
+  // indices as well, so both sizes are counted over the same runs.
+  size_t plainRleSize = 1;
+  size_t paletteRleSize = 1;
+  bool paletteIsFull = false;
+  PIXEL_T runPx = row[0] & mask;
   int runLength = 0;
-  for (int i = 1; i < tileRect->area(); ++i) {
-    // FIXME: This variant may be not the most optimal.
-    // One of the possible variant is double for loops.
-    int x = tileRect->left + i % tileRect->getWidth();
-    int y = tileRect->top + i / tileRect->getWidth();
-
-    px = buffer[y * m_fbWidth + x];
-
-    indexOfColor = m_pal.getIndex(px);
-    if (indexOfColor != previousIndexOfColor) {
-      if (runLength > 0) {
-        pushRunLengthPaletteRle(runLength, &paletteRleData);
-        runLength = 0;
+  for (int y = 0; y < height; y++, row += stride) {
+    for (int x = 0; x < width; x++) {
+      PIXEL_T px = row[x] & mask;
+      if (px == runPx) {
+        runLength++;
+        continue;
       }
-      paletteRleData.push_back(indexOfColor);
-      previousIndexOfColor = indexOfColor;
-    } else {
-      runLength++;
-      paletteRleData.back() |= 0x80;
+      plainRleSize += m_bytesPerPixel + getRunLengthSize(runLength);
+      paletteRleSize += runLength == 1 ? 1 : 1 + getRunLengthSize(runLength);
+      if (!paletteIsFull) {
+        paletteIsFull = pal->insert(runPx, runLength) == 0;
+      }
+      runPx = px;
+      runLength = 1;
     }
   }
-  if (runLength > 0) {
-    pushRunLengthPaletteRle(runLength, &paletteRleData);
+  plainRleSize += m_bytesPerPixel + getRunLengthSize(runLength);
+  paletteRleSize += runLength == 1 ? 1 : 1 + getRunLengthSize(runLength);
+  if (!paletteIsFull) {
+    pal->insert(runPx, runLength);
+  }
+
+  // The palette reports zero colors when it is full.
+  int numColors = pal->getNumColors();
+  if (numColors == 1) {
+    dst[0] = 1;
+    return 1 + writeCPixel(pal->getEntry(0), dst + 1);
   }
 
-  m_oldSize = m_rgbData.size();
-  m_rgbData.resize(m_oldSize + paletteRleData.size());
-  memcpy(&m_rgbData[m_oldSize], &paletteRleData[0], paletteRleData.size());
+  // Choose the subencoding with the min size.
+  size_t rawTileSize = 1 + tileRect->area() * m_bytesPerPixel;
+  size_t packedPaletteTileSize = (size_t)-1;
+  if (numColors > 1 && numColors <= MAX_NUMBER_OF_COLORS_IN_PACKED_PALETTE) {
+    int bitsPerIndex = numColors == 2 ? 1 : (numColors <= 4 ? 2 : 4);
+    packedPaletteTileSize = 1 + numColors * m_bytesPerPixel +
+                            ((width * bitsPerIndex + 7) / 8) * height;
+  }
+  if (numColors > 1) {
+    paletteRleSize += numColors * m_bytesPerPixel;
+  } else {
+    paletteRleSize = (size_t)-1;
+  }
+
+  size_t minSizeOfTile = min(min(rawTileSize, packedPaletteTileSize),
+                             min(plainRleSize, paletteRleSize));
+  if (minSizeOfTile == rawTileSize) {
+    return writeRawTile<PIXEL_T>(tileRect, dst);
+  } else if (minSizeOfTile == packedPaletteTileSize) {
+    return writePackedPaletteTile<PIXEL_T>(tileRect, pal, dst);
+  } else if (minSizeOfTile == plainRleSize) {
+    return writePlainRleTile<PIXEL_T>(tileRect, dst);
+  } else {
+    return writePaletteRleTile<PIXEL_T>(tileRect, pal, dst);
+  }
 }
 
-void ZrleEncoder::pushRunLengthRle(int runLength)
+template <class PIXEL_T>
+size_t ZrleEncoder::writeRawTile(const Rect *tileRect,
+                                 UINT8 *dst)
 {
-  do {
-    if (runLength > 255) {
-      m_plainRleTile.push_back(255);
+  const int width = tileRect->getWidth();
+  const int height = tileRect->getHeight();
+  const int stride = m_clientFb->getDimension().width;
+  const PIXEL_T *row = static_cast<const PIXEL_T *>(
+    m_clientFb->getBufferPtr(tileRect->left, tileRect->top));
+
+  UINT8 *p = dst;
+  *p++ = 0;
+  for (int y = 0; y < height; y++, row += stride) {
+    if (m_bytesPerPixel == sizeof(PIXEL_T)) {
+      memcpy(p, row, width * sizeof(PIXEL_T));
+      p += width * sizeof(PIXEL_T);
     } else {
-      m_plainRleTile.push_back(runLength);
+      for (int x = 0; x < width; x++) {
+        p += writeCPixel(row[x], p);
+      }
     }
-    // Increase the size of palette RLE tile.
-    m_paletteRleTileSize++;
-    runLength -= 255;
-  } while (runLength >= 0);
+  }
+  return p - dst;
 }
 
 template <class PIXEL_T>
-void ZrleEncoder::writePixelToPlainRleTile(const PIXEL_T px,
-                                           PIXEL_T *previousPx)
+size_t ZrleEncoder::writePackedPaletteTile(const Rect *tileRect,
+                                           const TightPalette *pal,
+                                           UINT8 *dst)
 {
-  m_plainRleTile.resize(m_plainRleTile.size() + m_bytesPerPixel);
-  memcpy(&m_plainRleTile[m_plainRleTile.size() - m_bytesPerPixel],
-          &px + m_numberFirstByte,
-          m_bytesPerPixel);
-  *previousPx = px;
+  const int width = tileRect->getWidth();
+  const int height = tileRect->getHeight();
+  const int stride = m_clientFb->getDimension().width;
+  const PIXEL_T mask = (PIXEL_T)m_pixelMask;
+  const PIXEL_T *row = static_cast<const PIXEL_T *>(
+    m_clientFb->getBufferPtr(tileRect->left, tileRect->top));
+
+  int numColors = pal->getNumColors();
+  int bitsPerIndex = numColors == 2 ? 1 : (numColors <= 4 ? 2 : 4);
+
+  UINT8 *p = dst;
+  *p++ = (UINT8)numColors;
+  p += writePalette(pal, p);
+
+  // Each row starts from a new byte, the most significant bits first.
+  for (int y = 0; y < height; y++, row += stride) {
+    UINT8 packedByte = 0;
+    int numBits = 0;
+    for (int x = 0; x < width; x++) {
+      packedByte = (packedByte << bitsPerIndex) | pal->getIndex(row[x] & mask);
+      numBits += bitsPerIndex;
+      if (numBits == 8) {
+        *p++ = packedByte;
+        packedByte = 0;
+        numBits = 0;
+      }
+    }
+    if (numBits != 0) {
+      *p++ = packedByte << (8 - numBits);
+    }
+  }
+  return p - dst;
 }
 
 template <class PIXEL_T>
-void ZrleEncoder::fillPalette(const Rect *tileRect,
-                              const FrameBuffer *fb)
+size_t ZrleEncoder::writePlainRleTile(const Rect *tileRect,
+                                      UINT8 *dst)
 {
-  // Clear the palette.
-  m_pal.reset();
-  m_pal.setMaxColors(MAX_NUMBER_OF_COLORS_IN_PALETTE);
-  int tryInsertPx = 1;
-
-  const PIXEL_T *buffer = (const PIXEL_T *)fb->getBuffer();
-  PixelFormat pxFormat = fb->getPixelFormat();
-
-  // Mask for cutting rubbish bits.
-  PIXEL_T mask = pxFormat.redMax << pxFormat.redShift |
-                 pxFormat.greenMax << pxFormat.greenShift |
-                 pxFormat.blueMax << pxFormat.blueShift;
-
-  // There is the first iteration of loop below.
-  // Pixel for adding to plainRleTile
-  PIXEL_T previousPx;
-  PIXEL_T px = buffer[tileRect->top * m_fbWidth + tileRect->left];
-
-  // Pixel for adding to palette
-  PIXEL_T oldPixel = px;
-  int palLength = 1;
-  
-  // Fill RLE tile vector.
-  px &= mask;
-  // Write type of subencoding.
-  m_plainRleTile.push_back(128);
-
-  // Calculate size of palette RLE tile.
-  m_paletteRleTileSize = 1;
-  writePixelToPlainRleTile<PIXEL_T>(px, &previousPx);
-
-  // Increase the size of palette RLE tile.
-  m_paletteRleTileSize++;
+  const int width = tileRect->getWidth();
+  const int height = tileRect->getHeight();
+  const int stride = m_clientFb->getDimension().width;
+  const PIXEL_T mask = (PIXEL_T)m_pixelMask;
+  const PIXEL_T *row = static_cast<const PIXEL_T *>(
+    m_clientFb->getBufferPtr(tileRect->left, tileRect->top));
 
+  UINT8 *p = dst;
+  *p++ = 128;
+
+  PIXEL_T runPx = row[0] & mask;
   int runLength = 0;
-  for (int i = 1; i < tileRect->area(); ++i) {
-    // FIXME: This variant may be not the most optimal.
-    // One of the possible variant is double for loops.
-    int x = tileRect->left + i % tileRect->getWidth();
-    int y = tileRect->top + i / tileRect->getWidth();
-
-    px = buffer[y * m_fbWidth + x];
-    
-    // Fill palette
-    if (tryInsertPx && oldPixel != px) {
-      tryInsertPx = m_pal.insert(oldPixel, palLength);
-      oldPixel = px;
-      palLength = 1;
-    } else {
-      palLength++;
+  for (int y = 0; y < height; y++, row += stride) {
+    for (int x = 0; x < width; x++) {
+      PIXEL_T px = row[x] & mask;
+      if (px == runPx) {
+        runLength++;
+        continue;
+      }
+      p += writeCPixel(runPx, p);
+      p += writeRunLength(runLength, p);
+      runPx = px;
+      runLength = 1;
     }
-    
-    // Fill RLE tile vector.
-    px &= mask;
-    if (px != previousPx) {
-      pushRunLengthRle(runLength);
-      runLength = 0;
-      writePixelToPlainRleTile<PIXEL_T>(px, &previousPx);
-    } else {
-      runLength++;
+  }
+  p += writeCPixel(runPx, p);
+  p += writeRunLength(runLength, p);
+  return p - dst;
+}
+
+template <class PIXEL_T>
+size_t ZrleEncoder::writePaletteRleTile(const Rect *tileRect,
+                                        const TightPalette *pal,
+                                        UINT8 *dst)
+{
+  const int width = tileRect->getWidth();
+  const int height = tileRect->getHeight();
+  const int stride = m_clientFb->getDimension().width;
+  const PIXEL_T mask = (PIXEL_T)m_pixelMask;
+  const PIXEL_T *row = static_cast<const PIXEL_T *>(
+    m_clientFb->getBufferPtr(tileRect->left, tileRect->top));
+
+  UINT8 *p = dst;
+  *p++ = (UINT8)(pal->getNumColors() + 128);
+  p += writePalette(pal, p);
+
+  // A single pixel is written as its index, a longer run is written as
+  // the index with the top bit set followed by the run length.
+  PIXEL_T runPx = row[0] & mask;
+  int runLength = 0;
+  for (int y = 0; y < height; y++, row += stride) {
+    for (int x = 0; x < width; x++) {
+      PIXEL_T px = row[x] & mask;
+      if (px == runPx) {
+        runLength++;
+        continue;
+      }
+      if (runLength == 1) {
+        *p++ = pal->getIndex(runPx);
+      } else {
+        *p++ = pal->getIndex(runPx) | 0x80;
+        p += writeRunLength(runLength, p);
+      }
+      runPx = px;
+      runLength = 1;
     }
   }
-  if (tryInsertPx) {
-    m_pal.insert(oldPixel, palLength);
+  if (runLength == 1) {
+    *p++ = pal->getIndex(runPx);
+  } else {
+    *p++ = pal->getIndex(runPx) | 0x80;
+    p += writeRunLength(runLength, p);
   }
-  pushRunLengthRle(runLength);
+  return p - dst;
 }
 
-template <class PIXEL_T>
-void ZrleEncoder::copyPixels(const Rect *rect,
-                             const FrameBuffer *fb,
-                             UINT8 *dst)
+size_t ZrleEncoder::writePalette(const TightPalette *pal, UINT8 *dst)
 {
-  const int rectHeight = rect->getHeight();
-  const int rectWidth = rect->getWidth();
-  const PIXEL_T *src = static_cast<const PIXEL_T *>(fb->getBufferPtr(rect->left, rect->top));
-  const int fbStride = fb->getDimension().width;
-  const size_t bytesPerRow = rect->getWidth() * m_bytesPerPixel;
-
-  for (int y = 0; y < rectHeight; y++) {
-    memcpy(dst, src, bytesPerRow);
-    src += fbStride;
-    dst += bytesPerRow;
+  UINT8 *p = dst;
+  for (int i = 0; i < pal->getNumColors(); i++) {
+    p += writeCPixel(pal->getEntry(i), p);
   }
+  return p - dst;
 }
 
-void ZrleEncoder::copyCPixels(const Rect *rect,
-                              const FrameBuffer *fb,
-                              UINT8 *dst)
+size_t ZrleEncoder::writeCPixel(UINT32 px, UINT8 *dst)
 {
-  const int rectHeight = rect->getHeight();
-  const int rectWidth = rect->getWidth();
-  const UINT8 *src = static_cast<const UINT8 *>(fb->getBufferPtr(rect->left, rect->top));
-  const int fbStride = fb->getDimension().width;
-  
-  for (int y = 0; y < rectHeight; y++) {
-    for (int x = 0; x < rectWidth; x++) {
-      memcpy(dst, src + m_numberFirstByte, 3);
-      src += 4;
-      dst += 3;
-    }
-    src += ((fbStride - rectWidth) * 4);
+  // The pixel value is stored in the same byte order as in the frame
+  // buffer, so the CPIXEL bytes are taken from the memory representation.
+  memcpy(dst, reinterpret_cast<const UINT8 *>(&px) + m_numberFirstByte,
+         m_bytesPerPixel);
+  return m_bytesPerPixel;
+}
+
+size_t ZrleEncoder::writeRunLength(int runLength, UINT8 *dst)
+{
+  // The length is written as (runLength - 1) in the form of
+  // a sequence of 255 values ended by a value less than 255.
+  UINT8 *p = dst;
+  int rest = runLength - 1;
+  while (rest >= 255) {
+    *p++ = 255;
+    rest -= 255;
   }
+  *p++ = (UINT8)rest;
+  return p - dst;
+}
+
+size_t ZrleEncoder::getRunLengthSize(int runLength)
+{
+  return (runLength - 1) / 255 + 1;
 }
@@ -28,8 +28,14 @@
 #include "Encoder.h"
 #include "TightPalette.h"
 #include "util/Deflater.h"
-
-class ZrleEncoder : public Encoder
+#include "thread/WorkerPool.h"
+
+// The encoder analyzes and encodes the 64x64 tiles of a rectangle
+// independently of each other, on several threads when the rectangle is big
+// enough. Each tile is encoded into its own fixed-size slot of a reusable
+// arena, the slots are then joined in tile order and compressed by the single
+// zlib stream of the connection.
+class ZrleEncoder : public Encoder, public ParallelTask
 {
 public:
   ZrleEncoder(PixelConverter *conv, DataOutputStream *output);
@@ -38,6 +44,10 @@ public:
   // Follow methods were inherited from the Encoder.
   virtual int getCode() const;
 
+  // ZRLE protocol has no way to reset the zlib stream on the client side,
+  // so this function does nothing and returns false.
+  virtual bool resetCompression();
+
   virtual void splitRectangle(const Rect *rect,
                               std::vector<Rect> *rectList,
                               const FrameBuffer *serverFb,
@@ -47,110 +57,97 @@ public:
                              const FrameBuffer *serverFb,
                              const EncodeOptions *options) throw(IOException);
 
+protected:
+  // Encodes the tile with the index into its slot of the arena.
+  // Implementation of the ParallelTask interface.
+  virtual void execute(size_t index, size_t slot);
+
 private:
-  // Determine the class of rectangle and call necessary function for this type.
+  // Encodes one tile into dst and returns the number of bytes written.
+  // The size of the dst buffer must be at least m_tileSlotSize.
   template <class PIXEL_T>
-    void sendRect(const Rect *rect,
-                  const FrameBuffer *serverFb,
-                  const FrameBuffer *clientFb,
-                  const EncodeOptions *options) throw(IOException);
+    size_t encodeTile(const Rect *tileRect,
+                      TightPalette *pal,
+                      UINT8 *dst);
 
-  // Send raw tile.
+  // Writes the tile pixels as is (raw subencoding), returns the size.
   template <class PIXEL_T>
-    void writeRawTile(const Rect *tileRect,
-                      const FrameBuffer *fb) throw(IOException);
+    size_t writeRawTile(const Rect *tileRect,
+                        UINT8 *dst);
 
-  // Send a solid-color tile.
-    void writeSolidTile() throw(IOException);
-  
-  // Send packed palette tile.
+  // Writes packed palette indices, returns the size.
   template <class PIXEL_T>
-    void writePackedPaletteTile(const Rect *tileRect,
-                                const FrameBuffer *fb) throw(IOException);
+    size_t writePackedPaletteTile(const Rect *tileRect,
+                                  const TightPalette *pal,
+                                  UINT8 *dst);
 
-  // Send palette RLE tile.
+  // Writes the runs of pixels (plain RLE subencoding), returns the size.
   template <class PIXEL_T>
-    void writePaletteRleTile(const Rect *tileRect,
-                             const FrameBuffer *fb) throw(IOException);
+    size_t writePlainRleTile(const Rect *tileRect,
+                             UINT8 *dst);
 
-  // Write data from runLength (used in plain Rle encoding).
-  void pushRunLengthRle(int runLength);
+  // Writes the runs of palette indices, returns the size.
+  template <class PIXEL_T>
+    size_t writePaletteRleTile(const Rect *tileRect,
+                               const TightPalette *pal,
+                               UINT8 *dst);
 
-  // Write data from runLength (used in palette Rle encoding).
-  void pushRunLengthPaletteRle(int runLength,
-                                 std::vector<UINT8> *paletteRleData);
+  // Writes the palette colors as CPIXELs, returns the size.
+  size_t writePalette(const TightPalette *pal, UINT8 *dst);
 
-  // Write pixel to the plainRleTile.
-  template <class PIXEL_T>
-    void writePixelToPlainRleTile(const PIXEL_T px,
-                                  PIXEL_T *previousPx);
+  // Writes one pixel value as a CPIXEL, returns the size.
+  inline size_t writeCPixel(UINT32 px, UINT8 *dst);
 
-  // Fill palette (m_pal), create m_plainRleTile vector and calculate size of data in palette RLE tile.
-  template <class PIXEL_T>
-    void fillPalette(const Rect *tileRect,
-                     const FrameBuffer *fb);
+  // Writes the length of a run in the form used by both RLE
+  // subencodings, returns the size.
+  static inline size_t writeRunLength(int runLength, UINT8 *dst);
 
-  // Copy ordinary PIXELs.
-  template <class PIXEL_T>
-    void copyPixels(const Rect *rect,
-                    const FrameBuffer *fb,
-                    UINT8 *dst);
-  
-  // Copy CPIXELs.
-  void copyCPixels(const Rect *rect,
-                   const FrameBuffer *fb,
-                   UINT8 *dst);
+  // Returns the size of a run length written by writeRunLength().
+  static inline size_t getRunLengthSize(int runLength);
 
-  // Vector for storing all tiles for the future zlib compression.
-  std::vector<UINT8> m_rgbData;
-  // Size of m_rgbData before writing information in it.
-  size_t m_oldSize;
+  // Current client frame buffer and rectangle, used by the tile tasks.
+  const FrameBuffer *m_clientFb;
+  Rect m_rect;
+  int m_tilesPerRow;
 
-  // Size of stride.
-  int m_fbWidth;
+  // Arena with a slot for every tile of the rectangle and the sizes of
+  // the encoded tiles. Both only grow and are reused by following rectangles.
+  std::vector<UINT8> m_tileArena;
+  size_t m_tileSlotSize;
+  std::vector<size_t> m_tileSizes;
 
-  // Size of packed pixels in palette.
-  int m_mSize;
-  
-  // The only pixel format type for whole rectangle.
-  PixelFormat m_pxFormat;
+  // Color palettes, one for each slot of the worker pool.
+  std::vector<TightPalette *> m_palettes;
+
+  // Threads used to encode tiles of big rectangles, shared by the encoders
+  // of all the clients, got on first demand.
+  WorkerPool *m_workerPool;
+
+  // Mask for cutting rubbish bits of client pixels.
+  UINT32 m_pixelMask;
 
   // Used for determing: is it CPIXEL or PIXEL.
   size_t m_bytesPerPixel;
   size_t m_numberFirstByte;
 
-  // Zlib object and settings for the it.
+  // Zlib stream of the connection.
   Deflater m_deflater;
-  int m_idxZlibLevel;
-  int m_monoZlibLevel;
-  int m_rawZlibLevel;
-  
-  // Color palette.
-  TightPalette m_pal;
-
-  // Variables for storing size of all tiles.
-  size_t m_rawTileSize;
-  size_t m_paletteTileSize;
-  size_t m_paletteRleTileSize;
-
-  // vector for storing plain RLE tile data
-  std::vector<UINT8> m_plainRleTile;
 
 private:
   // Tile size in ZRLE encoding by default.
   static const int TILE_SIZE = 64;
 
-  // Default values for zlib settings.
-  static const int ZLIB_IDX_LEVEL_DEFAULT = 7;
-  static const int ZLIB_MONO_LEVEL_DEFAULT = 7;
-  static const int ZLIB_RAW_LEVEL_DEFAULT = 6;
+  // Zlib level used when the client has not requested a compression level.
+  static const int DEFAULT_COMPRESSION_LEVEL = 6;
 
-  // Description of tile max size is located in ZrleDecoder.h.
-  // The max possible size of tile is 20481, so 20482 is not possible.
-  static const int THIS_TYPE_OF_TILE_IS_NOT_POSSIBLE = 20482;
+  // Rectangles with fewer tiles are encoded by the calling thread only.
+  static const int MIN_TILES_FOR_PARALLEL_ENCODING = 4;
 
   // Max possible colors in palette (127 is max for RLE palette type encoding).
-  static const UINT8 MAX_NUMBER_OF_COLORS_IN_PALETTE = 127;
+  static const int MAX_NUMBER_OF_COLORS_IN_PALETTE = 127;
+
+  // Max possible colors in packed palette.
+  static const int MAX_NUMBER_OF_COLORS_IN_PACKED_PALETTE = 16;
 };
 
 #endif // __RFB_ZRLE_ENCODER_H_INCLUDED__
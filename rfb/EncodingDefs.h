@@ -72,6 +72,8 @@ public:
   static const int LAST_RECT = -224;
   static const int DESKTOP_SIZE = -223;
 
+  static const int TILE_CACHE = -218;
+
   static const int QUALITY_LEVEL_0 = -32;
   static const int QUALITY_LEVEL_1 = -31;
   static const int QUALITY_LEVEL_2 = -30;
@@ -89,6 +91,7 @@ public:
   static const char *const SIG_POINTER_POS;
   static const char *const SIG_LAST_RECT;
   static const char *const SIG_DESKTOP_SIZE;
+  static const char *const SIG_TILE_CACHE;
   static const char *const SIG_QUALITY_LEVEL;
 };
 
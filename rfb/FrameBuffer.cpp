@@ -40,8 +40,9 @@ FrameBuffer::~FrameBuffer(void)
 
 bool FrameBuffer::assignProperties(const FrameBuffer *srcFrameBuffer)
 {
-  setProperties(&srcFrameBuffer->getDimension(),
-                &srcFrameBuffer->getPixelFormat());
+  Dimension dimension = srcFrameBuffer->getDimension();
+  PixelFormat pixelFormat = srcFrameBuffer->getPixelFormat();
+  setProperties(&dimension, &pixelFormat);
   return resizeBuffer();
 }
 
@@ -51,7 +52,7 @@ bool FrameBuffer::clone(const FrameBuffer *srcFrameBuffer)
     return false;
   }
 
-  Rect fbRect = &m_dimension.getRect();
+  Rect fbRect = m_dimension.getRect();
   copyFrom(&fbRect, srcFrameBuffer, fbRect.left, fbRect.top);
 
   return true;
@@ -100,8 +101,10 @@ void FrameBuffer::fillRect(const Rect *dstRect, UINT32 color)
 
 bool FrameBuffer::isEqualTo(const FrameBuffer *frameBuffer)
 {
-  return m_dimension.cmpDim(&frameBuffer->getDimension()) &&
-         m_pixelFormat.isEqualTo(&frameBuffer->getPixelFormat());
+  Dimension dimension = frameBuffer->getDimension();
+  PixelFormat pixelFormat = frameBuffer->getPixelFormat();
+  return m_dimension.cmpDim(&dimension) &&
+         m_pixelFormat.isEqualTo(&pixelFormat);
 }
 
 void FrameBuffer::clipRect(const Rect *dstRect, const FrameBuffer *srcFrameBuffer,
@@ -125,7 +128,7 @@ void FrameBuffer::clipRect(const Rect *dstRect, const FrameBuffer *srcFrameBuffe
   dstCommonArea.move(-dstRect->left, -dstRect->top);
   srcCommonArea.move(-srcRect.left, -srcRect.top);
 
-  Rect commonRect(&dstCommonArea.intersection(&srcCommonArea));
+  Rect commonRect = dstCommonArea.intersection(&srcCommonArea);
 
   // Moving commonRect to destination coordinates and source
   dstClippedRect->setRect(&commonRect);
@@ -140,7 +143,8 @@ bool FrameBuffer::overlay(const Rect *dstRect,
                           int srcX, int srcY,
                           const char *andMask)
 {
-  if (!m_pixelFormat.isEqualTo(&srcFrameBuffer->getPixelFormat())) {
+  PixelFormat srcPixelFormat = srcFrameBuffer->getPixelFormat();
+  if (!m_pixelFormat.isEqualTo(&srcPixelFormat)) {
     return false;
   }
   if (m_pixelFormat.bitsPerPixel == 32) {
@@ -189,7 +193,8 @@ template<class PIXEL_T> bool FrameBuffer::overlayT(const Rect *dstRect,
 bool FrameBuffer::copyFrom(const Rect *dstRect, const FrameBuffer *srcFrameBuffer,
                            int srcX, int srcY)
 {
-  if (!m_pixelFormat.isEqualTo(&srcFrameBuffer->getPixelFormat())) {
+  PixelFormat srcPixelFormat = srcFrameBuffer->getPixelFormat();
+  if (!m_pixelFormat.isEqualTo(&srcPixelFormat)) {
     return false;
   }
 
@@ -226,13 +231,15 @@ bool FrameBuffer::copyFrom(const Rect *dstRect, const FrameBuffer *srcFrameBuffe
 bool FrameBuffer::copyFrom(const FrameBuffer *srcFrameBuffer,
                            int srcX, int srcY)
 {
-  return copyFrom(&m_dimension.getRect(), srcFrameBuffer, srcX, srcY);
+  Rect fbRect = m_dimension.getRect();
+  return copyFrom(&fbRect, srcFrameBuffer, srcX, srcY);
 }
 
 bool FrameBuffer::cmpFrom(const Rect *dstRect, const FrameBuffer *srcFrameBuffer,
                           const int srcX, const int srcY)
 {
-  if (!m_pixelFormat.isEqualTo(&srcFrameBuffer->getPixelFormat())) {
+  PixelFormat srcPixelFormat = srcFrameBuffer->getPixelFormat();
+  if (!m_pixelFormat.isEqualTo(&srcPixelFormat)) {
     return false;
   }
 
@@ -28,7 +28,8 @@
 
 PixelConverter::PixelConverter(void)
 : m_convertMode(NO_CONVERT),
-  m_dstFrameBuffer(0)
+  m_dstFrameBuffer(0),
+  m_dstFrameBufferArea(0)
 {
 }
 
@@ -126,12 +127,19 @@ PixelConverter::convert(const Rect *rect, const FrameBuffer *srcFb)
     // No frame buffer allocated - construct new one from the scratch.
     m_dstFrameBuffer = new FrameBuffer;
     m_dstFrameBuffer->setProperties(&fbSize, &m_dstFormat);
+    m_dstFrameBufferArea = fbSize.area();
   } else if (!m_dstFrameBuffer->getDimension().isEqualTo(&fbSize)) {
     // Frame buffer is allocated but its size it wrong - just resize it.
     // Note that if the frame buffer is allocated, its pixel format is
     // guaranteed to be relevant, because setPixelFormats() always calls
     // reset() if at least one pixel format has been changed.
-    m_dstFrameBuffer->setDimension(&fbSize);
+    if (fbSize.area() > m_dstFrameBufferArea) {
+      m_dstFrameBuffer->setDimension(&fbSize);
+      m_dstFrameBufferArea = fbSize.area();
+    } else {
+      // The buffer is big enough, reuse it.
+      m_dstFrameBuffer->setPropertiesWithoutResize(&fbSize, &m_dstFormat);
+    }
   }
 
   // Finally, convert pixels.
@@ -145,6 +153,7 @@ void PixelConverter::reset()
   if (m_dstFrameBuffer != 0) {
     delete m_dstFrameBuffer;
     m_dstFrameBuffer = 0;
+    m_dstFrameBufferArea = 0;
   }
 }
 
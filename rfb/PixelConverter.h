@@ -49,10 +49,9 @@ public:
   // The pixel format of `srcFb' must be identical to the source format set by
   // the most recent setPixelFormats() call. The entire rectangle referenced
   // by `rect' must be within the frame buffer boundaries.
-  // This function will work efficiently only if the frame buffer size does
-  // not vary from call to call. It checks if the frame buffer size has
-  // changed since the previous call and reallocates the frame buffer if
-  // necessary.
+  // The internal frame buffer is reallocated only when `srcFb' gets bigger
+  // than any one converted before, so converting rectangles of varying size
+  // does not cost an allocation per call.
   virtual const FrameBuffer *convert(const Rect *rect,
                                      const FrameBuffer *srcFb);
 
@@ -93,6 +92,8 @@ protected:
   // An internally maintained frame buffer used by the two-argument version of
   // the convert() function.
   FrameBuffer *m_dstFrameBuffer;
+  // The number of pixels m_dstFrameBuffer has been allocated for.
+  int m_dstFrameBufferArea;
 };
 
 #endif // __RFB_PIXEL_CONVERTER_H_INCLUDED__
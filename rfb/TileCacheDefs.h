@@ -0,0 +1,58 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __RFB_TILE_CACHE_DEFS_H_INCLUDED__
+#define __RFB_TILE_CACHE_DEFS_H_INCLUDED__
+
+#include "util/inttypes.h"
+
+//
+// Definitions of the TILE_CACHE pseudo-encoding.
+//
+// The viewer keeps SLOT_COUNT slots with pixels of screen tiles. The server
+// decides which tile goes to which slot, so the viewer never evicts
+// anything by itself. A pseudo-rectangle of this encoding is followed by
+// an operation code:
+//   RESET - drop all the slots, the rectangle is empty;
+//   STORE - copy the pixels of the rectangle from the frame buffer to a slot;
+//   LOAD  - copy the pixels of a slot to the rectangle of the frame buffer.
+// STORE and LOAD are followed by the slot number (UINT16) and the content
+// hash of the tile (UINT64). The hash is remembered by STORE and must match
+// on LOAD.
+//
+
+class TileCacheDefs
+{
+public:
+  static const UINT8 RESET = 0;
+  static const UINT8 STORE = 1;
+  static const UINT8 LOAD = 2;
+
+  // Number of slots in the viewer cache.
+  static const UINT16 SLOT_COUNT = 2048;
+
+  // Tiles are aligned to a grid of this step and are not bigger than it.
+  static const int TILE_SIZE = 64;
+};
+
+#endif // __RFB_TILE_CACHE_DEFS_H_INCLUDED__
@@ -510,6 +510,9 @@ bool Configurator::saveServerConfig(SettingsManager *sm)
   if (!sm->setUINT(_T("LogLevel"), (UINT)m_serverConfig.getLogLevel())) {
     saveResult = false;
   }
+  if (!sm->setBoolean(_T("BinaryLog"), m_serverConfig.isBinaryLogEnabled())) {
+    saveResult = false;
+  }
   if (!sm->setBoolean(_T("EnableFileTransfers"), m_serverConfig.isFileTransfersEnabled())) {
     saveResult = false;
   }
@@ -582,6 +585,11 @@ bool Configurator::saveServerConfig(SettingsManager *sm)
   if (!sm->setBoolean(_T("RunControlInterface"), m_serverConfig.getShowTrayIconFlag())) {
     saveResult = false;
   }
+  StringStorage sessionRecordDir;
+  m_serverConfig.getSessionRecordDir(&sessionRecordDir);
+  if (!sm->setString(_T("SessionRecordDir"), sessionRecordDir.getString())) {
+    saveResult = false;
+  }
   return saveResult;
 }
 
@@ -595,6 +603,7 @@ bool Configurator::loadServerConfig(SettingsManager *sm, ServerConfig *config)
 
   bool boolVal;
   UINT uintVal;
+  StringStorage stringVal;
 
   if (!sm->getUINT(_T("RfbPort"), &uintVal)) {
     loadResult = false;
@@ -655,6 +664,12 @@ bool Configurator::loadServerConfig(SettingsManager *sm, ServerConfig *config)
     m_isConfigLoadedPartly = true;
     m_serverConfig.setLogLevel(uintVal);
   }
+  if (!sm->getBoolean(_T("BinaryLog"), &boolVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.enableBinaryLog(boolVal);
+  }
   if (!sm->getBoolean(_T("EnableFileTransfers"), &boolVal)) {
     loadResult = false;
   } else {
@@ -761,6 +776,12 @@ bool Configurator::loadServerConfig(SettingsManager *sm, ServerConfig *config)
     m_isConfigLoadedPartly = true;
     m_serverConfig.setShowTrayIconFlag(boolVal);
   }
+  if (!sm->getString(_T("SessionRecordDir"), &stringVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setSessionRecordDir(stringVal.getString());
+  }
   updateLogDirPath();
   return loadResult;
 }
@@ -30,7 +30,8 @@
 
 ServerConfig::ServerConfig()
 : m_rfbPort(5900), m_httpPort(5800),
-  m_disconnectAction(DA_DO_NOTHING), m_logLevel(0), m_useControlAuth(false),
+  m_disconnectAction(DA_DO_NOTHING), m_logLevel(0), m_binaryLog(false),
+  m_useControlAuth(false),
   m_controlAuthAlwaysChecking(false),
   m_acceptRfbConnections(true), m_useAuthentication(true),
   m_onlyLoopbackConnections(false), m_acceptHttpConnections(true),
@@ -74,6 +75,7 @@ void ServerConfig::serialize(DataOutputStream *output)
   output->writeInt8(m_onlyLoopbackConnections ? 1 : 0);
   output->writeInt8(m_enableAppletParamInUrl ? 1 : 0);
   output->writeInt32(m_logLevel);
+  output->writeInt8(m_binaryLog ? 1 : 0);
   output->writeInt8(m_useControlAuth ? 1 : 0);
   output->writeInt8(m_controlAuthAlwaysChecking ? 1 : 0);
   output->writeInt8(m_alwaysShared ? 1 : 0);
@@ -109,6 +111,7 @@ void ServerConfig::serialize(DataOutputStream *output)
   output->writeInt8(m_showTrayIcon ? 1 : 0);
 
   output->writeUTF8(m_logFilePath.getString());
+  output->writeUTF8(m_sessionRecordDir.getString());
 }
 
 void ServerConfig::deserialize(DataInputStream *input)
@@ -130,6 +133,7 @@ void ServerConfig::deserialize(DataInputStream *input)
   m_onlyLoopbackConnections = input->readInt8() == 1;
   m_enableAppletParamInUrl = input->readInt8() == 1;
   m_logLevel = input->readInt32();
+  m_binaryLog = input->readInt8() == 1;
   m_useControlAuth = input->readInt8() == 1;
   m_controlAuthAlwaysChecking = input->readInt8() != 0;
   m_alwaysShared = input->readInt8() == 1;
@@ -167,6 +171,7 @@ void ServerConfig::deserialize(DataInputStream *input)
   m_showTrayIcon = input->readInt8() == 1;
 
   input->readUTF8(&m_logFilePath);
+  input->readUTF8(&m_sessionRecordDir);
 }
 
 bool ServerConfig::getShowTrayIconFlag()
@@ -197,6 +202,20 @@ void ServerConfig::setLogFileDir(const TCHAR *logFilePath)
   m_logFilePath.setString(logFilePath);
 }
 
+void ServerConfig::getSessionRecordDir(StringStorage *sessionRecordDir)
+{
+  AutoLock l(this);
+
+  *sessionRecordDir = m_sessionRecordDir;
+}
+
+void ServerConfig::setSessionRecordDir(const TCHAR *sessionRecordDir)
+{
+  AutoLock l(this);
+
+  m_sessionRecordDir.setString(sessionRecordDir);
+}
+
 IpAccessRule::ActionType ServerConfig::getActionByAddress(unsigned long ip)
 {
   AutoLock l(this);
@@ -495,6 +514,18 @@ void ServerConfig::setLogLevel(int logLevel)
   }
 }
 
+bool ServerConfig::isBinaryLogEnabled()
+{
+  AutoLock lock(&m_objectCS);
+  return m_binaryLog;
+}
+
+void ServerConfig::enableBinaryLog(bool enabled)
+{
+  AutoLock lock(&m_objectCS);
+  m_binaryLog = enabled;
+}
+
 bool ServerConfig::isAlwaysShared()
 {
   AutoLock lock(&m_objectCS);
@@ -170,6 +170,11 @@ public:
 
   void setLogLevel(int logLevel);
 
+  // Binary log files are written instead of text ones when enabled.
+  bool isBinaryLogEnabled();
+
+  void enableBinaryLog(bool enabled);
+
   //
   // Sharing configuration
   //
@@ -271,6 +276,11 @@ public:
 
   void getLogFileDir(StringStorage *logFileDir);
   void setLogFileDir(const TCHAR *logFileDir);
+
+  // Directory to write session recordings to. Empty string means that
+  // sessions are not recorded.
+  void getSessionRecordDir(StringStorage *sessionRecordDir);
+  void setSessionRecordDir(const TCHAR *sessionRecordDir);
 protected:
 
   //
@@ -312,6 +322,7 @@ protected:
   bool m_onlyLoopbackConnections;
   bool m_enableAppletParamInUrl;
   int m_logLevel;
+  bool m_binaryLog;
   bool m_useControlAuth;
   bool m_controlAuthAlwaysChecking;
 
@@ -395,6 +406,8 @@ protected:
   bool m_showTrayIcon;
 
   StringStorage m_logFilePath;
+
+  StringStorage m_sessionRecordDir;
 private:
 
   //
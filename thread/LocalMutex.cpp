@@ -24,6 +24,8 @@
 
 #include "LocalMutex.h"
 
+#ifdef _WIN32
+
 LocalMutex::LocalMutex(void)
 {
   InitializeCriticalSection(&m_criticalSection);
@@ -43,3 +45,31 @@ void LocalMutex::unlock()
 {
   LeaveCriticalSection(&m_criticalSection);
 }
+
+#else
+
+LocalMutex::LocalMutex(void)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&m_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+LocalMutex::~LocalMutex(void)
+{
+  pthread_mutex_destroy(&m_mutex);
+}
+
+void LocalMutex::lock()
+{
+  pthread_mutex_lock(&m_mutex);
+}
+
+void LocalMutex::unlock()
+{
+  pthread_mutex_unlock(&m_mutex);
+}
+
+#endif // _WIN32
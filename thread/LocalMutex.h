@@ -27,13 +27,17 @@
 
 #include "util/CommonHeader.h"
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 #include "Lockable.h"
 
 /**
  * Local mutex (cannot be used within separate processes).
  *
  * @remark local mutex uses Windows critical sections to implement
- * lockable interface..
+ * lockable interface.. On other systems it is a recursive pthread mutex.
  */
 class LocalMutex : public Lockable
 {
@@ -59,10 +63,17 @@ public:
   virtual void unlock();
 
 private:
+#ifdef _WIN32
   /**
    * Windows critical section.
    */
   CRITICAL_SECTION m_criticalSection;
+#else
+  /**
+   * Recursive mutex, acts like the critical section.
+   */
+  pthread_mutex_t m_mutex;
+#endif
 };
 
 #endif // __LOCALMUTEX_H__
@@ -0,0 +1,49 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __PARALLELTASK_H__
+#define __PARALLELTASK_H__
+
+#include <stddef.h>
+
+/**
+ * Interface of a job made of independent work items that WorkerPool runs
+ * on several threads at once.
+ */
+class ParallelTask
+{
+public:
+  virtual ~ParallelTask() {}
+
+  /**
+   * Processes one work item.
+   * @param index index of the work item.
+   * @param slot index of the thread executing the call, in the range from
+   * 0 to WorkerPool::getSlotCount() - 1. Calls made with the same slot never
+   * overlap, so the slot may select per-thread scratch data.
+   * @remark must not throw exceptions.
+   */
+  virtual void execute(size_t index, size_t slot) = 0;
+};
+
+#endif // __PARALLELTASK_H__
@@ -0,0 +1,185 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "WorkerPool.h"
+#include "AutoLock.h"
+
+#include <crtdbg.h>
+
+LocalMutex WorkerPool::s_sharedMutex;
+WorkerPool *WorkerPool::s_sharedPool = 0;
+size_t WorkerPool::s_sharedUsers = 0;
+
+WorkerPool::WorkerThread::WorkerThread(WorkerPool *pool, size_t slot)
+: m_pool(pool),
+  m_slot(slot)
+{
+}
+
+void WorkerPool::WorkerThread::wakeUp()
+{
+  m_wakeUpEvent.notify();
+}
+
+void WorkerPool::WorkerThread::execute()
+{
+  while (!isTerminating()) {
+    m_wakeUpEvent.waitForEvent();
+    if (!isTerminating()) {
+      m_pool->work(0, m_slot);
+    }
+  }
+}
+
+void WorkerPool::WorkerThread::onTerminate()
+{
+  m_wakeUpEvent.notify();
+}
+
+WorkerPool::WorkerPool(size_t threadCount)
+{
+  if (threadCount == 0) {
+    threadCount = getProcessorCount() - 1;
+  }
+  for (size_t i = 0; i < threadCount; i++) {
+    WorkerThread *thread = new WorkerThread(this, i + 1);
+    m_threads.push_back(thread);
+    thread->resume();
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  std::vector<WorkerThread *>::iterator iThread;
+  for (iThread = m_threads.begin(); iThread != m_threads.end(); iThread++) {
+    (*iThread)->terminate();
+  }
+  for (iThread = m_threads.begin(); iThread != m_threads.end(); iThread++) {
+    (*iThread)->wait();
+    delete *iThread;
+  }
+}
+
+void WorkerPool::run(ParallelTask *task, size_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  Batch batch;
+  batch.task = task;
+  batch.count = count;
+  batch.nextIndex = 0;
+  batch.pendingCount = count;
+  {
+    AutoLock al(&m_taskMutex);
+    m_batches.push_back(&batch);
+  }
+  // There is no use of waking up more threads than there are items.
+  size_t wakeUpCount = min(m_threads.size(), count - 1);
+  for (size_t i = 0; i < wakeUpCount; i++) {
+    m_threads[i]->wakeUp();
+  }
+
+  work(&batch, 0);
+
+  // Wait for the items taken by the pool threads.
+  while (true) {
+    {
+      AutoLock al(&m_taskMutex);
+      if (batch.pendingCount == 0) {
+        break;
+      }
+    }
+    batch.doneEvent.waitForEvent();
+  }
+}
+
+size_t WorkerPool::getSlotCount() const
+{
+  return m_threads.size() + 1;
+}
+
+size_t WorkerPool::getProcessorCount()
+{
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return systemInfo.dwNumberOfProcessors > 0 ? systemInfo.dwNumberOfProcessors : 1;
+}
+
+WorkerPool *WorkerPool::getShared()
+{
+  AutoLock al(&s_sharedMutex);
+
+  if (s_sharedPool == 0) {
+    s_sharedPool = new WorkerPool();
+  }
+  s_sharedUsers++;
+  return s_sharedPool;
+}
+
+void WorkerPool::releaseShared()
+{
+  AutoLock al(&s_sharedMutex);
+
+  _ASSERT(s_sharedUsers > 0);
+  if (--s_sharedUsers == 0) {
+    delete s_sharedPool;
+    s_sharedPool = 0;
+  }
+}
+
+void WorkerPool::work(Batch *batch, size_t slot)
+{
+  while (true) {
+    Batch *current;
+    size_t index;
+    {
+      AutoLock al(&m_taskMutex);
+      if (batch != 0) {
+        if (batch->nextIndex >= batch->count) {
+          return;
+        }
+        current = batch;
+      } else {
+        if (m_batches.empty()) {
+          return;
+        }
+        current = m_batches.front();
+      }
+      index = current->nextIndex++;
+      // The batch leaves the queue with its last item, so it is not
+      // touched after run() has returned.
+      if (current->nextIndex == current->count) {
+        m_batches.remove(current);
+      }
+    }
+
+    current->task->execute(index, slot);
+
+    AutoLock al(&m_taskMutex);
+    if (--current->pendingCount == 0) {
+      current->doneEvent.notify();
+    }
+  }
+}
@@ -0,0 +1,140 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include "Thread.h"
+#include "LocalMutex.h"
+#include "ParallelTask.h"
+#include "win-system/WindowsEvent.h"
+#include <list>
+#include <vector>
+
+/**
+ * Fixed set of threads running the work items of ParallelTask objects in
+ * parallel with the calling threads.
+ *
+ * The threads are started once and sleep between run() calls, so running a
+ * task costs no thread creation. Several threads may run their tasks at
+ * once: each caller works on its own task and the pool threads take the
+ * items of all the running tasks in order of the calls.
+ */
+class WorkerPool
+{
+public:
+  /**
+   * Creates the pool and starts its threads.
+   * @param threadCount number of threads in addition to the calling one.
+   * Zero means one thread less than the number of processors.
+   */
+  WorkerPool(size_t threadCount = 0);
+  /**
+   * Stops the threads of the pool.
+   */
+  virtual ~WorkerPool();
+
+  /**
+   * Calls task->execute() for every index from 0 to count - 1 and returns
+   * when all the calls have returned. The calling thread takes part in the
+   * work with slot 0.
+   * @remark thread-safe, concurrent calls share the pool threads.
+   */
+  void run(ParallelTask *task, size_t count);
+
+  /**
+   * Returns the number of distinct slots passed to ParallelTask::execute(),
+   * that is the number of pool threads plus one.
+   */
+  size_t getSlotCount() const;
+
+  /**
+   * Returns the number of logical processors of the system.
+   */
+  static size_t getProcessorCount();
+
+  /**
+   * Returns the pool shared by the whole process, the pool is created by
+   * the first call. Every call must be paired with a releaseShared() call.
+   * The pool has one thread less than the number of processors, so users
+   * of the shared pool together do not run more threads than there are
+   * processors.
+   */
+  static WorkerPool *getShared();
+
+  /**
+   * Releases the shared pool got by getShared(), the pool is stopped when
+   * it is released by all its users.
+   */
+  static void releaseShared();
+
+private:
+  class WorkerThread : public Thread
+  {
+  public:
+    WorkerThread(WorkerPool *pool, size_t slot);
+
+    void wakeUp();
+
+  protected:
+    virtual void execute();
+    virtual void onTerminate();
+
+  private:
+    WorkerPool *m_pool;
+    size_t m_slot;
+    WindowsEvent m_wakeUpEvent;
+  };
+
+  /**
+   * Task passed to run() and its progress.
+   */
+  struct Batch
+  {
+    ParallelTask *task;
+    size_t count;
+    size_t nextIndex;
+    size_t pendingCount;
+    // Notified when the last work item has been executed.
+    WindowsEvent doneEvent;
+  };
+
+  /**
+   * Executes the work items of the given batch until there are no ones
+   * left, or of any queued batch if batch is zero.
+   */
+  void work(Batch *batch, size_t slot);
+
+  std::vector<WorkerThread *> m_threads;
+
+  // Batches with work items that are not taken yet, protected by
+  // m_taskMutex.
+  LocalMutex m_taskMutex;
+  std::list<Batch *> m_batches;
+
+  static LocalMutex s_sharedMutex;
+  static WorkerPool *s_sharedPool;
+  static size_t s_sharedUsers;
+};
+
+#endif // __WORKERPOOL_H__
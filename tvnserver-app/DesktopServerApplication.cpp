@@ -48,7 +48,8 @@ DesktopServerApplication::DesktopServerApplication(HINSTANCE appInstance,
   m_configurator(true),
   m_clientLogger(LogNames::LOG_PIPE_PUBLIC_NAME,
                 LogNames::SERVER_LOG_FILE_STUB_NAME),
-  m_log(&m_clientLogger)
+  m_asyncLogger(&m_clientLogger),
+  m_log(&m_asyncLogger)
 {
   try {
     m_clientLogger.connect();
@@ -37,6 +37,7 @@
 #include "SessionChangesWatcher.h"
 #include "win-system/LocalWindowsApplication.h"
 #include "log-server/ClientLogger.h"
+#include "log-writer/AsyncLogger.h"
 #include "log-writer/LogWriter.h"
 #include "server-config-lib/ConfigReloadListener.h"
 #include "util/CommandLineArgs.h"
@@ -75,6 +76,8 @@ private:
 
   Configurator m_configurator;
   ClientLogger m_clientLogger;
+  // Sends to m_clientLogger on a background thread.
+  AsyncLogger m_asyncLogger;
   LogWriter m_log;
 
   // Transport
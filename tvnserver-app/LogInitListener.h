@@ -28,8 +28,11 @@
 class LogInitListener
 {
 public:
-  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel) = 0;
-  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel) = 0;
+  // The binaryLog argument selects binary log files instead of text ones.
+  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel,
+                         bool binaryLog) = 0;
+  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel,
+                                bool binaryLog) = 0;
 };
 
 #endif // __LOGINITLISTENER_H__
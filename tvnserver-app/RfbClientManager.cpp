@@ -189,13 +189,19 @@ void RfbClientManager::onClipboardUpdate(const StringStorage *newClipboard)
 void RfbClientManager::onSendUpdate(const UpdateContainer *updateContainer,
                                     const CursorShape *cursorShape)
 {
-  AutoLock al(&m_clientListLocker);
-  for (ClientListIter iter = m_clientList.begin();
-       iter != m_clientList.end(); iter++) {
-    if ((*iter)->getClientState() == IN_NORMAL_PHASE) {
-      (*iter)->sendUpdate(updateContainer, cursorShape);
+  // One snapshot is shared by all clients, passing it to a client is just
+  // a reference count increment and a lock-free post.
+  UpdateSnapshot *snapshot = new UpdateSnapshot(updateContainer, cursorShape);
+  {
+    AutoLock al(&m_clientListLocker);
+    for (ClientListIter iter = m_clientList.begin();
+         iter != m_clientList.end(); iter++) {
+      if ((*iter)->getClientState() == IN_NORMAL_PHASE) {
+        (*iter)->sendUpdate(snapshot);
+      }
     }
   }
+  snapshot->release();
 }
 
 bool RfbClientManager::isReadyToSend()
@@ -81,8 +81,10 @@ TvnServer::TvnServer(bool runsInServiceContext,
     StringStorage logDir;
     m_srvConfig->getLogFileDir(&logDir);
     unsigned char logLevel = m_srvConfig->getLogLevel();
+    bool binaryLog = m_srvConfig->isBinaryLogEnabled();
     // FIXME: Use correct log name.
-    m_logInitListener->onLogInit(logDir.getString(), LogNames::SERVER_LOG_FILE_STUB_NAME, logLevel);
+    m_logInitListener->onLogInit(logDir.getString(), LogNames::SERVER_LOG_FILE_STUB_NAME, logLevel,
+                                 binaryLog);
 
   } catch (...) {
     // A log error must not be a reason that stop the server.
@@ -426,10 +428,12 @@ void TvnServer::changeLogProps()
 {
   StringStorage logDir;
   unsigned char logLevel;
+  bool binaryLog;
   {
     AutoLock al(&m_mutex);
     m_srvConfig->getLogFileDir(&logDir);
     logLevel = m_srvConfig->getLogLevel();
+    binaryLog = m_srvConfig->isBinaryLogEnabled();
   }
-  m_logInitListener->onChangeLogProps(logDir.getString(), logLevel);
+  m_logInitListener->onChangeLogProps(logDir.getString(), logLevel, binaryLog);
 }
@@ -41,6 +41,7 @@ TvnServerApplication::TvnServerApplication(HINSTANCE hInstance,
                                            NewConnectionEvents *newConnectionEvents)
 : WindowsApplication(hInstance, windowClassName),
   m_fileLogger(true),
+  m_asyncLogger(&m_fileLogger),
   m_tvnServer(0),
   m_commandLine(commandLine),
   m_newConnectionEvents(newConnectionEvents)
@@ -83,9 +84,9 @@ int TvnServerApplication::run()
 
   // Start TightVNC server and TightVNC control application.
   try {
-    m_tvnServer = new TvnServer(false, m_newConnectionEvents, this, &m_fileLogger);
+    m_tvnServer = new TvnServer(false, m_newConnectionEvents, this, &m_asyncLogger);
     m_tvnServer->addListener(this);
-    m_tvnControlRunner = new WsConfigRunner(&m_fileLogger);
+    m_tvnControlRunner = new WsConfigRunner(&m_asyncLogger);
 
     int exitCode = WindowsApplication::run();
 
@@ -111,13 +112,18 @@ void TvnServerApplication::onTvnServerShutdown()
 }
 
 void TvnServerApplication::onLogInit(const TCHAR *logDir, const TCHAR *fileName,
-                                     unsigned char logLevel)
+                                     unsigned char logLevel, bool binaryLog)
 {
+  // Lines logged before the initialization must get to the log header.
+  m_asyncLogger.flush();
+  m_fileLogger.setBinaryFormat(binaryLog);
   m_fileLogger.init(logDir, fileName, logLevel);
   m_fileLogger.storeHeader();
 }
 
-void TvnServerApplication::onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel)
+void TvnServerApplication::onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel,
+                                            bool binaryLog)
 {
+  m_fileLogger.setBinaryFormat(binaryLog);
   m_fileLogger.changeLogProps(newLogDir, newLevel);
 }
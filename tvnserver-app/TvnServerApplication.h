@@ -34,6 +34,7 @@
 #include "TvnServerListener.h"
 #include "WsConfigRunner.h"
 #include "log-writer/FileLogger.h"
+#include "log-writer/AsyncLogger.h"
 #include "LogInitListener.h"
 
 /**
@@ -81,12 +82,16 @@ public:
 
 private:
   // This is a callback function that calls when the log can be initialized.
-  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel);
+  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel,
+                         bool binaryLog);
 
   // This is a callback function that calls when log properties have changed.
-  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel);
+  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel,
+                                bool binaryLog);
 
   FileLogger m_fileLogger;
+  // Writes to m_fileLogger on a background thread.
+  AsyncLogger m_asyncLogger;
 
   /**
    * Command line string.
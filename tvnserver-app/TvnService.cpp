@@ -38,7 +38,8 @@ TvnService::TvnService(WinServiceEvents *winServiceEvents,
   m_winServiceEvents(winServiceEvents),
   m_newConnectionEvents(newConnectionEvents),
   m_logServer(LogNames::LOG_PIPE_PUBLIC_NAME),
-  m_clientLogger(LogNames::LOG_PIPE_PUBLIC_NAME, LogNames::SERVER_LOG_FILE_STUB_NAME)
+  m_clientLogger(LogNames::LOG_PIPE_PUBLIC_NAME, LogNames::SERVER_LOG_FILE_STUB_NAME),
+  m_asyncLogger(&m_clientLogger)
 {
 }
 
@@ -51,7 +52,7 @@ void TvnService::onStart()
   try {
     m_winServiceEvents->enable();
     // FIXME: Use real logger instead of zero.
-    m_tvnServer = new TvnServer(true, m_newConnectionEvents, this, &m_clientLogger);
+    m_tvnServer = new TvnServer(true, m_newConnectionEvents, this, &m_asyncLogger);
     m_tvnServer->addListener(this);
     m_winServiceEvents->onSuccServiceStart();
   } catch (Exception &e) {
@@ -140,14 +141,19 @@ bool TvnService::getBinPath(StringStorage *binPath)
 }
 
 void TvnService::onLogInit(const TCHAR *logDir, const TCHAR *fileName,
-                           unsigned char logLevel)
+                           unsigned char logLevel, bool binaryLog)
 {
+  // Lines logged before the initialization must get to the log dump.
+  m_asyncLogger.flush();
   size_t headerLineCount = m_clientLogger.getLogDumpSize();
+  m_logServer.setBinaryFormat(binaryLog);
   m_logServer.start(logDir, logLevel, headerLineCount);
   m_clientLogger.connect();
 }
 
-void TvnService::onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel)
+void TvnService::onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel,
+                                  bool binaryLog)
 {
+  m_logServer.setBinaryFormat(binaryLog);
   m_logServer.changeLogProps(newLogDir, newLevel);
 }
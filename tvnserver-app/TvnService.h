@@ -29,6 +29,7 @@
 #include "TvnServerListener.h"
 #include "log-server/LogServer.h"
 #include "log-server/ClientLogger.h"
+#include "log-writer/AsyncLogger.h"
 #include "win-system/Service.h"
 
 #include "thread/Thread.h"
@@ -129,10 +130,12 @@ protected:
   static bool getBinPath(StringStorage *binPath);
 
   // This is a callback function that calls when the log can be initialized.
-  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel);
+  virtual void onLogInit(const TCHAR *logDir, const TCHAR *fileName, unsigned char logLevel,
+                         bool binaryLog);
 
   // This is a callback function that calls when log properties have changed.
-  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel);
+  virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel,
+                                bool binaryLog);
 
 protected:
   /**
@@ -146,6 +149,8 @@ protected:
 
   LogServer m_logServer;
   ClientLogger m_clientLogger;
+  // Sends to m_clientLogger on a background thread.
+  AsyncLogger m_asyncLogger;
 
   WinServiceEvents *m_winServiceEvents;
   NewConnectionEvents *m_newConnectionEvents;
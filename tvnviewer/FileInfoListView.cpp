@@ -65,6 +65,12 @@ void FileInfoListView::setWindow(HWND hwnd)
 }
 
 void FileInfoListView::addItem(int index, FileInfo *fileInfo)
+{
+  insertItem(index, fileInfo);
+  ListView::sort();
+}
+
+void FileInfoListView::insertItem(int index, FileInfo *fileInfo)
 {
   const TCHAR *filename = fileInfo->getFileName();
 
@@ -107,7 +113,6 @@ void FileInfoListView::addItem(int index, FileInfo *fileInfo)
 
   ListView::setSubItemText(index, 1, sizeString.getString());
   ListView::setSubItemText(index, 2, modTimeString.getString());
-  ListView::sort();
 }
 
 void FileInfoListView::addRange(FileInfo **filesInfo, size_t count)
@@ -120,7 +125,7 @@ void FileInfoListView::addRange(FileInfo **filesInfo, size_t count)
   for (i = 0; i < count; i++) {
     FileInfo *fi = &arr[i];
     if (fi->isDirectory()) {
-      addItem(index++, fi);
+      insertItem(index++, fi);
     } // if directory
   } // for all files info
 
@@ -128,10 +133,11 @@ void FileInfoListView::addRange(FileInfo **filesInfo, size_t count)
   for (i = 0; i < count; i++) {
     FileInfo *fi = &arr[i];
     if (!fi->isDirectory()) {
-      addItem(index++, fi);
+      insertItem(index++, fi);
     } // if not directory
   } // for all files info
 
+  // List is sorted once for all added items
   ListView::sort();
 } // void
 
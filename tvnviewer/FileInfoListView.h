@@ -57,6 +57,12 @@ public:
   void sort(int columnIndex);
 protected:
 
+  //
+  // Adds new item without sorting of list
+  //
+
+  void insertItem(int index, FileInfo *fileInfo);
+
   //
   // Loads file list view icons from application resources
   //
@@ -220,6 +220,11 @@ void FileTransferMainDialog::onMessageReceived(UINT uMsg, WPARAM wParam, LPARAM
       kill(0);
       return;
     } 
+  case WM_FILE_LIST_PAGE:
+    if (!m_isClosing) {
+      addRemoteFileListPage();
+    }
+    break;
   } // switch
 } // void
 
@@ -925,21 +930,33 @@ void FileTransferMainDialog::getPathToSelectedRemoteFile(StringStorage *out)
 
 void FileTransferMainDialog::setNothingState()
 {
-  m_lastReceivedFileListPath = m_lastSentFileListPath;
-  m_remoteCurFolderTextBox.setText(m_lastReceivedFileListPath.getString());
+  // Take the rest of remote file list
+  addRemoteFileListPage();
+}
+
+void FileTransferMainDialog::addRemoteFileListPage()
+{
+  bool isNewList = false;
+  vector<FileInfo> *page = m_ftCore->takeRemoteFileListPage(&isNewList);
 
-  m_remoteFileListView.clear();
-  vector<FileInfo> *fileRemoteList = m_ftCore->getListRemoteFolder();
-  if (!fileRemoteList->empty()) {
-    FileInfo *filesInfo = &fileRemoteList->front();
-    m_remoteFileListView.addRange(&filesInfo, fileRemoteList->size());
-  }
+  if (isNewList) {
+    // Files info of previous list is deleted already
+    m_remoteFileListView.clear();
+
+    m_lastReceivedFileListPath = m_lastSentFileListPath;
+    m_remoteCurFolderTextBox.setText(m_lastReceivedFileListPath.getString());
 
-  bool isRoot = m_lastSentFileListPath.isEqualTo(_T("/"));
+    bool isRoot = m_lastSentFileListPath.isEqualTo(_T("/"));
 
-  // Add fake ".." folder if not root
-  if (!isRoot) {
-    m_remoteFileListView.addItem(0, m_fakeMoveUpFolder);
+    // Add fake ".." folder if not root
+    if (!isRoot) {
+      m_remoteFileListView.addItem(0, m_fakeMoveUpFolder);
+    }
+  }
+
+  if (page != NULL && !page->empty()) {
+    FileInfo *filesInfo = &page->front();
+    m_remoteFileListView.addRange(&filesInfo, page->size());
   }
 }
 
@@ -971,3 +988,8 @@ void FileTransferMainDialog::onRefreshRemoteFileList()
 {
   refreshRemoteFileList();
 }
+
+void FileTransferMainDialog::onRemoteFileListPage()
+{
+  PostMessage(m_ctrlThis.getWindow(), WM_FILE_LIST_PAGE, 0, 0);
+}
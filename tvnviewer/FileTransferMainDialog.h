@@ -84,6 +84,9 @@ public:
   // Called if remote file list is updated
   void onRefreshRemoteFileList();
 
+  // Called if part of remote file list is received
+  void onRemoteFileListPage();
+
   //
   // Shows error message and throws exception
   //
@@ -191,6 +194,13 @@ private:
 
   void tryListRemoteFolder(const TCHAR *pathToFile) throw(IOException);
 
+  //
+  // Adds received part of remote folder content to remote file list view
+  // (clears view first if content of new folder is received)
+  //
+
+  void addRemoteFileListPage();
+
   //
   // Filenames helper methods
   //
@@ -279,6 +289,7 @@ protected:
 private:
 
   static const UINT WM_OPERATION_FINISHED = WM_USER + 2;
+  static const UINT WM_FILE_LIST_PAGE = WM_USER + 3;
 };
 
 #endif
@@ -25,7 +25,9 @@
 #include "AnsiStringStorage.h"
 #include "CommonHeader.h"
 #include "util/Exception.h"
+#ifdef _WIN32
 #include <crtdbg.h>
+#endif
 
 AnsiStringStorage::AnsiStringStorage()
 {
@@ -26,6 +26,10 @@
 #include <crtdbg.h>
 
 Deflater::Deflater()
+: m_level(Z_DEFAULT_COMPRESSION),
+  m_newLevel(Z_DEFAULT_COMPRESSION),
+  m_strategy(Z_DEFAULT_STRATEGY),
+  m_newStrategy(Z_DEFAULT_STRATEGY)
 {
   m_zlibStream.zalloc = Z_NULL;
   m_zlibStream.zfree = Z_NULL;
@@ -55,12 +59,14 @@ void Deflater::deflate()
 
   m_output.resize(avaliableOutput);
 
-  m_zlibStream.next_in = (Bytef *)m_input;
-  m_zlibStream.avail_in = (unsigned int)m_inputSize;
-
   m_zlibStream.next_out = (Bytef *)&m_output.front();
   m_zlibStream.avail_out = (unsigned int)avaliableOutput;
 
+  applyParams();
+
+  m_zlibStream.next_in = (Bytef *)m_input;
+  m_zlibStream.avail_in = (unsigned int)m_inputSize;
+
   if (::deflate(&m_zlibStream, Z_SYNC_FLUSH) != Z_OK) {
     throw ZLibException(_T("Deflate method return error"));
   }
@@ -71,3 +77,30 @@ void Deflater::deflate()
  
   m_outputSize = m_zlibStream.total_out - prevTotalOut;
 }
+
+void Deflater::applyParams()
+{
+  if (m_newLevel == m_level && m_newStrategy == m_strategy) {
+    return;
+  }
+  // The new parameters are applied when there is no input, so they affect
+  // only the data passed after this call. Z_BUF_ERROR means that zlib has
+  // had nothing to flush.
+  m_zlibStream.avail_in = 0;
+  int r = deflateParams(&m_zlibStream, m_newLevel, m_newStrategy);
+  if (r != Z_OK && r != Z_BUF_ERROR) {
+    throw ZLibException(_T("Error configuring zlib stream"));
+  }
+  m_level = m_newLevel;
+  m_strategy = m_newStrategy;
+}
+
+void Deflater::setLevel(int level)
+{
+  m_newLevel = level;
+}
+
+void Deflater::setStrategy(int strategy)
+{
+  m_newStrategy = strategy;
+}
@@ -26,7 +26,7 @@
 #define _DEFLATER_H_
 
 #include "ZLibBase.h"
-#include "ZLibException.h"
+#include "ZlibException.h"
 
 class Deflater : public ZLibBase
 {
@@ -35,8 +35,27 @@ public:
   ~Deflater();
 
   void deflate() throw(ZLibException);
+
+  // Sets the compression level (0..9) for the data passed to the
+  // following deflate() calls. The stream is not reset, so the peer
+  // keeps decompressing it as before.
+  void setLevel(int level);
+
+  // Sets the compression strategy (Z_DEFAULT_STRATEGY, Z_FILTERED, Z_RLE,
+  // etc.) the same way as setLevel() sets the level.
+  void setStrategy(int strategy);
 protected:
+  // Applies the level and the strategy requested by setLevel() and
+  // setStrategy(). The output buffer of the stream must be set.
+  void applyParams() throw(ZLibException);
+
   z_stream m_zlibStream;
+  // Level the stream is configured with and the level requested by setLevel().
+  int m_level;
+  int m_newLevel;
+  // The same for the strategy.
+  int m_strategy;
+  int m_newStrategy;
 };
 
 #endif
@@ -23,7 +23,9 @@
 //
 
 #include "Inflater.h"
+#ifdef _WIN32
 #include <crtdbg.h>
+#endif
 
 Inflater::Inflater()
 : m_unpackedSize(0)
@@ -50,7 +52,7 @@ void Inflater::setUnpackedSize(size_t size)
   m_unpackedSize = size;
 }
 
-void Inflater::inflate()
+void Inflater::inflate() throw(ZLibException)
 {
   size_t avaliableOutput = m_unpackedSize + m_unpackedSize / 100 + 1024;
   unsigned long prevTotalOut = m_zlibStream.total_out;
@@ -69,26 +71,55 @@ void Inflater::inflate()
   m_zlibStream.next_out = (Bytef *)&m_output.front();
   m_zlibStream.avail_out = (unsigned int)avaliableOutput;
 
+  checkResult(::inflate(&m_zlibStream, Z_SYNC_FLUSH));
+
+  if (m_zlibStream.avail_in != 0) {
+    throw ZLibException(_T("Not enough buffer size for data decompression"));
+  }
+
+  m_outputSize = m_zlibStream.total_out - prevTotalOut;
+}
+
+size_t Inflater::inflate(const char **input, size_t *inputSize,
+                         char *output, size_t outputSize) throw(ZLibException)
+{
+  // Check to overflow.
+  _ASSERT((unsigned int)*inputSize == *inputSize);
+  _ASSERT((unsigned int)outputSize == outputSize);
+
+  m_zlibStream.next_in = (Bytef *)*input;
+  m_zlibStream.avail_in = (unsigned int)*inputSize;
+
+  m_zlibStream.next_out = (Bytef *)output;
+  m_zlibStream.avail_out = (unsigned int)outputSize;
+
   int r = ::inflate(&m_zlibStream, Z_SYNC_FLUSH);
+  // Z_BUF_ERROR only means that no progress was possible.
+  if (r != Z_BUF_ERROR) {
+    checkResult(r);
+  }
 
-  if (r == Z_STREAM_END) {
+  size_t consumed = *inputSize - m_zlibStream.avail_in;
+  *input += consumed;
+  *inputSize -= consumed;
+  return outputSize - m_zlibStream.avail_out;
+}
+
+void Inflater::checkResult(int result) throw(ZLibException)
+{
+  if (result == Z_STREAM_END) {
     throw ZLibException(_T("ZLib stream end"));
   }
-  if (r == Z_NEED_DICT) {
+  if (result == Z_NEED_DICT) {
     throw ZLibException(_T("ZLib need dictionary"));
   }
-  if (r == Z_STREAM_ERROR) {
+  if (result == Z_STREAM_ERROR) {
     throw ZLibException(_T("ZLib stream error"));
   }
-  if (r == Z_MEM_ERROR) {
+  if (result == Z_MEM_ERROR) {
     throw ZLibException(_T("ZLib memory error"));
   }
-  if (r == Z_DATA_ERROR) {
+  if (result == Z_DATA_ERROR) {
     throw ZLibException(_T("Zlib data error"));
   }
-  if (m_zlibStream.avail_in != 0) {
-    throw ZLibException(_T("Not enough buffer size for data decompression"));
-  }
-
-  m_outputSize = m_zlibStream.total_out - prevTotalOut;
 }
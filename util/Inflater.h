@@ -26,7 +26,7 @@
 #define _INFLATER_H_
 
 #include "ZLibBase.h"
-#include "ZLibException.h"
+#include "ZlibException.h"
 
 class Inflater : public ZLibBase
 {
@@ -42,7 +42,19 @@ public:
 
   void inflate() throw(ZLibException);
 
+  // Streaming interface. Decompresses the data from the input buffer
+  // directly to the output buffer until one of them is exhausted. The input
+  // pointer and size are advanced past the consumed bytes, the unconsumed
+  // rest should be passed to the next call. Returns the number of bytes
+  // written to the output, it may be 0 if more input is needed.
+  // The getOutput() buffer is not used by this method.
+  size_t inflate(const char **input, size_t *inputSize,
+                 char *output, size_t outputSize) throw(ZLibException);
+
 protected:
+  // Throws ZLibException if the result code of zlib inflate() is an error.
+  static void checkResult(int result) throw(ZLibException);
+
   z_stream m_zlibStream;
 
   //
@@ -0,0 +1,186 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __POSIXDEFS_H__
+#define __POSIXDEFS_H__
+
+// Definitions of the Windows types and TCHAR functions used by the
+// portable parts of the tree (e.g. file-lib/MappedFileChannel and the
+// replay benchmark), so that they can be built on POSIX systems. There is
+// no Unicode build on these systems, TCHAR is char.
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <wchar.h>
+#include <sched.h>
+
+// The standard headers are included before the min() and max() macros
+// are defined, as windows.h defines them too.
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "inttypes.h"
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int BOOL;
+
+typedef unsigned int UINT;
+
+typedef wchar_t WCHAR;
+typedef char TCHAR;
+
+typedef struct tagRECT {
+  LONG left;
+  LONG top;
+  LONG right;
+  LONG bottom;
+} RECT;
+
+typedef struct _FILETIME {
+  DWORD dwLowDateTime;
+  DWORD dwHighDateTime;
+} FILETIME, *LPFILETIME;
+
+typedef struct _SYSTEMTIME {
+  WORD wYear;
+  WORD wMonth;
+  WORD wDayOfWeek;
+  WORD wDay;
+  WORD wHour;
+  WORD wMinute;
+  WORD wSecond;
+  WORD wMilliseconds;
+} SYSTEMTIME, *LPSYSTEMTIME;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define _T(x) x
+
+#define _ASSERT(expr) assert(expr)
+
+#define _tmain main
+#define _tcslen strlen
+#define _tcscmp strcmp
+#define _tcsncmp strncmp
+#define _tcscpy strcpy
+#define _tcsstr strstr
+#define _tcschr strchr
+#define _tcsrchr strrchr
+#define _totlower tolower
+#define _totupper toupper
+#define _istalpha isalpha
+#define _istdigit isdigit
+#define _istspace isspace
+#define _ttoi atoi
+#define _sctprintf(...) snprintf(0, 0, __VA_ARGS__)
+#define _tprintf printf
+#define _ftprintf fprintf
+#define _stprintf sprintf
+#define _vstprintf vsprintf
+#define _stscanf sscanf
+
+inline int _vsctprintf(const char *format, va_list args)
+{
+  va_list copy;
+  va_copy(copy, args);
+  int count = vsnprintf(0, 0, format, copy);
+  va_end(copy);
+  return count;
+}
+
+#define _vscprintf _vsctprintf
+#define vsprintf_s _vstprintf_s
+
+inline int _tcsupr_s(char *str, size_t size)
+{
+  for (size_t i = 0; i < size && str[i] != 0; i++) {
+    str[i] = (char)toupper((unsigned char)str[i]);
+  }
+  return 0;
+}
+
+inline int _vstprintf_s(char *buffer, size_t size, const char *format,
+                        va_list args)
+{
+  return vsnprintf(buffer, size, format, args);
+}
+
+inline LONG InterlockedExchange(volatile LONG *target, LONG value)
+{
+  __sync_synchronize();
+  return __sync_lock_test_and_set(target, value);
+}
+
+inline LONG InterlockedIncrement(volatile LONG *target)
+{
+  return __sync_add_and_fetch(target, 1);
+}
+
+inline LONG InterlockedDecrement(volatile LONG *target)
+{
+  return __sync_sub_and_fetch(target, 1);
+}
+
+inline LONG InterlockedCompareExchange(volatile LONG *target, LONG value,
+                                       LONG comparand)
+{
+  return __sync_val_compare_and_swap(target, comparand, value);
+}
+
+inline BOOL SwitchToThread()
+{
+  return sched_yield() == 0;
+}
+
+// INT32 is defined by inttypes.h, keep libjpeg from defining it again
+// (basetsd.h plays this role on Windows).
+#define XMD_H
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#endif // __POSIXDEFS_H__
@@ -27,7 +27,9 @@
 #include "Exception.h"
 #include <stdio.h>
 
+#ifdef _WIN32
 #include <crtdbg.h>
+#endif
 
 StringStorage::StringStorage()
 {
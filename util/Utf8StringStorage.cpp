@@ -26,11 +26,14 @@
 #include "CommonHeader.h"
 #include "util/Exception.h"
 #include "UnicodeStringStorage.h"
+#ifdef _WIN32
 #include <crtdbg.h>
+#endif
 
 Utf8StringStorage::Utf8StringStorage()
 {
-  fromStringStorage(&StringStorage(_T("")));
+  StringStorage empty(_T(""));
+  fromStringStorage(&empty);
 }
 
 Utf8StringStorage::Utf8StringStorage(const std::vector<char> *utf8Buffer)
@@ -69,6 +72,11 @@ size_t Utf8StringStorage::getSize() const
 
 void Utf8StringStorage::fromStringStorage(const StringStorage *src)
 {
+#ifndef _WIN32
+  // Strings are in UTF8 on POSIX systems already.
+  const char *string = src->getString();
+  m_buffer.assign(string, string + src->getLength() + 1);
+#else
 #ifndef _UNICODE
   // 1) From ANSI to UNICODE
   UnicodeStringStorage uniSrc(src);
@@ -94,10 +102,17 @@ void Utf8StringStorage::fromStringStorage(const StringStorage *src)
   m_buffer.resize(dstRequiredSize);
   WideCharToMultiByte(CP_UTF8, 0, uniString, constrSrcSize,
                       &m_buffer.front(), dstRequiredSize, 0, 0);
+#endif // _WIN32
 }
 
 void Utf8StringStorage::toStringStorage(StringStorage *dst)
 {
+#ifndef _WIN32
+  // The source string may be without the termination symbol.
+  std::vector<char> buffer(m_buffer);
+  buffer.push_back('\0');
+  dst->setString(&buffer.front());
+#else
   // 1) From UTF8 to UNICODE
   int constrSize = (int)getSize();
   _ASSERT(constrSize == getSize());
@@ -116,4 +131,5 @@ void Utf8StringStorage::toStringStorage(StringStorage *dst)
   // 2) From UNICODE to StringStorage
   UnicodeStringStorage uniString(&uniBuff.front());
   uniString.toStringStorage(dst);
+#endif // _WIN32
 }
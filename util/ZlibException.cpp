@@ -22,7 +22,7 @@
 //-------------------------------------------------------------------------
 //
 
-#include "ZLibException.h"
+#include "ZlibException.h"
 
 ZLibException::ZLibException(const TCHAR *message)
  : Exception(message)
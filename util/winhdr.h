@@ -25,6 +25,8 @@
 #ifndef __WINHDR_H__
 #define __WINHDR_H__
 
+#ifdef _WIN32
+
 #ifdef WINVER
 #undef WINVER
 #endif
@@ -47,4 +49,10 @@
 #include <commctrl.h>
 #include <Dbghelp.h>
 
+#else
+
+#include "PosixDefs.h"
+
+#endif // _WIN32
+
 #endif // __WINHDR_H__
@@ -52,6 +52,8 @@ bool Decoder::isPseudo(int encoding)
   case EncodingDefs::HEXTILE:
   case EncodingDefs::TIGHT:
   case EncodingDefs::ZRLE:
+  // Tile cache operations are bound to rectangles of the frame buffer.
+  case PseudoEncDefs::TILE_CACHE:
     return false;
 
   case PseudoEncDefs::COMPR_LEVEL_0:
@@ -24,7 +24,7 @@
 
 #include "DecoderOfRectangle.h"
 
-#include "FbUpdateNotifier.h"
+#include "FbUpdateListener.h"
 
 DecoderOfRectangle::DecoderOfRectangle(LogWriter *logWriter)
 : Decoder(logWriter)
@@ -40,7 +40,7 @@ void DecoderOfRectangle::process(RfbInputGate *input,
                      FrameBuffer *secondFrameBuffer,
                      const Rect *rect,
                      LocalMutex *fbLock,
-                     FbUpdateNotifier *fbNotifier)
+                     FbUpdateListener *fbNotifier)
 {
   decode(input, secondFrameBuffer, rect);
   copy(frameBuffer, secondFrameBuffer, rect, fbLock);
@@ -56,7 +56,7 @@ void DecoderOfRectangle::copy(FrameBuffer *dstFrameBuffer,
   dstFrameBuffer->copyFrom(rect, srcFrameBuffer, rect->left, rect->top);
 }
 
-void DecoderOfRectangle::notify(FbUpdateNotifier *fbNotifier,
+void DecoderOfRectangle::notify(FbUpdateListener *fbNotifier,
                      const Rect *rect)
 {
   fbNotifier->onUpdate(rect);
@@ -27,7 +27,7 @@
 
 #include "Decoder.h"
 
-class FbUpdateNotifier;
+class FbUpdateListener;
 
 class DecoderOfRectangle : public Decoder
 {
@@ -50,7 +50,7 @@ public:
                        FrameBuffer *secondFrameBuffer,
                        const Rect *rect,
                        LocalMutex *fbLock,
-                       FbUpdateNotifier *fbNotifier);
+                       FbUpdateListener *fbNotifier);
 
   //
   // This method inherited Decoder::isPseudo() and return true.
@@ -77,7 +77,7 @@ protected:
   //
   // This method notify fbNotifier about update of rect.
   //
-  virtual void notify(FbUpdateNotifier *fbNotifier,
+  virtual void notify(FbUpdateListener *fbNotifier,
                       const Rect *rect);
 };
 
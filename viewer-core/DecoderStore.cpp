@@ -84,8 +84,11 @@ vector<INT32> DecoderStore::getDecoderIds()
        i++) {
     sortedDecoders.push_back(i->second);
   }
-  if (sortedDecoders.empty())
-    sortedDecoders.push_back(EncodingDefs::RAW);
+  if (sortedDecoders.empty()) {
+    // Copy of the constant, it has no definition to bind the reference to.
+    int rawEncoding = EncodingDefs::RAW;
+    sortedDecoders.push_back(rawEncoding);
+  }
   return sortedDecoders;
 }
 
@@ -35,10 +35,11 @@
 #include "win-system/WindowsEvent.h"
 
 #include "CursorPainter.h"
+#include "FbUpdateListener.h"
 
 class CoreEventsAdapter;
 
-class FbUpdateNotifier : public Thread
+class FbUpdateNotifier : public Thread, public FbUpdateListener
 {
 public:
   FbUpdateNotifier(FrameBuffer *fb, LocalMutex *fbLock, LogWriter *logger);
@@ -46,6 +47,7 @@ public:
 
   void setAdapter(CoreEventsAdapter *adapter);
 
+  // Inherited from FbUpdateListener
   void onUpdate(const Rect *rect);
   void onPropertiesFb();
 
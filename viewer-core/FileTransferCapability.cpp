@@ -122,6 +122,26 @@ void FileTransferCapability::addCapabilities(CapabilitiesManager *capabilities)
                                   FTMessage::DOWNLOAD_DATA_REQUEST_SIG,
                                   _T("File download data request"));
 
+  capabilities->addClientMsgCapability(FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::DOWNLOAD_DATA_WINDOW_REQUEST_SIG,
+                                  _T("Pipelined file download data request"));
+
+  capabilities->addClientMsgCapability(FTMessage::FILE_SIGNATURE_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::FILE_SIGNATURE_REQUEST_SIG,
+                                  _T("File signature request"));
+
+  capabilities->addClientMsgCapability(FTMessage::UPLOAD_COPY_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::UPLOAD_COPY_REQUEST_SIG,
+                                  _T("File upload copy request"));
+
+  capabilities->addClientMsgCapability(FTMessage::FILE_LIST_PAGED_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::FILE_LIST_PAGED_REQUEST_SIG,
+                                  _T("Paged file list request"));
+
   capabilities->addClientMsgCapability(FTMessage::UPLOAD_START_REQUEST,
                                   VendorDefs::TIGHTVNC,
                                   FTMessage::UPLOAD_START_REQUEST_SIG,
@@ -137,6 +157,16 @@ void FileTransferCapability::addCapabilities(CapabilitiesManager *capabilities)
                                   FTMessage::UPLOAD_END_REQUEST_SIG,
                                   _T("File upload end request"));
 
+  capabilities->addClientMsgCapability(FTMessage::UPLOAD_BATCH_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::UPLOAD_BATCH_REQUEST_SIG,
+                                  _T("File upload batch request"));
+
+  capabilities->addClientMsgCapability(FTMessage::DOWNLOAD_BATCH_REQUEST,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::DOWNLOAD_BATCH_REQUEST_SIG,
+                                  _T("File download batch request"));
+
   // Server-to-Client messages:
   capabilities->addServerMsgCapability(this,
                                   FTMessage::COMPRESSION_SUPPORT_REPLY,
@@ -150,6 +180,12 @@ void FileTransferCapability::addCapabilities(CapabilitiesManager *capabilities)
                                   FTMessage::FILE_LIST_REPLY_SIG,
                                   _T("File list reply"));
 
+  capabilities->addServerMsgCapability(this,
+                                  FTMessage::FILE_LIST_PAGE_REPLY,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::FILE_LIST_PAGE_REPLY_SIG,
+                                  _T("File list page reply"));
+
   capabilities->addServerMsgCapability(this,
                                   FTMessage::LAST_REQUEST_FAILED_REPLY,
                                   VendorDefs::TIGHTVNC,
@@ -168,6 +204,12 @@ void FileTransferCapability::addCapabilities(CapabilitiesManager *capabilities)
                                   FTMessage::DIRSIZE_REPLY_SIG,
                                   _T("Directory size reply"));
 
+  capabilities->addServerMsgCapability(this,
+                                  FTMessage::FILE_SIGNATURE_REPLY,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::FILE_SIGNATURE_REPLY_SIG,
+                                  _T("File signature reply"));
+
   capabilities->addServerMsgCapability(this,
                                   FTMessage::RENAME_REPLY,
                                   VendorDefs::TIGHTVNC,
@@ -221,4 +263,16 @@ void FileTransferCapability::addCapabilities(CapabilitiesManager *capabilities)
                                   VendorDefs::TIGHTVNC,
                                   FTMessage::UPLOAD_END_REPLY_SIG,
                                   _T("File upload end reply"));
+
+  capabilities->addServerMsgCapability(this,
+                                  FTMessage::UPLOAD_BATCH_REPLY,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::UPLOAD_BATCH_REPLY_SIG,
+                                  _T("File upload batch reply"));
+
+  capabilities->addServerMsgCapability(this,
+                                  FTMessage::DOWNLOAD_BATCH_REPLY,
+                                  VendorDefs::TIGHTVNC,
+                                  FTMessage::DOWNLOAD_BATCH_REPLY_SIG,
+                                  _T("File download batch reply"));
 }
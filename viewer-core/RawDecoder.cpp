@@ -39,7 +39,7 @@ void RawDecoder::process(RfbInputGate *input,
                          FrameBuffer *secondFrameBuffer,
                          const Rect *rect,
                          LocalMutex *fbLock,
-                         FbUpdateNotifier *fbNotifier)
+                         FbUpdateListener *fbNotifier)
 {
   // If area of rectangle is 0, then exit from process: nothing update.
   if (rect->area() == 0) {
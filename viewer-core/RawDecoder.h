@@ -41,7 +41,7 @@ public:
                        FrameBuffer *secondFrameBuffer,
                        const Rect *rect,
                        LocalMutex *fbLock,
-                       FbUpdateNotifier *fbNotifier);
+                       FbUpdateListener *fbNotifier);
 
 protected:
   virtual void decode(RfbInputGate *input,
@@ -55,6 +55,7 @@
 #include "LastRectDecoder.h"
 #include "PointerPosDecoder.h"
 #include "RichCursorDecoder.h"
+#include "TileCacheDecoder.h"
 
 #include <algorithm>
 
@@ -122,6 +123,7 @@ void RemoteViewerCore::init()
   m_decoderStore.addDecoder(new LastRectDecoder(&m_logWriter), -1);
   m_decoderStore.addDecoder(new PointerPosDecoder(&m_logWriter), -1);
   m_decoderStore.addDecoder(new RichCursorDecoder(&m_logWriter), -1);
+  m_decoderStore.addDecoder(new TileCacheDecoder(&m_logWriter), -1);
 
   m_input = 0;
   m_output = 0;
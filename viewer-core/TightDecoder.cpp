@@ -25,6 +25,7 @@
 #include "TightDecoder.h"
 
 #include "rfb/StandardPixelFormatFactory.h"
+#include "io-lib/InflaterInputStream.h"
 
 TightDecoder::TightDecoder(LogWriter *logWriter)
 : DecoderOfRectangle(logWriter),
@@ -271,21 +272,16 @@ void TightDecoder::readCompressedData(RfbInputGate *input,
 {
   size_t rawDataLength = readCompactSize(input);
 
-  vector<char> compressed(rawDataLength);
-
-  // read compressed (raw) data behind space allocated for decompressed data
   if (rawDataLength != 0) {
-    input->readFully(&compressed.front(), rawDataLength);
-
-    Inflater *decoder = m_inflater[decoderId];
-    decoder->setInput(&compressed.front(), rawDataLength);
-    decoder->setUnpackedSize(expectedLength);
-    decoder->inflate();
-
-    size_t size = decoder->getOutputSize();
-    const char *output = decoder->getOutput();
-    buffer.resize(size);
-    buffer.assign(output, output + size);
+    // Decompress directly from the input to the buffer.
+    InflaterInputStream inflaterStream(m_inflater[decoderId], input,
+                                       rawDataLength);
+    buffer.resize(expectedLength);
+    if (expectedLength != 0) {
+      DataInputStream unpackedDataStream(&inflaterStream);
+      unpackedDataStream.readFully(&buffer.front(), expectedLength);
+    }
+    inflaterStream.finish();
   } else {
     _ASSERT(rawDataLength != 0);
     m_logWriter->debug(_T("Tight decoder: Length of Raw compressed data is 0"));
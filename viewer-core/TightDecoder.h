@@ -89,7 +89,7 @@ private:
                          size_t pixelOffset);
 
   UINT32 transformPixelToTight(UINT32 color);
-  vector<UINT8> TightDecoder::transformArray(const vector<UINT8> &buffer);
+  vector<UINT8> transformArray(const vector<UINT8> &buffer);
 
   vector<Inflater *> m_inflater;
   JpegDecompressor m_jpeg;
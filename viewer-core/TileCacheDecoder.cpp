@@ -0,0 +1,119 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TileCacheDecoder.h"
+
+#include "rfb/TileCacheDefs.h"
+#include "util/Exception.h"
+
+TileCacheDecoder::TileCacheDecoder(LogWriter *logWriter)
+: DecoderOfRectangle(logWriter),
+  m_tiles(TileCacheDefs::SLOT_COUNT, 0),
+  m_hashes(TileCacheDefs::SLOT_COUNT, 0),
+  m_operation(TileCacheDefs::RESET),
+  m_slot(0),
+  m_hash(0)
+{
+  m_encoding = PseudoEncDefs::TILE_CACHE;
+}
+
+TileCacheDecoder::~TileCacheDecoder()
+{
+  reset();
+}
+
+void TileCacheDecoder::decode(RfbInputGate *input,
+                              FrameBuffer *frameBuffer,
+                              const Rect *rect)
+{
+  m_operation = input->readUInt8();
+  if (m_operation == TileCacheDefs::RESET) {
+    return;
+  }
+  if (m_operation != TileCacheDefs::STORE &&
+      m_operation != TileCacheDefs::LOAD) {
+    throw Exception(_T("Error in protocol: unknown tile cache operation"));
+  }
+  m_slot = input->readUInt16();
+  m_hash = input->readUInt64();
+
+  if (m_slot >= TileCacheDefs::SLOT_COUNT ||
+      rect->getWidth() > TileCacheDefs::TILE_SIZE ||
+      rect->getHeight() > TileCacheDefs::TILE_SIZE) {
+    throw Exception(_T("Error in protocol: incorrect tile cache rectangle"));
+  }
+}
+
+void TileCacheDecoder::copy(FrameBuffer *dstFrameBuffer,
+                            const FrameBuffer *srcFrameBuffer,
+                            const Rect *rect,
+                            LocalMutex *fbLock)
+{
+  if (m_operation == TileCacheDefs::RESET) {
+    m_logWriter->debug(_T("Tile cache is reset"));
+    reset();
+    return;
+  }
+
+  FrameBuffer *tile = m_tiles[m_slot];
+  Dimension tileDim(rect);
+
+  AutoLock al(fbLock);
+  PixelFormat pf = dstFrameBuffer->getPixelFormat();
+  if (m_operation == TileCacheDefs::STORE) {
+    if (tile == 0) {
+      tile = new FrameBuffer;
+      m_tiles[m_slot] = tile;
+    }
+    if (!tile->getDimension().isEqualTo(&tileDim) ||
+        !tile->getPixelFormat().isEqualTo(&pf)) {
+      tile->setProperties(&tileDim, &pf);
+    }
+    tile->copyFrom(dstFrameBuffer, rect->left, rect->top);
+    m_hashes[m_slot] = m_hash;
+  } else {
+    if (tile == 0 || m_hashes[m_slot] != m_hash ||
+        !tile->getDimension().isEqualTo(&tileDim) ||
+        !tile->getPixelFormat().isEqualTo(&pf)) {
+      throw Exception(_T("Error in protocol: tile is not in the tile cache"));
+    }
+    dstFrameBuffer->copyFrom(rect, tile, 0, 0);
+  }
+}
+
+void TileCacheDecoder::notify(FbUpdateListener *fbNotifier,
+                              const Rect *rect)
+{
+  if (m_operation == TileCacheDefs::LOAD) {
+    DecoderOfRectangle::notify(fbNotifier, rect);
+  }
+}
+
+void TileCacheDecoder::reset()
+{
+  for (size_t i = 0; i < m_tiles.size(); i++) {
+    delete m_tiles[i];
+    m_tiles[i] = 0;
+    m_hashes[i] = 0;
+  }
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2013 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _TILE_CACHE_DECODER_H_
+#define _TILE_CACHE_DECODER_H_
+
+#include "DecoderOfRectangle.h"
+
+#include <vector>
+
+//
+// Keeps the tile cache of the viewer (see rfb/TileCacheDefs.h). The server
+// decides what is stored in every slot, this decoder only stores tiles of
+// the frame buffer and draws them back when the server refers to them.
+//
+class TileCacheDecoder : public DecoderOfRectangle
+{
+public:
+  TileCacheDecoder(LogWriter *logWriter);
+  virtual ~TileCacheDecoder();
+
+protected:
+  //
+  // This method inherited by DecoderOfRectangle.
+  // It reads the operation and checks it.
+  //
+  virtual void decode(RfbInputGate *input,
+                      FrameBuffer *frameBuffer,
+                      const Rect *rect);
+
+  //
+  // This method inherited by DecoderOfRectangle.
+  // It applies the operation to the frame buffer and the slots.
+  //
+  virtual void copy(FrameBuffer *dstFrameBuffer,
+                    const FrameBuffer *srcFrameBuffer,
+                    const Rect *rect,
+                    LocalMutex *fbLock);
+
+  //
+  // This method inherited by DecoderOfRectangle.
+  // Only loaded tiles change the frame buffer, so only they are notified.
+  //
+  virtual void notify(FbUpdateListener *fbNotifier,
+                      const Rect *rect);
+
+private:
+  // Drops pixels of all the slots.
+  void reset();
+
+  // Pixels and content hashes of the slots, a slot is empty if its pixels
+  // are 0.
+  std::vector<FrameBuffer *> m_tiles;
+  std::vector<UINT64> m_hashes;
+
+  // The operation read by decode().
+  UINT8 m_operation;
+  UINT16 m_slot;
+  UINT64 m_hash;
+};
+
+#endif
@@ -24,7 +24,7 @@
 
 #include "ZrleDecoder.h"
 
-#include "io-lib/ByteArrayInputStream.h"
+#include "io-lib/InflaterInputStream.h"
 
 #include <vector>
 
@@ -42,11 +42,8 @@ void ZrleDecoder::decode(RfbInputGate *input,
                          FrameBuffer *frameBuffer,
                          const Rect *dstRect)
 {
-  size_t maxUnpackedSize = getMaxSizeOfRectangle(dstRect);
-  readAndInflate(input, maxUnpackedSize);
-
-  size_t unpackedDataSize = m_inflater.getOutputSize();
-  if (unpackedDataSize == 0) {
+  UINT32 length = input->readUInt32();
+  if (length == 0) {
     m_logWriter->debug(_T("Empty unpacked data (zrle-decoder)"));
     if (dstRect->area() != 0) {
       m_logWriter->detail(_T("Corrupted data in zrle-decoder, rectangle is undefined."));
@@ -55,12 +52,9 @@ void ZrleDecoder::decode(RfbInputGate *input,
     return;
   }
 
-  vector<unsigned char> unpackedData;
-  unpackedData.resize(unpackedDataSize);
-  unpackedData.assign(m_inflater.getOutput(), m_inflater.getOutput() + unpackedDataSize);
-  ByteArrayInputStream unpackedByteArrayStream(reinterpret_cast<char *>(&unpackedData.front()),
-                                               unpackedData.size());
-  DataInputStream unpackedDataStream(&unpackedByteArrayStream);
+  // The tiles are decompressed directly from the input as they are read.
+  InflaterInputStream inflaterStream(&m_inflater, input, length);
+  DataInputStream unpackedDataStream(&inflaterStream);
 
   m_numberFirstByte = 0;
   PixelFormat pxFormat = frameBuffer->getPixelFormat();
@@ -129,29 +123,8 @@ void ZrleDecoder::decode(RfbInputGate *input,
       drawTile(frameBuffer, &tileRect, &pixels);
     } // tile(x, y)
   } // tile(..., y)
-}
-
-void ZrleDecoder::readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize)
-{
-  UINT32 length = input->readUInt32();
-  std::vector<char> zlibData;
-  zlibData.resize(length);
-  if (length == 0) {
-    zlibData.resize(1);
-  }
-  input->readFully(&zlibData.front(), length);
 
-  m_inflater.setInput(&zlibData.front(), length);
-  m_inflater.setUnpackedSize(maximalUnpackedSize);
-  m_inflater.inflate();
-}
-
-size_t ZrleDecoder::getMaxSizeOfRectangle(const Rect *dstRect)
-{
-  size_t widthCount = (dstRect->getWidth() + TILE_SIZE - 1) / TILE_SIZE;
-  size_t heightCount = (dstRect->getHeight() + TILE_SIZE - 1) / TILE_SIZE;
-  size_t tileCount = widthCount * heightCount;
-  return TILE_LENGTH_SIZE + MAXIMAL_TILE_SIZE * tileCount;
+  inflaterStream.finish();
 }
 
 int ZrleDecoder::readType(DataInputStream *input)
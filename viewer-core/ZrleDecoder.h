@@ -45,8 +45,6 @@ protected:
                       const Rect *dstRect);
 
 
-  void readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize);
-
   int readType(DataInputStream *input);
 
   size_t readRunLength(DataInputStream *input);
@@ -88,22 +86,6 @@ protected:
 
 private:
   static const int TILE_SIZE = 64;
-
-  // maximal size of tile (64x64) is max value from follow:
-  // 1. size of raw: subenc + data:
-  //    1 + width * height * pixelSize = 1 + 64 * 64 * 4 = 16385
-  // 2. size of solid: subenc + solidColor:
-  //    1 + pixelSize = 1 + 4 = 5
-  // 3. size of packpalette: subenc + palleteSize + data:
-  //    1 + paletteSize * pixelSize + m = 1 + 16 * 4 + 32 * 64 = 2113
-  // 4. size of plainRle: subenc + rle * width * height:
-  //    1 + (pixelSize + 1) * width * height = 1 + (4 + 1) * 64 * 64 = 20481
-  // 5. size of paletteRle: subenc + paletteSzie + data:
-  //    1 + paletteSize * pixelSize + rle * width * height = 1 + 128 * 4 + (1 + 1) * 64 * 64 = 8705
-  static const size_t MAXIMAL_TILE_SIZE = 20481;
-  static const size_t TILE_LENGTH_SIZE = sizeof(UINT32);
-
-  static size_t getMaxSizeOfRectangle(const Rect *dstRect);
 };
 
 #endif
@@ -92,6 +92,33 @@ SecurityIdentifier *SecurityIdentifier::getProcessOwner(HANDLE processHandle)
   }
 }
 
+SecurityIdentifier *SecurityIdentifier::getThreadUser()
+{
+  HANDLE threadToken;
+
+  if (!OpenThreadToken(GetCurrentThread(), TOKEN_QUERY, TRUE, &threadToken)) {
+    if (GetLastError() != ERROR_NO_TOKEN) {
+      throw SystemException();
+    }
+    return getProcessOwner(GetCurrentProcess());
+  }
+
+  try {
+    char buffer[1024];
+    DWORD retLen = 0;
+    if (!GetTokenInformation(threadToken, TokenUser, &buffer, sizeof(buffer), &retLen)) {
+      throw SystemException();
+    }
+    SecurityIdentifier *sid =
+      new SecurityIdentifier((SID *)((TOKEN_USER *)buffer)->User.Sid);
+    CloseHandle(threadToken);
+    return sid;
+  } catch (...) {
+    CloseHandle(threadToken);
+    throw;
+  }
+}
+
 SecurityIdentifier *SecurityIdentifier::createSidFromString(const TCHAR *sidString)
 {
   return new SecurityIdentifier(sidString);
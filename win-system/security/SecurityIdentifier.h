@@ -103,6 +103,14 @@ public:
    */
   static SecurityIdentifier *getProcessOwner(HANDLE processHandle) throw(SystemException);
 
+  /**
+   * Returns SID of user the calling thread acts as: the impersonated user
+   * or the process owner if the thread does not impersonate.
+   * @return SID of the thread user.
+   * @throws SystemException if operation failed.
+   */
+  static SecurityIdentifier *getThreadUser() throw(SystemException);
+
   /**
    * Creates SID from sid string.
    * @return created SID.